@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace neoneo {
+namespace calc {
+
+// Error in parsing or evaluating an expression
+class CalcError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Arbitrary-precision signed decimal: an integer magnitude and a count of
+// fraction digits. Arithmetic follows bc: results are truncated toward
+// zero to the scale bc would give the operation.
+class Decimal {
+public:
+    Decimal() = default;
+
+    static Decimal from_int(int64_t value);
+
+    // Parse digits with an optional '.' fraction and e/E exponent. Throws
+    // CalcError when the exponent is too large to expand.
+    static bool parse(const std::string& text, Decimal& out);
+
+    bool is_zero() const { return limbs.empty(); }
+    bool is_negative() const { return negative; }
+    int get_scale() const { return scale; }
+    bool is_integer() const;
+
+    // Significant digits, as bc's length()
+    size_t length() const;
+    // Digits before the decimal point
+    size_t integer_digits() const;
+
+    // Integer part; false if it does not fit
+    bool to_int64(int64_t& out) const;
+    double to_double() const;
+    std::string to_string() const;
+
+    Decimal negated() const;
+    Decimal abs() const;
+
+    // Same value with new_scale fraction digits, truncating if fewer
+    Decimal rescaled(int new_scale) const;
+
+    // <0, 0 or >0 as a is less than, equal to or greater than b
+    static int compare(const Decimal& a, const Decimal& b);
+
+    friend Decimal add(const Decimal& a, const Decimal& b);
+    friend Decimal multiply(const Decimal& a, const Decimal& b, int scale);
+    friend Decimal divide(const Decimal& a, const Decimal& b, int scale);
+    friend Decimal sqrt(const Decimal& x, int scale);
+
+private:
+    static Decimal make(bool negative, std::vector<uint32_t> limbs, int scale);
+
+    bool negative = false;
+    std::vector<uint32_t> limbs; // Magnitude in base 10^9, least significant first
+    int scale = 0;
+};
+
+Decimal add(const Decimal& a, const Decimal& b);
+Decimal subtract(const Decimal& a, const Decimal& b);
+
+// Product truncated to min(a.scale + b.scale, max(scale, a.scale, b.scale))
+Decimal multiply(const Decimal& a, const Decimal& b, int scale);
+
+// Quotient with exactly scale fraction digits; throws on division by zero
+Decimal divide(const Decimal& a, const Decimal& b, int scale);
+
+// Remainder of truncated integer division, a - trunc(a / b) * b
+Decimal modulo(const Decimal& a, const Decimal& b);
+
+// Integer powers are exact up to the bc result scale; other exponents go
+// through exp(y * ln(x))
+Decimal power(const Decimal& x, const Decimal& y, int scale);
+
+// bc math library (bc -l) functions, computed the way lib.bc does
+Decimal sqrt(const Decimal& x, int scale);
+Decimal exp(const Decimal& x, int scale);
+Decimal ln(const Decimal& x, int scale);
+Decimal sin(const Decimal& x, int scale);
+Decimal cos(const Decimal& x, int scale);
+Decimal atan(const Decimal& x, int scale);
+Decimal bessel(const Decimal& n, const Decimal& x, int scale);
+
+} // namespace calc
+} // namespace neoneo
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "decimal.hpp"
+
+namespace neoneo {
+namespace calc {
+
+enum class OpCode : uint8_t {
+    Constant,      // Push constants[arg]
+    Pi,            // Push pi at the current precision
+    Load,          // Push variables[arg]
+    Store,         // variables[arg] = top (value stays on the stack)
+    Pop,
+    Print,         // Pop and append to the output
+    Add, Subtract, Multiply, Divide, Modulo, Power,
+    Negate, Not,
+    Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual,
+    Truth,         // Replace top with 0 or 1
+    Jump,          // Continue at arg
+    JumpIfZero,    // Pop, continue at arg if it was zero
+    JumpIfNonZero, // Pop, continue at arg if it was not zero
+    Call,          // Call function arg >> 8 with (arg & 0xff) arguments
+};
+
+enum class Function : uint8_t {
+    Sqrt, Sin, Cos, Tan, Atan, Ln, Exp, Bessel, Abs, Length, Scale,
+};
+
+struct Instruction {
+    OpCode op;
+    uint32_t arg = 0;
+};
+
+// Bytecode for a bc-style program: statements separated by ';' or newlines,
+// each either an assignment or an expression whose value is printed
+struct Program {
+    std::vector<Instruction> code;
+    std::vector<std::string> constants; // Numeric literals as written
+    std::vector<double> numbers;        // The same literals as doubles
+    std::vector<std::string> variables; // Slot 0 is bc's scale
+    size_t max_stack = 0;
+    bool uses_scale = false;            // Reads or writes scale, or calls scale()/length()
+    size_t max_literal_digits = 0;      // Most significant digits in any literal
+    bool literal_out_of_range = false;  // Some literal overflows or underflows a double
+};
+
+enum class Backend {
+    Auto,    // Doubles, switching to Decimal when they can not represent the result
+    Double,
+    Decimal,
+};
+
+// Bounds on the work an expression may ask for
+struct Limits {
+    int max_scale = 1000;      // Largest scale (fraction digits) accepted
+    size_t max_digits = 10000; // Largest number of integer digits in any value
+};
+
+struct EvalOptions {
+    Backend backend = Backend::Auto;
+    std::optional<int> scale; // Initial scale, forces the Decimal backend (bc -l uses 20)
+    Limits limits;
+};
+
+struct EvalResult {
+    std::string output;       // One printed value per line
+    Backend backend = Backend::Double;
+};
+
+// Parse and compile source; throws CalcError with the position on syntax errors
+Program compile(const std::string& source);
+
+// Run a compiled program; throws CalcError on math errors or exceeded limits
+EvalResult evaluate(const Program& program, const EvalOptions& options = {});
+
+// Compile and run source
+EvalResult evaluate(const std::string& source, const EvalOptions& options = {});
+
+} // namespace calc
+} // namespace neoneo
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace neoneo {
+namespace calc {
+
+// Aggregates of a numeric dataset
+struct Summary {
+    size_t count = 0;
+    double sum = 0.0;
+    double mean = 0.0;
+    double variance = 0.0; // Sample variance (n - 1), 0 for fewer than two values
+    double stddev = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+// Count, sum, mean, variance, min and max in a single pass.
+// Uses SSE2 kernels where the target has them and a scalar loop otherwise.
+Summary summarize(const double* data, size_t count);
+
+// Percentiles (0-100) with linear interpolation between the closest ranks.
+// Selects each needed rank with nth_element instead of sorting, so data is
+// reordered.
+std::vector<double> percentiles(std::vector<double>& data, const std::vector<double>& ranks);
+
+// Counts per equal-width bin over [min, max]; max falls into the last bin
+std::vector<size_t> histogram(const double* data, size_t count, double min, double max, size_t bins);
+
+} // namespace calc
+} // namespace neoneo
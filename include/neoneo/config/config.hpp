@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+
+namespace neoneo {
+namespace config {
+
+// Application configuration, persisted as JSON
+class Config {
+public:
+    Config();
+
+    // Factory helpers
+    static Config load_from_path(const std::string& path);
+    static Config create_default();
+
+    // Persistence
+    bool load_from_file(const std::string& path);
+    bool save_to_file(const std::string& path) const;
+    static std::string get_default_config_path();
+
+    // JSON conversion
+    nlohmann::json to_json() const;
+    static Config from_json(const nlohmann::json& json);
+
+    // Connection settings
+    const std::string& get_model() const { return model; }
+    void set_model(const std::string& value) { model = value; }
+    const std::string& get_host() const { return host; }
+    void set_host(const std::string& value) { host = value; }
+
+    // Feature toggles
+    bool is_tools_enabled() const { return enable_tools; }
+    void set_tools_enabled(bool value) { enable_tools = value; }
+    bool is_debug_mode() const { return debug_mode; }
+    void set_debug_mode(bool value) { debug_mode = value; }
+    bool is_shell_enabled() const { return enable_shell; }
+    void set_shell_enabled(bool value) { enable_shell = value; }
+    bool is_model_list_enabled() const { return enable_model_list; }
+    void set_model_list_enabled(bool value) { enable_model_list = value; }
+    bool is_file_ops_enabled() const { return enable_file_ops; }
+    void set_file_ops_enabled(bool value) { enable_file_ops = value; }
+    bool is_search_index_enabled() const { return enable_search_index; }
+    void set_search_index_enabled(bool value) { enable_search_index = value; }
+
+    // Confirmation and safety settings
+    bool is_auto_confirm_shell() const { return auto_confirm_shell; }
+    void set_auto_confirm_shell(bool value) { auto_confirm_shell = value; }
+    bool is_auto_confirm_file_ops() const { return auto_confirm_file_ops; }
+    void set_auto_confirm_file_ops(bool value) { auto_confirm_file_ops = value; }
+    bool is_calc_safety_ignored() const { return ignore_calc_safety; }
+    void set_calc_safety_ignored(bool value) { ignore_calc_safety = value; }
+    bool is_shell_safety_ignored() const { return ignore_shell_safety; }
+    void set_shell_safety_ignored(bool value) { ignore_shell_safety = value; }
+    // Extra rules for the shell command policies (see process/command_policy.hpp)
+    const std::vector<std::string>& get_shell_policy_rules() const { return shell_policy_rules; }
+    void add_shell_policy_rule(const std::string& rule) { shell_policy_rules.push_back(rule); }
+
+    // Conversation context settings
+    int get_tool_output_max_age() const { return tool_output_max_age; }
+    void set_tool_output_max_age(int value) { tool_output_max_age = value; }
+    size_t get_tool_output_max_bytes() const { return tool_output_max_bytes; }
+    void set_tool_output_max_bytes(size_t value) { tool_output_max_bytes = value; }
+    bool is_tool_output_reduced() const { return reduce_tool_output; }
+    void set_tool_output_reduced(bool value) { reduce_tool_output = value; }
+    bool is_tool_memo_enabled() const { return memoize_tools; }
+    void set_tool_memo_enabled(bool value) { memoize_tools = value; }
+
+    const std::string& get_config_file_path() const { return config_file_path; }
+
+private:
+    std::string model = "llama3";
+    std::string host = "http://localhost:11434";
+    bool enable_tools = false;
+    bool debug_mode = false;
+    bool enable_shell = false;
+    bool auto_confirm_shell = false;
+    bool enable_model_list = false;
+    bool enable_file_ops = false;
+    bool auto_confirm_file_ops = false;
+    bool enable_search_index = false;     // Keep a trigram index of the working directory for search
+    bool ignore_calc_safety = false;
+    bool ignore_shell_safety = false;
+    std::vector<std::string> shell_policy_rules;
+    int tool_output_max_age = 3;          // Turns before a tool output is stubbed (0 = never)
+    size_t tool_output_max_bytes = 16384; // Outputs above this are stubbed after one turn (0 = never)
+    bool reduce_tool_output = true;       // Strip escapes and collapse repeated lines in command output
+    bool memoize_tools = false;           // Answer repeated read-only tool calls from earlier results
+    std::string config_file_path;
+};
+
+} // namespace config
+} // namespace neoneo
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace neoneo {
+namespace conversation {
+
+// What reduce_output may do to a tool output
+struct ReductionOptions {
+    bool strip_control = true;     // Drop ANSI escape sequences and other control characters
+    bool collapse_progress = true; // Keep only what a carriage return leaves of a line, as a terminal would
+    size_t min_run = 3;            // Collapse runs of this many identical or near-identical lines (0 = never)
+    size_t max_bytes = 0;          // Past this, keep the head, the tail and lines around errors (0 = no limit)
+    size_t context_lines = 3;      // Lines kept before and after each error line
+};
+
+// What reduce_output did
+struct ReductionStats {
+    size_t input_bytes = 0;
+    size_t output_bytes = 0;
+    size_t escapes_removed = 0;     // Escape sequences and control characters
+    size_t progress_updates = 0;    // Line contents overwritten after a carriage return
+    size_t lines_collapsed = 0;     // Repeated or near-identical lines replaced by a note
+    size_t lines_omitted = 0;       // Lines dropped to fit max_bytes
+
+    size_t saved_bytes() const { return input_bytes > output_bytes ? input_bytes - output_bytes : 0; }
+};
+
+// Shrink command output (build logs, test runs, listings) before the model
+// sees it. Lines are cleaned of escape sequences and progress updates as
+// they are read, using SSE2 to skip over the plain bytes between control
+// characters. Consecutive lines that are equal, or equal once runs of
+// digits and hex are masked ("frame 0x7f3a at line 120"), collapse to the
+// first one, a count and the last one. Only then, if the result is still
+// over max_bytes, lines away from the head, the tail and anything that
+// looks like an error are left out, with a note of how many.
+std::string reduce_output(std::string_view text, const ReductionOptions& options, ReductionStats& stats);
+
+} // namespace conversation
+} // namespace neoneo
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../../ollama_client.hpp"
+
+namespace neoneo {
+namespace conversation {
+
+// Policy deciding when a tool output in the conversation is replaced by a stub
+struct AgingPolicy {
+    int max_age_turns = 3;     // Stub outputs this many turns old (0 disables)
+    size_t max_bytes = 16384;  // Stub larger outputs once their turn has passed (0 disables)
+    size_t head_bytes = 512;   // Bytes of the original kept at the start of a stub
+    size_t tail_bytes = 512;   // Bytes of the original kept at the end of a stub
+    // Full text of stubbed outputs kept for /output; past this the least
+    // recently used are dropped (0 = no limit)
+    size_t archive_bytes = 64 * 1024 * 1024;
+
+    // Whether an output of size bytes, age turns old, is due to be stubbed
+    bool is_aged(int age, size_t size) const;
+};
+
+// Full tool output kept locally after it has been stubbed in the conversation
+struct ArchivedOutput {
+    size_t id = 0;
+    std::string tool_name;
+    int turn = 0;
+    std::string content;
+    size_t size = 0;        // Of the content, also once it has been evicted
+    uint64_t hash = 0;
+    bool stubbed = false;
+    bool evicted = false;   // Content dropped to keep the archive within archive_bytes
+    uint64_t last_used = 0; // When it was stubbed or last looked up
+};
+
+// Deterministically ages tool outputs out of the conversation.
+//
+// Tool messages are matched to archived outputs by their order in the
+// conversation: the n-th tool message is the n-th tracked output. The
+// conversation only ever appends tool messages, and reset() is called
+// whenever it is cleared, so the two stay in step.
+class ToolOutputAging {
+public:
+    explicit ToolOutputAging(AgingPolicy policy = {});
+
+    // Advance the turn counter (one turn per user message)
+    void begin_turn();
+    int current_turn() const { return turn; }
+
+    // Record a tool response that was just appended to the conversation, returns its id
+    size_t track(const ChatMessage& message);
+
+    // Replace aged tool outputs with stubs, returns the number of bytes removed
+    size_t apply(std::vector<ChatMessage>& conversation);
+
+    // Look up the full output for an id, nullptr if unknown; check evicted
+    // before using the content. Counts as a use for the archive limit.
+    const ArchivedOutput* find(size_t id);
+
+    // Forget all tracked outputs (conversation was cleared)
+    void reset();
+
+    const AgingPolicy& get_policy() const { return policy; }
+
+    // 64-bit FNV-1a hash used to identify outputs
+    static uint64_t hash_content(const std::string& content);
+
+private:
+    bool is_aged(const ArchivedOutput& output) const;
+    std::string make_stub(const ArchivedOutput& output) const;
+    void evict_to_fit();
+
+    AgingPolicy policy;
+    int turn = 0;
+    std::vector<ArchivedOutput> outputs;
+    size_t archived_bytes = 0; // Content of stubbed outputs not yet evicted
+    uint64_t uses = 0;
+};
+
+} // namespace conversation
+} // namespace neoneo
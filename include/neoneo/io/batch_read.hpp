@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace neoneo {
+namespace io {
+
+struct FileContent {
+    std::string path;
+    std::string data;       // The file, or its first bytes when truncated
+    uint64_t size = 0;      // Size of the whole file
+    bool truncated = false; // data stops short of the end of the file
+    bool binary = false;    // Contains NUL bytes; data is left empty
+    std::string error;      // Set if the file could not be read
+};
+
+class ContentCache;
+
+// Read the start of every file concurrently. Each file gets at most
+// per_file bytes and the batch at most total bytes, handed out in the
+// order of paths, so the result does not depend on which read finishes
+// first. Files are opened and sized in one parallel pass and read with
+// pread into exactly sized buffers in a second. With a cache, files are
+// taken from it (and kept in it) instead.
+std::vector<FileContent> read_batch(const std::vector<std::string>& paths, size_t per_file, size_t total,
+                                    ContentCache* cache = nullptr);
+
+} // namespace io
+} // namespace neoneo
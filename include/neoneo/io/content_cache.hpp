@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+#include "mapped_file.hpp"
+
+namespace neoneo {
+namespace io {
+
+// Mappings of recently used files, shared by the tools for a session so
+// that reading a file again costs no open or page faults. Files are kept
+// by their real path, so symlinks resolve to the file they point at, and
+// each is kept until inotify reports a change to its name in its
+// directory. Files with other hard links, and files without a watch
+// (usually the inotify limit), have their device, inode, mtime and size
+// checked with a stat instead. Bounded by the total size of the
+// files kept; a file over a quarter of that is mapped but not kept. Safe to
+// use from several threads.
+class ContentCache {
+public:
+    explicit ContentCache(uint64_t max_bytes = 256ull * 1024 * 1024);
+    ~ContentCache();
+    ContentCache(const ContentCache&) = delete;
+    ContentCache& operator=(const ContentCache&) = delete;
+
+    // The file's content, mapped and kept if it was not already. Returns
+    // nullptr and sets error if path can not be opened or mapped.
+    std::shared_ptr<const MappedFile> open(const std::string& path, std::string& error);
+
+    // The file's content only if it is kept and unchanged; never reads
+    std::shared_ptr<const MappedFile> find(const std::string& path);
+
+    // Path was just written through the tools: replace what is kept with
+    // the new file, instead of dropping it, so the next read is a hit
+    void refresh(const std::string& path);
+
+    void erase(const std::string& path);
+    void clear();
+
+    uint64_t get_cached_bytes() const;
+
+private:
+    struct Cached {
+        std::shared_ptr<const MappedFile> file;
+        int watch = -1;   // On the directory; -1 means check with stat
+        std::string name; // Within that directory
+        bool linked = false; // Has other hard links, which the watch does not see; check with stat
+        uint64_t last_used = 0;
+        std::vector<std::string> aliases; // Other paths open() was given for the file
+    };
+
+    struct Watch {
+        std::vector<std::string> keys; // Kept files in the directory
+        size_t loading = 0;            // Files in it being mapped right now
+        bool alive = true;             // False once inotify dropped it
+    };
+
+    // Map the file and keep it; mutex must not be held
+    std::shared_ptr<const MappedFile> load(const std::string& key, std::string& error);
+    // Drop the files inotify reported changes to; mutex must be held
+    void drain_events();
+    void remove(const std::string& key);
+    // Remove the watch once nothing in its directory is kept or loading
+    void release(int watch);
+    bool unchanged(const std::string& key, const Cached& cached) const;
+    // Remember path as another name of a kept file, so find() can skip realpath; mutex must be held
+    void add_alias(const std::string& path, const std::string& key);
+
+    mutable std::mutex mutex;
+    int inotify_fd = -1;
+    std::unordered_map<std::string, Cached> entries; // Real path -> content
+    std::unordered_map<std::string, std::string> aliases; // Normalized path -> real path
+    std::unordered_map<int, Watch> watches;
+    uint64_t max_bytes;
+    uint64_t cached_bytes = 0;
+    uint64_t use_counter = 0;
+};
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "piece_table.hpp"
+
+namespace neoneo {
+namespace io {
+
+struct UnifiedDiff {
+    std::string text;       // "--- a/path", "+++ b/path" and the hunks
+    size_t added = 0;       // Lines
+    size_t removed = 0;
+    bool truncated = false; // text stops after max_lines; the counts are still complete
+};
+
+// Unified diff of original against original with changes applied (as
+// returned by PieceTable::changes), with context lines around each hunk.
+// Only the lines around the changes are looked at, so the cost depends on
+// the size of the changes rather than of the file. Hunk line numbers count
+// from first_line, for when original is a slice of a longer file.
+UnifiedDiff unified_diff(const std::string& path, std::string_view original, const std::vector<TextChange>& changes,
+                         size_t context = 3, size_t max_lines = 400, size_t first_line = 1);
+
+// The changes turning before into after, whole lines at a time, found with
+// Myers' algorithm after the common first and last lines are set aside. If
+// more than max_distance lines would have to be removed and added, what is
+// left between the common lines is given as one change instead.
+std::vector<TextChange> line_changes(std::string_view before, std::string_view after, size_t max_distance = 1000);
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "piece_table.hpp"
+
+namespace neoneo {
+namespace io {
+
+// Replacements and removals of several files that take effect together.
+// New contents are first written to temporary files next to their targets
+// and flushed to disk; commit then renames them all into place, keeping a
+// hard link to each old file so that a failure part way through can put
+// back the files already replaced. Symlinks are followed.
+class FileTransaction {
+public:
+    FileTransaction() = default;
+    ~FileTransaction(); // Deletes whatever was staged but not committed
+    FileTransaction(const FileTransaction&) = delete;
+    FileTransaction& operator=(const FileTransaction&) = delete;
+
+    // Write content to a temporary file that will replace path, keeping
+    // the permissions and owner of the file it replaces; a file we may not
+    // write, or whose owner could not be kept, is refused. A new file takes
+    // the permissions of mode_from when given (the source of a rename),
+    // else the umask's.
+    // Missing directories are created, and removed again unless the
+    // transaction commits.
+    bool stage(const std::string& path, const PieceTable& content, std::string& error,
+               const std::string& mode_from = "");
+
+    // Delete path on commit
+    void remove(const std::string& path);
+
+    // Apply everything staged; on failure every file is left as it was
+    bool commit(std::string& error);
+
+private:
+    struct Entry {
+        std::string path;      // As given, for messages
+        std::string target;    // With symlinks resolved
+        std::string temporary; // New content; empty for a removal
+        std::string backup;    // Link to the replaced file while committing
+        bool existed = false;
+        bool done = false;
+    };
+
+    bool make_parents(const std::string& target, std::string& error);
+    void roll_back();
+
+    std::vector<Entry> entries;
+    std::vector<std::string> created_directories; // Outermost first
+};
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace neoneo {
+namespace io {
+
+// True if pattern contains glob metacharacters (* ? [)
+bool has_glob_chars(std::string_view pattern);
+
+// Match a '/' separated path against a shell pattern. '*', '?' and '[...]'
+// do not cross '/'; a "**" component matches any number of directories.
+// Wildcards only match names starting with '.' when hidden is set.
+bool glob_match(std::string_view pattern, std::string_view path, bool hidden = false);
+
+// Regular files matching pattern, sorted, at most max_results of them:
+// the first ones in sorted order. Hidden files and directories are only
+// matched by patterns that name them explicitly (".github/**/*.yml",
+// "**/.env"). truncated is set when more matches were found, or when a
+// "**" walk gave up before visiting every directory.
+std::vector<std::string> expand_glob(const std::string& pattern, size_t max_results, bool& truncated);
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace neoneo {
+namespace io {
+
+// The .gitignore rules in effect for one directory: its own file layered
+// over those of its parents. Lists are immutable once built, so a walk can
+// share a parent's list between threads and extend it per directory.
+class IgnoreList {
+public:
+    // Rules from directory/.gitignore over parent. base is the directory
+    // relative to the walk root ("" or ending in '/'). Returns parent when
+    // the directory has no .gitignore.
+    static std::shared_ptr<const IgnoreList> load(const std::string& directory, const std::string& base,
+                                                  std::shared_ptr<const IgnoreList> parent);
+
+    // Rules parsed from text in gitignore syntax
+    static std::shared_ptr<const IgnoreList> parse(std::string_view text, const std::string& base,
+                                                   std::shared_ptr<const IgnoreList> parent);
+
+    // True if a path relative to the walk root is ignored. The last matching
+    // rule wins and the rules of deeper directories are checked first.
+    bool is_ignored(std::string_view path, bool is_directory) const;
+
+private:
+    struct Rule {
+        std::string pattern;
+        bool negated = false;
+        bool directory_only = false;
+        bool anchored = false; // Matched against the path below base, not just the name
+    };
+
+    std::string base;
+    std::vector<Rule> rules;
+    std::shared_ptr<const IgnoreList> parent;
+};
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+
+namespace neoneo {
+namespace io {
+
+enum class EntryType : uint8_t { File, Directory, Symlink, Other };
+
+struct DirectoryEntry {
+    std::string name;
+    EntryType type = EntryType::Other;
+    uint64_t size = 0;     // Only with metadata
+    int64_t mtime_ns = 0;  // Only with metadata
+    std::string target;    // Where a symlink points
+};
+
+using DirectoryEntries = std::vector<DirectoryEntry>;
+
+// Directory contents read with getdents64, kept until inotify reports a
+// change inside the directory (or it is replaced), so listing the same
+// tree again costs a stat per directory instead of a read of every entry.
+// Safe to use from several threads.
+class DirectoryCache {
+public:
+    explicit DirectoryCache(size_t max_directories = 4096);
+    ~DirectoryCache();
+    DirectoryCache(const DirectoryCache&) = delete;
+    DirectoryCache& operator=(const DirectoryCache&) = delete;
+
+    // Entries of directory path sorted by name, without . and .. but with
+    // everything else. size and mtime are filled in when metadata is set.
+    // Returns nullptr and sets error if path can not be read.
+    std::shared_ptr<const DirectoryEntries> read(const std::string& path, bool metadata, std::string& error);
+
+    void clear();
+
+private:
+    struct Cached {
+        std::shared_ptr<const DirectoryEntries> entries;
+        bool metadata = false;
+        int watch = -1;
+        uint64_t last_used = 0;
+    };
+
+    // Drop the directories inotify reported changes in; mutex must be held
+    void drain_events();
+    void evict_oldest();
+
+    // Directories are keyed by inode, so renames and aliases need no special care
+    using Key = std::pair<dev_t, ino_t>;
+
+    std::mutex mutex;
+    int inotify_fd = -1;
+    std::map<Key, Cached> entries;
+    std::unordered_map<int, Key> watched;          // Watch descriptor -> directory
+    std::unordered_map<int, uint64_t> generations; // Watch descriptor -> events seen
+    size_t max_directories;
+    uint64_t use_counter = 0;
+};
+
+struct ListOptions {
+    size_t max_depth = 1;           // 1 lists only the entries of the root itself
+    size_t max_entries = 500;       // Entries returned
+    std::string glob;               // Only files whose name (or path, if it has a '/') matches
+    bool hidden = false;            // Include names starting with '.' (never .git)
+    bool ignored = false;           // Include what .gitignore files exclude
+    bool metadata = false;          // Fill in size and mtime
+    size_t threads = 0;             // 0 picks one per core
+};
+
+struct ListedEntry {
+    std::string path;               // Relative to the listed directory
+    EntryType type = EntryType::Other;
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    std::string target;
+};
+
+struct ListResult {
+    std::vector<ListedEntry> entries; // Sorted by path, cut to max_entries
+    size_t directories = 0;           // Counted over all entries found
+    size_t files = 0;
+    size_t others = 0;
+    bool truncated = false;           // More entries than max_entries were found
+    bool incomplete = false;          // The walk stopped at its hard limit, so the counts are lower bounds
+};
+
+// List the tree below the directory root down to max_depth, walking
+// subdirectories in parallel and reading each through cache. Symlinks are
+// listed but not followed. Directories are listed only without a glob, but
+// are always descended. Returns false and sets error if root is not a
+// readable directory.
+bool list_directory(const std::string& root, const ListOptions& options, DirectoryCache& cache,
+                    ListResult& result, std::string& error);
+
+} // namespace io
+} // namespace neoneo
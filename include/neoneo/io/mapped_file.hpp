@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+
+namespace neoneo {
+namespace io {
+
+// Read-only memory mapping of a whole regular file.
+// Mapping is O(1); only the pages that are touched are read from disk.
+class MappedFile {
+public:
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns nullptr and sets error if the file can not be opened or mapped
+    static std::unique_ptr<MappedFile> open(const std::string& path, std::string& error);
+
+    const char* data() const { return bytes; }
+    uint64_t size() const { return length; }
+    std::string_view view() const { return {bytes, static_cast<size_t>(length)}; }
+
+    // Identity used to key caches: a changed mtime or size means new content
+    dev_t get_device() const { return device; }
+    ino_t get_inode() const { return inode; }
+    int64_t get_mtime_ns() const { return mtime_ns; }
+
+private:
+    MappedFile() = default;
+
+    const char* bytes = "";
+    uint64_t length = 0;
+    bool mapped = false;
+    dev_t device = 0;
+    ino_t inode = 0;
+    int64_t mtime_ns = 0;
+};
+
+// Sparse index of line start offsets, one checkpoint every STRIDE lines.
+// It is extended lazily, only as far as the lines that have been asked for,
+// so reading the first lines of a huge file never scans the rest of it.
+struct LineIndex {
+    static constexpr uint64_t STRIDE = 64;
+
+    std::vector<uint64_t> checkpoints{0}; // Offset of line k * STRIDE (0-based)
+    uint64_t scanned_to = 0;              // Bytes scanned for newlines so far
+    uint64_t lines_found = 1;             // Line starts found in the scanned bytes
+    bool complete = false;                // Whole file scanned; lines_found is the line count
+};
+
+// Line indexes for recently read files, keyed on device and inode and
+// invalidated when the file's mtime or size changes
+class LineIndexCache {
+public:
+    explicit LineIndexCache(size_t max_files = 64);
+
+    // Byte offset where a 0-based line starts, or nullopt past the last line
+    std::optional<uint64_t> line_offset(const MappedFile& file, uint64_t line);
+
+    // Total number of lines if the whole file has been indexed
+    std::optional<uint64_t> line_count(const MappedFile& file);
+
+    // Index the rest of the file and return its line count
+    uint64_t count_lines(const MappedFile& file);
+
+    void clear();
+
+private:
+    struct Entry {
+        LineIndex index;
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+        uint64_t last_used = 0;
+    };
+
+    Entry& entry_for(const MappedFile& file);
+    static void extend(const MappedFile& file, LineIndex& index, uint64_t line);
+
+    std::mutex mutex;
+    std::map<std::pair<dev_t, ino_t>, Entry> entries;
+    size_t max_files;
+    uint64_t use_counter = 0;
+};
+
+// Offset just past count complete lines starting at offset, looking no
+// further than max_bytes. Stops early at the end of the data or at the
+// last line that fits the budget; lines_skipped receives the number of
+// complete lines passed. If not even one line fits, returns the budget end.
+uint64_t skip_lines(std::string_view data, uint64_t offset, uint64_t count, uint64_t max_bytes,
+                    uint64_t& lines_skipped);
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace neoneo {
+namespace io {
+
+// Worker count for I/O bound batches: blocking syscalls overlap well past
+// the core count, but more threads than items is pointless
+inline size_t io_threads(size_t items, size_t max_threads = 16) {
+    size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    return std::max<size_t>(1, std::min({items, max_threads, cores * 4}));
+}
+
+// Call fn(i) for every i in [0, count) on up to threads threads.
+// Items are handed out one at a time so slow items do not hold up a whole
+// share. Runs inline when one thread is enough; fn must not throw.
+template <typename Fn>
+void parallel_for(size_t count, size_t threads, Fn&& fn) {
+    threads = std::min(threads, count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            fn(i);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t t = 1; t < threads; ++t) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+}
+
+} // namespace io
+} // namespace neoneo
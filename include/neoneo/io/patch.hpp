@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "piece_table.hpp"
+
+namespace neoneo {
+namespace io {
+
+// One line of a hunk; text points into the patch and has no newline
+struct PatchLine {
+    char kind = ' '; // ' ' context, '-' removed, '+' added
+    std::string_view text;
+    bool newline = true; // False when followed by "\ No newline at end of file"
+};
+
+struct Hunk {
+    uint64_t old_start = 0; // From the "@@ -old_start,old_count +new_start,new_count @@" header
+    uint64_t old_count = 0;
+    uint64_t new_start = 0;
+    uint64_t new_count = 0;
+    bool numbered = true; // False for a bare "@@": placed after the previous hunk
+    std::vector<PatchLine> lines;
+};
+
+// The changes to one file; "/dev/null" as old_path creates it, as new_path deletes it
+struct FilePatch {
+    std::string old_path; // As written, without any timestamp
+    std::string new_path;
+    std::vector<Hunk> hunks;
+};
+
+// Split a unified diff into its files and hunks. Text around the diff
+// (explanations, code fences, git's extended headers) is skipped, and the
+// line counts in hunk headers are not trusted, since hand-written diffs
+// often get them wrong.
+bool parse_patch(std::string_view text, std::vector<FilePatch>& patches, std::string& error);
+
+// Where a hunk was applied
+struct HunkPlacement {
+    uint64_t line = 0;       // 1-based line of the original the hunk starts at
+    int64_t offset = 0;      // Lines from where its header said it would be
+    size_t fuzz = 0;         // Context lines left unmatched at each end
+    bool whitespace = false; // Matched only when ignoring differences in whitespace
+};
+
+// Apply hunks, in order, to content, a PieceTable over original. Each hunk
+// is looked for at its header's line, adjusted by the offset of the hunk
+// before it, then further and further away in both directions; failing
+// that, ignoring whitespace and then with up to max_fuzz context lines
+// dropped from either end. The original is walked line by line, never
+// indexed or copied, so large files cost little memory. On failure error
+// names the hunk and content is left unchanged.
+bool apply_hunks(std::string_view original, const std::vector<Hunk>& hunks, PieceTable& content,
+                 std::vector<HunkPlacement>& placements, std::string& error, size_t max_fuzz = 2);
+
+} // namespace io
+} // namespace neoneo
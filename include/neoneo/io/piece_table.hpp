@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace neoneo {
+namespace io {
+
+// A difference from the original: length bytes at offset were replaced by text
+struct TextChange {
+    uint64_t offset = 0;
+    uint64_t length = 0;
+    std::string text;
+};
+
+// Editable view of a document that never copies it: the text is a list of
+// pieces, each a span of either the unchanged original (usually a
+// MappedFile, which must outlive the table) or an append-only buffer of
+// inserted text. An edit only splits the pieces around it, so its cost is
+// independent of the document size, and saving streams the pieces out once.
+class PieceTable {
+public:
+    explicit PieceTable(std::string_view original);
+
+    uint64_t size() const { return length; }
+
+    // Offset of the first occurrence of needle at or after from
+    std::optional<uint64_t> find(std::string_view needle, uint64_t from = 0) const;
+
+    // Offset where a 0-based line starts, or nullopt if the document has
+    // fewer lines. A final line without a newline still counts.
+    std::optional<uint64_t> line_offset(uint64_t line) const;
+
+    // Edits take offsets into the current text and are clamped to its size
+    void insert(uint64_t offset, std::string_view text);
+    void erase(uint64_t offset, uint64_t count);
+    void replace(uint64_t offset, uint64_t count, std::string_view text);
+
+    // Replace every non-overlapping occurrence of needle in one pass over
+    // the pieces, so many matches cost no more than one; returns how many
+    size_t replace_every(std::string_view needle, std::string_view text);
+
+    // Byte at offset, which must be less than size()
+    char at(uint64_t offset) const;
+
+    // Call fn(std::string_view) for each span of the text in order
+    template <typename Fn>
+    void for_each_span(Fn&& fn) const {
+        for (const auto& piece : pieces) {
+            fn(span_of(piece));
+        }
+    }
+
+    // The whole text, for small documents and tests
+    std::string str() const;
+
+    // How the text differs from the original, in order of offset. Found
+    // from the pieces alone, so it costs nothing for unedited stretches.
+    std::vector<TextChange> changes() const;
+
+    // Replace path with the text: written to a temporary file next to it
+    // (keeping its permissions), flushed to disk and renamed over it, so a
+    // crash leaves either the old or the new file, never a truncated one.
+    // Symlinks are followed, so the file they point to is replaced.
+    bool save(const std::string& path, std::string& error) const;
+
+private:
+    struct Piece {
+        bool added = false; // In added rather than original
+        uint64_t start = 0;
+        uint64_t length = 0;
+    };
+
+    std::string_view span_of(const Piece& piece) const;
+    // Split so that a piece boundary falls at offset; returns the index of the piece starting there
+    size_t split(uint64_t offset);
+
+    std::string_view original;
+    std::string added;
+    std::vector<Piece> pieces;
+    uint64_t length = 0;
+};
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace neoneo {
+namespace io {
+
+class ContentCache;
+
+struct SearchOptions {
+    std::string pattern;
+    bool regex = false;               // POSIX extended regex instead of a literal
+    bool ignore_case = false;
+    std::string glob;                 // Only files whose name (or path, if it has a '/') matches
+    size_t max_matches = 100;         // Matches returned over all files
+    size_t max_per_file = 10;         // Matches returned from any one file
+    uint64_t max_file_size = 16 * 1024 * 1024;
+    size_t threads = 0;               // 0 picks one per core
+    ContentCache* cache = nullptr;    // Files kept there are searched without reading them again
+};
+
+struct LineMatch {
+    uint64_t line = 0;  // 1-based
+    std::string text;   // The matching line, cut to a few hundred bytes
+    int score = 0;
+};
+
+struct FileMatches {
+    std::string path;
+    std::vector<LineMatch> lines; // The first max_per_file matching lines
+    size_t count = 0;             // All matching lines in the file
+    int score = 0;
+};
+
+struct SearchResult {
+    std::vector<FileMatches> files; // Best files first, cut to max_matches lines in total
+    size_t total_matches = 0;       // Matching lines found, including those not returned
+    size_t files_searched = 0;
+    size_t binary_skipped = 0;
+    size_t large_skipped = 0;
+    bool stopped_early = false;     // Enough matches were found to stop walking
+};
+
+// Search the files below root (or root itself, if it is a file) in parallel.
+// Hidden entries and anything ignored by the .gitignore files from the
+// enclosing repository down are skipped, as are binary files. Files are
+// ranked by how likely they are to be what was looked for: whole-word
+// matches, definitions and matching file names score higher.
+// Returns false and sets error for a bad pattern or root.
+bool search(const std::string& root, const SearchOptions& options, SearchResult& result, std::string& error);
+
+// Search only the given files, named relative to root (like the candidates
+// of a TrigramIndex), instead of walking root. The glob still applies.
+bool search_files(const std::string& root, const std::vector<std::string>& files, const SearchOptions& options,
+                  SearchResult& result, std::string& error);
+
+// A literal that every match of an extended regex must contain, or "" if
+// none can be proven. Only runs outside groups and brackets count, and a
+// top-level alternation gives up, which keeps this simple and always safe.
+std::string required_literal(const std::string& pattern);
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "mapped_file.hpp"
+
+namespace neoneo {
+namespace io {
+
+// A tool output kept in full after only a summary of it went to the model
+struct SpilledOutput {
+    std::string handle;    // "out-N", what the model asks for it by
+    std::string tool_name;
+    std::string name;      // File name within the store's directory
+    std::shared_ptr<const MappedFile> file;
+};
+
+// Full tool outputs kept for the session in files under a private
+// temporary directory and read back through memory mappings, so even
+// very large ones cost no heap. Past max_bytes the oldest are removed;
+// an output still being read stays mapped until its reader is done. The
+// directory is deleted with the store. Safe to use from several threads.
+class SpillStore {
+public:
+    explicit SpillStore(uint64_t max_bytes = 1024ull * 1024 * 1024);
+    ~SpillStore();
+    SpillStore(const SpillStore&) = delete;
+    SpillStore& operator=(const SpillStore&) = delete;
+
+    // Keep content and return it as stored, or nullptr with error set
+    std::shared_ptr<const SpilledOutput> put(const std::string& tool_name, std::string_view content,
+                                             std::string& error);
+
+    // nullptr if there is no such handle, or it was removed to stay in budget
+    std::shared_ptr<const SpilledOutput> find(const std::string& handle) const;
+
+    // Empty until the first output is stored
+    std::string get_directory() const;
+
+    void clear();
+
+private:
+    bool create_directory(std::string& error);
+    void remove(std::map<uint64_t, std::shared_ptr<const SpilledOutput>>::iterator it);
+
+    mutable std::mutex mutex;
+    std::string directory;
+    std::map<uint64_t, std::shared_ptr<const SpilledOutput>> outputs; // By number, so oldest first
+    uint64_t max_bytes;
+    uint64_t stored_bytes = 0;
+    uint64_t next_number = 1;
+};
+
+} // namespace io
+} // namespace neoneo
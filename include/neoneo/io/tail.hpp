@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace neoneo {
+namespace io {
+
+// Number of '\n' bytes in [data, data + size).
+// Uses SSE2 where the target has it and memchr otherwise.
+uint64_t count_newlines(const char* data, size_t size);
+
+// Offset where the last count lines of data start. A trailing newline ends
+// the last line rather than starting an empty one. The data is scanned
+// backwards from the end in large blocks, so the cost depends on the size
+// of the tail rather than the size of the file. lines_found receives the
+// number of lines in the tail, which is less than count for short data.
+uint64_t tail_offset(std::string_view data, uint64_t count, uint64_t& lines_found);
+
+// How a follow ended
+enum class FollowEnd {
+    Timeout,   // The time ran out
+    Limit,     // max_bytes of new data were read
+    Truncated, // The file shrank below the offset being followed
+    Replaced,  // The path now names a different file (rotated or deleted)
+    Error,
+};
+
+struct FollowResult {
+    std::string data;    // Bytes appended after the start offset
+    uint64_t offset = 0; // Offset just past the data that was read
+    FollowEnd end = FollowEnd::Timeout;
+    std::string error;
+};
+
+// Wait up to seconds for data appended to path after offset, like tail -f
+// with a deadline. The file is polled and new bytes are read with pread.
+FollowResult follow_file(const std::string& path, uint64_t offset, double seconds, size_t max_bytes);
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "ignore.hpp"
+#include "mapped_file.hpp"
+
+namespace neoneo {
+namespace io {
+
+// On-disk layout of an index file; all integers are native endian
+struct TrigramIndexHeader {
+    char magic[8];            // "NNTRIGR"
+    uint32_t version;
+    uint32_t file_count;
+    uint64_t trigram_count;
+    uint64_t files_offset;    // TrigramIndexFile[file_count], sorted by path
+    uint64_t names_offset;    // Path bytes
+    uint64_t trigrams_offset; // TrigramIndexEntry[trigram_count], sorted by key
+    uint64_t postings_offset; // Per trigram: ascending file ids as varint deltas
+    uint64_t total_size;
+};
+
+// Binary or oversized: listed so a restart knows it is unchanged, but no trigrams
+constexpr uint32_t TRIGRAM_FILE_SKIPPED = 1;
+
+struct TrigramIndexFile {
+    uint64_t name_offset;
+    uint32_t name_length;
+    uint32_t flags;           // TRIGRAM_FILE_SKIPPED
+    uint64_t size;
+    int64_t mtime_ns;
+};
+
+struct TrigramIndexEntry {
+    uint32_t key;   // Three case-folded bytes
+    uint32_t count; // Files containing them
+    uint64_t offset;
+};
+
+// Trigram index of the text files below a directory, for narrowing
+// searches to the files that can match.
+//
+// The index is built on a background thread by a parallel walk that reads
+// every file once, and is saved to index_path as memory-mappable posting
+// lists; a later start only stats the files to find what changed since.
+// inotify watches on every directory keep it current: changed files are
+// remembered and always searched, and a full rebuild runs in the background
+// once there are many changes or the directory structure changes.
+class TrigramIndex {
+public:
+    TrigramIndex(std::string root, std::string index_path);
+    ~TrigramIndex();
+    TrigramIndex(const TrigramIndex&) = delete;
+    TrigramIndex& operator=(const TrigramIndex&) = delete;
+
+    // Start loading or building in the background
+    void start();
+
+    // Files below directory (relative to the root: "" or ending in '/') that
+    // may contain literal, compared without regard to ASCII case, and named
+    // relative to directory. nullopt when the index can not narrow the
+    // search: it is still being built, it may be stale, directory is not
+    // indexed, or literal is shorter than a trigram.
+    std::optional<std::vector<std::string>> candidates(const std::string& literal,
+                                                       const std::string& directory = "") const;
+
+    const std::string& get_root() const { return root; }
+
+    // One line describing the index, for status output
+    std::string describe() const;
+
+    // Default location of the index for root under the user's cache directory
+    static std::string default_index_path(const std::string& root);
+
+private:
+    // A loaded index file
+    struct Snapshot {
+        std::unique_ptr<MappedFile> file;
+        const TrigramIndexHeader* header = nullptr;
+        const TrigramIndexFile* files = nullptr;
+        const TrigramIndexEntry* entries = nullptr;
+
+        std::string path_of(uint32_t id) const;
+        const TrigramIndexEntry* find(uint32_t key) const;
+        void decode(const TrigramIndexEntry& entry, std::vector<uint32_t>& ids) const;
+    };
+
+    // What the watcher knows about a watched directory
+    struct WatchedDirectory {
+        std::string relative; // "" or ending in '/'
+        std::shared_ptr<const IgnoreList> ignores;
+    };
+
+    void run();
+    bool rebuild(bool reuse_existing);
+    void read_events();
+    static std::shared_ptr<const Snapshot> load(const std::string& path);
+
+    std::string root;
+    std::string index_path;
+    std::string ignore_prefix;
+
+    mutable std::mutex mutex;
+    std::shared_ptr<const Snapshot> snapshot;
+    std::unordered_map<std::string, bool> changed; // Relative path -> deleted
+    bool stale = true;                             // Structure changed or watches are missing
+    std::string status = "starting";
+
+    int inotify_fd = -1;
+    std::map<int, WatchedDirectory> watches; // Swapped under mutex; otherwise only the worker touches it
+
+    std::thread worker;
+    std::atomic<bool> stopping{false};
+};
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace neoneo {
+namespace io {
+
+// How sanitize_utf8 writes bytes that are not valid UTF-8
+enum class Utf8Repair {
+    Replace, // U+FFFD for each maximal invalid subpart, as browsers and most decoders do
+    Escape   // \xNN for each invalid byte, so the model can still tell what they were
+};
+
+// Length of the longest prefix of text that is valid UTF-8. Runs of ASCII
+// are skipped 32 bytes at a time with SSE2 where the target has it; other
+// bytes are checked against the well-formed sequences of Unicode table 3-7,
+// so overlong forms, surrogates and code points past U+10FFFF are invalid.
+size_t valid_utf8_prefix(std::string_view text);
+
+inline bool is_valid_utf8(std::string_view text) {
+    return valid_utf8_prefix(text) == text.size();
+}
+
+// Make text valid UTF-8 in place and return the number of invalid
+// sequences that were repaired. Valid text is only scanned, never copied.
+size_t sanitize_utf8(std::string& text, Utf8Repair repair = Utf8Repair::Replace);
+
+// Whether the first probe bytes of data look like binary rather than text:
+// a NUL, or many bytes that are invalid UTF-8 or control characters
+bool looks_binary(std::string_view data, size_t probe = 8192);
+
+// pos, moved back to the start of the UTF-8 sequence it falls inside, so
+// text cut there does not end in a partial character
+size_t utf8_boundary(std::string_view text, size_t pos);
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include "ignore.hpp"
+
+namespace neoneo {
+namespace io {
+
+// The .gitignore rules in effect at directory: those of the enclosing
+// repository's root down to directory itself. prefix receives directory's
+// path below the repository root ("" or ending in '/'); paths relative to
+// directory must be prefixed with it before they are checked.
+std::shared_ptr<const IgnoreList> load_ignores(const std::string& directory, std::string& prefix);
+
+// Callbacks of a parallel walk; they run on the walking threads
+struct WalkVisitor {
+    // Each regular file that is not hidden, ignored or filtered out
+    std::function<void(const std::string& path, const std::string& relative, size_t worker)> file;
+    // Optional: each directory entered, including the root (relative ""),
+    // with the ignore rules in effect inside it
+    std::function<void(const std::string& path, const std::string& relative,
+                       const std::shared_ptr<const IgnoreList>& ignores)> directory;
+    // Optional: filter files by their relative path and name
+    std::function<bool(const std::string& relative, const char* name)> accept;
+    // Optional: polled after every directory and file; true abandons the walk
+    std::function<bool()> should_stop;
+};
+
+// One thread per core, at most 16
+size_t default_walk_threads();
+
+// Walk the tree below the directory root on a work-stealing pool of
+// threads. Hidden entries (including .git), symlinks, special files and
+// anything the .gitignore files ignore are skipped. worker is in [0, threads).
+void walk_tree(const std::string& root, size_t threads, const WalkVisitor& visitor);
+
+// Join a path and an entry name the way the walk reports paths
+std::string child_path(const std::string& parent, const std::string& name);
+
+} // namespace io
+} // namespace neoneo
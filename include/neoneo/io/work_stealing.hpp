@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace neoneo {
+namespace io {
+
+// Runs a tree of tasks (like a directory walk) on a fixed set of threads.
+// Each worker pushes the tasks it discovers onto its own deque and pops them
+// back LIFO, which keeps a walk depth-first and cache-warm; idle workers
+// steal the oldest task of another worker, which tends to be a large subtree.
+template <typename Task>
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(size_t threads) : queues(threads < 1 ? 1 : threads) {}
+
+    // Run fn(task, worker) until every task, including those pushed by fn,
+    // has finished or stop() was called. fn must not throw.
+    template <typename Fn>
+    void run(std::vector<Task> initial, Fn&& fn) {
+        stopped.store(false);
+        for (size_t i = 0; i < initial.size(); ++i) {
+            push(i % queues.size(), std::move(initial[i]));
+        }
+
+        auto worker = [&](size_t index) {
+            Task task;
+            while (!stopped.load(std::memory_order_relaxed)) {
+                if (pop(index, task) || steal(index, task)) {
+                    fn(task, index);
+                    pending.fetch_sub(1, std::memory_order_acq_rel);
+                } else if (pending.load(std::memory_order_acquire) == 0) {
+                    break;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(queues.size() - 1);
+        for (size_t i = 1; i < queues.size(); ++i) {
+            workers.emplace_back(worker, i);
+        }
+        worker(0);
+        for (auto& thread : workers) {
+            thread.join();
+        }
+
+        // Tasks left behind by stop()
+        for (auto& queue : queues) {
+            queue.tasks.clear();
+        }
+        pending.store(0);
+    }
+
+    // Queue a task from worker (the index passed to fn)
+    void push(size_t worker, Task task) {
+        pending.fetch_add(1, std::memory_order_acq_rel);
+        Queue& queue = queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+
+    // Abandon the remaining tasks
+    void stop() { stopped.store(true); }
+
+    size_t size() const { return queues.size(); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool pop(size_t worker, Task& task) {
+        Queue& queue = queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t thief, Task& task) {
+        for (size_t offset = 1; offset < queues.size(); ++offset) {
+            Queue& queue = queues[(thief + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Queue> queues;
+    std::atomic<size_t> pending{0};
+    std::atomic<bool> stopped{false};
+};
+
+} // namespace io
+} // namespace neoneo
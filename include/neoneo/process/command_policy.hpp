@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace neoneo {
+namespace process {
+
+struct Redirection {
+    std::string op;     // ">", ">>", ">|", "&>", "&>>", "<", "<<", "<<<", "<>", ">&", "<&"
+    std::string target; // File, descriptor for ">&" and "<&", or here-document delimiter
+};
+
+// One simple command of a command line, with quotes and escapes removed
+struct ShellCommand {
+    std::vector<std::string> words;
+    std::vector<Redirection> redirections;
+    bool piped = false; // Reads the output of the command before it ("a | b", "a |& b")
+};
+
+struct ParsedCommandLine {
+    // Every simple command, including those in pipelines, lists, subshells,
+    // brace groups, function bodies and $(...) or `...` substitutions
+    std::vector<ShellCommand> commands;
+    std::vector<std::string> operators;       // "|", "|&", "||", "&&", ";" (also for newlines) and "&"
+    std::vector<std::string> recursive_calls; // Functions called from their own body, as in a fork bomb
+    std::vector<std::string> keywords;        // Reserved words such as if, while and ! in command position
+};
+
+// Split a bash command line into simple commands the way bash would,
+// following quoting, escapes, comments and here-documents. The command
+// line is not expanded; words with substitutions keep only their
+// literal parts. Reserved words (if, then, while, do, !, function NAME,
+// coproc NAME, ...) are left out, so the command after them comes first.
+// Text that bash would reject is parsed as far as it goes.
+ParsedCommandLine parse_command_line(std::string_view text);
+
+// Whether every command in the line only reads (git status, ls, cat, grep
+// and the like, without options that make them write, wait or run other
+// programs), no word expands a variable or names a device or /proc file,
+// and nothing is redirected to a file or run in the background, so running
+// the line again with nothing else changed gives the same output
+bool is_read_only_command(std::string_view command_line);
+
+// Why a command line was flagged
+struct PolicyVerdict {
+    bool allowed = true;
+    std::string rule;    // The rule that matched, as written
+    std::string command; // The simple command (or operator) it matched
+};
+
+// Rules a command line is checked against before it runs. A rule is one
+// line of words:
+//   "rm -r|-R|--recursive -f|--force"  the command rm with some argument
+//       matching each of the following patterns; '|' separates
+//       alternatives, "-r" also matches option clusters such as "-fr",
+//       "--force" also matches "--force=...", and fnmatch wildcards work
+//   "mkfs*"                            any command whose name matches
+//   "> /dev/*"                         output redirected to a matching file
+//                                      ("<" for input; no target: any)
+//   "|"                                an operator: | || && ; &
+// Command names are compared without their directory, behind reserved
+// words and wrappers such as sudo, env, nice, timeout, xargs and busybox,
+// in find -exec commands, and inside bash -c, sh -c and eval scripts.
+// Names are looked up in a hash table, so checking a command line costs
+// time linear in its length plus the rules for the commands it actually
+// runs. Recursive functions are always flagged.
+class CommandPolicy {
+public:
+    CommandPolicy() = default;
+    explicit CommandPolicy(const std::vector<std::string>& rules);
+
+    void add_rule(const std::string& rule);
+
+    PolicyVerdict check(std::string_view command_line) const;
+
+    // Commands the bash tool and background jobs confirm before running
+    static std::vector<std::string> bash_rules();
+    // Commands and operators execute_shell_command confirms before running
+    static std::vector<std::string> shell_rules();
+
+private:
+    struct Rule {
+        std::string text;
+        std::vector<std::vector<std::string>> arguments; // Each needs an argument matching one alternative
+    };
+    struct RedirectRule {
+        bool output;
+        std::string target; // Empty for any
+        size_t rule;
+    };
+
+    PolicyVerdict check(std::string_view command_line, int depth) const;
+    bool check_words(const std::vector<std::string>& words, size_t first, bool reads_input, PolicyVerdict& verdict,
+                     int depth) const;
+    bool matches(const Rule& rule, const std::vector<std::string>& words, size_t first) const;
+
+    std::vector<Rule> rules;
+    std::unordered_map<std::string, std::vector<size_t>> command_rules; // By command name
+    std::vector<std::pair<std::string, size_t>> pattern_rules;         // Command name patterns ("mkfs*")
+    std::unordered_map<std::string, size_t> operator_rules;
+    std::vector<RedirectRule> redirect_rules;
+};
+
+} // namespace process
+} // namespace neoneo
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/types.h>
+
+namespace neoneo {
+namespace process {
+
+enum class OutputStream { Stdout, Stderr };
+
+// Called with each piece of output as it is read, before any of it is dropped for the cap
+using OutputCallback = std::function<void(OutputStream stream, std::string_view data)>;
+
+// What to run and how to capture it
+struct ProcessOptions {
+    std::vector<std::string> argv;            // argv[0] is looked up in PATH unless it contains '/'
+    std::string working_directory;            // Empty to inherit the current directory
+    std::vector<std::string> environment;     // Extra NAME=value entries added to the inherited environment
+    std::string stdin_data;                   // Written to the child's stdin, which is then closed
+    std::chrono::milliseconds timeout{10000}; // Wall-clock limit for the whole process group (0 = none)
+    size_t max_stdout_bytes = 1000000;        // Captured bytes per stream, the rest is counted and dropped
+    size_t max_stderr_bytes = 1000000;
+    OutputCallback on_output;                 // Optional, to show the output while the process runs
+};
+
+// Captured output, exit status and resource usage of a finished process
+struct ProcessResult {
+    bool started = false;
+    std::string error;              // Why the process could not be started
+    int exit_code = -1;             // Exit code, -1 when killed by a signal
+    int term_signal = 0;            // Signal that terminated the process, 0 if it exited
+    bool timed_out = false;         // Process group was killed at the deadline
+
+    std::string stdout_data;
+    std::string stderr_data;
+    size_t stdout_bytes = 0;        // Total bytes produced, including dropped ones
+    size_t stderr_bytes = 0;
+    bool stdout_truncated = false;
+    bool stderr_truncated = false;
+
+    std::chrono::milliseconds wall_time{0};
+    double user_seconds = 0.0;      // From wait4() rusage
+    double system_seconds = 0.0;
+    long max_rss_kb = 0;
+
+    bool succeeded() const { return started && !timed_out && term_signal == 0 && exit_code == 0; }
+
+    // One-line summary of the exit status and resource usage
+    std::string describe_status() const;
+};
+
+// A child process in its own process group with pipes to its standard streams.
+// Destroying a ChildProcess that is still running kills its process group.
+class ChildProcess {
+public:
+    ~ChildProcess();
+    ChildProcess(const ChildProcess&) = delete;
+    ChildProcess& operator=(const ChildProcess&) = delete;
+
+    // Spawn argv with stdin, stdout and stderr connected to pipes.
+    // Returns nullptr and sets error if the process could not be started.
+    static std::unique_ptr<ChildProcess> spawn(const std::vector<std::string>& argv,
+                                               const std::string& working_directory,
+                                               const std::vector<std::string>& environment,
+                                               std::string& error);
+
+    pid_t get_pid() const { return pid; }
+    int stdin_fd() const { return stdin_pipe; }
+    int stdout_fd() const { return stdout_pipe; }
+    int stderr_fd() const { return stderr_pipe; }
+
+    void close_stdin();
+    void close_stdout();
+    void close_stderr();
+
+    // Send a signal to the whole process group
+    void kill_group(int signal_number);
+
+    // Reap the child with wait4(); returns true once it has exited.
+    // Without block this only checks whether it already has.
+    bool wait(bool block);
+    bool has_exited() const { return exited; }
+    int get_status() const { return status; }
+    const struct rusage& get_usage() const { return usage; }
+
+private:
+    ChildProcess() = default;
+
+    pid_t pid = -1;
+    int stdin_pipe = -1;
+    int stdout_pipe = -1;
+    int stderr_pipe = -1;
+    bool exited = false;
+    int status = 0;
+    struct rusage usage {};
+};
+
+// Run a process to completion with a hard wall-clock timeout,
+// capturing stdout and stderr separately
+ProcessResult run_process(const ProcessOptions& options);
+
+} // namespace process
+} // namespace neoneo
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "executor.hpp"
+
+namespace neoneo {
+namespace process {
+
+// Snapshot of a background job
+struct JobStatus {
+    int id = 0;
+    std::string command;
+    std::string working_directory;
+    bool running = false;
+    int exit_code = -1;     // Once it has exited, -1 when killed by a signal
+    int term_signal = 0;
+    bool killed = false;    // By kill()
+    bool timed_out = false; // Killed at its time limit
+    std::chrono::milliseconds elapsed{0};
+    uint64_t output_bytes = 0;  // Output produced so far, stdout and stderr together
+    uint64_t dropped_bytes = 0; // Oldest output no longer kept
+
+    // "running for 12.3s" or "exit code 1 after 4.0s", with the output size
+    std::string describe() const;
+};
+
+// A stretch of a job's output
+struct JobOutput {
+    std::string data;
+    uint64_t offset = 0;  // Of the first byte of data; later than asked for if that was dropped
+    uint64_t next = 0;    // Offset to continue from
+    bool running = false; // More output may follow
+};
+
+// Commands run in the background with bash -c, each in its own process
+// group with stdin closed. A thread per job collects stdout and stderr,
+// interleaved as they arrive, into a log addressed by byte offset; past
+// max_output_bytes the oldest part is dropped. Jobs still running when the
+// manager is destroyed or stop_all() is called are killed.
+class JobManager {
+public:
+    explicit JobManager(size_t max_running = 8, size_t max_output_bytes = 8 * 1024 * 1024);
+    ~JobManager();
+    JobManager(const JobManager&) = delete;
+    JobManager& operator=(const JobManager&) = delete;
+
+    // Start command and return its id, or -1 with error set. A zero
+    // time_limit lets it run until it exits or is killed.
+    int start(const std::string& command, const std::string& working_directory,
+              std::chrono::seconds time_limit, std::string& error);
+
+    // False if there is no job with that id
+    bool status(int id, JobStatus& status) const;
+    std::vector<JobStatus> list() const;
+    bool read(int id, uint64_t offset, size_t max_bytes, JobOutput& output) const;
+
+    // Block until the job exits or timeout passes, then report its status
+    bool wait(int id, std::chrono::milliseconds timeout, JobStatus& status);
+
+    // SIGTERM to its process group, SIGKILL if it is still there after a grace period
+    bool kill(int id, JobStatus& status);
+
+    // Kill every job and forget them all
+    void stop_all();
+
+private:
+    struct Job {
+        JobStatus status;
+        std::unique_ptr<ChildProcess> child;
+        std::chrono::steady_clock::time_point started;
+        std::chrono::steady_clock::time_point deadline; // Unset when there is no time limit
+        std::string output;     // Bytes from status.dropped_bytes on
+        bool kill_requested = false;
+        bool force_kill = false; // SIGKILL without a grace period
+        std::thread reader;
+    };
+
+    // Reader thread: pump the pipes until the job exits
+    void collect(Job& job);
+    void append(Job& job, const char* data, size_t size);
+    JobStatus snapshot(const Job& job) const;
+
+    size_t max_running;
+    size_t max_output_bytes;
+    mutable std::mutex mutex;
+    std::condition_variable changed; // A job exited
+    std::map<int, std::unique_ptr<Job>> jobs;
+    int next_id = 1;
+};
+
+} // namespace process
+} // namespace neoneo
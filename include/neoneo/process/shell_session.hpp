@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "executor.hpp"
+
+namespace neoneo {
+namespace process {
+
+// Result of one command run in a ShellSession
+struct SessionCommandResult : ProcessResult {
+    bool session_restarted = false; // A fresh shell had to be started for this command
+    std::string cwd;                // Session working directory after the command
+};
+
+// Long-lived bash coprocess that runs commands one at a time.
+//
+// Commands are written to the shell's stdin wrapped in eval with stdin from
+// /dev/null, followed by a printf of a per-command sentinel on stdout and
+// stderr. Output is read until both sentinels arrive, so the working
+// directory, environment, functions and sourced files persist between
+// commands. On a timeout the shell's process group is killed and a new
+// shell is started in the last known working directory; exported state is
+// lost in that case and reported through session_restarted.
+class ShellSession {
+public:
+    explicit ShellSession(std::vector<std::string> argv = {"/bin/bash", "--noprofile", "--norc"});
+    ~ShellSession();
+    ShellSession(const ShellSession&) = delete;
+    ShellSession& operator=(const ShellSession&) = delete;
+
+    // Run a command in the session. With a working directory the command
+    // runs in a subshell there and does not change the session state.
+    // on_output, if set, gets the command's output as it arrives; the
+    // sentinel is never passed to it.
+    SessionCommandResult run(const std::string& command,
+                             const std::string& working_directory,
+                             std::chrono::milliseconds timeout,
+                             size_t max_output_bytes,
+                             const OutputCallback& on_output = nullptr);
+
+    // Kill the shell; the next command starts a fresh one
+    void stop();
+
+    bool is_running() const;
+    const std::string& get_cwd() const { return cwd; }
+
+private:
+    bool start(std::string& error);
+
+    std::vector<std::string> argv;
+    std::unique_ptr<ChildProcess> child;
+    std::string nonce;
+    uint64_t sequence = 0;
+    std::string cwd;
+};
+
+} // namespace process
+} // namespace neoneo
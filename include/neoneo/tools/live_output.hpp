@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include "../process/executor.hpp"
+
+namespace neoneo {
+namespace tools {
+
+// Shows a command's output on the terminal while it runs, a whole line at a
+// time. Lines are let through by a token bucket, so a command that prints
+// thousands of lines a second does not flood the terminal: lines over the
+// budget are counted, and the count is shown along with the last few of
+// them once lines are let through again or the command ends.
+class LiveOutput {
+public:
+    explicit LiveOutput(bool enabled);
+    ~LiveOutput();
+
+    void write(process::OutputStream stream, std::string_view data);
+
+    // Show any unfinished lines and what was skipped; called by the destructor
+    void finish();
+
+    bool is_enabled() const { return enabled; }
+    // Whether anything was shown
+    bool has_output() const { return lines_shown > 0 || skipped > 0; }
+
+    // For ProcessOptions::on_output and ShellSession::run; empty when disabled
+    process::OutputCallback callback();
+
+    // Shown in place of the tool result once the output has been: "exit code 0, 1.20s; output shown above"
+    static std::string describe(const process::ProcessResult& result);
+
+private:
+    struct Line {
+        process::OutputStream stream;
+        std::string text;
+    };
+
+    void add_line(process::OutputStream stream, std::string text);
+    void show(const Line& line);
+    void show_skipped();
+
+    bool enabled;
+    bool finished = false;
+    std::string partial[2]; // Unfinished line of stdout and of stderr
+    bool pending_return[2] = {false, false}; // A '\r' that may start a \r\n, per stream
+    double tokens;
+    std::chrono::steady_clock::time_point last_refill;
+    size_t lines_shown = 0;
+    size_t skipped = 0;
+    std::deque<Line> recent_skipped; // The last lines over the budget
+};
+
+} // namespace tools
+} // namespace neoneo
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace neoneo {
+namespace tools {
+
+// Describes one member of a tool argument struct.
+//
+// A tool declares its arguments as a plain struct with a static constexpr
+// fields() function returning a tuple of ArgField descriptors:
+//
+//     struct Args {
+//         std::string command;
+//         int timeout = 10;
+//         static constexpr auto fields() {
+//             return std::make_tuple(
+//                 required_arg("command", &Args::command, "The command to run"),
+//                 optional_arg("timeout", &Args::timeout, "Timeout in seconds"));
+//         }
+//     };
+//
+// tool_schema<Args>() then yields the JSON schema for get_parameters() and
+// parse_args<Args>() fills the struct from a tool call, so the two can not
+// drift apart. Optional fields keep their default when absent; wrap the
+// member in std::optional to tell "absent" from "default". std::string_view
+// members point into the argument JSON and avoid copying large strings.
+template <typename Struct, typename T>
+struct ArgField {
+    const char* name;
+    T Struct::*member;
+    const char* description;
+    bool required;
+};
+
+template <typename Struct, typename T>
+constexpr ArgField<Struct, T> required_arg(const char* name, T Struct::*member, const char* description) {
+    return {name, member, description, true};
+}
+
+template <typename Struct, typename T>
+constexpr ArgField<Struct, T> optional_arg(const char* name, T Struct::*member, const char* description) {
+    return {name, member, description, false};
+}
+
+namespace detail {
+
+template <typename T, typename = void>
+struct has_fields : std::false_type {};
+
+template <typename T>
+struct has_fields<T, std::void_t<decltype(T::fields())>> : std::true_type {};
+
+template <typename T>
+struct is_optional : std::false_type {};
+
+template <typename T>
+struct is_optional<std::optional<T>> : std::true_type {};
+
+template <typename T>
+struct is_vector : std::false_type {};
+
+template <typename T, typename Alloc>
+struct is_vector<std::vector<T, Alloc>> : std::true_type {};
+
+template <typename T>
+inline constexpr bool dependent_false = false;
+
+// Call f for every field descriptor, stopping at the first one returning false
+template <typename Tuple, typename F>
+bool for_each_field(const Tuple& fields, F&& f) {
+    return std::apply([&](const auto&... field) { return (f(field) && ...); }, fields);
+}
+
+template <typename Struct>
+nlohmann::json object_schema();
+
+// JSON schema for a C++ member type
+template <typename T>
+nlohmann::json type_schema() {
+    if constexpr (is_optional<T>::value) {
+        return type_schema<typename T::value_type>();
+    } else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+        return {{"type", "string"}};
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return {{"type", "boolean"}};
+    } else if constexpr (std::is_integral_v<T>) {
+        return {{"type", "integer"}};
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return {{"type", "number"}};
+    } else if constexpr (is_vector<T>::value) {
+        return {{"type", "array"}, {"items", type_schema<typename T::value_type>()}};
+    } else if constexpr (has_fields<T>::value) {
+        return object_schema<T>();
+    } else if constexpr (std::is_same_v<T, nlohmann::json>) {
+        return nlohmann::json::object();
+    } else {
+        static_assert(dependent_false<T>, "Unsupported tool argument type");
+    }
+}
+
+template <typename Struct>
+nlohmann::json object_schema() {
+    nlohmann::json properties = nlohmann::json::object();
+    nlohmann::json required = nlohmann::json::array();
+
+    for_each_field(Struct::fields(), [&](const auto& field) {
+        using Member = std::decay_t<decltype(std::declval<Struct&>().*(field.member))>;
+        nlohmann::json schema = type_schema<Member>();
+        schema["description"] = field.description;
+        properties[field.name] = std::move(schema);
+        if (field.required) {
+            required.push_back(field.name);
+        }
+        return true;
+    });
+
+    nlohmann::json schema = {
+        {"type", "object"},
+        {"properties", std::move(properties)}
+    };
+    if (!required.empty()) {
+        schema["required"] = std::move(required);
+    }
+    return schema;
+}
+
+inline bool type_error(std::string& error, std::string_view path, const char* expected) {
+    error = "Invalid '" + std::string(path) + "' parameter: expected " + expected;
+    return false;
+}
+
+// Parse a whole decimal number from a string argument (models often quote numbers)
+inline bool parse_number_string(const std::string& text, double& out) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    out = std::strtod(text.c_str(), &end);
+    return errno == 0 && end == text.c_str() + text.size();
+}
+
+template <typename Struct>
+bool parse_object(const nlohmann::json& object, Struct& out, std::string& error, std::string_view path);
+
+// Parse one JSON value into a C++ member
+template <typename T>
+bool parse_value(const nlohmann::json& value, T& out, std::string& error, std::string_view path) {
+    if constexpr (is_optional<T>::value) {
+        typename T::value_type parsed{};
+        if (!parse_value(value, parsed, error, path)) {
+            return false;
+        }
+        out = std::move(parsed);
+        return true;
+    } else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+        if (!value.is_string()) {
+            return type_error(error, path, "string");
+        }
+        out = value.get_ref<const std::string&>();
+        return true;
+    } else if constexpr (std::is_same_v<T, bool>) {
+        if (value.is_boolean()) {
+            out = value.get<bool>();
+            return true;
+        }
+        if (value.is_string()) {
+            const auto& text = value.get_ref<const std::string&>();
+            if (text == "true" || text == "false") {
+                out = text == "true";
+                return true;
+            }
+        }
+        return type_error(error, path, "boolean");
+    } else if constexpr (std::is_integral_v<T>) {
+        // JSON integers are compared as integers, since doubles past 2^53 round
+        using Limits = std::numeric_limits<T>;
+        if (value.is_number_unsigned()) {
+            auto number = value.get<unsigned long long>();
+            if (number > static_cast<unsigned long long>(Limits::max())) {
+                return type_error(error, path, "integer");
+            }
+            out = static_cast<T>(number);
+            return true;
+        }
+        if (value.is_number_integer()) {
+            auto number = value.get<long long>();
+            bool fits = number < 0 ? std::is_signed_v<T> && number >= static_cast<long long>(Limits::min())
+                                   : static_cast<unsigned long long>(number) <=
+                                         static_cast<unsigned long long>(Limits::max());
+            if (!fits) {
+                return type_error(error, path, "integer");
+            }
+            out = static_cast<T>(number);
+            return true;
+        }
+
+        double number = 0;
+        if (value.is_number_float()) {
+            number = value.get<double>();
+        } else if (!value.is_string() || !parse_number_string(value.get_ref<const std::string&>(), number)) {
+            return type_error(error, path, "integer");
+        }
+        // The bounds are exact powers of two: max() itself rounds up to 2^digits
+        // as a double, so "number > max()" would let 2^63 through to the cast
+        double limit = std::ldexp(1.0, Limits::digits);
+        if (number != std::floor(number) || number >= limit || number < (std::is_signed_v<T> ? -limit : 0.0)) {
+            return type_error(error, path, "integer");
+        }
+        out = static_cast<T>(number);
+        return true;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        double number = 0;
+        if (value.is_number()) {
+            number = value.get<double>();
+        } else if (!value.is_string() || !parse_number_string(value.get_ref<const std::string&>(), number)) {
+            return type_error(error, path, "number");
+        }
+        out = static_cast<T>(number);
+        return true;
+    } else if constexpr (is_vector<T>::value) {
+        if (!value.is_array()) {
+            return type_error(error, path, "array");
+        }
+        out.clear();
+        out.reserve(value.size());
+        for (size_t i = 0; i < value.size(); ++i) {
+            typename T::value_type element{};
+            if (!parse_value(value[i], element, error, path)) {
+                // Only build the indexed path when there is an error to report
+                parse_value(value[i], element, error, std::string(path) + "[" + std::to_string(i) + "]");
+                return false;
+            }
+            out.push_back(std::move(element));
+        }
+        return true;
+    } else if constexpr (has_fields<T>::value) {
+        if (!value.is_object()) {
+            return type_error(error, path, "object");
+        }
+        return parse_object(value, out, error, path);
+    } else if constexpr (std::is_same_v<T, nlohmann::json>) {
+        out = value;
+        return true;
+    } else {
+        static_assert(dependent_false<T>, "Unsupported tool argument type");
+    }
+}
+
+template <typename Struct>
+bool parse_object(const nlohmann::json& object, Struct& out, std::string& error, std::string_view path) {
+    return for_each_field(Struct::fields(), [&](const auto& field) {
+        auto it = object.find(field.name);
+        bool absent = it == object.end() || it->is_null();
+
+        // Nested fields are reported with their full path, top-level ones by name
+        std::string nested_name;
+        std::string_view name = field.name;
+        if (!path.empty()) {
+            nested_name = std::string(path) + "." + field.name;
+            name = nested_name;
+        }
+
+        if (absent) {
+            if (field.required) {
+                error = "Missing or invalid '" + std::string(name) + "' parameter";
+                return false;
+            }
+            return true;
+        }
+        return parse_value(*it, out.*(field.member), error, name);
+    });
+}
+
+} // namespace detail
+
+// JSON schema for an argument struct, generated once per type
+template <typename Args>
+const nlohmann::json& tool_schema() {
+    static const nlohmann::json schema = detail::object_schema<Args>();
+    return schema;
+}
+
+// Fill an argument struct from tool call arguments, returns false with a message on error
+template <typename Args>
+bool parse_args(const nlohmann::json& json, Args& out, std::string& error) {
+    if (!json.is_object()) {
+        error = "Tool arguments must be a JSON object";
+        return false;
+    }
+    return detail::parse_object(json, out, error, "");
+}
+
+} // namespace tools
+} // namespace neoneo
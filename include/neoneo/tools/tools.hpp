@@ -0,0 +1,790 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "../../ollama_client.hpp"
+#include "../config/config.hpp"
+#include "../io/content_cache.hpp"
+#include "../io/listing.hpp"
+#include "../io/mapped_file.hpp"
+#include "../io/spill_store.hpp"
+#include "../io/tail.hpp"
+#include "../process/command_policy.hpp"
+#include "../process/jobs.hpp"
+#include "tool_args.hpp"
+
+namespace neoneo {
+
+namespace process {
+class ShellSession;
+struct SessionCommandResult;
+}
+
+namespace io {
+class TrigramIndex;
+}
+
+namespace tools {
+
+class LiveOutput;
+
+// Result of a tool execution
+struct ToolResult {
+    bool is_success = false;
+    std::string content;
+    std::string error_message;
+    std::string display; // Shown on the terminal instead of content when set, e.g. after streaming it live
+    size_t original_bytes = 0; // Size of content as the tool returned it, when the tool manager shrank it
+    bool memoized = false; // Reused from an identical earlier call; the tool did not run
+
+    static ToolResult success(const std::string& content) {
+        ToolResult result;
+        result.is_success = true;
+        result.content = content;
+        return result;
+    }
+
+    static ToolResult error(const std::string& message) {
+        ToolResult result;
+        result.is_success = false;
+        result.error_message = message;
+        return result;
+    }
+};
+
+// Whether a call's result may answer a later call with the same arguments
+// (see ToolManager::execute_tool; memoization is off unless configured)
+struct MemoRule {
+    bool side_effects = true;        // May change files or other state; results kept until_side_effect are dropped
+    bool reusable = false;           // The result may be reused at all
+    std::vector<std::string> files;  // Reuse only while these files are unchanged
+    bool until_side_effect = false;  // Reuse only until a call with side effects runs, and not while jobs run
+    std::chrono::seconds max_age{0}; // Reuse only this long (0 = no limit)
+
+    // Depends on nothing but the arguments
+    static MemoRule pure() {
+        MemoRule rule;
+        rule.side_effects = false;
+        rule.reusable = true;
+        return rule;
+    }
+
+    // Changes nothing, but its result is not worth keeping or not repeatable
+    static MemoRule read_only() {
+        MemoRule rule;
+        rule.side_effects = false;
+        return rule;
+    }
+};
+
+class ToolManager;
+
+// Base class for all tools
+class ToolBase {
+public:
+    explicit ToolBase(ToolManager& manager);
+    virtual ~ToolBase() = default;
+
+    virtual std::string get_name() const = 0;
+    virtual std::string get_description() const = 0;
+    virtual nlohmann::json get_parameters() const = 0;
+    virtual ToolResult execute(const nlohmann::json& args) = 0;
+
+    // Drop per-conversation state (called when the conversation is reset)
+    virtual void reset() {}
+
+    // Whether the tool returns one page of something the model can ask for
+    // more of; such outputs are passed on whole instead of being spilled
+    virtual bool pages_output() const { return false; }
+
+    // Whether the output is command output (build logs, test runs) that may
+    // be cleaned of escape sequences and repeated lines before the model sees it
+    virtual bool reduces_output() const { return false; }
+
+    // How a call with these arguments may be memoized; by default it is
+    // assumed to have side effects and is always run
+    virtual MemoRule memo_rule(const nlohmann::json& /*args*/) const { return MemoRule(); }
+
+    // Full function definition in the format expected by Ollama
+    nlohmann::json get_definition() const;
+
+protected:
+    ToolManager& tool_manager;
+};
+
+// Calculator tool backed by the in-process expression engine (calc/)
+class CalculatorTool : public ToolBase {
+public:
+    explicit CalculatorTool(ToolManager& manager);
+
+    struct Args {
+        std::string expression;
+        std::optional<int> precision;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("expression", &Args::expression,
+                             "A mathematical expression to evaluate. "
+                             "Supports +, -, *, /, % (remainder), ^ (power), comparisons, "
+                             "parentheses, variables and functions (sqrt, sin, cos, ln, exp, etc.)"),
+                optional_arg("precision", &Args::precision,
+                             "Digits after the decimal point for exact arbitrary-precision evaluation "
+                             "(like bc's scale). Omit for fast double precision."));
+        }
+    };
+
+    std::string get_name() const override { return "calculator"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+    MemoRule memo_rule(const nlohmann::json&) const override { return MemoRule::pure(); }
+};
+
+// Descriptive statistics over a numeric array or a column of a text file
+class StatisticsTool : public ToolBase {
+public:
+    explicit StatisticsTool(ToolManager& manager);
+
+    struct Args {
+        std::optional<std::vector<double>> values;
+        std::optional<std::string> file;
+        std::optional<nlohmann::json> column;
+        std::optional<std::string> delimiter;
+        std::optional<std::vector<double>> percentiles;
+        int histogram_bins = 0;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                optional_arg("values", &Args::values, "The numbers to analyze (use this or 'file')"),
+                optional_arg("file", &Args::file,
+                             "Path of a text file (CSV, TSV or whitespace separated) to read numbers from. "
+                             "Requires file operations to be enabled."),
+                optional_arg("column", &Args::column,
+                             "Column of the file: 1-based number or header name. Defaults to the first column."),
+                optional_arg("delimiter", &Args::delimiter,
+                             "Field separator of the file: ',', 'tab' or 'whitespace'. Detected when omitted."),
+                optional_arg("percentiles", &Args::percentiles,
+                             "Percentiles to report (0-100). Defaults to 25, 50, 75, 90 and 99."),
+                optional_arg("histogram_bins", &Args::histogram_bins,
+                             "Number of equal-width histogram bins to report (0-1000). Defaults to none."));
+        }
+    };
+
+    std::string get_name() const override { return "statistics"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+    MemoRule memo_rule(const nlohmann::json& args) const override;
+
+private:
+    bool load_column(const Args& args, std::vector<double>& values, size_t& skipped, std::string& error);
+};
+
+// Restricted shell command tool
+class ShellTool : public ToolBase {
+public:
+    explicit ShellTool(ToolManager& manager);
+
+    struct Args {
+        std::string command;
+        int timeout = 5;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("command", &Args::command,
+                             "The shell command to execute. Certain commands are blocked for security."),
+                optional_arg("timeout", &Args::timeout,
+                             "Maximum execution time in seconds (1-30). Defaults to 5 seconds."));
+        }
+    };
+
+    std::string get_name() const override { return "execute_shell_command"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+    MemoRule memo_rule(const nlohmann::json& args) const override;
+    bool reduces_output() const override { return true; }
+
+private:
+    bool split_command(const std::string& command, std::vector<std::string>& argv, std::string& error);
+};
+
+// Bash command tool backed by a persistent bash session
+class BashTool : public ToolBase {
+public:
+    explicit BashTool(ToolManager& manager);
+    ~BashTool() override;
+
+    struct Args {
+        std::string command;
+        int timeout = 10;
+        std::optional<std::string> working_directory;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("command", &Args::command,
+                             "The bash command to execute. Must be a valid bash command."),
+                optional_arg("timeout", &Args::timeout,
+                             "Maximum execution time in seconds (1-60). Defaults to 10 seconds."),
+                optional_arg("working_directory", &Args::working_directory,
+                             "Working directory to execute the command in. Defaults to current directory."));
+        }
+    };
+
+    std::string get_name() const override { return "bash"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+    MemoRule memo_rule(const nlohmann::json& args) const override;
+    void reset() override;
+    bool reduces_output() const override { return true; }
+
+private:
+    std::string execute_command(const std::string& command, const std::string& working_directory,
+                                int timeout_seconds, LiveOutput& live, process::SessionCommandResult& result);
+
+    std::unique_ptr<process::ShellSession> session;
+};
+
+// Starts a command in the background and returns its job id at once (process/jobs.hpp)
+class StartJobTool : public ToolBase {
+public:
+    explicit StartJobTool(ToolManager& manager);
+
+    struct Args {
+        std::string command;
+        std::optional<std::string> working_directory;
+        int time_limit = 3600;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("command", &Args::command, "The bash command to run in the background"),
+                optional_arg("working_directory", &Args::working_directory,
+                             "Directory to run it in. Defaults to the current directory."),
+                optional_arg("time_limit", &Args::time_limit,
+                             "Seconds after which the job is killed (default 3600, at most 86400)"));
+        }
+    };
+
+    std::string get_name() const override { return "start_job"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+};
+
+// Reports the state of one background job or of all of them
+class JobStatusTool : public ToolBase {
+public:
+    explicit JobStatusTool(ToolManager& manager);
+
+    struct Args {
+        std::optional<int> id;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                optional_arg("id", &Args::id, "Job id; all jobs if omitted"));
+        }
+    };
+
+    std::string get_name() const override { return "job_status"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+    MemoRule memo_rule(const nlohmann::json&) const override { return MemoRule::read_only(); }
+};
+
+// Reads a background job's output from a byte offset
+class JobOutputTool : public ToolBase {
+public:
+    explicit JobOutputTool(ToolManager& manager);
+
+    struct Args {
+        int id = 0;
+        std::optional<long long> offset;
+        int max_bytes = 16000;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("id", &Args::id, "Job id"),
+                optional_arg("offset", &Args::offset,
+                             "Byte offset to read from; defaults to where the previous job_output call for this job stopped"),
+                optional_arg("max_bytes", &Args::max_bytes, "Bytes to return (default 16000, at most 50000)"));
+        }
+    };
+
+    std::string get_name() const override { return "job_output"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+    MemoRule memo_rule(const nlohmann::json&) const override { return MemoRule::read_only(); }
+    void reset() override;
+    bool pages_output() const override { return true; }
+    bool reduces_output() const override { return true; }
+
+private:
+    std::map<int, uint64_t> read_offsets; // Job id -> where the last read stopped
+};
+
+// Waits for a background job to finish, up to a timeout
+class WaitJobTool : public ToolBase {
+public:
+    explicit WaitJobTool(ToolManager& manager);
+
+    struct Args {
+        int id = 0;
+        int timeout = 30;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("id", &Args::id, "Job id"),
+                optional_arg("timeout", &Args::timeout, "Seconds to wait at most (default 30, at most 300)"));
+        }
+    };
+
+    std::string get_name() const override { return "wait_job"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+    MemoRule memo_rule(const nlohmann::json&) const override { return MemoRule::read_only(); }
+};
+
+// Kills a background job's whole process group
+class KillJobTool : public ToolBase {
+public:
+    explicit KillJobTool(ToolManager& manager);
+
+    struct Args {
+        int id = 0;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("id", &Args::id, "Job id"));
+        }
+    };
+
+    std::string get_name() const override { return "kill_job"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+};
+
+// Reads ranges of, or searches, a tool output kept in the spill store
+class ReadOutputTool : public ToolBase {
+public:
+    explicit ReadOutputTool(ToolManager& manager);
+
+    struct Args {
+        std::string handle;
+        std::optional<long long> offset;
+        std::optional<long long> length;
+        std::optional<long long> start_line;
+        std::optional<long long> end_line;
+        std::optional<std::string> grep;
+        bool regex = false;
+        bool ignore_case = false;
+        int max_matches = 100;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("handle", &Args::handle, "Handle of the stored output, e.g. out-3"),
+                optional_arg("offset", &Args::offset, "Byte offset to start reading at"),
+                optional_arg("length", &Args::length, "Number of bytes to read (at most 50000)"),
+                optional_arg("start_line", &Args::start_line, "First line to read (1-based)"),
+                optional_arg("end_line", &Args::end_line, "Last line to read (inclusive)"),
+                optional_arg("grep", &Args::grep, "Return only the lines containing this text"),
+                optional_arg("regex", &Args::regex, "Treat grep as a POSIX extended regular expression"),
+                optional_arg("ignore_case", &Args::ignore_case, "Match grep case-insensitively"),
+                optional_arg("max_matches", &Args::max_matches, "Matching lines to return (default 100, at most 1000)"));
+        }
+    };
+
+    std::string get_name() const override { return "read_output"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+    MemoRule memo_rule(const nlohmann::json&) const override { return MemoRule::read_only(); }
+    bool pages_output() const override { return true; }
+
+private:
+    io::LineIndexCache line_cache;
+};
+
+// Lists models available on the Ollama server
+class ModelListTool : public ToolBase {
+public:
+    explicit ModelListTool(ToolManager& manager);
+
+    struct Args {
+        std::optional<std::string> host;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                optional_arg("host", &Args::host,
+                             "Optional: The Ollama server URL (default: http://localhost:11434)"));
+        }
+    };
+
+    std::string get_name() const override { return "list_models"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+    MemoRule memo_rule(const nlohmann::json& args) const override;
+};
+
+// File reading tool
+class FileReadTool : public ToolBase {
+public:
+    explicit FileReadTool(ToolManager& manager);
+
+    struct Args {
+        std::string path;
+        std::optional<long long> offset;
+        std::optional<long long> length;
+        std::optional<long long> start_line;
+        std::optional<long long> end_line;
+        std::optional<long long> tail;
+        double follow_seconds = 0;
+        bool full = false;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("path", &Args::path, "The path to the file to read"),
+                optional_arg("offset", &Args::offset, "Byte offset to start reading at"),
+                optional_arg("length", &Args::length, "Number of bytes to read (at most 50000)"),
+                optional_arg("start_line", &Args::start_line, "First line to read (1-based)"),
+                optional_arg("end_line", &Args::end_line, "Last line to read (inclusive)"),
+                optional_arg("tail", &Args::tail, "Read the last N lines of the file"),
+                optional_arg("follow_seconds", &Args::follow_seconds,
+                             "With tail: also wait up to this many seconds (at most 30) for appended lines"),
+                optional_arg("full", &Args::full,
+                             "Return the whole content even if this range was read earlier in the conversation"));
+        }
+    };
+
+    std::string get_name() const override { return "read_file"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+    MemoRule memo_rule(const nlohmann::json&) const override { return MemoRule::read_only(); }
+    void reset() override;
+    bool pages_output() const override { return true; }
+
+private:
+    // What an earlier call returned for a file and range
+    struct PastRead {
+        int turn = 0;         // Of the last call that returned the content in full
+        size_t size = 0;      // Of that output, which decides when it ages out of the conversation
+        uint64_t hash = 0;    // Of the content as last returned, in full or as a diff
+        std::string content;  // Without the header and footer
+    };
+
+    // header + content + footer, or the header and only what changed in the
+    // content since the same range was last returned if that output is still
+    // in the conversation. first_line is the file line content starts on.
+    ToolResult since_last_read(const Args& parsed, const std::string& range, const std::string& header,
+                               std::string content, const std::string& footer, size_t first_line = 1);
+
+    io::LineIndexCache line_cache;
+    std::map<std::string, PastRead> past_reads; // Normalized path and range -> last read
+};
+
+// Reads several files (or glob matches) concurrently in one call
+class MultiFileReadTool : public ToolBase {
+public:
+    explicit MultiFileReadTool(ToolManager& manager);
+
+    struct Args {
+        std::vector<std::string> paths;
+        long long max_bytes_per_file = 20000;
+        long long max_total_bytes = 100000;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("paths", &Args::paths,
+                             "Files to read; glob patterns like src/*.cpp or include/**/*.hpp are expanded"),
+                optional_arg("max_bytes_per_file", &Args::max_bytes_per_file,
+                             "Bytes to read from the start of each file (default 20000, at most 50000)"),
+                optional_arg("max_total_bytes", &Args::max_total_bytes,
+                             "Bytes to read across all files (default 100000, at most 200000)"));
+        }
+    };
+
+    std::string get_name() const override { return "read_files"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+    MemoRule memo_rule(const nlohmann::json&) const override { return MemoRule::read_only(); }
+};
+
+// Parallel code and text search over a directory tree (io/search.hpp)
+class SearchTool : public ToolBase {
+public:
+    explicit SearchTool(ToolManager& manager);
+    ~SearchTool() override;
+
+    struct Args {
+        std::string pattern;
+        std::string path = ".";
+        bool regex = false;
+        bool ignore_case = false;
+        std::optional<std::string> glob;
+        int max_results = 100;
+        int max_per_file = 10;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("pattern", &Args::pattern, "Text to search for (a literal unless regex is set)"),
+                optional_arg("path", &Args::path, "Directory or file to search (default: current directory)"),
+                optional_arg("regex", &Args::regex, "Treat pattern as a POSIX extended regular expression"),
+                optional_arg("ignore_case", &Args::ignore_case, "Match without regard to case"),
+                optional_arg("glob", &Args::glob, "Only search files matching this pattern, e.g. *.cpp or src/**/*.hpp"),
+                optional_arg("max_results", &Args::max_results, "Matching lines to return (default 100, at most 1000)"),
+                optional_arg("max_per_file", &Args::max_per_file, "Matching lines to return per file (default 10)"));
+        }
+    };
+
+    std::string get_name() const override { return "search"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+    MemoRule memo_rule(const nlohmann::json&) const override { return MemoRule::read_only(); }
+
+private:
+    // Index of the working directory, when enabled in the config
+    std::unique_ptr<io::TrigramIndex> index;
+};
+
+// Lists a directory tree with optional size and mtime (io/listing.hpp)
+class ListFilesTool : public ToolBase {
+public:
+    explicit ListFilesTool(ToolManager& manager);
+
+    struct Args {
+        std::string path = ".";
+        int depth = 1;
+        std::optional<std::string> glob;
+        bool details = false;
+        bool hidden = false;
+        bool ignored = false;
+        int max_entries = 500;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                optional_arg("path", &Args::path, "Directory to list (default: current directory)"),
+                optional_arg("depth", &Args::depth, "Levels to descend; 1 lists only the directory itself (default 1, at most 32)"),
+                optional_arg("glob", &Args::glob, "Only list files matching this pattern, e.g. *.cpp or src/**/*.hpp"),
+                optional_arg("details", &Args::details, "Include size in bytes and modification time"),
+                optional_arg("hidden", &Args::hidden, "Include names starting with '.'"),
+                optional_arg("ignored", &Args::ignored, "Include files excluded by .gitignore"),
+                optional_arg("max_entries", &Args::max_entries, "Entries to return (default 500, at most 10000)"));
+        }
+    };
+
+    std::string get_name() const override { return "list_files"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+    MemoRule memo_rule(const nlohmann::json&) const override { return MemoRule::read_only(); }
+
+private:
+    io::DirectoryCache cache;
+};
+
+// File writing tool
+class FileWriteTool : public ToolBase {
+public:
+    explicit FileWriteTool(ToolManager& manager);
+
+    struct Args {
+        std::string path;
+        std::string_view content;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("path", &Args::path, "The path to the file to write"),
+                required_arg("content", &Args::content, "The content to write to the file"));
+        }
+    };
+
+    std::string get_name() const override { return "write_file"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+};
+
+// File editing tool
+class FileEditTool : public ToolBase {
+public:
+    explicit FileEditTool(ToolManager& manager);
+
+    // One edit: exactly one of replace_all, old_text+new_text, append,
+    // prepend or insert_at_line+text
+    struct Edit {
+        std::optional<std::string_view> replace_all;
+        std::optional<std::string_view> old_text;
+        std::optional<std::string_view> new_text;
+        std::optional<int> occurrence;
+        bool all = false;
+        std::optional<std::string_view> append;
+        std::optional<std::string_view> prepend;
+        std::optional<int> insert_at_line;
+        std::optional<std::string_view> text;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                optional_arg("replace_all", &Edit::replace_all, "If provided, replaces the entire file content"),
+                optional_arg("old_text", &Edit::old_text, "The text to find and replace"),
+                optional_arg("new_text", &Edit::new_text, "The new text to replace with"),
+                optional_arg("occurrence", &Edit::occurrence, "Which occurrence of old_text to replace, counting from 1 (default 1)"),
+                optional_arg("all", &Edit::all, "Replace every occurrence of old_text"),
+                optional_arg("append", &Edit::append, "Text to append to the end of the file"),
+                optional_arg("prepend", &Edit::prepend, "Text to insert at the beginning of the file"),
+                optional_arg("insert_at_line", &Edit::insert_at_line, "Line number where to insert text (0-based)"),
+                optional_arg("text", &Edit::text, "Text to insert at the specified line"));
+        }
+    };
+
+    struct FileEdits {
+        std::string path;
+        std::vector<Edit> edits;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("path", &FileEdits::path, "The path to the file to edit"),
+                required_arg("edits", &FileEdits::edits, "Edits to apply in order, each to the result of the previous ones"));
+        }
+    };
+
+    // A single edit of path can be given inline, as before
+    struct Args : Edit {
+        std::string path;
+        std::optional<std::vector<Edit>> edits;
+        std::optional<std::vector<FileEdits>> files;
+
+        static constexpr auto fields() {
+            return std::tuple_cat(
+                std::make_tuple(optional_arg("path", &Args::path, "The path to the file to edit")),
+                Edit::fields(),
+                std::make_tuple(
+                    optional_arg("edits", &Args::edits,
+                                 "Several edits of path, applied in order, each to the result of the previous ones"),
+                    optional_arg("files", &Args::files, "Several files to edit, each with its own path and edits")));
+        }
+    };
+
+    std::string get_name() const override { return "edit_file"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+};
+
+// Unified diff application tool
+class ApplyPatchTool : public ToolBase {
+public:
+    explicit ApplyPatchTool(ToolManager& manager);
+
+    struct Args {
+        std::string_view patch;
+        std::optional<int> strip;
+        bool check = false;
+
+        static constexpr auto fields() {
+            return std::make_tuple(
+                required_arg("patch", &Args::patch, "Unified diff of one or more files ('--- a/path', '+++ b/path', '@@' hunks)"),
+                optional_arg("strip", &Args::strip, "Leading path components to remove from the file names, like patch -p "
+                                                    "(default: 1 for a/ and b/ prefixes, otherwise 0)"),
+                optional_arg("check", &Args::check, "Only check that the patch applies, without changing any file"));
+        }
+    };
+
+    std::string get_name() const override { return "apply_patch"; }
+    std::string get_description() const override;
+    nlohmann::json get_parameters() const override;
+    ToolResult execute(const nlohmann::json& args) override;
+};
+
+// Owns the registered tools and dispatches tool calls
+class ToolManager {
+public:
+    explicit ToolManager(config::Config& config);
+    ~ToolManager();
+
+    // Tool registration
+    void register_tool(std::unique_ptr<ToolBase> tool);
+    bool unregister_tool(const std::string& name);
+    void register_default_tools();
+
+    // Tool definitions as JSON objects (built on every call)
+    std::vector<nlohmann::json> get_tool_definitions() const;
+
+    // Tool definitions serialized once per tool set, shared until the next (un)register
+    std::shared_ptr<const ToolDefinitionBlob> get_compiled_tool_definitions() const;
+    uint64_t get_definitions_version() const { return definitions_version; }
+
+    bool has_tool(const std::string& name) const;
+    ToolResult execute_tool(const std::string& name, const nlohmann::json& args);
+
+    // Reset per-conversation tool state
+    void reset_tools();
+
+    const config::Config& get_config() const { return config; }
+
+    // File contents shared by the file tools for the whole session
+    io::ContentCache& get_content_cache() { return content_cache; }
+
+    // Conversation turn the tools are running in (one per user message)
+    void set_turn(int value) { turn = value; }
+    int get_turn() const { return turn; }
+
+    // Background jobs started by the tools; killed when the conversation is reset
+    process::JobManager& get_jobs() { return jobs; }
+
+    // Rules shell commands are checked against before they run, built on first
+    // use from the defaults and the configured rules. The bash policy also
+    // covers background jobs; execute_shell_command has a stricter one.
+    const process::CommandPolicy& get_bash_policy();
+    const process::CommandPolicy& get_shell_policy();
+
+    // Full outputs of the tool calls whose results were cut to a summary
+    io::SpillStore& get_spill_store() { return spill_store; }
+
+    // Whether commands show their output on the terminal while they run
+    void set_live_output(bool enabled) { live_output = enabled; }
+    bool is_live_output() const { return live_output; }
+
+private:
+    config::Config& config;
+    io::ContentCache content_cache;
+    process::JobManager jobs;
+    io::SpillStore spill_store;
+    std::unique_ptr<process::CommandPolicy> bash_policy;
+    std::unique_ptr<process::CommandPolicy> shell_policy;
+    std::map<std::string, std::unique_ptr<ToolBase>> tools;
+    uint64_t definitions_version = 0;
+    mutable std::shared_ptr<const ToolDefinitionBlob> compiled_definitions;
+    int turn = 0;
+    bool live_output = false;
+
+    // A result kept for reuse, with what it depended on (see MemoRule)
+    struct MemoEntry {
+        ToolResult result;
+        MemoRule rule;
+        std::vector<std::string> stamps; // Of rule.files when the call ran
+        uint64_t epoch = 0;              // side_effect_epoch when the call ran
+        std::chrono::steady_clock::time_point stored;
+    };
+    bool is_memo_valid(const MemoEntry& entry, const std::vector<std::string>& stamps) const;
+
+    std::unordered_map<std::string, MemoEntry> memo; // By tool name and canonical arguments
+    uint64_t side_effect_epoch = 0;                  // Calls with side effects run so far
+};
+
+} // namespace tools
+} // namespace neoneo
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <functional>
@@ -50,6 +51,13 @@ struct Tool {
     } function;
 };
 
+// Tool definitions pre-serialized as a JSON array, spliced into requests as-is
+struct ToolDefinitionBlob {
+    uint64_t version = 0; // Changes whenever the tool set changes
+    size_t count = 0;     // Number of tools in the array
+    std::string json;     // Serialized JSON array, empty when there are no tools
+};
+
 class OllamaClient {
 public:
     OllamaClient(const std::string& host = "http://localhost:11434");
@@ -73,6 +81,12 @@ public:
                      const std::vector<nlohmann::json>& tool_definitions,
                      std::function<void(const std::string&)> stream_callback = nullptr);
     
+    // Generate a chat completion with pre-serialized tool definitions
+    ChatMessage chat(const std::string& model, 
+                     const std::vector<ChatMessage>& messages,
+                     const ToolDefinitionBlob& tools,
+                     std::function<void(const std::string&)> stream_callback = nullptr);
+    
     // Generate a streaming chat completion
     void chat_stream(const std::string& model,
                    const std::vector<ChatMessage>& messages,
@@ -84,6 +98,12 @@ public:
                    const std::vector<ChatMessage>& messages,
                    std::function<void(const std::string&)> callback,
                    const std::vector<nlohmann::json>& tool_definitions = {});
+    
+    // Generate a streaming chat completion with pre-serialized tool definitions
+    void chat_stream(const std::string& model,
+                   const std::vector<ChatMessage>& messages,
+                   std::function<void(const std::string&)> callback,
+                   const ToolDefinitionBlob& tools);
 
 private:
     class Impl;
@@ -0,0 +1,752 @@
+#include "../../include/neoneo/calc/decimal.hpp"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace neoneo {
+namespace calc {
+
+namespace {
+
+using Limbs = std::vector<uint32_t>;
+
+constexpr uint32_t BASE = 1000000000;
+constexpr uint32_t POW10[10] = {1, 10, 100, 1000, 10000, 100000, 1000000,
+                                10000000, 100000000, 1000000000};
+
+void trim(Limbs& value) {
+    while (!value.empty() && value.back() == 0) {
+        value.pop_back();
+    }
+}
+
+size_t digit_count(const Limbs& value) {
+    if (value.empty()) {
+        return 0;
+    }
+    size_t digits = (value.size() - 1) * 9;
+    uint32_t top = value.back();
+    while (top > 0) {
+        ++digits;
+        top /= 10;
+    }
+    return digits;
+}
+
+int compare_magnitude(const Limbs& a, const Limbs& b) {
+    if (a.size() != b.size()) {
+        return a.size() < b.size() ? -1 : 1;
+    }
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+Limbs add_magnitude(const Limbs& a, const Limbs& b) {
+    const Limbs& longer = a.size() >= b.size() ? a : b;
+    const Limbs& shorter = a.size() >= b.size() ? b : a;
+    Limbs sum;
+    sum.reserve(longer.size() + 1);
+    uint32_t carry = 0;
+    for (size_t i = 0; i < longer.size(); ++i) {
+        uint32_t digit = longer[i] + (i < shorter.size() ? shorter[i] : 0) + carry;
+        carry = digit >= BASE;
+        sum.push_back(carry ? digit - BASE : digit);
+    }
+    if (carry) {
+        sum.push_back(carry);
+    }
+    return sum;
+}
+
+// a - b for a >= b
+Limbs subtract_magnitude(const Limbs& a, const Limbs& b) {
+    Limbs difference = a;
+    int64_t borrow = 0;
+    for (size_t i = 0; i < difference.size(); ++i) {
+        if (i >= b.size() && borrow == 0) {
+            break;
+        }
+        int64_t digit = static_cast<int64_t>(difference[i]) - (i < b.size() ? b[i] : 0) - borrow;
+        borrow = digit < 0;
+        difference[i] = static_cast<uint32_t>(borrow ? digit + BASE : digit);
+    }
+    trim(difference);
+    return difference;
+}
+
+void multiply_small(Limbs& value, uint32_t factor) {
+    uint64_t carry = 0;
+    for (auto& limb : value) {
+        uint64_t product = static_cast<uint64_t>(limb) * factor + carry;
+        limb = static_cast<uint32_t>(product % BASE);
+        carry = product / BASE;
+    }
+    while (carry > 0) {
+        value.push_back(static_cast<uint32_t>(carry % BASE));
+        carry /= BASE;
+    }
+    trim(value);
+}
+
+void divide_small(Limbs& value, uint32_t divisor) {
+    uint64_t remainder = 0;
+    for (size_t i = value.size(); i-- > 0;) {
+        uint64_t current = remainder * BASE + value[i];
+        value[i] = static_cast<uint32_t>(current / divisor);
+        remainder = current % divisor;
+    }
+    trim(value);
+}
+
+Limbs multiply_magnitude(const Limbs& a, const Limbs& b) {
+    if (a.empty() || b.empty()) {
+        return {};
+    }
+    Limbs product(a.size() + b.size(), 0);
+    for (size_t i = 0; i < a.size(); ++i) {
+        uint64_t carry = 0;
+        uint64_t digit = a[i];
+        if (digit == 0) {
+            continue;
+        }
+        for (size_t j = 0; j < b.size(); ++j) {
+            uint64_t current = product[i + j] + digit * b[j] + carry;
+            product[i + j] = static_cast<uint32_t>(current % BASE);
+            carry = current / BASE;
+        }
+        product[i + b.size()] = static_cast<uint32_t>(carry);
+    }
+    trim(product);
+    return product;
+}
+
+void shift_up(Limbs& value, int digits) {
+    if (value.empty() || digits <= 0) {
+        return;
+    }
+    value.insert(value.begin(), static_cast<size_t>(digits / 9), 0);
+    if (digits % 9) {
+        multiply_small(value, POW10[digits % 9]);
+    }
+}
+
+// Divide by 10^digits, truncating
+void shift_down(Limbs& value, int digits) {
+    if (value.empty() || digits <= 0) {
+        return;
+    }
+    size_t whole = std::min(value.size(), static_cast<size_t>(digits / 9));
+    value.erase(value.begin(), value.begin() + whole);
+    if (digits % 9) {
+        divide_small(value, POW10[digits % 9]);
+    }
+}
+
+// Truncated quotient (Knuth, TAOCP vol. 2, algorithm D)
+Limbs divide_magnitude(const Limbs& a, const Limbs& b) {
+    if (compare_magnitude(a, b) < 0) {
+        return {};
+    }
+    if (b.size() == 1) {
+        Limbs quotient = a;
+        divide_small(quotient, b[0]);
+        return quotient;
+    }
+
+    // Normalize so the divisor's top limb is at least BASE / 2
+    uint32_t factor = BASE / (b.back() + 1);
+    Limbs u = a;
+    multiply_small(u, factor);
+    u.resize(a.size() + 1, 0);
+    Limbs v = b;
+    multiply_small(v, factor);
+
+    size_t n = v.size();
+    size_t m = a.size() - n;
+    Limbs quotient(m + 1, 0);
+
+    for (size_t j = m + 1; j-- > 0;) {
+        uint64_t numerator = static_cast<uint64_t>(u[j + n]) * BASE + u[j + n - 1];
+        uint64_t qhat = numerator / v[n - 1];
+        uint64_t rhat = numerator % v[n - 1];
+        while (qhat >= BASE || qhat * v[n - 2] > rhat * BASE + u[j + n - 2]) {
+            --qhat;
+            rhat += v[n - 1];
+            if (rhat >= BASE) {
+                break;
+            }
+        }
+
+        // u[j..j+n] -= qhat * v
+        int64_t borrow = 0;
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t product = qhat * v[i] + carry;
+            carry = product / BASE;
+            int64_t digit = static_cast<int64_t>(u[i + j]) - static_cast<int64_t>(product % BASE) - borrow;
+            borrow = digit < 0;
+            u[i + j] = static_cast<uint32_t>(borrow ? digit + BASE : digit);
+        }
+        int64_t top = static_cast<int64_t>(u[j + n]) - static_cast<int64_t>(carry) - borrow;
+
+        if (top < 0) {
+            // qhat was one too large; add v back
+            --qhat;
+            uint32_t add_carry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                uint32_t digit = u[i + j] + v[i] + add_carry;
+                add_carry = digit >= BASE;
+                u[i + j] = add_carry ? digit - BASE : digit;
+            }
+            top += add_carry;
+        }
+        u[j + n] = static_cast<uint32_t>(top);
+        quotient[j] = static_cast<uint32_t>(qhat);
+    }
+
+    trim(quotient);
+    return quotient;
+}
+
+Limbs integer_sqrt(const Limbs& value) {
+    // Start from a power of ten at or above the root and run Newton's
+    // iteration down to floor(sqrt(value))
+    Limbs root{1};
+    shift_up(root, static_cast<int>((digit_count(value) + 1) / 2));
+    while (true) {
+        Limbs next = add_magnitude(root, divide_magnitude(value, root));
+        divide_small(next, 2);
+        if (compare_magnitude(next, root) >= 0) {
+            return root;
+        }
+        root = std::move(next);
+    }
+}
+
+const Decimal& one() {
+    static const Decimal value = Decimal::from_int(1);
+    return value;
+}
+
+const Decimal& two() {
+    static const Decimal value = Decimal::from_int(2);
+    return value;
+}
+
+Decimal constant(const char* text) {
+    Decimal value;
+    Decimal::parse(text, value);
+    return value;
+}
+
+} // namespace
+
+Decimal Decimal::make(bool negative, std::vector<uint32_t> limbs, int scale) {
+    Decimal value;
+    value.limbs = std::move(limbs);
+    value.negative = negative && !value.limbs.empty();
+    value.scale = scale;
+    return value;
+}
+
+Decimal Decimal::from_int(int64_t value) {
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    Limbs limbs;
+    while (magnitude > 0) {
+        limbs.push_back(static_cast<uint32_t>(magnitude % BASE));
+        magnitude /= BASE;
+    }
+    return make(value < 0, std::move(limbs), 0);
+}
+
+bool Decimal::parse(const std::string& text, Decimal& out) {
+    std::string digits;
+    int fraction = 0;
+    bool point = false;
+    size_t i = 0;
+
+    for (; i < text.size(); ++i) {
+        char c = text[i];
+        if (c >= '0' && c <= '9') {
+            digits += c;
+            fraction += point;
+        } else if (c == '.' && !point) {
+            point = true;
+        } else {
+            break;
+        }
+    }
+    if (digits.empty()) {
+        return false;
+    }
+
+    long exponent = 0;
+    if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+        ++i;
+        bool exponent_negative = false;
+        if (i < text.size() && (text[i] == '+' || text[i] == '-')) {
+            exponent_negative = text[i] == '-';
+            ++i;
+        }
+        if (i >= text.size()) {
+            return false;
+        }
+        for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i) {
+            exponent = exponent * 10 + (text[i] - '0');
+            if (exponent > 100000) {
+                throw CalcError("Exponent out of range in '" + text + "'");
+            }
+        }
+        if (exponent_negative) {
+            exponent = -exponent;
+        }
+    }
+    if (i != text.size()) {
+        return false;
+    }
+
+    long scale = fraction - exponent;
+    if (scale < 0) {
+        digits.append(static_cast<size_t>(-scale), '0');
+        scale = 0;
+    }
+
+    Limbs limbs;
+    limbs.reserve(digits.size() / 9 + 1);
+    for (size_t end = digits.size(); end > 0;) {
+        size_t start = end >= 9 ? end - 9 : 0;
+        uint32_t limb = 0;
+        for (size_t k = start; k < end; ++k) {
+            limb = limb * 10 + static_cast<uint32_t>(digits[k] - '0');
+        }
+        limbs.push_back(limb);
+        end = start;
+    }
+    trim(limbs);
+    out = make(false, std::move(limbs), static_cast<int>(scale));
+    return true;
+}
+
+bool Decimal::is_integer() const {
+    size_t whole = static_cast<size_t>(scale / 9);
+    for (size_t i = 0; i < whole && i < limbs.size(); ++i) {
+        if (limbs[i] != 0) {
+            return false;
+        }
+    }
+    return whole >= limbs.size() || limbs[whole] % POW10[scale % 9] == 0;
+}
+
+size_t Decimal::length() const {
+    size_t digits = digit_count(limbs);
+    return std::max({digits, static_cast<size_t>(scale), static_cast<size_t>(1)});
+}
+
+size_t Decimal::integer_digits() const {
+    size_t digits = digit_count(limbs);
+    return digits > static_cast<size_t>(scale) ? digits - scale : 0;
+}
+
+bool Decimal::to_int64(int64_t& out) const {
+    Limbs whole = limbs;
+    shift_down(whole, scale);
+    if (whole.size() > 3) {
+        return false;
+    }
+    uint64_t magnitude = 0;
+    for (size_t i = whole.size(); i-- > 0;) {
+        if (magnitude > (static_cast<uint64_t>(INT64_MAX) - whole[i]) / BASE) {
+            return false;
+        }
+        magnitude = magnitude * BASE + whole[i];
+    }
+    out = negative ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
+    return true;
+}
+
+double Decimal::to_double() const {
+    return std::strtod(to_string().c_str(), nullptr);
+}
+
+std::string Decimal::to_string() const {
+    if (limbs.empty()) {
+        return "0";
+    }
+
+    std::string digits;
+    digits.reserve(limbs.size() * 9 + 3);
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%u", limbs.back());
+    digits += buffer;
+    for (size_t i = limbs.size() - 1; i-- > 0;) {
+        std::snprintf(buffer, sizeof(buffer), "%09u", limbs[i]);
+        digits += buffer;
+    }
+
+    if (scale > 0) {
+        size_t fraction = static_cast<size_t>(scale);
+        if (digits.size() <= fraction) {
+            digits.insert(0, fraction + 1 - digits.size(), '0');
+        }
+        digits.insert(digits.size() - fraction, 1, '.');
+    }
+    return negative ? "-" + digits : digits;
+}
+
+Decimal Decimal::negated() const {
+    Decimal value = *this;
+    value.negative = !negative && !limbs.empty();
+    return value;
+}
+
+Decimal Decimal::abs() const {
+    Decimal value = *this;
+    value.negative = false;
+    return value;
+}
+
+Decimal Decimal::rescaled(int new_scale) const {
+    Limbs magnitude = limbs;
+    if (new_scale > scale) {
+        shift_up(magnitude, new_scale - scale);
+    } else {
+        shift_down(magnitude, scale - new_scale);
+    }
+    return make(negative, std::move(magnitude), new_scale);
+}
+
+int Decimal::compare(const Decimal& a, const Decimal& b) {
+    if (a.negative != b.negative) {
+        return a.negative ? -1 : 1;
+    }
+    int result;
+    if (a.scale == b.scale) {
+        result = compare_magnitude(a.limbs, b.limbs);
+    } else if (a.scale < b.scale) {
+        Limbs aligned = a.limbs;
+        shift_up(aligned, b.scale - a.scale);
+        result = compare_magnitude(aligned, b.limbs);
+    } else {
+        Limbs aligned = b.limbs;
+        shift_up(aligned, a.scale - b.scale);
+        result = compare_magnitude(a.limbs, aligned);
+    }
+    return a.negative ? -result : result;
+}
+
+Decimal add(const Decimal& a, const Decimal& b) {
+    int scale = std::max(a.scale, b.scale);
+    Limbs left = a.limbs;
+    Limbs right = b.limbs;
+    shift_up(left, scale - a.scale);
+    shift_up(right, scale - b.scale);
+
+    if (a.negative == b.negative) {
+        return Decimal::make(a.negative, add_magnitude(left, right), scale);
+    }
+    int order = compare_magnitude(left, right);
+    if (order >= 0) {
+        return Decimal::make(a.negative, subtract_magnitude(left, right), scale);
+    }
+    return Decimal::make(b.negative, subtract_magnitude(right, left), scale);
+}
+
+Decimal subtract(const Decimal& a, const Decimal& b) {
+    return add(a, b.negated());
+}
+
+Decimal multiply(const Decimal& a, const Decimal& b, int scale) {
+    int full = a.scale + b.scale;
+    int target = std::min(full, std::max({scale, a.scale, b.scale}));
+    Limbs product = multiply_magnitude(a.limbs, b.limbs);
+    shift_down(product, full - target);
+    return Decimal::make(a.negative != b.negative, std::move(product), target);
+}
+
+Decimal divide(const Decimal& a, const Decimal& b, int scale) {
+    if (b.is_zero()) {
+        throw CalcError("Divide by zero");
+    }
+    Limbs numerator = a.limbs;
+    Limbs denominator = b.limbs;
+    int shift = scale + b.scale - a.scale;
+    if (shift >= 0) {
+        shift_up(numerator, shift);
+    } else {
+        shift_up(denominator, -shift);
+    }
+    return Decimal::make(a.negative != b.negative, divide_magnitude(numerator, denominator), scale);
+}
+
+Decimal modulo(const Decimal& a, const Decimal& b) {
+    Decimal quotient = divide(a, b, 0);
+    return subtract(a, multiply(quotient, b, b.get_scale()));
+}
+
+Decimal power(const Decimal& x, const Decimal& y, int scale) {
+    if (y.is_integer()) {
+        int64_t exponent;
+        if (!y.to_int64(exponent)) {
+            throw CalcError("Exponent too large");
+        }
+        if (exponent == 0) {
+            return one();
+        }
+
+        // Exact power by squaring, truncated once at the end
+        uint64_t remaining = exponent < 0 ? 0 - static_cast<uint64_t>(exponent) : static_cast<uint64_t>(exponent);
+        Decimal result = one();
+        Decimal base = x;
+        while (true) {
+            if (remaining & 1) {
+                result = multiply(result, base, result.get_scale() + base.get_scale());
+            }
+            remaining >>= 1;
+            if (remaining == 0) {
+                break;
+            }
+            base = multiply(base, base, 2 * base.get_scale());
+        }
+
+        if (exponent < 0) {
+            return divide(one(), result, scale);
+        }
+        return result.rescaled(std::min(result.get_scale(), std::max(scale, x.get_scale())));
+    }
+
+    if (x.is_negative()) {
+        throw CalcError("Non-integer power of a negative number");
+    }
+    if (x.is_zero()) {
+        if (y.is_negative()) {
+            throw CalcError("Divide by zero");
+        }
+        return Decimal().rescaled(scale);
+    }
+
+    // x^y = e(y * l(x)); the error of l() is scaled by y and by the size of
+    // the result, so carry guard digits for both
+    double magnitude = std::fabs(y.to_double() * std::log10(x.to_double()));
+    double y_digits = std::log10(std::fabs(y.to_double()) + 1);
+    int guard = 10;
+    if (std::isfinite(magnitude) && std::isfinite(y_digits)) {
+        guard += static_cast<int>(std::min(magnitude + y_digits, 1e6));
+    }
+    int inner = scale + guard;
+    return exp(multiply(y, ln(x, inner), inner), inner).rescaled(scale);
+}
+
+Decimal sqrt(const Decimal& x, int scale) {
+    if (x.is_negative()) {
+        throw CalcError("Square root of a negative number");
+    }
+    int result_scale = std::max(scale, x.scale);
+    if (x.is_zero()) {
+        return Decimal::make(false, {}, result_scale);
+    }
+    Limbs value = x.limbs;
+    shift_up(value, 2 * result_scale - x.scale);
+    return Decimal::make(false, integer_sqrt(value), result_scale);
+}
+
+Decimal exp(const Decimal& x, int scale) {
+    bool negative = x.is_negative();
+    Decimal value = x.abs();
+
+    // Halve the argument until it is at most 1 and square the result back
+    int inner = 4 + scale + static_cast<int>(0.44 * value.to_double());
+    int halvings = 0;
+    while (Decimal::compare(value, one()) > 0) {
+        ++halvings;
+        value = divide(value, two(), inner);
+        ++inner;
+    }
+
+    Decimal sum = add(one(), value);
+    Decimal numerator = value;
+    Decimal denominator = one();
+    for (int64_t i = 2;; ++i) {
+        numerator = multiply(numerator, value, inner);
+        denominator = multiply(denominator, Decimal::from_int(i), inner);
+        Decimal term = divide(numerator, denominator, inner);
+        if (term.is_zero()) {
+            break;
+        }
+        sum = add(sum, term);
+    }
+    while (halvings-- > 0) {
+        sum = multiply(sum, sum, inner);
+    }
+
+    if (negative) {
+        return divide(one(), sum, scale);
+    }
+    return sum.rescaled(scale);
+}
+
+Decimal ln(const Decimal& x, int scale) {
+    if (x.is_negative() || x.is_zero()) {
+        throw CalcError("Logarithm of a non-positive number");
+    }
+    static const Decimal half = constant(".5");
+
+    // Take square roots until .5 < x < 2, then sum the atanh series
+    int inner = scale + 6;
+    Decimal factor = two();
+    Decimal value = x;
+    while (Decimal::compare(value, two()) >= 0) {
+        factor = multiply(factor, two(), inner);
+        value = sqrt(value, inner);
+    }
+    while (Decimal::compare(value, half) <= 0) {
+        factor = multiply(factor, two(), inner);
+        value = sqrt(value, inner);
+    }
+
+    Decimal term_numerator = divide(subtract(value, one()), add(value, one()), inner);
+    Decimal sum = term_numerator;
+    Decimal square = multiply(term_numerator, term_numerator, inner);
+    for (int64_t i = 3;; i += 2) {
+        term_numerator = multiply(term_numerator, square, inner);
+        Decimal term = divide(term_numerator, Decimal::from_int(i), inner);
+        if (term.is_zero()) {
+            break;
+        }
+        sum = add(sum, term);
+    }
+    return multiply(factor, sum, inner).rescaled(scale);
+}
+
+Decimal sin(const Decimal& x, int scale) {
+    bool negative = x.is_negative();
+    Decimal value = x.abs();
+
+    // Reduce by the nearest multiple of pi, flipping the sign for odd multiples
+    Decimal quarter_pi = atan(one(), 11 * scale / 10 + 2);
+    Decimal multiple = divide(add(divide(value, quarter_pi, 0), two()), Decimal::from_int(4), 0);
+    value = subtract(value, multiply(multiply(Decimal::from_int(4), multiple, 0), quarter_pi, 0));
+    if (!modulo(multiple, two()).is_zero()) {
+        value = value.negated();
+    }
+
+    int inner = scale + 2;
+    Decimal sum = value;
+    Decimal term = value;
+    Decimal square = multiply(value, value, inner).negated();
+    for (int64_t i = 3;; i += 2) {
+        term = multiply(term, divide(square, Decimal::from_int(i * (i - 1)), inner), inner);
+        if (term.is_zero()) {
+            break;
+        }
+        sum = add(sum, term);
+    }
+    sum = sum.rescaled(scale);
+    return negative ? sum.negated() : sum;
+}
+
+Decimal cos(const Decimal& x, int scale) {
+    int inner = 12 * scale / 10;
+    Decimal half_pi = multiply(atan(one(), inner), two(), inner);
+    return sin(add(x, half_pi), inner).rescaled(scale);
+}
+
+Decimal atan(const Decimal& x, int scale) {
+    static const Decimal fifth = constant(".2");
+    static const Decimal atan_one[] = {
+        constant(".7853981633974483096156608"),
+        constant(".7853981633974483096156608458198757210492"),
+        constant(".785398163397448309615660845819875721049292349843776455243736"),
+    };
+    static const Decimal atan_fifth[] = {
+        constant(".1973955598498807583700497"),
+        constant(".1973955598498807583700497651947902934475"),
+        constant(".197395559849880758370049765194790293447585103787852101517688"),
+    };
+
+    Decimal sign = Decimal::from_int(x.is_negative() ? -1 : 1);
+    Decimal value = x.abs();
+
+    // Known values for the common arguments, as in lib.bc
+    const Decimal* known = nullptr;
+    if (Decimal::compare(value, one()) == 0) {
+        known = atan_one;
+    } else if (Decimal::compare(value, fifth) == 0) {
+        known = atan_fifth;
+    }
+    if (known && scale <= 60) {
+        return divide(known[scale <= 25 ? 0 : scale <= 40 ? 1 : 2], sign, scale);
+    }
+
+    // Reduce with atan(x) = atan(.2) + atan((x - .2) / (1 + .2x))
+    Decimal atan_reduce;
+    if (Decimal::compare(value, fifth) > 0) {
+        atan_reduce = atan(fifth, scale + 5);
+    }
+    int inner = scale + 3;
+    int64_t reductions = 0;
+    while (Decimal::compare(value, fifth) > 0) {
+        ++reductions;
+        value = divide(subtract(value, fifth), add(one(), multiply(value, fifth, inner)), inner);
+    }
+
+    Decimal sum = value;
+    Decimal numerator = value;
+    Decimal square = multiply(value, value, inner).negated();
+    for (int64_t i = 3;; i += 2) {
+        numerator = multiply(numerator, square, inner);
+        Decimal term = divide(numerator, Decimal::from_int(i), inner);
+        if (term.is_zero()) {
+            break;
+        }
+        sum = add(sum, term);
+    }
+    Decimal total = add(multiply(Decimal::from_int(reductions), atan_reduce, inner), sum);
+    return divide(total, sign, scale);
+}
+
+Decimal bessel(const Decimal& n, const Decimal& x, int scale) {
+    int64_t order;
+    if (!n.to_int64(order) || order > INT_MAX || order < -INT_MAX) {
+        throw CalcError("Bessel order too large");
+    }
+    bool negative = false;
+    if (order < 0) {
+        order = -order;
+        negative = order % 2 == 1;
+    }
+
+    // f = x^n / (2^n * n!)
+    Decimal factorial = one();
+    for (int64_t i = 2; i <= order; ++i) {
+        factorial = multiply(factorial, Decimal::from_int(i), 0);
+    }
+    int inner = 3 * scale / 2;
+    Decimal order_value = Decimal::from_int(order);
+    Decimal factor = divide(divide(power(x, order_value, inner), power(two(), order_value, inner), inner),
+                            factorial, inner);
+
+    Decimal sum = one();
+    Decimal term = one();
+    Decimal square = divide(multiply(x, x, inner).negated(), Decimal::from_int(4), inner);
+    inner = 3 * scale / 2 + static_cast<int>(factor.length()) - factor.get_scale();
+    for (int64_t i = 1;; ++i) {
+        term = divide(divide(multiply(term, square, inner), Decimal::from_int(i), inner),
+                      Decimal::from_int(order + i), inner);
+        if (term.is_zero()) {
+            break;
+        }
+        sum = add(sum, term);
+    }
+
+    Decimal result = multiply(factor, sum, scale).rescaled(scale);
+    return negative ? result.negated() : result;
+}
+
+} // namespace calc
+} // namespace neoneo
@@ -0,0 +1,778 @@
+#include "../../include/neoneo/calc/expression.hpp"
+#include <charconv>
+#include <cmath>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace neoneo {
+namespace calc {
+
+namespace {
+
+enum class TokenType { Number, Identifier, Operator, Separator, End };
+
+struct Token {
+    TokenType type = TokenType::End;
+    std::string_view text;
+    size_t position = 0;
+};
+
+struct FunctionInfo {
+    const char* name;
+    Function function;
+    uint8_t arity;
+};
+
+// bc -l names first, then the common spellings models tend to use
+constexpr FunctionInfo FUNCTIONS[] = {
+    {"sqrt", Function::Sqrt, 1},
+    {"s", Function::Sin, 1},      {"sin", Function::Sin, 1},
+    {"c", Function::Cos, 1},      {"cos", Function::Cos, 1},
+    {"tan", Function::Tan, 1},
+    {"a", Function::Atan, 1},     {"atan", Function::Atan, 1},
+    {"l", Function::Ln, 1},       {"ln", Function::Ln, 1},
+    {"e", Function::Exp, 1},      {"exp", Function::Exp, 1},
+    {"j", Function::Bessel, 2},
+    {"abs", Function::Abs, 1},
+    {"length", Function::Length, 1},
+    {"scale", Function::Scale, 1},
+};
+
+constexpr int ASSIGNMENT_POWER = 1;
+constexpr int PREFIX_POWER = 7;
+constexpr int MAX_NESTING = 256;
+
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+bool is_identifier_start(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+bool is_identifier_char(char c) { return is_identifier_start(c) || is_digit(c); }
+
+// Significant digits of a literal, ignoring leading zeros and the exponent
+size_t significant_digits(std::string_view literal) {
+    size_t count = 0;
+    bool leading = true;
+    for (char c : literal) {
+        if (c == 'e' || c == 'E') {
+            break;
+        }
+        if (!is_digit(c) || (leading && c == '0')) {
+            continue;
+        }
+        leading = false;
+        ++count;
+    }
+    return count;
+}
+
+// Binding power of a binary operator, 0 if the token is not one
+int infix_power(const Token& token) {
+    if (token.type != TokenType::Operator) {
+        return 0;
+    }
+    // Two-character forms of + - * / % ^ are compound assignments, not operators
+    bool pair = token.text.size() == 2;
+    switch (token.text[0]) {
+        case '|': return 2;
+        case '&': return 3;
+        case '=': case '!': return pair ? 4 : 0;
+        case '<': case '>': return 4;
+        case '+': case '-': return pair ? 0 : 5;
+        case '*': case '/': case '%': return pair ? 0 : 6;
+        case '^': return pair ? 0 : 8;
+        default: return 0;
+    }
+}
+
+OpCode binary_opcode(std::string_view op) {
+    switch (op[0]) {
+        case '+': return OpCode::Add;
+        case '-': return OpCode::Subtract;
+        case '*': return OpCode::Multiply;
+        case '/': return OpCode::Divide;
+        case '%': return OpCode::Modulo;
+        case '^': return OpCode::Power;
+        case '=': return OpCode::Equal;
+        case '!': return OpCode::NotEqual;
+        case '<': return op.size() == 2 ? OpCode::LessEqual : OpCode::Less;
+        default: return op.size() == 2 ? OpCode::GreaterEqual : OpCode::Greater;
+    }
+}
+
+bool is_assignment(const Token& token) {
+    if (token.type != TokenType::Operator) {
+        return false;
+    }
+    std::string_view op = token.text;
+    return op == "=" || (op.size() == 2 && op[1] == '=' && std::string_view("+-*/%^").find(op[0]) != std::string_view::npos);
+}
+
+// Single-pass compiler: a Pratt parser that emits stack bytecode as it goes
+class Compiler {
+public:
+    explicit Compiler(const std::string& source) : source(source) {
+        // One instruction per character is a generous upper bound for most input
+        program.code.reserve(source.size() + 8);
+        program.constants.reserve(8);
+        program.numbers.reserve(8);
+        program.variables.reserve(4);
+        program.variables.push_back("scale");
+        next();
+    }
+
+    Program compile() {
+        while (current.type != TokenType::End) {
+            if (current.type == TokenType::Separator) {
+                next();
+                continue;
+            }
+            bool assignment = expression(0);
+            emit(assignment ? OpCode::Pop : OpCode::Print, 0, -1);
+            if (current.type != TokenType::Separator && current.type != TokenType::End) {
+                fail("Unexpected '" + std::string(current.text) + "'");
+            }
+        }
+        return std::move(program);
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& message) const {
+        throw CalcError(message + " at position " + std::to_string(current.position + 1));
+    }
+
+    void next() {
+        while (cursor < source.size()) {
+            char c = source[cursor];
+            if (c == ' ' || c == '\t' || c == '\r') {
+                ++cursor;
+            } else if (c == '#') {
+                while (cursor < source.size() && source[cursor] != '\n') {
+                    ++cursor;
+                }
+            } else {
+                break;
+            }
+        }
+
+        current.position = cursor;
+        current.text = {};
+        if (cursor >= source.size()) {
+            current.type = TokenType::End;
+            return;
+        }
+
+        char c = source[cursor];
+        size_t start = cursor;
+        if (is_digit(c) || (c == '.' && cursor + 1 < source.size() && is_digit(source[cursor + 1]))) {
+            bool point = false;
+            while (cursor < source.size() && (is_digit(source[cursor]) || (source[cursor] == '.' && !point))) {
+                point = point || source[cursor] == '.';
+                ++cursor;
+            }
+            // Scientific notation, e.g. 1.5e-3
+            if (cursor < source.size() && (source[cursor] == 'e' || source[cursor] == 'E')) {
+                size_t digits = cursor + 1;
+                if (digits < source.size() && (source[digits] == '+' || source[digits] == '-')) {
+                    ++digits;
+                }
+                if (digits < source.size() && is_digit(source[digits])) {
+                    cursor = digits;
+                    while (cursor < source.size() && is_digit(source[cursor])) {
+                        ++cursor;
+                    }
+                }
+            }
+            current.type = TokenType::Number;
+        } else if (is_identifier_start(c)) {
+            while (cursor < source.size() && is_identifier_char(source[cursor])) {
+                ++cursor;
+            }
+            current.type = TokenType::Identifier;
+        } else if (c == ';' || c == '\n') {
+            ++cursor;
+            current.type = TokenType::Separator;
+        } else {
+            if (std::string_view("+-*/%^()=,<>!&|").find(c) == std::string_view::npos) {
+                fail("Unexpected character '" + std::string(1, c) + "'");
+            }
+            char following = cursor + 1 < source.size() ? source[cursor + 1] : '\0';
+            bool pair = (following == '=' && std::string_view("+-*/%^=!<>").find(c) != std::string_view::npos) ||
+                        ((c == '&' || c == '|') && following == c);
+            if ((c == '&' || c == '|') && !pair) {
+                fail("Unexpected character '" + std::string(1, c) + "'");
+            }
+            cursor += pair ? 2 : 1;
+            current.type = TokenType::Operator;
+        }
+        current.text = std::string_view(source).substr(start, cursor - start);
+    }
+
+    bool accept(const char* op) {
+        if (current.type == TokenType::Operator && current.text == op) {
+            next();
+            return true;
+        }
+        return false;
+    }
+
+    void expect(const char* op) {
+        if (!accept(op)) {
+            fail(std::string("Expected '") + op + "'");
+        }
+    }
+
+    void emit(OpCode op, uint32_t arg, int stack_effect) {
+        program.code.push_back({op, arg});
+        depth = static_cast<size_t>(static_cast<long>(depth) + stack_effect);
+        program.max_stack = std::max(program.max_stack, depth);
+    }
+
+    uint32_t constant(std::string_view literal) {
+        for (size_t i = 0; i < program.constants.size(); ++i) {
+            if (program.constants[i] == literal) {
+                return static_cast<uint32_t>(i);
+            }
+        }
+        double number = 0.0;
+        auto parsed = std::from_chars(literal.data(), literal.data() + literal.size(), number);
+        if (parsed.ec == std::errc::result_out_of_range) {
+            program.literal_out_of_range = true;
+        }
+        program.constants.emplace_back(literal);
+        program.numbers.push_back(number);
+        program.max_literal_digits = std::max(program.max_literal_digits, significant_digits(literal));
+        return static_cast<uint32_t>(program.constants.size() - 1);
+    }
+
+    uint32_t variable(std::string_view name) {
+        if (name == "scale") {
+            program.uses_scale = true;
+        }
+        for (size_t i = 0; i < program.variables.size(); ++i) {
+            if (program.variables[i] == name) {
+                return static_cast<uint32_t>(i);
+            }
+        }
+        program.variables.emplace_back(name);
+        return static_cast<uint32_t>(program.variables.size() - 1);
+    }
+
+    // Jump with its target patched in later
+    size_t emit_jump(OpCode op, int stack_effect) {
+        emit(op, 0, stack_effect);
+        return program.code.size() - 1;
+    }
+
+    void patch(size_t jump) {
+        program.code[jump].arg = static_cast<uint32_t>(program.code.size());
+    }
+
+    // Compile an expression whose operators bind tighter than min_power.
+    // Returns true if it was a bare assignment (which bc does not print).
+    bool expression(int min_power) {
+        if (++nesting > MAX_NESTING) {
+            fail("Expression nested too deeply");
+        }
+        bool assignment = prefix();
+
+        while (true) {
+            int power = infix_power(current);
+            if (power <= min_power) {
+                break;
+            }
+            std::string_view op = current.text;
+            next();
+            assignment = false;
+
+            if (op == "&&" || op == "||") {
+                // Short-circuit: the right operand only runs when it decides the result
+                size_t decided = emit_jump(op == "&&" ? OpCode::JumpIfZero : OpCode::JumpIfNonZero, -1);
+                expression(power);
+                emit(OpCode::Truth, 0, 0);
+                size_t done = emit_jump(OpCode::Jump, -1);
+                patch(decided);
+                emit(OpCode::Constant, constant(op == "&&" ? "0" : "1"), 1);
+                patch(done);
+                continue;
+            }
+
+            // ^ is right associative, everything else left associative
+            expression(op == "^" ? power - 1 : power);
+            emit(binary_opcode(op), 0, -1);
+        }
+
+        --nesting;
+        return assignment;
+    }
+
+    bool prefix() {
+        Token token = current;
+        switch (token.type) {
+            case TokenType::Number:
+                next();
+                emit(OpCode::Constant, constant(token.text), 1);
+                return false;
+
+            case TokenType::Identifier:
+                next();
+                return identifier(token);
+
+            case TokenType::Operator:
+                next();
+                if (token.text == "(") {
+                    expression(0);
+                    expect(")");
+                    return false;
+                }
+                if (token.text == "-" || token.text == "+" || token.text == "!") {
+                    expression(PREFIX_POWER);
+                    if (token.text == "-") {
+                        emit(OpCode::Negate, 0, 0);
+                    } else if (token.text == "!") {
+                        emit(OpCode::Not, 0, 0);
+                    }
+                    return false;
+                }
+                current = token;
+                fail("Unexpected '" + std::string(token.text) + "'");
+
+            default:
+                fail("Expected a number, variable or function");
+        }
+    }
+
+    bool identifier(const Token& name) {
+        if (accept("(")) {
+            const FunctionInfo* info = nullptr;
+            for (const auto& candidate : FUNCTIONS) {
+                if (name.text == candidate.name) {
+                    info = &candidate;
+                    break;
+                }
+            }
+            if (!info) {
+                current = name;
+                fail("Unknown function '" + std::string(name.text) + "'");
+            }
+            if (info->function == Function::Length || info->function == Function::Scale) {
+                program.uses_scale = true;
+            }
+
+            uint32_t count = 0;
+            if (!accept(")")) {
+                do {
+                    expression(0);
+                    ++count;
+                } while (accept(","));
+                expect(")");
+            }
+            if (count != info->arity) {
+                current = name;
+                fail("Function '" + std::string(name.text) + "' takes " + std::to_string(info->arity) + " argument" +
+                     (info->arity == 1 ? "" : "s"));
+            }
+            emit(OpCode::Call, static_cast<uint32_t>(info->function) << 8 | count, 1 - static_cast<int>(count));
+            return false;
+        }
+
+        if (is_assignment(current)) {
+            if (name.text == "pi") {
+                current = name;
+                fail("Cannot assign to the constant pi");
+            }
+            uint32_t slot = variable(name.text);
+            std::string_view op = current.text;
+            next();
+            if (op != "=") {
+                emit(OpCode::Load, slot, 1);
+            }
+            expression(ASSIGNMENT_POWER - 1);
+            if (op != "=") {
+                emit(binary_opcode(op.substr(0, 1)), 0, -1);
+            }
+            emit(OpCode::Store, slot, 0);
+            return true;
+        }
+
+        if (name.text == "pi") {
+            emit(OpCode::Pi, 0, 1);
+        } else {
+            emit(OpCode::Load, variable(name.text), 1);
+        }
+        return false;
+    }
+
+    const std::string& source;
+    size_t cursor = 0;
+    Token current;
+    Program program;
+    size_t depth = 0;
+    int nesting = 0;
+};
+
+// IEEE doubles: the fast path. Flags results doubles can not show exactly
+// so evaluate() can rerun the program with Decimal.
+class DoubleBackend {
+public:
+    using Value = double;
+
+    explicit DoubleBackend(const Program& program) : constants(program.numbers) {}
+
+    bool inexact = false;
+
+    double constant(uint32_t index) const { return constants[index]; }
+    double zero() const { return 0.0; }
+    double pi() const { return M_PI; }
+    double get_scale() const { return 0.0; }
+    void set_scale(double) {}
+
+    double add(double a, double b) { return finite(a + b); }
+    double subtract(double a, double b) { return finite(a - b); }
+    double multiply(double a, double b) { return finite(a * b); }
+
+    double divide(double a, double b) {
+        if (b == 0.0) {
+            throw CalcError("Divide by zero");
+        }
+        return finite(a / b);
+    }
+
+    double modulo(double a, double b) {
+        if (b == 0.0) {
+            throw CalcError("Divide by zero");
+        }
+        return std::fmod(a, b);
+    }
+
+    double power(double a, double b) {
+        if (a < 0.0 && b != std::trunc(b)) {
+            throw CalcError("Non-integer power of a negative number");
+        }
+        if (a == 0.0 && b < 0.0) {
+            throw CalcError("Divide by zero");
+        }
+        return finite(std::pow(a, b));
+    }
+
+    double negate(double a) const { return -a; }
+    bool is_zero(double a) const { return a == 0.0; }
+    double from_bool(bool value) const { return value ? 1.0 : 0.0; }
+    int compare(double a, double b) const { return a < b ? -1 : a > b ? 1 : 0; }
+
+    double call(Function function, const double* args) {
+        double x = args[0];
+        switch (function) {
+            case Function::Sqrt:
+                if (x < 0.0) {
+                    throw CalcError("Square root of a negative number");
+                }
+                return std::sqrt(x);
+            case Function::Sin: return std::sin(x);
+            case Function::Cos: return std::cos(x);
+            case Function::Tan: return finite(std::tan(x));
+            case Function::Atan: return std::atan(x);
+            case Function::Ln:
+                if (x <= 0.0) {
+                    throw CalcError("Logarithm of a non-positive number");
+                }
+                return std::log(x);
+            case Function::Exp: return finite(std::exp(x));
+            case Function::Bessel:
+                if (std::fabs(x) > 2147483647.0) {
+                    throw CalcError("Bessel order too large");
+                }
+                return jn(static_cast<int>(x), args[1]);
+            case Function::Abs: return std::fabs(x);
+            case Function::Length:
+            case Function::Scale:
+                break;
+        }
+        // length() and scale() mark the program as needing Decimal
+        throw CalcError("Function needs the decimal backend");
+    }
+
+    std::string format(double value) {
+        bool exact_integer = std::isfinite(value) && value == std::trunc(value) &&
+                             std::fabs(value) < 9007199254740992.0;
+        if (!std::isfinite(value) || (value == std::trunc(value) && !exact_integer)) {
+            inexact = true;
+        }
+        char buffer[32];
+        std::to_chars_result written;
+        if (exact_integer) {
+            written = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<int64_t>(value));
+        } else {
+            written = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 15);
+        }
+        return std::string(buffer, written.ptr);
+    }
+
+private:
+    double finite(double value) {
+        if (!std::isfinite(value)) {
+            inexact = true;
+        }
+        return value;
+    }
+
+    const std::vector<double>& constants;
+};
+
+// Arbitrary precision with bc's scale rules
+class DecimalBackend {
+public:
+    using Value = Decimal;
+
+    DecimalBackend(const Program& program, int scale, const Limits& limits) : scale(scale), limits(limits) {
+        constants.reserve(program.constants.size());
+        for (const auto& literal : program.constants) {
+            Decimal value;
+            if (!Decimal::parse(literal, value)) {
+                throw CalcError("Invalid number '" + literal + "'");
+            }
+            constants.push_back(checked(std::move(value)));
+        }
+    }
+
+    const Decimal& constant(uint32_t index) const { return constants[index]; }
+    Decimal zero() const { return Decimal(); }
+
+    const Decimal& pi() {
+        if (pi_scale != scale) {
+            pi_value = calc::multiply(calc::atan(Decimal::from_int(1), scale + 2), Decimal::from_int(4), scale + 2)
+                           .rescaled(scale);
+            pi_scale = scale;
+        }
+        return pi_value;
+    }
+
+    Decimal get_scale() const { return Decimal::from_int(scale); }
+
+    void set_scale(const Decimal& value) {
+        int64_t requested;
+        if (!value.to_int64(requested) || requested < 0 || requested > limits.max_scale) {
+            throw CalcError("scale must be between 0 and " + std::to_string(limits.max_scale));
+        }
+        scale = static_cast<int>(requested);
+    }
+
+    Decimal add(const Decimal& a, const Decimal& b) { return checked(calc::add(a, b)); }
+    Decimal subtract(const Decimal& a, const Decimal& b) { return checked(calc::subtract(a, b)); }
+    Decimal multiply(const Decimal& a, const Decimal& b) { return checked(calc::multiply(a, b, scale)); }
+    Decimal divide(const Decimal& a, const Decimal& b) { return checked(calc::divide(a, b, scale)); }
+    Decimal modulo(const Decimal& a, const Decimal& b) { return calc::modulo(a, b); }
+
+    Decimal power(const Decimal& a, const Decimal& b) {
+        // Estimate the size of the result before computing it
+        double digits;
+        if (b.is_integer()) {
+            bool unit = a.is_zero() || Decimal::compare(a.abs(), Decimal::from_int(1)) == 0;
+            digits = unit ? 0.0 : static_cast<double>(a.length()) * std::fabs(b.to_double());
+        } else {
+            digits = std::fabs(b.to_double() * std::log10(a.abs().to_double()));
+        }
+        if (!(digits <= static_cast<double>(limits.max_digits))) {
+            too_large();
+        }
+        return checked(calc::power(a, b, scale));
+    }
+
+    Decimal negate(const Decimal& a) const { return a.negated(); }
+    bool is_zero(const Decimal& a) const { return a.is_zero(); }
+    Decimal from_bool(bool value) const { return Decimal::from_int(value ? 1 : 0); }
+    int compare(const Decimal& a, const Decimal& b) const { return Decimal::compare(a, b); }
+
+    Decimal call(Function function, const Decimal* args) {
+        const Decimal& x = args[0];
+        switch (function) {
+            case Function::Sqrt: return calc::sqrt(x, scale);
+            case Function::Sin: return calc::sin(x, scale);
+            case Function::Cos: return calc::cos(x, scale);
+            case Function::Tan: {
+                Decimal cosine = calc::cos(x, scale + 5);
+                if (cosine.is_zero()) {
+                    throw CalcError("Tangent is undefined");
+                }
+                return checked(calc::divide(calc::sin(x, scale + 5), cosine, scale));
+            }
+            case Function::Atan: return calc::atan(x, scale);
+            case Function::Ln: return calc::ln(x, scale);
+            case Function::Exp:
+                // e^x has about 0.434 * x integer digits
+                if (!(x.to_double() * 0.4343 <= static_cast<double>(limits.max_digits))) {
+                    too_large();
+                }
+                return calc::exp(x, scale);
+            case Function::Bessel:
+                if (x.integer_digits() > 6 || args[1].integer_digits() > 6) {
+                    too_large();
+                }
+                return calc::bessel(x, args[1], scale);
+            case Function::Abs: return x.abs();
+            case Function::Length: return Decimal::from_int(static_cast<int64_t>(x.length()));
+            case Function::Scale: return Decimal::from_int(x.get_scale());
+        }
+        return Decimal();
+    }
+
+    std::string format(const Decimal& value) const { return value.to_string(); }
+
+private:
+    [[noreturn]] void too_large() const {
+        throw CalcError("Result too large (limit is " + std::to_string(limits.max_digits) + " digits)");
+    }
+
+    Decimal checked(Decimal value) const {
+        if (value.integer_digits() > limits.max_digits) {
+            too_large();
+        }
+        return value;
+    }
+
+    int scale;
+    Limits limits;
+    std::vector<Decimal> constants;
+    Decimal pi_value;
+    int pi_scale = -1;
+};
+
+template <typename Backend>
+std::string run(const Program& program, Backend& backend) {
+    using Value = typename Backend::Value;
+
+    std::vector<Value> stack;
+    stack.reserve(program.max_stack);
+    std::vector<Value> variables(program.variables.size(), backend.zero());
+    std::string output;
+
+    const auto& code = program.code;
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        const Instruction& instruction = code[pc];
+        switch (instruction.op) {
+            case OpCode::Constant:
+                stack.push_back(backend.constant(instruction.arg));
+                break;
+            case OpCode::Pi:
+                stack.push_back(backend.pi());
+                break;
+            case OpCode::Load:
+                stack.push_back(instruction.arg == 0 ? backend.get_scale() : variables[instruction.arg]);
+                break;
+            case OpCode::Store:
+                if (instruction.arg == 0) {
+                    backend.set_scale(stack.back());
+                } else {
+                    variables[instruction.arg] = stack.back();
+                }
+                break;
+            case OpCode::Pop:
+                stack.pop_back();
+                break;
+            case OpCode::Print:
+                output += backend.format(stack.back());
+                output += '\n';
+                stack.pop_back();
+                break;
+            case OpCode::Negate:
+                stack.back() = backend.negate(stack.back());
+                break;
+            case OpCode::Not:
+                stack.back() = backend.from_bool(backend.is_zero(stack.back()));
+                break;
+            case OpCode::Truth:
+                stack.back() = backend.from_bool(!backend.is_zero(stack.back()));
+                break;
+            case OpCode::Jump:
+                pc = instruction.arg - 1;
+                break;
+            case OpCode::JumpIfZero:
+            case OpCode::JumpIfNonZero: {
+                bool zero = backend.is_zero(stack.back());
+                stack.pop_back();
+                if (zero == (instruction.op == OpCode::JumpIfZero)) {
+                    pc = instruction.arg - 1;
+                }
+                break;
+            }
+            case OpCode::Call: {
+                size_t count = instruction.arg & 0xff;
+                auto function = static_cast<Function>(instruction.arg >> 8);
+                Value result = backend.call(function, stack.data() + stack.size() - count);
+                stack.resize(stack.size() - count);
+                stack.push_back(std::move(result));
+                break;
+            }
+            default: {
+                Value right = std::move(stack.back());
+                stack.pop_back();
+                Value& left = stack.back();
+                switch (instruction.op) {
+                    case OpCode::Add: left = backend.add(left, right); break;
+                    case OpCode::Subtract: left = backend.subtract(left, right); break;
+                    case OpCode::Multiply: left = backend.multiply(left, right); break;
+                    case OpCode::Divide: left = backend.divide(left, right); break;
+                    case OpCode::Modulo: left = backend.modulo(left, right); break;
+                    case OpCode::Power: left = backend.power(left, right); break;
+                    case OpCode::Equal: left = backend.from_bool(backend.compare(left, right) == 0); break;
+                    case OpCode::NotEqual: left = backend.from_bool(backend.compare(left, right) != 0); break;
+                    case OpCode::Less: left = backend.from_bool(backend.compare(left, right) < 0); break;
+                    case OpCode::LessEqual: left = backend.from_bool(backend.compare(left, right) <= 0); break;
+                    case OpCode::Greater: left = backend.from_bool(backend.compare(left, right) > 0); break;
+                    case OpCode::GreaterEqual: left = backend.from_bool(backend.compare(left, right) >= 0); break;
+                    default: break;
+                }
+                break;
+            }
+        }
+    }
+
+    if (!output.empty()) {
+        output.pop_back();
+    }
+    return output;
+}
+
+} // namespace
+
+Program compile(const std::string& source) {
+    return Compiler(source).compile();
+}
+
+EvalResult evaluate(const Program& program, const EvalOptions& options) {
+    EvalResult result;
+
+    bool decimal = options.backend == Backend::Decimal || options.scale.has_value() || program.uses_scale ||
+                   (options.backend == Backend::Auto &&
+                    (program.max_literal_digits > 15 || program.literal_out_of_range));
+    if (options.backend == Backend::Double && program.uses_scale) {
+        throw CalcError("scale, length() and scale() need the decimal backend");
+    }
+    if (options.backend == Backend::Double && program.literal_out_of_range) {
+        throw CalcError("A number is out of range for the double backend");
+    }
+
+    if (!decimal) {
+        DoubleBackend backend(program);
+        result.output = run(program, backend);
+        result.backend = Backend::Double;
+        if (!backend.inexact || options.backend == Backend::Double) {
+            return result;
+        }
+    }
+
+    // Same default as bc -l
+    int scale = options.scale.value_or(20);
+    if (scale < 0 || scale > options.limits.max_scale) {
+        throw CalcError("scale must be between 0 and " + std::to_string(options.limits.max_scale));
+    }
+    DecimalBackend backend(program, scale, options.limits);
+    result.output = run(program, backend);
+    result.backend = Backend::Decimal;
+    return result;
+}
+
+EvalResult evaluate(const std::string& source, const EvalOptions& options) {
+    return evaluate(compile(source), options);
+}
+
+} // namespace calc
+} // namespace neoneo
@@ -0,0 +1,135 @@
+#include "../../include/neoneo/calc/statistics.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace neoneo {
+namespace calc {
+
+Summary summarize(const double* data, size_t count) {
+    Summary summary;
+    summary.count = count;
+    if (count == 0) {
+        return summary;
+    }
+
+    // Sums are taken of deviations from the first value, which keeps the
+    // one-pass variance formula stable when values are large but close
+    double shift = data[0];
+    double deviation = 0.0;
+    double squares = 0.0;
+    double low = data[0];
+    double high = data[0];
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // Two independent accumulators of two lanes each hide the add latency
+    const __m128d shift_vector = _mm_set1_pd(shift);
+    __m128d deviation0 = _mm_setzero_pd(), deviation1 = _mm_setzero_pd();
+    __m128d squares0 = _mm_setzero_pd(), squares1 = _mm_setzero_pd();
+    __m128d low0 = _mm_set1_pd(low), low1 = low0;
+    __m128d high0 = _mm_set1_pd(high), high1 = high0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128d a = _mm_loadu_pd(data + i);
+        __m128d b = _mm_loadu_pd(data + i + 2);
+        low0 = _mm_min_pd(low0, a);
+        low1 = _mm_min_pd(low1, b);
+        high0 = _mm_max_pd(high0, a);
+        high1 = _mm_max_pd(high1, b);
+        a = _mm_sub_pd(a, shift_vector);
+        b = _mm_sub_pd(b, shift_vector);
+        deviation0 = _mm_add_pd(deviation0, a);
+        deviation1 = _mm_add_pd(deviation1, b);
+        squares0 = _mm_add_pd(squares0, _mm_mul_pd(a, a));
+        squares1 = _mm_add_pd(squares1, _mm_mul_pd(b, b));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(deviation0, deviation1));
+    deviation = lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, _mm_add_pd(squares0, squares1));
+    squares = lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, _mm_min_pd(low0, low1));
+    low = std::min(lanes[0], lanes[1]);
+    _mm_storeu_pd(lanes, _mm_max_pd(high0, high1));
+    high = std::max(lanes[0], lanes[1]);
+#endif
+
+    for (; i < count; ++i) {
+        double value = data[i];
+        low = std::min(low, value);
+        high = std::max(high, value);
+        double d = value - shift;
+        deviation += d;
+        squares += d * d;
+    }
+
+    double n = static_cast<double>(count);
+    summary.mean = shift + deviation / n;
+    summary.sum = shift * n + deviation;
+    if (count > 1) {
+        summary.variance = std::max(0.0, (squares - deviation * deviation / n) / (n - 1));
+    }
+    summary.stddev = std::sqrt(summary.variance);
+    summary.min = low;
+    summary.max = high;
+    return summary;
+}
+
+std::vector<double> percentiles(std::vector<double>& data, const std::vector<double>& ranks) {
+    std::vector<double> results(ranks.size(), 0.0);
+    if (data.empty()) {
+        return results;
+    }
+
+    // Order statistics needed for every requested rank
+    size_t last = data.size() - 1;
+    std::vector<size_t> indices;
+    indices.reserve(ranks.size() * 2);
+    for (double rank : ranks) {
+        double position = std::clamp(rank, 0.0, 100.0) / 100.0 * static_cast<double>(last);
+        size_t below = static_cast<size_t>(position);
+        indices.push_back(below);
+        indices.push_back(std::min(below + 1, last));
+    }
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    // Each selection only has to partition what lies above the previous one
+    size_t start = 0;
+    for (size_t index : indices) {
+        std::nth_element(data.begin() + start, data.begin() + index, data.end());
+        start = index + 1;
+    }
+
+    for (size_t i = 0; i < ranks.size(); ++i) {
+        double position = std::clamp(ranks[i], 0.0, 100.0) / 100.0 * static_cast<double>(last);
+        size_t below = static_cast<size_t>(position);
+        size_t above = std::min(below + 1, last);
+        double fraction = position - static_cast<double>(below);
+        results[i] = data[below] + fraction * (data[above] - data[below]);
+    }
+    return results;
+}
+
+std::vector<size_t> histogram(const double* data, size_t count, double min, double max, size_t bins) {
+    std::vector<size_t> counts(bins, 0);
+    if (bins == 0) {
+        return counts;
+    }
+    // Divided before subtracting, so finite values far apart do not overflow to inf
+    double scale = static_cast<double>(bins);
+    double range = max / scale - min / scale;
+    for (size_t i = 0; i < count; ++i) {
+        double position = range > 0.0 ? (data[i] / scale - min / scale) / range * scale : 0.0;
+        ++counts[static_cast<size_t>(std::min(position, static_cast<double>(bins - 1)))];
+    }
+    return counts;
+}
+
+} // namespace calc
+} // namespace neoneo
@@ -97,8 +97,14 @@ nlohmann::json Config::to_json() const {
         {"enable_model_list", enable_model_list},
         {"enable_file_ops", enable_file_ops},
         {"auto_confirm_file_ops", auto_confirm_file_ops},
+        {"enable_search_index", enable_search_index},
         {"ignore_calc_safety", ignore_calc_safety},
-        {"ignore_shell_safety", ignore_shell_safety}
+        {"ignore_shell_safety", ignore_shell_safety},
+        {"shell_policy_rules", shell_policy_rules},
+        {"tool_output_max_age", tool_output_max_age},
+        {"tool_output_max_bytes", tool_output_max_bytes},
+        {"reduce_tool_output", reduce_tool_output},
+        {"memoize_tools", memoize_tools}
     };
 }
 
@@ -142,6 +148,10 @@ Config Config::from_json(const nlohmann::json& json) {
         config.auto_confirm_file_ops = json["auto_confirm_file_ops"].get<bool>();
     }
     
+    if (json.contains("enable_search_index") && json["enable_search_index"].is_boolean()) {
+        config.enable_search_index = json["enable_search_index"].get<bool>();
+    }
+    
     if (json.contains("ignore_calc_safety") && json["ignore_calc_safety"].is_boolean()) {
         config.ignore_calc_safety = json["ignore_calc_safety"].get<bool>();
     }
@@ -150,6 +160,30 @@ Config Config::from_json(const nlohmann::json& json) {
         config.ignore_shell_safety = json["ignore_shell_safety"].get<bool>();
     }
     
+    if (json.contains("shell_policy_rules") && json["shell_policy_rules"].is_array()) {
+        for (const auto& rule : json["shell_policy_rules"]) {
+            if (rule.is_string()) {
+                config.shell_policy_rules.push_back(rule.get<std::string>());
+            }
+        }
+    }
+    
+    if (json.contains("tool_output_max_age") && json["tool_output_max_age"].is_number_integer()) {
+        config.tool_output_max_age = json["tool_output_max_age"].get<int>();
+    }
+    
+    if (json.contains("tool_output_max_bytes") && json["tool_output_max_bytes"].is_number_unsigned()) {
+        config.tool_output_max_bytes = json["tool_output_max_bytes"].get<size_t>();
+    }
+    
+    if (json.contains("reduce_tool_output") && json["reduce_tool_output"].is_boolean()) {
+        config.reduce_tool_output = json["reduce_tool_output"].get<bool>();
+    }
+    
+    if (json.contains("memoize_tools") && json["memoize_tools"].is_boolean()) {
+        config.memoize_tools = json["memoize_tools"].get<bool>();
+    }
+    
     return config;
 }
 
@@ -0,0 +1,342 @@
+#include "../../include/neoneo/conversation/output_reduction.hpp"
+#include "../../include/neoneo/io/utf8.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace neoneo {
+namespace conversation {
+
+namespace {
+
+const char ESC = '\x1b';
+
+// Lines mentioning any of these are kept when the output has to be cut
+const char* const ERROR_WORDS[] = {"error", "fail", "fatal", "exception", "panic", "traceback", "abort",
+                                   "segmentation fault", "undefined reference", "assert"};
+
+// First byte at or after pos that is a control character (below 0x20 or DEL), or end
+size_t next_control(const char* data, size_t pos, size_t end) {
+#if defined(__SSE2__)
+    // Unsigned bytes up to 0x1f are exactly those whose maximum with 0x1f is 0x1f
+    const __m128i limit = _mm_set1_epi8(0x1f);
+    const __m128i del = _mm_set1_epi8(0x7f);
+    while (pos + 16 <= end) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i low = _mm_cmpeq_epi8(_mm_max_epu8(chunk, limit), limit);
+        int mask = _mm_movemask_epi8(_mm_or_si128(low, _mm_cmpeq_epi8(chunk, del)));
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+        pos += 16;
+    }
+#endif
+    for (; pos < end; ++pos) {
+        unsigned char c = static_cast<unsigned char>(data[pos]);
+        if (c < 0x20 || c == 0x7f) {
+            return pos;
+        }
+    }
+    return end;
+}
+
+// Bytes taken by the escape sequence at line[pos], which is ESC
+size_t escape_length(std::string_view line, size_t pos) {
+    size_t i = pos + 1;
+    if (i >= line.size()) {
+        return 1;
+    }
+    char kind = line[i++];
+    if (kind == '[') {
+        // CSI: parameter and intermediate bytes, then one final byte
+        while (i < line.size() && line[i] >= 0x20 && line[i] <= 0x3f) {
+            ++i;
+        }
+        return (i < line.size() && line[i] >= 0x40 && line[i] <= 0x7e ? i + 1 : i) - pos;
+    }
+    if (kind == ']' || kind == 'P' || kind == '_' || kind == '^') {
+        // OSC and other strings: up to BEL or ESC backslash
+        for (; i < line.size(); ++i) {
+            if (line[i] == '\a') {
+                return i + 1 - pos;
+            }
+            if (line[i] == ESC && i + 1 < line.size() && line[i + 1] == '\\') {
+                return i + 2 - pos;
+            }
+        }
+        return line.size() - pos;
+    }
+    // Two-byte sequences, some with intermediate bytes first ("ESC ( B")
+    while (kind >= 0x20 && kind <= 0x2f && i < line.size()) {
+        kind = line[i++];
+    }
+    return i - pos;
+}
+
+// The line as a terminal would show it, in scratch unless it needed no changes
+std::string_view clean_line(std::string_view line, size_t first_control, const ReductionOptions& options,
+                            std::string& scratch, ReductionStats& stats) {
+    scratch.assign(line.data(), first_control);
+    size_t pos = first_control;
+    while (pos < line.size()) {
+        char c = line[pos];
+        if (c == ESC && options.strip_control) {
+            pos += escape_length(line, pos);
+            ++stats.escapes_removed;
+        } else if (c == '\r' && pos + 1 == line.size()) {
+            ++pos; // CRLF line ending
+        } else if (c == '\r' && options.collapse_progress) {
+            // What follows is drawn over what came before
+            if (!scratch.empty()) {
+                ++stats.progress_updates;
+            }
+            scratch.clear();
+            ++pos;
+        } else if (c == '\b' && options.strip_control) {
+            if (!scratch.empty()) {
+                scratch.pop_back();
+            }
+            ++stats.escapes_removed;
+            ++pos;
+        } else if (c != '\t' && options.strip_control) {
+            ++stats.escapes_removed;
+            ++pos;
+        } else {
+            scratch += c;
+            ++pos;
+        }
+        size_t next = next_control(line.data(), pos, line.size());
+        scratch.append(line.data() + pos, next - pos);
+        pos = next;
+    }
+    return scratch;
+}
+
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool is_hex(char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// Hash of the line with every number (and hex run starting with a digit) counted as one '#'
+uint64_t shape_hash(std::string_view line) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < line.size();) {
+        char c = line[i];
+        if (is_digit(c)) {
+            while (i < line.size() && (is_hex(line[i]) || line[i] == 'x' || line[i] == 'X')) {
+                ++i;
+            }
+            c = '#';
+        } else {
+            ++i;
+        }
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool mentions_error(std::string_view line) {
+    std::string lowered(line.substr(0, 1024));
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+                   [](unsigned char c) { return static_cast<char>(c >= 'A' && c <= 'Z' ? c + 32 : c); });
+    for (const char* word : ERROR_WORDS) {
+        if (lowered.find(word) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Consecutive lines of the same shape, written out once the shape changes
+class RunWriter {
+public:
+    RunWriter(const ReductionOptions& options, ReductionStats& stats, std::string& out)
+        : options(options), stats(stats), out(out) {}
+
+    void add(std::string_view line) {
+        if (options.min_run == 0) {
+            write(line);
+            return;
+        }
+        uint64_t hash = shape_hash(line);
+        if (count > 0 && hash == shape) {
+            identical = identical && line == first;
+            if (count < options.min_run) {
+                pending.emplace_back(line);
+            }
+            last.assign(line.data(), line.size());
+            ++count;
+            return;
+        }
+        flush();
+        shape = hash;
+        count = 1;
+        identical = true;
+        first.assign(line.data(), line.size());
+        last = first;
+        pending.assign(1, first);
+    }
+
+    void flush() {
+        if (count == 0) {
+            return;
+        }
+        if (count < options.min_run) {
+            for (const auto& line : pending) {
+                write(line);
+            }
+        } else if (identical) {
+            write(first);
+            write("[... previous line repeated " + std::to_string(count - 1) + " more times]");
+            stats.lines_collapsed += count - 1;
+        } else {
+            write(first);
+            write("[... " + std::to_string(count - 2) + " similar lines ...]");
+            write(last);
+            stats.lines_collapsed += count - 2;
+        }
+        count = 0;
+        pending.clear();
+    }
+
+private:
+    void write(std::string_view line) {
+        out.append(line.data(), line.size());
+        out += '\n';
+    }
+
+    const ReductionOptions& options;
+    ReductionStats& stats;
+    std::string& out;
+    uint64_t shape = 0;
+    size_t count = 0;
+    bool identical = true;
+    std::string first;
+    std::string last;
+    std::vector<std::string> pending; // All lines of the run while it is shorter than min_run
+};
+
+// Keep the head, the tail and the lines around errors within max_bytes
+std::string cut_to_fit(const std::string& text, const ReductionOptions& options, ReductionStats& stats) {
+    // Lines too long for the head or tail on their own are taken in pieces
+    size_t quarter = std::max<size_t>(options.max_bytes / 4, 1);
+    std::vector<std::string_view> lines;
+    for (size_t pos = 0; pos < text.size();) {
+        size_t end = text.find('\n', pos);
+        end = end == std::string::npos ? text.size() : end + 1;
+        if (end - pos > quarter) {
+            size_t cut = io::utf8_boundary(text, pos + quarter);
+            end = cut > pos ? cut : pos + quarter;
+        }
+        lines.emplace_back(text.data() + pos, end - pos);
+        pos = end;
+    }
+
+    std::vector<bool> keep(lines.size(), false);
+    size_t budget = options.max_bytes;
+    auto take = [&](size_t i, size_t limit) {
+        if (keep[i] || lines[i].size() > limit || lines[i].size() > budget) {
+            return false;
+        }
+        keep[i] = true;
+        budget -= lines[i].size();
+        return true;
+    };
+
+    // A quarter for the head and a quarter for the tail, the rest around errors
+    size_t used = 0;
+    for (size_t i = 0; i < lines.size() && used + lines[i].size() <= quarter && take(i, quarter); ++i) {
+        used += lines[i].size();
+    }
+    used = 0;
+    for (size_t i = lines.size(); i-- > 0 && used + lines[i].size() <= quarter && (keep[i] || take(i, quarter));) {
+        used += lines[i].size();
+    }
+    for (size_t i = 0; i < lines.size() && budget > 0; ++i) {
+        if (keep[i] || !mentions_error(lines[i])) {
+            continue;
+        }
+        size_t from = i > options.context_lines ? i - options.context_lines : 0;
+        size_t to = std::min(lines.size(), i + options.context_lines + 1);
+        for (size_t j = from; j < to; ++j) {
+            take(j, budget);
+        }
+    }
+
+    std::string out;
+    for (size_t i = 0; i < lines.size();) {
+        if (keep[i]) {
+            out.append(lines[i].data(), lines[i].size());
+            ++i;
+            continue;
+        }
+        size_t skipped = 0;
+        for (; i < lines.size() && !keep[i]; ++i) {
+            ++skipped;
+        }
+        if (!out.empty() && out.back() != '\n') {
+            out += '\n';
+        }
+        out += "[... " + std::to_string(skipped) + " lines omitted ...]\n";
+        stats.lines_omitted += skipped;
+    }
+    return out;
+}
+
+} // namespace
+
+std::string reduce_output(std::string_view text, const ReductionOptions& options, ReductionStats& stats) {
+    stats = ReductionStats{};
+    stats.input_bytes = text.size();
+
+    std::string out;
+    out.reserve(text.size());
+    RunWriter runs(options, stats, out);
+    std::string scratch;
+    bool clean = options.strip_control || options.collapse_progress;
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        // One scan finds the line end or, on lines that need cleaning, the first thing to clean
+        size_t control = next_control(text.data(), pos, text.size());
+        while (control < text.size() && text[control] == '\t') {
+            control = next_control(text.data(), control + 1, text.size());
+        }
+        size_t end = control;
+        if (control < text.size() && text[control] != '\n') {
+            const void* newline = std::memchr(text.data() + control, '\n', text.size() - control);
+            end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - text.data()) : text.size();
+        }
+
+        std::string_view line = text.substr(pos, end - pos);
+        if (clean && control < end) {
+            line = clean_line(line, control - pos, options, scratch, stats);
+        }
+        runs.add(line);
+        pos = end + 1;
+    }
+    runs.flush();
+
+    // Lines were written with newlines; keep the original ending
+    if (!text.empty() && text.back() != '\n' && !out.empty()) {
+        out.pop_back();
+    }
+
+    if (options.max_bytes > 0 && out.size() > options.max_bytes) {
+        out = cut_to_fit(out, options, stats);
+    }
+    stats.output_bytes = out.size();
+    return out;
+}
+
+} // namespace conversation
+} // namespace neoneo
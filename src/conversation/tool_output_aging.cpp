@@ -0,0 +1,187 @@
+#include "../../include/neoneo/conversation/tool_output_aging.hpp"
+#include "../../include/neoneo/io/utf8.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace neoneo {
+namespace conversation {
+
+namespace {
+
+// Leading excerpt, cut at the last line break within the budget when there is one
+std::string head_excerpt(const std::string& text, size_t max_bytes) {
+    if (text.size() <= max_bytes) {
+        return text;
+    }
+    size_t end = text.rfind('\n', max_bytes);
+    if (end == std::string::npos || end == 0) {
+        end = io::utf8_boundary(text, max_bytes);
+    }
+    return text.substr(0, end);
+}
+
+// Trailing excerpt, starting after the first line break within the budget when there is one
+std::string tail_excerpt(const std::string& text, size_t max_bytes) {
+    if (text.size() <= max_bytes) {
+        return text;
+    }
+    size_t start = text.size() - max_bytes;
+    size_t newline = text.find('\n', start);
+    if (newline != std::string::npos && newline + 1 < text.size()) {
+        start = newline + 1;
+    } else {
+        start = io::utf8_boundary(text, start);
+    }
+    return text.substr(start);
+}
+
+} // namespace
+
+ToolOutputAging::ToolOutputAging(AgingPolicy policy) : policy(policy) {}
+
+void ToolOutputAging::begin_turn() {
+    ++turn;
+}
+
+size_t ToolOutputAging::track(const ChatMessage& message) {
+    ArchivedOutput output;
+    output.id = outputs.size() + 1;
+    output.tool_name = message.name;
+    output.turn = turn;
+    output.content = message.content;
+    output.size = message.content.size();
+    output.hash = hash_content(message.content);
+    outputs.push_back(std::move(output));
+    return outputs.back().id;
+}
+
+bool AgingPolicy::is_aged(int age, size_t size) const {
+    if (max_age_turns > 0 && age >= max_age_turns) {
+        return true;
+    }
+    // Oversized outputs stay verbatim only for the turn that produced them
+    return max_bytes > 0 && age >= 1 && size > max_bytes;
+}
+
+bool ToolOutputAging::is_aged(const ArchivedOutput& output) const {
+    return policy.is_aged(turn - output.turn, output.size);
+}
+
+size_t ToolOutputAging::apply(std::vector<ChatMessage>& conversation) {
+    size_t bytes_removed = 0;
+    size_t index = 0;
+
+    for (auto& message : conversation) {
+        if (message.role != "tool") {
+            continue;
+        }
+        if (index >= outputs.size()) {
+            break;
+        }
+
+        ArchivedOutput& output = outputs[index++];
+        if (output.stubbed || !is_aged(output)) {
+            continue;
+        }
+
+        // Only replace the message we archived, never something edited in between
+        if (message.content.size() != output.size ||
+            hash_content(message.content) != output.hash) {
+            continue;
+        }
+
+        std::string stub = make_stub(output);
+        if (stub.size() >= message.content.size()) {
+            continue;
+        }
+
+        bytes_removed += message.content.size() - stub.size();
+        message.content = std::move(stub);
+        output.stubbed = true;
+        output.last_used = ++uses;
+        archived_bytes += output.size;
+    }
+
+    evict_to_fit();
+    return bytes_removed;
+}
+
+void ToolOutputAging::evict_to_fit() {
+    // Outputs not yet stubbed are still in the conversation and are never evicted
+    while (policy.archive_bytes > 0 && archived_bytes > policy.archive_bytes) {
+        ArchivedOutput* oldest = nullptr;
+        for (auto& output : outputs) {
+            if (output.stubbed && !output.evicted && (!oldest || output.last_used < oldest->last_used)) {
+                oldest = &output;
+            }
+        }
+        if (!oldest) {
+            break;
+        }
+        std::string().swap(oldest->content);
+        oldest->evicted = true;
+        archived_bytes -= oldest->size;
+    }
+}
+
+const ArchivedOutput* ToolOutputAging::find(size_t id) {
+    if (id == 0 || id > outputs.size()) {
+        return nullptr;
+    }
+    ArchivedOutput& output = outputs[id - 1];
+    if (output.stubbed) {
+        output.last_used = ++uses;
+    }
+    return &output;
+}
+
+void ToolOutputAging::reset() {
+    outputs.clear();
+    archived_bytes = 0;
+}
+
+uint64_t ToolOutputAging::hash_content(const std::string& content) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : content) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::string ToolOutputAging::make_stub(const ArchivedOutput& output) const {
+    const std::string& content = output.content;
+    size_t lines = std::count(content.begin(), content.end(), '\n');
+    if (!content.empty() && content.back() != '\n') {
+        ++lines;
+    }
+
+    char hash_hex[17];
+    std::snprintf(hash_hex, sizeof(hash_hex), "%016llx", static_cast<unsigned long long>(output.hash));
+
+    std::string stub = "[tool output #" + std::to_string(output.id);
+    if (!output.tool_name.empty()) {
+        stub += " from '" + output.tool_name + "'";
+    }
+    stub += " aged out: " + std::to_string(content.size()) + " bytes, " +
+            std::to_string(lines) + " lines, fnv1a " + hash_hex +
+            ". The full output is kept locally.]\n";
+
+    std::string head = head_excerpt(content, policy.head_bytes);
+    std::string tail = tail_excerpt(content, policy.tail_bytes);
+
+    if (head.size() + tail.size() >= content.size()) {
+        stub += content;
+        return stub;
+    }
+
+    stub += "--- head ---\n" + head;
+    if (!head.empty() && head.back() != '\n') {
+        stub += "\n";
+    }
+    stub += "--- tail ---\n" + tail;
+    return stub;
+}
+
+} // namespace conversation
+} // namespace neoneo
@@ -0,0 +1,110 @@
+#include "../../include/neoneo/io/batch_read.hpp"
+#include "../../include/neoneo/io/content_cache.hpp"
+#include "../../include/neoneo/io/parallel.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace neoneo {
+namespace io {
+
+namespace {
+
+// Bytes checked for NUL when deciding whether a file is binary
+constexpr size_t BINARY_PROBE = 8192;
+
+} // namespace
+
+std::vector<FileContent> read_batch(const std::vector<std::string>& paths, size_t per_file, size_t total,
+                                    ContentCache* cache) {
+    std::vector<FileContent> files(paths.size());
+    std::vector<int> descriptors(paths.size(), -1);
+    std::vector<std::shared_ptr<const MappedFile>> mapped(paths.size());
+    size_t threads = io_threads(paths.size());
+
+    // Open and size every file
+    parallel_for(paths.size(), threads, [&](size_t i) {
+        FileContent& file = files[i];
+        file.path = paths[i];
+        if (cache) {
+            mapped[i] = cache->open(file.path, file.error);
+            file.size = mapped[i] ? mapped[i]->size() : 0;
+            return;
+        }
+        int fd = ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            file.error = std::strerror(errno);
+            return;
+        }
+        struct stat info {};
+        if (fstat(fd, &info) != 0) {
+            file.error = std::strerror(errno);
+            close(fd);
+            return;
+        }
+        if (!S_ISREG(info.st_mode)) {
+            file.error = "Not a regular file";
+            close(fd);
+            return;
+        }
+        file.size = static_cast<uint64_t>(info.st_size);
+        descriptors[i] = fd;
+    });
+
+    // Share out the budget in request order
+    std::vector<size_t> budgets(paths.size(), 0);
+    size_t remaining = total;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (descriptors[i] >= 0 || mapped[i]) {
+            budgets[i] = static_cast<size_t>(std::min<uint64_t>({files[i].size, per_file, remaining}));
+            remaining -= budgets[i];
+        }
+    }
+
+    parallel_for(paths.size(), threads, [&](size_t i) {
+        int fd = descriptors[i];
+        if (fd < 0 && !mapped[i]) {
+            return;
+        }
+        FileContent& file = files[i];
+        file.data.resize(budgets[i]);
+
+        size_t filled = 0;
+        if (mapped[i]) {
+            std::memcpy(&file.data[0], mapped[i]->data(), budgets[i]);
+            filled = budgets[i];
+        }
+        while (fd >= 0 && filled < file.data.size()) {
+            ssize_t got = pread(fd, &file.data[filled], file.data.size() - filled, static_cast<off_t>(filled));
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got < 0) {
+                file.error = std::strerror(errno);
+                break;
+            }
+            if (got == 0) {
+                break; // Shrank since fstat
+            }
+            filled += static_cast<size_t>(got);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        file.data.resize(filled);
+        file.truncated = filled < file.size;
+        if (std::memchr(file.data.data(), '\0', std::min(filled, BINARY_PROBE))) {
+            file.binary = true;
+            file.data.clear();
+        }
+    });
+
+    return files;
+}
+
+} // namespace io
+} // namespace neoneo
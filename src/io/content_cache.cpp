@@ -0,0 +1,308 @@
+#include "../../include/neoneo/io/content_cache.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace neoneo {
+namespace io {
+
+namespace {
+
+// Changes to the names in a directory, and to the directory itself
+constexpr uint32_t WATCH_MASK = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+// "./src//a.cpp" and "src/a.cpp" are the same entry
+std::string normalize(const std::string& path) {
+    // Most paths only need a leading "./" dropped, which is much cheaper than normalizing
+    std::string_view view = path;
+    while (view.size() > 2 && view.substr(0, 2) == "./") {
+        view.remove_prefix(2);
+    }
+    bool plain = !view.empty();
+    for (size_t start = plain && view[0] == '/' ? 1 : 0; start <= view.size() && plain;) {
+        size_t end = std::min(view.find('/', start), view.size());
+        std::string_view part = view.substr(start, end - start);
+        plain = !part.empty() && part != "." && part != "..";
+        start = end + 1;
+    }
+    if (plain) {
+        return std::string(view);
+    }
+    std::string key = std::filesystem::path(path).lexically_normal().string();
+    return key.empty() ? path : key;
+}
+
+// The file's real path, so a symlink and its target share one entry and the
+// watch goes on the directory the file is really in
+std::string real_key(const std::string& path) {
+    char* resolved = ::realpath(path.c_str(), nullptr);
+    if (!resolved) {
+        return normalize(path); // Missing; opening it will fail anyway
+    }
+    std::string key(resolved);
+    std::free(resolved);
+    return key;
+}
+
+void split(const std::string& key, std::string& directory, std::string& name) {
+    size_t slash = key.rfind('/');
+    directory = slash == std::string::npos ? "." : slash == 0 ? "/" : key.substr(0, slash);
+    name = slash == std::string::npos ? key : key.substr(slash + 1);
+}
+
+} // namespace
+
+ContentCache::ContentCache(uint64_t max_bytes)
+    : inotify_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)), max_bytes(max_bytes) {}
+
+ContentCache::~ContentCache() {
+    if (inotify_fd >= 0) {
+        close(inotify_fd);
+    }
+}
+
+void ContentCache::drain_events() {
+    if (inotify_fd < 0) {
+        return;
+    }
+    alignas(inotify_event) char buffer[16 * 1024];
+    for (;;) {
+        ssize_t length = ::read(inotify_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            return;
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost, so nothing kept can be trusted
+                std::vector<std::string> keys;
+                for (const auto& [key, cached] : entries) {
+                    keys.push_back(key);
+                }
+                for (const auto& key : keys) {
+                    remove(key);
+                }
+                continue;
+            }
+            auto watch = watches.find(event->wd);
+            if (watch == watches.end()) {
+                continue;
+            }
+
+            // An event about the directory itself concerns every file in it
+            bool whole_directory = event->len == 0 || (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED));
+            std::vector<std::string> stale;
+            for (const auto& key : watch->second.keys) {
+                if (whole_directory || entries[key].name == event->name) {
+                    stale.push_back(key);
+                }
+            }
+            if (event->mask & IN_IGNORED) {
+                watch->second.alive = false;
+            }
+            for (const auto& key : stale) {
+                remove(key);
+            }
+            if (event->mask & IN_IGNORED) {
+                release(event->wd);
+            }
+        }
+    }
+}
+
+void ContentCache::remove(const std::string& key) {
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return;
+    }
+    cached_bytes -= it->second.file->size();
+    int watch = it->second.watch;
+    for (const auto& alias : it->second.aliases) {
+        aliases.erase(alias);
+    }
+    entries.erase(it);
+    if (watch >= 0) {
+        auto& keys = watches[watch].keys;
+        keys.erase(std::find(keys.begin(), keys.end(), key));
+        release(watch);
+    }
+}
+
+void ContentCache::release(int watch) {
+    auto it = watches.find(watch);
+    if (it == watches.end() || !it->second.keys.empty() || it->second.loading > 0) {
+        return;
+    }
+    if (it->second.alive) {
+        inotify_rm_watch(inotify_fd, watch);
+    }
+    watches.erase(it);
+}
+
+bool ContentCache::unchanged(const std::string& key, const Cached& cached) const {
+    if (cached.watch >= 0 && !cached.linked) {
+        return true; // Any change would have been drained already
+    }
+    struct stat info {};
+    if (stat(key.c_str(), &info) != 0) {
+        return false;
+    }
+    int64_t mtime_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return info.st_dev == cached.file->get_device() && info.st_ino == cached.file->get_inode() &&
+           mtime_ns == cached.file->get_mtime_ns() && static_cast<uint64_t>(info.st_size) == cached.file->size();
+}
+
+std::shared_ptr<const MappedFile> ContentCache::load(const std::string& key, std::string& error) {
+    std::string directory;
+    std::string name;
+    split(key, directory, name);
+
+    // The watch goes in before the file is mapped, so a change while mapping is noticed
+    int watch = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (inotify_fd >= 0) {
+            watch = inotify_add_watch(inotify_fd, directory.c_str(), WATCH_MASK);
+            if (watch >= 0) {
+                ++watches[watch].loading;
+            }
+        }
+    }
+
+    std::shared_ptr<const MappedFile> file = MappedFile::open(key, error);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    bool alive = true;
+    if (watch >= 0) {
+        Watch& state = watches[watch];
+        --state.loading;
+        alive = state.alive;
+    }
+    // Files that would take much of the budget are not kept, so one huge log can not push out everything else
+    if (file && alive && file->size() <= max_bytes / 4) {
+        // Writes through another hard link raise events only in that link's directory
+        struct stat info {};
+        bool linked = stat(key.c_str(), &info) != 0 || info.st_nlink > 1;
+        remove(key);
+        entries[key] = Cached{file, watch, name, linked, ++use_counter, {}};
+        if (watch >= 0) {
+            watches[watch].keys.push_back(key);
+        }
+        cached_bytes += file->size();
+        while (cached_bytes > max_bytes) {
+            auto oldest = std::min_element(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+                return a.second.last_used < b.second.last_used;
+            });
+            remove(oldest->first);
+        }
+        // Drops it again if it changed since the watch went in
+        drain_events();
+    }
+    if (watch >= 0) {
+        release(watch);
+    }
+    return file;
+}
+
+void ContentCache::add_alias(const std::string& path, const std::string& key) {
+    std::string alias = normalize(path);
+    auto it = entries.find(key);
+    if (alias == key || it == entries.end() || !aliases.emplace(alias, key).second) {
+        return;
+    }
+    it->second.aliases.push_back(alias);
+}
+
+std::shared_ptr<const MappedFile> ContentCache::open(const std::string& path, std::string& error) {
+    std::string key = real_key(path);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        drain_events();
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            if (unchanged(key, it->second)) {
+                it->second.last_used = ++use_counter;
+                add_alias(path, key);
+                return it->second.file;
+            }
+            remove(key);
+        }
+    }
+    std::shared_ptr<const MappedFile> file = load(key, error);
+    std::lock_guard<std::mutex> lock(mutex);
+    add_alias(path, key);
+    return file;
+}
+
+std::shared_ptr<const MappedFile> ContentCache::find(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.empty()) {
+        return nullptr; // A search asks for every file it reads, so misses must be cheap
+    }
+    // Real paths and the paths open() was given hit without a realpath call;
+    // an alias is still resolved, as its link may point elsewhere by now
+    std::string key = normalize(path);
+    if (entries.find(key) == entries.end()) {
+        auto alias = aliases.find(key);
+        if (alias == aliases.end()) {
+            return nullptr;
+        }
+        key = real_key(path);
+        if (key != alias->second) {
+            return nullptr;
+        }
+    }
+    drain_events();
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return nullptr;
+    }
+    if (!unchanged(key, it->second)) {
+        remove(key);
+        return nullptr;
+    }
+    it->second.last_used = ++use_counter;
+    return it->second.file;
+}
+
+void ContentCache::refresh(const std::string& path) {
+    std::string key = real_key(path);
+    {
+        // The write's own events are drained with the old content
+        std::lock_guard<std::mutex> lock(mutex);
+        drain_events();
+        remove(key);
+    }
+    std::string error;
+    load(key, error);
+}
+
+void ContentCache::erase(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    remove(real_key(path));
+}
+
+void ContentCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> keys;
+    for (const auto& [key, cached] : entries) {
+        keys.push_back(key);
+    }
+    for (const auto& key : keys) {
+        remove(key);
+    }
+}
+
+uint64_t ContentCache::get_cached_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return cached_bytes;
+}
+
+} // namespace io
+} // namespace neoneo
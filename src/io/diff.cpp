@@ -0,0 +1,369 @@
+#include "../../include/neoneo/io/diff.hpp"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace neoneo {
+namespace io {
+
+namespace {
+
+// Start of the line containing offset
+size_t line_start(std::string_view text, size_t offset) {
+    if (offset == 0) {
+        return 0;
+    }
+    const void* hit = memrchr(text.data(), '\n', offset);
+    return hit ? static_cast<size_t>(static_cast<const char*>(hit) - text.data()) + 1 : 0;
+}
+
+// Just past the newline that ends the line containing offset
+size_t line_end(std::string_view text, size_t offset) {
+    if (offset >= text.size()) {
+        return text.size();
+    }
+    const void* hit = std::memchr(text.data() + offset, '\n', text.size() - offset);
+    return hit ? static_cast<size_t>(static_cast<const char*>(hit) - text.data()) + 1 : text.size();
+}
+
+size_t count_newlines(std::string_view text, size_t begin, size_t end) {
+    size_t count = 0;
+    const char* p = text.data() + begin;
+    const char* stop = text.data() + end;
+    while (const void* hit = std::memchr(p, '\n', static_cast<size_t>(stop - p))) {
+        p = static_cast<const char*>(hit) + 1;
+        ++count;
+    }
+    return count;
+}
+
+// Lines of text, each keeping its newline
+std::vector<std::string_view> split_lines(std::string_view text) {
+    std::vector<std::string_view> lines;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = line_end(text, pos);
+        lines.push_back(text.substr(pos, end - pos));
+        pos = end;
+    }
+    return lines;
+}
+
+// Line-aligned stretch of the original holding one or more changes
+struct Group {
+    size_t begin = 0;
+    size_t end = 0;
+    size_t first = 0; // Changes [first, last) fall inside
+    size_t last = 0;
+};
+
+class Renderer {
+public:
+    Renderer(std::string_view original, size_t context, size_t max_lines, size_t line_offset, UnifiedDiff& diff)
+        : original(original), context(context), max_lines(max_lines), line_offset(line_offset), diff(diff) {}
+
+    // Add a group whose old lines start at line (0-based)
+    void add(size_t line, size_t begin, const std::vector<std::string_view>& removed,
+             const std::vector<std::string_view>& added_lines) {
+        if (open && line <= end_line + 2 * context) {
+            // Close enough to share a hunk: the lines between become context
+            for (auto text : split_lines(original.substr(end_offset, begin - end_offset))) {
+                emit(' ', text);
+                ++old_count;
+                ++new_count;
+            }
+        } else {
+            finish();
+            size_t first = begin;
+            size_t lines_before = 0;
+            while (first > 0 && lines_before < context) {
+                first = line_start(original, first - 1);
+                ++lines_before;
+            }
+            open = true;
+            hunk_old_start = line - lines_before;
+            hunk_new_start = hunk_old_start + shift;
+            old_count = 0;
+            new_count = 0;
+            for (auto text : split_lines(original.substr(first, begin - first))) {
+                emit(' ', text);
+                ++old_count;
+                ++new_count;
+            }
+        }
+
+        size_t removed_bytes = 0;
+        for (auto text : removed) {
+            emit('-', text);
+            removed_bytes += text.size();
+        }
+        for (auto text : added_lines) {
+            emit('+', text);
+        }
+        old_count += removed.size();
+        new_count += added_lines.size();
+        diff.removed += removed.size();
+        diff.added += added_lines.size();
+        pending_shift += static_cast<long long>(added_lines.size()) - static_cast<long long>(removed.size());
+        end_line = line + removed.size();
+        end_offset = begin + removed_bytes;
+    }
+
+    void finish() {
+        if (!open) {
+            return;
+        }
+        size_t last = end_offset;
+        for (size_t i = 0; i < context && last < original.size(); ++i) {
+            size_t next = line_end(original, last);
+            emit(' ', original.substr(last, next - last));
+            last = next;
+            ++old_count;
+            ++new_count;
+        }
+
+        auto range = [this](size_t start, size_t count) {
+            // An empty range names the line before it
+            start += line_offset;
+            return std::to_string(count > 0 ? start + 1 : start) + (count == 1 ? "" : "," + std::to_string(count));
+        };
+        std::string header = "@@ -" + range(hunk_old_start, old_count) + " +" +
+                             range(static_cast<size_t>(hunk_new_start), new_count) + " @@\n";
+        if (!body.empty()) {
+            diff.text += header + body;
+        }
+        body.clear();
+        open = false;
+        shift += pending_shift;
+        pending_shift = 0;
+    }
+
+private:
+    void emit(char marker, std::string_view text) {
+        if (diff.truncated) {
+            return;
+        }
+        if (++lines >= max_lines) {
+            diff.truncated = true;
+            body += "... (diff truncated)\n";
+            return;
+        }
+        body += marker;
+        body.append(text);
+        if (text.empty() || text.back() != '\n') {
+            body += "\n\\ No newline at end of file\n";
+        }
+    }
+
+    std::string_view original;
+    size_t context;
+    size_t max_lines;
+    size_t line_offset; // Lines of the file before original
+    UnifiedDiff& diff;
+
+    bool open = false;
+    std::string body;
+    size_t hunk_old_start = 0;
+    long long hunk_new_start = 0;
+    size_t old_count = 0;
+    size_t new_count = 0;
+    size_t end_line = 0;   // Old line just past the last change in the open hunk
+    size_t end_offset = 0; // Byte offset of that line
+    long long shift = 0;   // New line number minus old line number before the open hunk
+    long long pending_shift = 0;
+    size_t lines = 0;
+};
+
+} // namespace
+
+UnifiedDiff unified_diff(const std::string& path, std::string_view original, const std::vector<TextChange>& changes,
+                         size_t context, size_t max_lines, size_t first_line) {
+    UnifiedDiff diff;
+
+    Renderer renderer(original, context, max_lines, first_line > 0 ? first_line - 1 : 0, diff);
+    size_t counted_to = 0;
+    size_t line = 0;
+    for (size_t next = 0; next < changes.size();) {
+        // Widen the change to whole lines, taking in any other change on them
+        Group group;
+        group.first = next;
+        group.begin = line_start(original, static_cast<size_t>(changes[next].offset));
+        group.end = group.begin;
+        std::string replacement;
+        for (;;) {
+            while (next < changes.size() &&
+                   (next == group.first || changes[next].offset < group.end || group.end == original.size())) {
+                const TextChange& change = changes[next++];
+                size_t offset = static_cast<size_t>(change.offset);
+                group.end = std::max(group.end, line_end(original, change.length > 0
+                                                                       ? offset + static_cast<size_t>(change.length) - 1
+                                                                       : offset));
+            }
+            group.last = next;
+
+            // The group's new text: the original around its changes
+            replacement.clear();
+            size_t position = group.begin;
+            for (size_t i = group.first; i < group.last; ++i) {
+                replacement.append(original.substr(position, static_cast<size_t>(changes[i].offset) - position));
+                replacement += changes[i].text;
+                position = static_cast<size_t>(changes[i].offset + changes[i].length);
+            }
+            replacement.append(original.substr(position, group.end - position));
+
+            // A new last line without its newline runs into the next line, which then belongs here too
+            if (!replacement.empty() && replacement.back() != '\n' && group.end < original.size()) {
+                group.end = line_end(original, group.end);
+                continue;
+            }
+            break;
+        }
+
+        auto removed = split_lines(original.substr(group.begin, group.end - group.begin));
+        auto added = split_lines(replacement);
+
+        // Lines the change left alone at either end are context, not changes
+        size_t prefix = 0;
+        while (prefix < removed.size() && prefix < added.size() && removed[prefix] == added[prefix]) {
+            ++prefix;
+        }
+        size_t suffix = 0;
+        while (suffix < removed.size() - prefix && suffix < added.size() - prefix &&
+               removed[removed.size() - 1 - suffix] == added[added.size() - 1 - suffix]) {
+            ++suffix;
+        }
+        if (prefix + suffix == removed.size() && prefix + suffix == added.size()) {
+            continue;
+        }
+
+        size_t begin = group.begin;
+        for (size_t i = 0; i < prefix; ++i) {
+            begin += removed[i].size();
+        }
+        line += count_newlines(original, counted_to, begin);
+        counted_to = begin;
+
+        renderer.add(line, begin,
+                     std::vector<std::string_view>(removed.begin() + static_cast<std::ptrdiff_t>(prefix),
+                                                   removed.end() - static_cast<std::ptrdiff_t>(suffix)),
+                     std::vector<std::string_view>(added.begin() + static_cast<std::ptrdiff_t>(prefix),
+                                                   added.end() - static_cast<std::ptrdiff_t>(suffix)));
+    }
+    renderer.finish();
+
+    if (!diff.text.empty() || diff.truncated) {
+        diff.text = "--- a/" + path + "\n+++ b/" + path + "\n" + diff.text;
+    }
+    return diff;
+}
+
+std::vector<TextChange> line_changes(std::string_view before, std::string_view after, size_t max_distance) {
+    auto a = split_lines(before);
+    auto b = split_lines(after);
+    size_t prefix = 0;
+    while (prefix < a.size() && prefix < b.size() && a[prefix] == b[prefix]) {
+        ++prefix;
+    }
+    size_t suffix = 0;
+    while (suffix < a.size() - prefix && suffix < b.size() - prefix &&
+           a[a.size() - 1 - suffix] == b[b.size() - 1 - suffix]) {
+        ++suffix;
+    }
+
+    // Lines in between, as numbers so that comparing them is cheap
+    long n = static_cast<long>(a.size() - prefix - suffix);
+    long m = static_cast<long>(b.size() - prefix - suffix);
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::vector<uint32_t> x(static_cast<size_t>(n));
+    std::vector<uint32_t> y(static_cast<size_t>(m));
+    for (long i = 0; i < n; ++i) {
+        x[static_cast<size_t>(i)] = ids.emplace(a[prefix + static_cast<size_t>(i)], ids.size()).first->second;
+    }
+    for (long j = 0; j < m; ++j) {
+        y[static_cast<size_t>(j)] = ids.emplace(b[prefix + static_cast<size_t>(j)], ids.size()).first->second;
+    }
+
+    // Which lines go and which are new; lines marked in neither are kept
+    std::vector<bool> removed(static_cast<size_t>(n), false);
+    std::vector<bool> added(static_cast<size_t>(m), false);
+
+    long limit = std::min(n + m, static_cast<long>(max_distance));
+    std::vector<long> v(static_cast<size_t>(2 * limit + 3), 0);
+    long middle = limit + 1; // v[middle + k]: furthest x reached on diagonal k
+    std::vector<std::vector<long>> trace; // v over [-d, d] before each step d
+    long distance = -1;
+    for (long d = 0; d <= limit && distance < 0; ++d) {
+        trace.emplace_back(v.begin() + (middle - d), v.begin() + (middle + d + 1));
+        for (long k = -d; k <= d; k += 2) {
+            long i = k == -d || (k != d && v[static_cast<size_t>(middle + k - 1)] < v[static_cast<size_t>(middle + k + 1)])
+                         ? v[static_cast<size_t>(middle + k + 1)]
+                         : v[static_cast<size_t>(middle + k - 1)] + 1;
+            long j = i - k;
+            while (i < n && j < m && x[static_cast<size_t>(i)] == y[static_cast<size_t>(j)]) {
+                ++i;
+                ++j;
+            }
+            v[static_cast<size_t>(middle + k)] = i;
+            if (i >= n && j >= m) {
+                distance = d;
+                break;
+            }
+        }
+    }
+
+    if (distance < 0) {
+        std::fill(removed.begin(), removed.end(), true);
+        std::fill(added.begin(), added.end(), true);
+    } else {
+        // Walk back from the end, one edit per step
+        long i = n;
+        long j = m;
+        for (long d = distance; d > 0; --d) {
+            const std::vector<long>& previous = trace[static_cast<size_t>(d)];
+            auto at = [&](long k) { return previous[static_cast<size_t>(k + d)]; };
+            long k = i - j;
+            long previous_k = k == -d || (k != d && at(k - 1) < at(k + 1)) ? k + 1 : k - 1;
+            long previous_i = at(previous_k);
+            long previous_j = previous_i - previous_k;
+            while (i > previous_i && j > previous_j) {
+                --i;
+                --j;
+            }
+            if (i == previous_i) {
+                added[static_cast<size_t>(previous_j)] = true;
+            } else {
+                removed[static_cast<size_t>(previous_i)] = true;
+            }
+            i = previous_i;
+            j = previous_j;
+        }
+    }
+
+    // Runs of removed and added lines between kept ones become one change each
+    uint64_t middle_end = suffix > 0 ? static_cast<uint64_t>(a[a.size() - suffix].data() - before.data()) : before.size();
+    std::vector<TextChange> changes;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < removed.size() || j < added.size()) {
+        if ((i < removed.size() && removed[i]) || (j < added.size() && added[j])) {
+            TextChange change;
+            change.offset = i < removed.size() ? static_cast<uint64_t>(a[prefix + i].data() - before.data()) : middle_end;
+            while (i < removed.size() && removed[i]) {
+                change.length += a[prefix + i].size();
+                ++i;
+            }
+            while (j < added.size() && added[j]) {
+                change.text.append(b[prefix + j]);
+                ++j;
+            }
+            changes.push_back(std::move(change));
+            continue;
+        }
+        ++i;
+        ++j;
+    }
+    return changes;
+}
+
+} // namespace io
+} // namespace neoneo
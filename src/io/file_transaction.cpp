@@ -0,0 +1,240 @@
+#include "../../include/neoneo/io/file_transaction.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace neoneo {
+namespace io {
+
+namespace {
+
+// Spans handed to one writev call
+constexpr size_t WRITE_BATCH = 64;
+
+// Write every byte of the spans, retrying short writes
+bool write_spans(int fd, std::vector<iovec>& spans) {
+    size_t first = 0;
+    while (first < spans.size()) {
+        size_t count = std::min(spans.size() - first, WRITE_BATCH);
+        ssize_t written = writev(fd, &spans[first], static_cast<int>(count));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0) {
+            return false;
+        }
+        size_t left = static_cast<size_t>(written);
+        while (first < spans.size() && left >= spans[first].iov_len) {
+            left -= spans[first].iov_len;
+            ++first;
+        }
+        if (left > 0) {
+            spans[first].iov_base = static_cast<char*>(spans[first].iov_base) + left;
+            spans[first].iov_len -= left;
+        }
+    }
+    return true;
+}
+
+std::string resolve(const std::string& path) {
+    char resolved[PATH_MAX];
+    return realpath(path.c_str(), resolved) ? std::string(resolved) : path;
+}
+
+// Directory part of path, "" when there is none
+std::string parent_of(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos || slash == 0 ? "" : path.substr(0, slash);
+}
+
+// A new unused name next to target; the temporary file must be in the
+// same directory for renames to be atomic. Created with mode 0666 rather
+// than mkstemp's 0600, so the umask and default ACLs apply as they would
+// to any new file.
+int make_sibling(const std::string& target, const char* suffix, std::string& name) {
+    static std::atomic<unsigned> counter{0};
+    size_t slash = target.rfind('/');
+    std::string directory = slash == std::string::npos ? "" : target.substr(0, slash + 1);
+    std::string base = slash == std::string::npos ? target : target.substr(slash + 1);
+    auto seed = static_cast<unsigned long long>(std::chrono::steady_clock::now().time_since_epoch().count());
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        char unique[48];
+        std::snprintf(unique, sizeof(unique), "-%d-%llx-%u", static_cast<int>(getpid()), seed & 0xffffffffULL,
+                      counter++);
+        name = directory + "." + base + suffix + unique;
+        int fd = open(name.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        if (fd >= 0 || errno != EEXIST) {
+            return fd;
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+FileTransaction::~FileTransaction() {
+    for (const auto& entry : entries) {
+        if (!entry.done && !entry.temporary.empty()) {
+            unlink(entry.temporary.c_str());
+        }
+    }
+    // Directories made for files that never arrived; rmdir leaves any that are not empty
+    for (auto it = created_directories.rbegin(); it != created_directories.rend(); ++it) {
+        rmdir(it->c_str());
+    }
+}
+
+bool FileTransaction::make_parents(const std::string& target, std::string& error) {
+    std::vector<std::string> missing;
+    struct stat info {};
+    for (std::string directory = parent_of(target);
+         !directory.empty() && stat(directory.c_str(), &info) != 0 && errno == ENOENT;
+         directory = parent_of(directory)) {
+        missing.push_back(directory);
+    }
+    for (auto it = missing.rbegin(); it != missing.rend(); ++it) {
+        if (mkdir(it->c_str(), 0777) != 0 && errno != EEXIST) {
+            error = "Could not create directory " + *it + ": " + std::strerror(errno);
+            return false;
+        }
+        created_directories.push_back(*it);
+    }
+    return true;
+}
+
+bool FileTransaction::stage(const std::string& path, const PieceTable& content, std::string& error,
+                            const std::string& mode_from) {
+    Entry entry;
+    entry.path = path;
+    entry.target = resolve(path);
+    // Renaming over the file would get around its permissions
+    if (access(entry.target.c_str(), F_OK) == 0 && access(entry.target.c_str(), W_OK) != 0) {
+        error = "Could not write " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    if (!make_parents(entry.target, error)) {
+        return false;
+    }
+    int fd = make_sibling(entry.target, ".neoneo", entry.temporary);
+    if (fd < 0) {
+        error = "Could not create a temporary file next to " + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // The replaced file's permissions, else those of the file renamed here, else the umask's
+    struct stat info {};
+    entry.existed = stat(entry.target.c_str(), &info) == 0;
+    if (entry.existed || (!mode_from.empty() && stat(mode_from.c_str(), &info) == 0)) {
+        fchmod(fd, info.st_mode & 07777);
+        struct stat created {};
+        if (fchown(fd, info.st_uid, info.st_gid) != 0 && entry.existed && fstat(fd, &created) == 0 &&
+            (created.st_uid != info.st_uid || created.st_gid != info.st_gid)) {
+            // Not permitted for other users' files, and replacing one would take it over
+            close(fd);
+            unlink(entry.temporary.c_str());
+            error = "Could not write " + path + ": its owner could not be kept";
+            return false;
+        }
+    }
+
+    std::vector<iovec> spans;
+    content.for_each_span([&](std::string_view span) {
+        spans.push_back(iovec{const_cast<char*>(span.data()), span.size()});
+    });
+    bool ok = write_spans(fd, spans) && fsync(fd) == 0;
+    int saved_errno = errno;
+    if (close(fd) != 0 && ok) {
+        ok = false;
+        saved_errno = errno;
+    }
+    if (!ok) {
+        unlink(entry.temporary.c_str());
+        error = "Could not write " + path + ": " + std::strerror(saved_errno);
+        return false;
+    }
+    entries.push_back(std::move(entry));
+    return true;
+}
+
+void FileTransaction::remove(const std::string& path) {
+    Entry entry;
+    entry.path = path;
+    entry.target = resolve(path);
+    entries.push_back(std::move(entry));
+}
+
+bool FileTransaction::commit(std::string& error) {
+    for (auto& entry : entries) {
+        bool ok = true;
+        if (entry.temporary.empty()) {
+            // Removal: move the file aside, so putting it back is a rename
+            int fd = make_sibling(entry.target, ".neoneo-removed", entry.backup);
+            ok = fd >= 0;
+            if (ok) {
+                close(fd);
+                ok = std::rename(entry.target.c_str(), entry.backup.c_str()) == 0;
+                if (!ok) {
+                    int saved_errno = errno;
+                    unlink(entry.backup.c_str());
+                    errno = saved_errno;
+                    entry.backup.clear();
+                }
+            }
+        } else {
+            // Without hard links (some filesystems) the old file can not be put back
+            std::string backup = entry.temporary + ".orig";
+            if (link(entry.target.c_str(), backup.c_str()) == 0) {
+                entry.backup = backup;
+            }
+            ok = std::rename(entry.temporary.c_str(), entry.target.c_str()) == 0;
+        }
+        if (!ok) {
+            error = "Could not " + std::string(entry.temporary.empty() ? "remove " : "write ") + entry.path + ": " +
+                    std::strerror(errno);
+            roll_back();
+            return false;
+        }
+        entry.done = true;
+    }
+
+    for (const auto& entry : entries) {
+        if (!entry.backup.empty()) {
+            unlink(entry.backup.c_str());
+        }
+    }
+    entries.clear();
+    created_directories.clear();
+    return true;
+}
+
+void FileTransaction::roll_back() {
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        if (!it->done) {
+            if (!it->backup.empty()) {
+                unlink(it->backup.c_str());
+            }
+            continue;
+        }
+        if (!it->backup.empty()) {
+            std::rename(it->backup.c_str(), it->target.c_str());
+        } else if (!it->temporary.empty() && !it->existed) {
+            // Nothing was there before, so the new file goes
+            unlink(it->target.c_str());
+        }
+        // Nothing is left to clean up for this entry
+        it->done = true;
+        it->temporary.clear();
+    }
+}
+
+} // namespace io
+} // namespace neoneo
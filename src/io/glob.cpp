@@ -0,0 +1,166 @@
+#include "../../include/neoneo/io/glob.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <fnmatch.h>
+#include <glob.h>
+#include <sys/stat.h>
+
+namespace neoneo {
+namespace io {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Directory entries a "**" walk may visit before it gives up
+constexpr size_t MAX_WALK_ENTRIES = 200000;
+
+std::vector<std::string> split_path(std::string_view path) {
+    std::vector<std::string> parts;
+    size_t pos = 0;
+    while (pos <= path.size()) {
+        size_t end = path.find('/', pos);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+        if (end > pos && path.substr(pos, end - pos) != ".") {
+            parts.emplace_back(path.substr(pos, end - pos));
+        }
+        pos = end + 1;
+    }
+    return parts;
+}
+
+bool match_parts(const std::vector<std::string>& pattern, size_t p,
+                 const std::vector<std::string>& path, size_t s, bool hidden) {
+    if (p == pattern.size()) {
+        return s == path.size();
+    }
+    if (pattern[p] == "**") {
+        // Zero or more directories, hidden ones only if asked for
+        for (size_t k = s; k <= path.size(); ++k) {
+            if (match_parts(pattern, p + 1, path, k, hidden)) {
+                return true;
+            }
+            if (!hidden && k < path.size() && path[k][0] == '.') {
+                break;
+            }
+        }
+        return false;
+    }
+    return s < path.size() && fnmatch(pattern[p].c_str(), path[s].c_str(), hidden ? 0 : FNM_PERIOD) == 0 &&
+           match_parts(pattern, p + 1, path, s + 1, hidden);
+}
+
+// Whether files below the directory path[s..] may match pattern[p..], so
+// that the walk has to enter it
+bool may_match_below(const std::vector<std::string>& pattern, size_t p,
+                     const std::vector<std::string>& path, size_t s) {
+    if (p == pattern.size()) {
+        return false;
+    }
+    if (s == path.size()) {
+        return true;
+    }
+    if (pattern[p] == "**") {
+        for (size_t k = s; k < path.size(); ++k) {
+            if (may_match_below(pattern, p + 1, path, k)) {
+                return true;
+            }
+            if (path[k][0] == '.') {
+                return false;
+            }
+        }
+        // "**" takes in the whole directory and goes on below it
+        return true;
+    }
+    return fnmatch(pattern[p].c_str(), path[s].c_str(), FNM_PERIOD) == 0 &&
+           may_match_below(pattern, p + 1, path, s + 1);
+}
+
+bool is_regular(const std::string& path) {
+    struct stat info {};
+    return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+} // namespace
+
+bool has_glob_chars(std::string_view pattern) {
+    return pattern.find_first_of("*?[") != std::string_view::npos;
+}
+
+bool glob_match(std::string_view pattern, std::string_view path, bool hidden) {
+    return match_parts(split_path(pattern), 0, split_path(path), 0, hidden);
+}
+
+std::vector<std::string> expand_glob(const std::string& pattern, size_t max_results, bool& truncated) {
+    truncated = false;
+    std::vector<std::string> results;
+
+    if (!has_glob_chars(pattern)) {
+        if (is_regular(pattern)) {
+            results.push_back(pattern);
+        }
+        return results;
+    }
+
+    if (pattern.find("**") == std::string::npos) {
+        glob_t matches{};
+        if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+            for (size_t i = 0; i < matches.gl_pathc; ++i) {
+                if (is_regular(matches.gl_pathv[i])) {
+                    if (results.size() == max_results) {
+                        truncated = true;
+                        break;
+                    }
+                    results.emplace_back(matches.gl_pathv[i]);
+                }
+            }
+        }
+        globfree(&matches);
+        return results;
+    }
+
+    // "**" needs a walk: start below the components without wildcards
+    std::vector<std::string> parts = split_path(pattern);
+    std::string base = pattern[0] == '/' ? "/" : "";
+    size_t first_wild = 0;
+    while (first_wild < parts.size() && !has_glob_chars(parts[first_wild])) {
+        base += parts[first_wild] + "/";
+        ++first_wild;
+    }
+    std::vector<std::string> rest(parts.begin() + static_cast<std::ptrdiff_t>(first_wild), parts.end());
+
+    std::error_code ec;
+    fs::recursive_directory_iterator it(base.empty() ? "." : base, fs::directory_options::skip_permission_denied, ec);
+    size_t visited = 0;
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (++visited > MAX_WALK_ENTRIES) {
+            truncated = true;
+            break;
+        }
+        std::string relative = it->path().lexically_relative(base.empty() ? "." : base).generic_string();
+        if (it->is_directory(ec)) {
+            // Hidden directories are only entered when the pattern names them
+            if (!may_match_below(rest, 0, split_path(relative), 0)) {
+                it.disable_recursion_pending();
+            }
+            continue;
+        }
+        if (it->is_regular_file(ec) && match_parts(rest, 0, split_path(relative), 0, false)) {
+            results.push_back(base + relative);
+        }
+    }
+
+    // Sorted before cutting, so the same files are kept whatever the walk order
+    std::sort(results.begin(), results.end());
+    if (results.size() > max_results) {
+        results.resize(max_results);
+        truncated = true;
+    }
+    return results;
+}
+
+} // namespace io
+} // namespace neoneo
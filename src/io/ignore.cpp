@@ -0,0 +1,100 @@
+#include "../../include/neoneo/io/ignore.hpp"
+#include "../../include/neoneo/io/glob.hpp"
+#include <fstream>
+#include <sstream>
+#include <fnmatch.h>
+
+namespace neoneo {
+namespace io {
+
+std::shared_ptr<const IgnoreList> IgnoreList::load(const std::string& directory, const std::string& base,
+                                                   std::shared_ptr<const IgnoreList> parent) {
+    std::ifstream file(directory + "/.gitignore", std::ios::binary);
+    if (!file.is_open()) {
+        return parent;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return parse(buffer.str(), base, std::move(parent));
+}
+
+std::shared_ptr<const IgnoreList> IgnoreList::parse(std::string_view text, const std::string& base,
+                                                    std::shared_ptr<const IgnoreList> parent) {
+    auto list = std::make_shared<IgnoreList>();
+    list->base = base;
+    list->parent = std::move(parent);
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        std::string_view line = text.substr(pos, end - pos);
+        pos = end + 1;
+
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        // Trailing spaces are dropped unless escaped
+        while (!line.empty() && line.back() == ' ' && !(line.size() > 1 && line[line.size() - 2] == '\\')) {
+            line.remove_suffix(1);
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        Rule rule;
+        if (line[0] == '!') {
+            rule.negated = true;
+            line.remove_prefix(1);
+        } else if (line[0] == '\\') {
+            line.remove_prefix(1);
+        }
+        if (!line.empty() && line.back() == '/') {
+            rule.directory_only = true;
+            line.remove_suffix(1);
+        }
+        // A slash anywhere but the end ties the pattern to this directory
+        rule.anchored = line.find('/') != std::string_view::npos;
+        if (!line.empty() && line[0] == '/') {
+            line.remove_prefix(1);
+        }
+        if (line.empty()) {
+            continue;
+        }
+        rule.pattern = std::string(line);
+        list->rules.push_back(std::move(rule));
+    }
+
+    if (list->rules.empty()) {
+        return list->parent;
+    }
+    return list;
+}
+
+bool IgnoreList::is_ignored(std::string_view path, bool is_directory) const {
+    size_t slash = path.rfind('/');
+    std::string name(slash == std::string_view::npos ? path : path.substr(slash + 1));
+
+    for (const IgnoreList* list = this; list; list = list->parent.get()) {
+        if (path.compare(0, list->base.size(), list->base) != 0) {
+            continue;
+        }
+        std::string_view below = path.substr(list->base.size());
+        for (auto rule = list->rules.rbegin(); rule != list->rules.rend(); ++rule) {
+            if (rule->directory_only && !is_directory) {
+                continue;
+            }
+            bool matched = rule->anchored ? glob_match(rule->pattern, below, true)
+                                          : fnmatch(rule->pattern.c_str(), name.c_str(), 0) == 0;
+            if (matched) {
+                return !rule->negated;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,340 @@
+#include "../../include/neoneo/io/listing.hpp"
+#include "../../include/neoneo/io/glob.hpp"
+#include "../../include/neoneo/io/walk.hpp"
+#include "../../include/neoneo/io/work_stealing.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace neoneo {
+namespace io {
+
+namespace {
+
+// Entries a listing collects before it stops walking
+constexpr size_t MAX_COLLECTED = 100000;
+
+constexpr uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ATTRIB |
+                                IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+// Record layout returned by getdents64, which glibc does not declare
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+EntryType type_of(mode_t mode) {
+    return S_ISREG(mode) ? EntryType::File
+           : S_ISDIR(mode) ? EntryType::Directory
+           : S_ISLNK(mode) ? EntryType::Symlink
+                           : EntryType::Other;
+}
+
+EntryType type_of_dirent(unsigned char type) {
+    switch (type) {
+        case DT_REG: return EntryType::File;
+        case DT_DIR: return EntryType::Directory;
+        case DT_LNK: return EntryType::Symlink;
+        default: return EntryType::Other;
+    }
+}
+
+// Read a directory with getdents64, statting entries relative to its fd
+std::shared_ptr<DirectoryEntries> read_entries(const std::string& path, bool metadata, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "Cannot read directory " + path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+
+    auto entries = std::make_shared<DirectoryEntries>();
+    alignas(LinuxDirent64) char buffer[32 * 1024];
+    for (;;) {
+        long length = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        if (length < 0 && errno == EINTR) {
+            continue;
+        }
+        if (length < 0) {
+            error = "Cannot read directory " + path + ": " + std::strerror(errno);
+            close(fd);
+            return nullptr;
+        }
+        if (length == 0) {
+            break;
+        }
+
+        for (long offset = 0; offset < length;) {
+            const auto* record = reinterpret_cast<const LinuxDirent64*>(buffer + offset);
+            offset += record->d_reclen;
+            const char* name = record->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+
+            DirectoryEntry entry;
+            entry.name = name;
+            entry.type = type_of_dirent(record->d_type);
+            if (metadata || record->d_type == DT_UNKNOWN) {
+                struct stat info {};
+                if (fstatat(fd, name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+                    continue; // Removed since it was listed
+                }
+                entry.type = type_of(info.st_mode);
+                entry.size = static_cast<uint64_t>(info.st_size);
+                entry.mtime_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+            }
+            if (entry.type == EntryType::Symlink) {
+                char target[4096];
+                ssize_t size = readlinkat(fd, name, target, sizeof(target));
+                if (size > 0) {
+                    entry.target.assign(target, static_cast<size_t>(size));
+                }
+            }
+            entries->push_back(std::move(entry));
+        }
+    }
+    close(fd);
+
+    std::sort(entries->begin(), entries->end(),
+              [](const DirectoryEntry& a, const DirectoryEntry& b) { return a.name < b.name; });
+    return entries;
+}
+
+// Path order with '/' sorting first, so a directory's contents follow it directly
+bool path_less(const std::string& a, const std::string& b) {
+    size_t length = std::min(a.size(), b.size());
+    for (size_t i = 0; i < length; ++i) {
+        if (a[i] != b[i]) {
+            unsigned char x = a[i] == '/' ? 0 : static_cast<unsigned char>(a[i]);
+            unsigned char y = b[i] == '/' ? 0 : static_cast<unsigned char>(b[i]);
+            return x < y;
+        }
+    }
+    return a.size() < b.size();
+}
+
+struct Task {
+    std::string path;
+    std::string relative; // "" or ending in '/'
+    std::shared_ptr<const IgnoreList> ignores;
+    size_t depth = 1;
+};
+
+} // namespace
+
+DirectoryCache::DirectoryCache(size_t max_directories)
+    : inotify_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)), max_directories(max_directories) {}
+
+DirectoryCache::~DirectoryCache() {
+    if (inotify_fd >= 0) {
+        close(inotify_fd);
+    }
+}
+
+void DirectoryCache::drain_events() {
+    if (inotify_fd < 0) {
+        return;
+    }
+    alignas(inotify_event) char buffer[16 * 1024];
+    for (;;) {
+        ssize_t length = ::read(inotify_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            return;
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost, so nothing cached can be trusted
+                for (auto& [wd, generation] : generations) {
+                    ++generation;
+                }
+                entries.clear();
+                continue;
+            }
+            ++generations[event->wd];
+            auto watch = watched.find(event->wd);
+            if (watch != watched.end()) {
+                entries.erase(watch->second);
+            }
+            if (event->mask & IN_IGNORED) {
+                watched.erase(event->wd);
+                generations.erase(event->wd);
+            }
+        }
+    }
+}
+
+void DirectoryCache::evict_oldest() {
+    auto oldest = std::min_element(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.second.last_used < b.second.last_used;
+    });
+    if (oldest == entries.end()) {
+        return;
+    }
+    if (oldest->second.watch >= 0) {
+        inotify_rm_watch(inotify_fd, oldest->second.watch);
+    }
+    entries.erase(oldest);
+}
+
+std::shared_ptr<const DirectoryEntries> DirectoryCache::read(const std::string& path, bool metadata,
+                                                             std::string& error) {
+    struct stat info {};
+    if (stat(path.c_str(), &info) != 0) {
+        error = "Cannot access " + path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        error = "Not a directory: " + path;
+        return nullptr;
+    }
+    Key key{info.st_dev, info.st_ino};
+
+    // The watch goes in before the read, so a change during the read is noticed
+    int watch = -1;
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        drain_events();
+        auto it = entries.find(key);
+        if (it != entries.end() && (it->second.metadata || !metadata)) {
+            it->second.last_used = ++use_counter;
+            return it->second.entries;
+        }
+        if (inotify_fd >= 0) {
+            watch = inotify_add_watch(inotify_fd, path.c_str(), WATCH_MASK);
+            if (watch >= 0) {
+                watched[watch] = key;
+                generation = generations[watch];
+            }
+        }
+    }
+
+    auto list = read_entries(path, metadata, error);
+    if (!list) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    drain_events();
+    // Not cached without a watch (usually the inotify limit) or if it changed while being read
+    if (watch >= 0 && generations[watch] == generation) {
+        if (entries.find(key) == entries.end() && entries.size() >= max_directories) {
+            evict_oldest();
+        }
+        entries[key] = Cached{list, metadata, watch, ++use_counter};
+    }
+    return list;
+}
+
+void DirectoryCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
+
+bool list_directory(const std::string& root, const ListOptions& options, DirectoryCache& cache,
+                    ListResult& result, std::string& error) {
+    result = ListResult{};
+    if (!cache.read(root, options.metadata, error)) {
+        return false;
+    }
+
+    std::string prefix;
+    std::shared_ptr<const IgnoreList> root_ignores;
+    if (!options.ignored) {
+        root_ignores = load_ignores(root, prefix);
+    }
+
+    size_t threads = options.threads > 0 ? options.threads : default_walk_threads();
+    std::vector<std::vector<ListedEntry>> found(threads);
+    std::atomic<size_t> collected{0};
+    std::atomic<bool> incomplete{false};
+
+    WorkStealingPool<Task> pool(threads);
+    std::vector<Task> initial;
+    initial.push_back(Task{root, "", root_ignores, 1});
+    pool.run(std::move(initial), [&](Task& task, size_t worker) {
+        std::string ignored_error;
+        auto list = cache.read(task.path, options.metadata, ignored_error);
+        if (!list) {
+            return; // Unreadable subdirectories are left out
+        }
+
+        // The listing shows whether there is a .gitignore to load
+        auto ignores = task.ignores;
+        auto gitignore = std::lower_bound(list->begin(), list->end(), ".gitignore",
+                                          [](const DirectoryEntry& entry, const char* name) { return entry.name < name; });
+        if (!options.ignored && !task.relative.empty() && gitignore != list->end() && gitignore->name == ".gitignore") {
+            ignores = IgnoreList::load(task.path, prefix + task.relative, task.ignores);
+        }
+
+        for (const auto& entry : *list) {
+            if (entry.name == ".git" || (!options.hidden && entry.name[0] == '.')) {
+                continue;
+            }
+            bool is_directory = entry.type == EntryType::Directory;
+            std::string relative = task.relative + entry.name;
+            if (ignores && ignores->is_ignored(prefix + relative, is_directory)) {
+                continue;
+            }
+            if (is_directory && task.depth < options.max_depth) {
+                pool.push(worker, Task{child_path(task.path, entry.name), relative + "/", ignores, task.depth + 1});
+            }
+
+            if (!options.glob.empty()) {
+                bool matches = options.glob.find('/') != std::string::npos
+                                   ? glob_match(options.glob, relative, options.hidden)
+                                   : fnmatch(options.glob.c_str(), entry.name.c_str(), 0) == 0;
+                if (is_directory || !matches) {
+                    continue;
+                }
+            }
+            if (collected.fetch_add(1) >= MAX_COLLECTED) {
+                incomplete = true;
+                pool.stop();
+                return;
+            }
+            found[worker].push_back(ListedEntry{std::move(relative), entry.type, entry.size, entry.mtime_ns,
+                                                entry.target});
+        }
+    });
+
+    for (auto& list : found) {
+        for (auto& entry : list) {
+            result.entries.push_back(std::move(entry));
+        }
+    }
+    std::sort(result.entries.begin(), result.entries.end(),
+              [](const ListedEntry& a, const ListedEntry& b) { return path_less(a.path, b.path); });
+    for (const auto& entry : result.entries) {
+        if (entry.type == EntryType::Directory) {
+            ++result.directories;
+        } else if (entry.type == EntryType::File) {
+            ++result.files;
+        } else {
+            ++result.others;
+        }
+    }
+    result.incomplete = incomplete;
+    if (result.entries.size() > options.max_entries) {
+        result.entries.resize(options.max_entries);
+        result.truncated = true;
+    }
+    return true;
+}
+
+} // namespace io
+} // namespace neoneo
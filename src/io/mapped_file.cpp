@@ -0,0 +1,177 @@
+#include "../../include/neoneo/io/mapped_file.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace neoneo {
+namespace io {
+
+MappedFile::~MappedFile() {
+    if (mapped) {
+        munmap(const_cast<char*>(bytes), static_cast<size_t>(length));
+    }
+}
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return nullptr;
+    }
+
+    struct stat info {};
+    if (fstat(fd, &info) != 0) {
+        error = std::strerror(errno);
+        close(fd);
+        return nullptr;
+    }
+    if (!S_ISREG(info.st_mode)) {
+        error = "Not a regular file";
+        close(fd);
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFile> file(new MappedFile());
+    file->length = static_cast<uint64_t>(info.st_size);
+    file->device = info.st_dev;
+    file->inode = info.st_ino;
+    file->mtime_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+
+    // Empty files can not be mapped; they keep the static empty buffer
+    if (file->length > 0) {
+        void* address = mmap(nullptr, static_cast<size_t>(file->length), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            error = std::strerror(errno);
+            close(fd);
+            return nullptr;
+        }
+        file->bytes = static_cast<const char*>(address);
+        file->mapped = true;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    return file;
+}
+
+LineIndexCache::LineIndexCache(size_t max_files) : max_files(max_files) {}
+
+LineIndexCache::Entry& LineIndexCache::entry_for(const MappedFile& file) {
+    auto key = std::make_pair(file.get_device(), file.get_inode());
+    auto it = entries.find(key);
+
+    if (it == entries.end()) {
+        if (entries.size() >= max_files) {
+            auto oldest = std::min_element(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+                return a.second.last_used < b.second.last_used;
+            });
+            entries.erase(oldest);
+        }
+        it = entries.emplace(key, Entry{}).first;
+    }
+
+    Entry& entry = it->second;
+    if (entry.size != file.size() || entry.mtime_ns != file.get_mtime_ns()) {
+        // New file or changed content: start over
+        entry.index = LineIndex{};
+        entry.size = file.size();
+        entry.mtime_ns = file.get_mtime_ns();
+    }
+    entry.last_used = ++use_counter;
+    return entry;
+}
+
+void LineIndexCache::extend(const MappedFile& file, LineIndex& index, uint64_t line) {
+    const char* data = file.data();
+    uint64_t size = file.size();
+
+    if (size == 0) {
+        index.lines_found = 0;
+        index.complete = true;
+        return;
+    }
+
+    while (!index.complete && index.lines_found <= line) {
+        const void* newline = std::memchr(data + index.scanned_to, '\n',
+                                          static_cast<size_t>(size - index.scanned_to));
+        if (!newline) {
+            index.scanned_to = size;
+            index.complete = true;
+            break;
+        }
+        uint64_t next = static_cast<uint64_t>(static_cast<const char*>(newline) - data) + 1;
+        index.scanned_to = next;
+        if (next >= size) {
+            // A trailing newline ends the last line rather than starting one
+            index.complete = true;
+            break;
+        }
+        if (index.lines_found % LineIndex::STRIDE == 0) {
+            index.checkpoints.push_back(next);
+        }
+        ++index.lines_found;
+    }
+}
+
+std::optional<uint64_t> LineIndexCache::line_offset(const MappedFile& file, uint64_t line) {
+    std::lock_guard<std::mutex> lock(mutex);
+    LineIndex& index = entry_for(file).index;
+    extend(file, index, line);
+    if (line >= index.lines_found) {
+        return std::nullopt;
+    }
+
+    // Walk forward from the nearest checkpoint
+    uint64_t skipped = 0;
+    uint64_t checkpoint = index.checkpoints[line / LineIndex::STRIDE];
+    return skip_lines(file.view(), checkpoint, line % LineIndex::STRIDE, file.size(), skipped);
+}
+
+std::optional<uint64_t> LineIndexCache::line_count(const MappedFile& file) {
+    std::lock_guard<std::mutex> lock(mutex);
+    LineIndex& index = entry_for(file).index;
+    if (!index.complete) {
+        return std::nullopt;
+    }
+    return index.lines_found;
+}
+
+uint64_t LineIndexCache::count_lines(const MappedFile& file) {
+    std::lock_guard<std::mutex> lock(mutex);
+    LineIndex& index = entry_for(file).index;
+    extend(file, index, UINT64_MAX);
+    return index.lines_found;
+}
+
+void LineIndexCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
+
+uint64_t skip_lines(std::string_view data, uint64_t offset, uint64_t count, uint64_t max_bytes,
+                    uint64_t& lines_skipped) {
+    lines_skipped = 0;
+    uint64_t limit = std::min<uint64_t>(data.size(), offset + std::min(max_bytes, data.size() - offset));
+    uint64_t position = offset;
+
+    while (lines_skipped < count && position < limit) {
+        const void* newline = std::memchr(data.data() + position, '\n', static_cast<size_t>(limit - position));
+        if (!newline) {
+            // Budget or data ends inside a line: keep whole lines when there are any
+            if (lines_skipped == 0 || limit == data.size()) {
+                return limit;
+            }
+            return position;
+        }
+        position = static_cast<uint64_t>(static_cast<const char*>(newline) - data.data()) + 1;
+        ++lines_skipped;
+    }
+    return position;
+}
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,451 @@
+#include "../../include/neoneo/io/patch.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace neoneo {
+namespace io {
+
+namespace {
+
+constexpr size_t NOT_FOUND = std::numeric_limits<size_t>::max();
+
+bool starts_with(std::string_view text, std::string_view prefix) {
+    return text.substr(0, prefix.size()) == prefix;
+}
+
+// Start of the line containing offset
+size_t line_start(std::string_view text, size_t offset) {
+    if (offset == 0) {
+        return 0;
+    }
+    const void* hit = memrchr(text.data(), '\n', offset);
+    return hit ? static_cast<size_t>(static_cast<const char*>(hit) - text.data()) + 1 : 0;
+}
+
+// Just past the newline that ends the line containing offset
+size_t line_end(std::string_view text, size_t offset) {
+    if (offset >= text.size()) {
+        return text.size();
+    }
+    const void* hit = std::memchr(text.data() + offset, '\n', text.size() - offset);
+    return hit ? static_cast<size_t>(static_cast<const char*>(hit) - text.data()) + 1 : text.size();
+}
+
+// "a/file.c\t2024-01-01 ..." -> "a/file.c"
+std::string header_path(std::string_view text) {
+    text = text.substr(0, text.find('\t'));
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    if (text.size() >= 2 && text.front() == '"' && text.back() == '"') {
+        text = text.substr(1, text.size() - 2);
+    }
+    return std::string(text);
+}
+
+bool parse_number(std::string_view& text, uint64_t& value) {
+    size_t digits = 0;
+    value = 0;
+    while (digits < text.size() && text[digits] >= '0' && text[digits] <= '9') {
+        value = value * 10 + static_cast<uint64_t>(text[digits] - '0');
+        ++digits;
+    }
+    text.remove_prefix(digits);
+    return digits > 0;
+}
+
+// "-12,5" or "-12" (a count of 1)
+bool parse_range(std::string_view& text, char sign, uint64_t& start, uint64_t& count) {
+    if (text.empty() || text[0] != sign) {
+        return false;
+    }
+    text.remove_prefix(1);
+    if (!parse_number(text, start)) {
+        return false;
+    }
+    count = 1;
+    if (!text.empty() && text[0] == ',') {
+        text.remove_prefix(1);
+        return parse_number(text, count);
+    }
+    return true;
+}
+
+// "@@ -12,5 +12,6 @@ context"; anything else after "@@" leaves the hunk unnumbered
+void parse_hunk_header(std::string_view line, Hunk& hunk) {
+    std::string_view rest = line.substr(2);
+    rest.remove_prefix(std::min(rest.find_first_not_of(' '), rest.size()));
+    if (!parse_range(rest, '-', hunk.old_start, hunk.old_count)) {
+        hunk.numbered = false;
+        return;
+    }
+    rest.remove_prefix(std::min(rest.find_first_not_of(' '), rest.size()));
+    hunk.numbered = parse_range(rest, '+', hunk.new_start, hunk.new_count);
+}
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// Equal, or with whitespace set equal once leading and trailing whitespace
+// is dropped and every other run of it is taken as one space
+bool same_line(std::string_view a, std::string_view b, bool whitespace) {
+    if (!whitespace) {
+        return a == b;
+    }
+    auto skip = [](std::string_view text, size_t& at) {
+        while (at < text.size() && is_space(text[at])) {
+            ++at;
+        }
+    };
+    size_t i = 0;
+    size_t j = 0;
+    skip(a, i);
+    skip(b, j);
+    while (i < a.size() && j < b.size()) {
+        bool space_a = is_space(a[i]);
+        if (space_a != is_space(b[j])) {
+            return false;
+        }
+        if (space_a) {
+            skip(a, i);
+            skip(b, j);
+            continue;
+        }
+        if (a[i++] != b[j++]) {
+            return false;
+        }
+    }
+    skip(a, i);
+    skip(b, j);
+    return i == a.size() && j == b.size();
+}
+
+// Start of a line of the original
+struct Position {
+    uint64_t line = 0; // 0-based
+    size_t offset = 0;
+};
+
+class LineWalker {
+public:
+    explicit LineWalker(std::string_view text) : text(text) {}
+
+    // To the next line; false at the end of the text
+    bool next(Position& position) const {
+        if (position.offset >= text.size()) {
+            return false;
+        }
+        position.offset = line_end(text, position.offset);
+        ++position.line;
+        return true;
+    }
+
+    // To the previous line, but not before floor
+    bool previous(Position& position, const Position& floor) const {
+        if (position.line <= floor.line) {
+            return false;
+        }
+        position.offset = line_start(text, position.offset - 1);
+        --position.line;
+        return true;
+    }
+
+    // From position to line, stopping at the end of the text
+    Position seek(Position position, uint64_t line, const Position& floor) const {
+        while (position.line > line && previous(position, floor)) {
+        }
+        while (position.line < line && next(position)) {
+        }
+        return position;
+    }
+
+    // Offset just past the lines of pattern if they are found at offset, otherwise NOT_FOUND
+    size_t match(size_t offset, const std::vector<const PatchLine*>& pattern, bool whitespace) const {
+        for (const PatchLine* line : pattern) {
+            if (offset >= text.size()) {
+                return NOT_FOUND;
+            }
+            size_t end = line_end(text, offset);
+            std::string_view found = text.substr(offset, end - offset);
+            if (!found.empty() && found.back() == '\n') {
+                found.remove_suffix(1);
+            }
+            if (!same_line(found, line->text, whitespace)) {
+                return NOT_FOUND;
+            }
+            offset = end;
+        }
+        return offset;
+    }
+
+private:
+    std::string_view text;
+};
+
+std::string describe_hunk(size_t index, const Hunk& hunk) {
+    std::string text = "hunk " + std::to_string(index + 1);
+    if (hunk.numbered) {
+        text += " (@@ -" + std::to_string(hunk.old_start) + "," + std::to_string(hunk.old_count) + " +" +
+                std::to_string(hunk.new_start) + "," + std::to_string(hunk.new_count) + " @@)";
+    }
+    return text;
+}
+
+} // namespace
+
+bool parse_patch(std::string_view text, std::vector<FilePatch>& patches, std::string& error) {
+    std::vector<std::string_view> lines;
+    for (size_t pos = 0; pos < text.size();) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        lines.push_back(text.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    auto is_file_header = [&](size_t i) {
+        return starts_with(lines[i], "--- ") && i + 1 < lines.size() && starts_with(lines[i + 1], "+++ ");
+    };
+
+    bool stray_hunk = false;
+    for (size_t i = 0; i < lines.size();) {
+        if (!is_file_header(i)) {
+            stray_hunk = stray_hunk || starts_with(lines[i], "@@");
+            ++i;
+            continue;
+        }
+        FilePatch patch;
+        patch.old_path = header_path(lines[i].substr(4));
+        patch.new_path = header_path(lines[i + 1].substr(4));
+        i += 2;
+
+        while (i < lines.size() && starts_with(lines[i], "@@")) {
+            Hunk hunk;
+            parse_hunk_header(lines[i], hunk);
+            ++i;
+
+            // Blank lines are usually context whose space was lost, but trailing ones may just separate hunks
+            std::vector<bool> blank;
+            while (i < lines.size() && !starts_with(lines[i], "@@") && !is_file_header(i)) {
+                std::string_view line = lines[i];
+                if (line.empty() || line == "\r") {
+                    hunk.lines.push_back(PatchLine{' ', std::string_view(), true});
+                    blank.push_back(true);
+                } else if (line[0] == ' ' || line[0] == '-' || line[0] == '+') {
+                    hunk.lines.push_back(PatchLine{line[0], line.substr(1), true});
+                    blank.push_back(false);
+                } else if (line[0] == '\\') {
+                    if (!hunk.lines.empty()) {
+                        hunk.lines.back().newline = false;
+                    }
+                } else {
+                    break;
+                }
+                ++i;
+            }
+
+            uint64_t old_lines = 0;
+            uint64_t new_lines = 0;
+            for (const auto& line : hunk.lines) {
+                old_lines += line.kind != '+' ? 1 : 0;
+                new_lines += line.kind != '-' ? 1 : 0;
+            }
+            while (!hunk.lines.empty() && blank.back() &&
+                   (!hunk.numbered || old_lines > hunk.old_count || new_lines > hunk.new_count)) {
+                hunk.lines.pop_back();
+                blank.pop_back();
+                --old_lines;
+                --new_lines;
+            }
+            if (hunk.lines.empty()) {
+                error = "Empty hunk in the changes to " + patch.new_path;
+                return false;
+            }
+            patch.hunks.push_back(std::move(hunk));
+        }
+        patches.push_back(std::move(patch));
+    }
+
+    if (patches.empty()) {
+        error = stray_hunk ? "The patch has hunks but no '--- a/path' and '+++ b/path' lines naming the file"
+                           : "No changes found; expected a unified diff with '--- a/path' and '+++ b/path' "
+                             "lines followed by '@@' hunks";
+        return false;
+    }
+    return true;
+}
+
+bool apply_hunks(std::string_view original, const std::vector<Hunk>& hunks, PieceTable& content,
+                 std::vector<HunkPlacement>& placements, std::string& error, size_t max_fuzz) {
+    LineWalker walker(original);
+    Position floor;  // Just past the previous hunk: no hunk may start before it
+    Position cursor; // Where the last search started, to seek from
+    int64_t last_offset = 0;
+    std::vector<TextChange> changes;
+    std::vector<HunkPlacement> placed;
+
+    for (size_t index = 0; index < hunks.size(); ++index) {
+        const Hunk& hunk = hunks[index];
+        const auto& lines = hunk.lines;
+        size_t leading = 0;
+        while (leading < lines.size() && lines[leading].kind == ' ') {
+            ++leading;
+        }
+        size_t trailing = 0;
+        while (trailing < lines.size() - leading && lines[lines.size() - 1 - trailing].kind == ' ') {
+            ++trailing;
+        }
+
+        // 0-based line the header puts the hunk's first line at; "-5,0" inserts after line 5
+        uint64_t nominal = floor.line;
+        if (hunk.numbered) {
+            nominal = hunk.old_count == 0 || hunk.old_start == 0 ? hunk.old_start : hunk.old_start - 1;
+        }
+        int64_t wanted = static_cast<int64_t>(nominal) + (hunk.numbered ? last_offset : 0);
+
+        bool found = false;
+        Position at;
+        size_t lead = 0;
+        size_t trail = 0;
+        HunkPlacement placement;
+        for (size_t fuzz = 0; fuzz <= max_fuzz && !found; ++fuzz) {
+            lead = std::min(fuzz, leading);
+            trail = std::min(fuzz, trailing);
+            if (fuzz > 0 && lead == std::min(fuzz - 1, leading) && trail == std::min(fuzz - 1, trailing)) {
+                break; // No more context to drop
+            }
+            std::vector<const PatchLine*> pattern;
+            for (size_t i = lead; i < lines.size() - trail; ++i) {
+                if (lines[i].kind != '+') {
+                    pattern.push_back(&lines[i]);
+                }
+            }
+            if (pattern.empty() && fuzz > 0) {
+                break; // Nothing left to anchor it
+            }
+
+            uint64_t start_line = static_cast<uint64_t>(std::max<int64_t>(wanted + static_cast<int64_t>(lead), 0));
+            Position start = walker.seek(cursor, std::max(start_line, floor.line), floor);
+            cursor = start;
+            if (pattern.empty()) {
+                // Only added lines: they go where the header says
+                at = start;
+                found = true;
+                break;
+            }
+
+            for (bool whitespace : {false, true}) {
+                Position forward = start;
+                Position backward = start;
+                bool forward_open = true;
+                bool backward_open = true;
+                found = walker.match(start.offset, pattern, whitespace) != NOT_FOUND;
+                at = start;
+                while (!found && (forward_open || backward_open)) {
+                    if (forward_open) {
+                        forward_open = walker.next(forward);
+                        if (forward_open && walker.match(forward.offset, pattern, whitespace) != NOT_FOUND) {
+                            at = forward;
+                            found = true;
+                            break;
+                        }
+                    }
+                    if (backward_open) {
+                        backward_open = walker.previous(backward, floor);
+                        if (backward_open && walker.match(backward.offset, pattern, whitespace) != NOT_FOUND) {
+                            at = backward;
+                            found = true;
+                        }
+                    }
+                }
+                if (found) {
+                    placement.fuzz = fuzz;
+                    placement.whitespace = whitespace;
+                    break;
+                }
+            }
+        }
+
+        if (!found) {
+            error = describe_hunk(index, hunk) + " does not apply: its lines were not found";
+            if (hunk.numbered) {
+                error += " near line " + std::to_string(static_cast<uint64_t>(std::max<int64_t>(wanted, 0)) + 1);
+            }
+            for (const auto& line : lines) {
+                if (line.kind != '+') {
+                    std::string_view first = line.text.substr(0, 80);
+                    error += " (looking for \"" + std::string(first) + (line.text.size() > 80 ? "..." : "") + "\")";
+                    break;
+                }
+            }
+            return false;
+        }
+
+        int64_t first_line = static_cast<int64_t>(at.line) - static_cast<int64_t>(lead);
+        placement.line = static_cast<uint64_t>(std::max<int64_t>(first_line, 0)) + 1;
+        placement.offset = first_line - static_cast<int64_t>(nominal);
+        if (hunk.numbered) {
+            last_offset = placement.offset;
+        }
+        placed.push_back(placement);
+
+        // Context lines keep the file's text, which may differ in whitespace;
+        // removed lines are cut out and added ones inserted
+        Position position = at;
+        bool pending = false;
+        TextChange change;
+        auto flush = [&]() {
+            if (pending) {
+                changes.push_back(std::move(change));
+                change = TextChange();
+                pending = false;
+            }
+        };
+        for (size_t i = lead; i < lines.size() - trail; ++i) {
+            const PatchLine& line = lines[i];
+            if (line.kind == ' ') {
+                flush();
+                walker.next(position);
+                continue;
+            }
+            if (!pending) {
+                change.offset = position.offset;
+                change.length = 0;
+                pending = true;
+            }
+            if (line.kind == '-') {
+                Position after = position;
+                walker.next(after);
+                change.length += after.offset - position.offset;
+                position = after;
+            } else {
+                // Lines added after a last line without a newline must not run on from it
+                if (change.length == 0 && change.text.empty() && position.offset == original.size() &&
+                    !original.empty() && original.back() != '\n') {
+                    change.text += '\n';
+                }
+                change.text.append(line.text);
+                if (line.newline) {
+                    change.text += '\n';
+                }
+            }
+        }
+        flush();
+        floor = position;
+        cursor = position;
+    }
+
+    // Offsets are into the original, so each is shifted by what the changes before it did to the length
+    int64_t shift = 0;
+    for (const auto& change : changes) {
+        content.replace(static_cast<uint64_t>(static_cast<int64_t>(change.offset) + shift), change.length, change.text);
+        shift += static_cast<int64_t>(change.text.size()) - static_cast<int64_t>(change.length);
+    }
+    placements = std::move(placed);
+    return true;
+}
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,242 @@
+#include "../../include/neoneo/io/piece_table.hpp"
+#include "../../include/neoneo/io/file_transaction.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace neoneo {
+namespace io {
+
+PieceTable::PieceTable(std::string_view original) : original(original), length(original.size()) {
+    if (!original.empty()) {
+        pieces.push_back(Piece{false, 0, original.size()});
+    }
+}
+
+std::string_view PieceTable::span_of(const Piece& piece) const {
+    const char* base = piece.added ? added.data() : original.data();
+    return std::string_view(base + piece.start, static_cast<size_t>(piece.length));
+}
+
+size_t PieceTable::split(uint64_t offset) {
+    uint64_t position = 0;
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        if (offset == position) {
+            return i;
+        }
+        if (offset < position + pieces[i].length) {
+            Piece tail = pieces[i];
+            uint64_t head_length = offset - position;
+            pieces[i].length = head_length;
+            tail.start += head_length;
+            tail.length -= head_length;
+            pieces.insert(pieces.begin() + static_cast<std::ptrdiff_t>(i) + 1, tail);
+            return i + 1;
+        }
+        position += pieces[i].length;
+    }
+    return pieces.size();
+}
+
+void PieceTable::insert(uint64_t offset, std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+    offset = std::min(offset, length);
+    Piece piece{true, added.size(), text.size()};
+    added.append(text);
+    size_t index = split(offset);
+    // Typing at the end of the previous insertion just extends it
+    if (index > 0 && pieces[index - 1].added && pieces[index - 1].start + pieces[index - 1].length == piece.start) {
+        pieces[index - 1].length += piece.length;
+    } else {
+        pieces.insert(pieces.begin() + static_cast<std::ptrdiff_t>(index), piece);
+    }
+    length += text.size();
+}
+
+void PieceTable::erase(uint64_t offset, uint64_t count) {
+    offset = std::min(offset, length);
+    count = std::min(count, length - offset);
+    if (count == 0) {
+        return;
+    }
+    size_t first = split(offset);
+    size_t last = split(offset + count);
+    pieces.erase(pieces.begin() + static_cast<std::ptrdiff_t>(first),
+                 pieces.begin() + static_cast<std::ptrdiff_t>(last));
+    length -= count;
+}
+
+void PieceTable::replace(uint64_t offset, uint64_t count, std::string_view text) {
+    erase(offset, count);
+    insert(offset, text);
+}
+
+size_t PieceTable::replace_every(std::string_view needle, std::string_view text) {
+    std::vector<uint64_t> matches;
+    if (needle.empty()) {
+        return 0;
+    }
+    for (auto pos = find(needle); pos; pos = find(needle, *pos + needle.size())) {
+        matches.push_back(*pos);
+    }
+    if (matches.empty()) {
+        return 0;
+    }
+
+    // Every replacement shares one copy of text in the add buffer
+    Piece replacement{true, added.size(), text.size()};
+    added.append(text);
+
+    std::vector<Piece> rebuilt;
+    rebuilt.reserve(pieces.size() + matches.size() * 2);
+    size_t next = 0;
+    uint64_t removed_until = 0; // Bytes before this offset belong to a match
+    uint64_t position = 0;
+    for (const auto& piece : pieces) {
+        uint64_t end = position + piece.length;
+        uint64_t cursor = std::max(position, removed_until);
+        while (cursor < end) {
+            uint64_t stop = next < matches.size() ? std::min(matches[next], end) : end;
+            if (stop > cursor) {
+                rebuilt.push_back(Piece{piece.added, piece.start + (cursor - position), stop - cursor});
+                cursor = stop;
+            }
+            if (next < matches.size() && matches[next] == cursor) {
+                if (replacement.length > 0) {
+                    rebuilt.push_back(replacement);
+                }
+                removed_until = cursor + needle.size();
+                cursor = std::min(removed_until, end);
+                ++next;
+            }
+        }
+        position = end;
+    }
+
+    pieces = std::move(rebuilt);
+    length = length - matches.size() * needle.size() + matches.size() * text.size();
+    return matches.size();
+}
+
+char PieceTable::at(uint64_t offset) const {
+    for (const auto& piece : pieces) {
+        if (offset < piece.length) {
+            return span_of(piece)[static_cast<size_t>(offset)];
+        }
+        offset -= piece.length;
+    }
+    return '\0';
+}
+
+std::optional<uint64_t> PieceTable::find(std::string_view needle, uint64_t from) const {
+    if (needle.empty()) {
+        return from <= length ? std::optional<uint64_t>(from) : std::nullopt;
+    }
+
+    // Matches inside one piece are found with memmem; those across a piece
+    // boundary in a window of the last needle.size() - 1 bytes before it
+    std::string carry;
+    uint64_t carry_start = 0; // Offset of carry[0]
+    uint64_t position = 0;
+    for (const auto& piece : pieces) {
+        std::string_view span = span_of(piece);
+        if (position + span.size() <= from) {
+            position += span.size();
+            continue;
+        }
+
+        if (!carry.empty()) {
+            std::string window = carry;
+            window.append(span.substr(0, std::min(span.size(), needle.size() - 1)));
+            for (size_t at = window.find(needle); at != std::string::npos && at < carry.size();
+                 at = window.find(needle, at + 1)) {
+                if (carry_start + at >= from) {
+                    return carry_start + at;
+                }
+            }
+        }
+
+        size_t local = from > position ? static_cast<size_t>(from - position) : 0;
+        if (local < span.size()) {
+            const void* hit = memmem(span.data() + local, span.size() - local, needle.data(), needle.size());
+            if (hit) {
+                return position + static_cast<uint64_t>(static_cast<const char*>(hit) - span.data());
+            }
+        }
+
+        // Keep the bytes a match across the next boundary could start in
+        size_t keep = needle.size() - 1;
+        if (span.size() >= keep) {
+            carry.assign(span.substr(span.size() - keep));
+        } else {
+            carry.append(span);
+            if (carry.size() > keep) {
+                carry.erase(0, carry.size() - keep);
+            }
+        }
+        position += span.size();
+        carry_start = position - carry.size();
+    }
+    return std::nullopt;
+}
+
+std::optional<uint64_t> PieceTable::line_offset(uint64_t line) const {
+    if (line == 0) {
+        return length > 0 ? std::optional<uint64_t>(0) : std::nullopt;
+    }
+    uint64_t seen = 0;
+    uint64_t position = 0;
+    for (const auto& piece : pieces) {
+        std::string_view span = span_of(piece);
+        const char* p = span.data();
+        const char* end = p + span.size();
+        while (const void* hit = std::memchr(p, '\n', static_cast<size_t>(end - p))) {
+            p = static_cast<const char*>(hit) + 1;
+            if (++seen == line) {
+                uint64_t offset = position + static_cast<uint64_t>(p - span.data());
+                return offset < length ? std::optional<uint64_t>(offset) : std::nullopt;
+            }
+        }
+        position += span.size();
+    }
+    return std::nullopt;
+}
+
+std::string PieceTable::str() const {
+    std::string text;
+    text.reserve(static_cast<size_t>(length));
+    for_each_span([&](std::string_view span) { text.append(span); });
+    return text;
+}
+
+std::vector<TextChange> PieceTable::changes() const {
+    // Original pieces are never reordered, so a gap between consecutive
+    // ones, or inserted text between them, is a change
+    std::vector<TextChange> result;
+    uint64_t expected = 0; // Original offset the next unchanged piece would start at
+    std::string inserted;
+    for (const auto& piece : pieces) {
+        if (piece.added) {
+            inserted.append(span_of(piece));
+            continue;
+        }
+        if (piece.start != expected || !inserted.empty()) {
+            result.push_back(TextChange{expected, piece.start - expected, std::move(inserted)});
+            inserted.clear();
+        }
+        expected = piece.start + piece.length;
+    }
+    if (expected != original.size() || !inserted.empty()) {
+        result.push_back(TextChange{expected, original.size() - expected, std::move(inserted)});
+    }
+    return result;
+}
+
+bool PieceTable::save(const std::string& path, std::string& error) const {
+    FileTransaction transaction;
+    return transaction.stage(path, *this, error) && transaction.commit(error);
+}
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,550 @@
+#include "../../include/neoneo/io/search.hpp"
+#include "../../include/neoneo/io/content_cache.hpp"
+#include "../../include/neoneo/io/glob.hpp"
+#include "../../include/neoneo/io/mapped_file.hpp"
+#include "../../include/neoneo/io/tail.hpp"
+#include "../../include/neoneo/io/walk.hpp"
+#include "../../include/neoneo/io/work_stealing.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <regex.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace neoneo {
+namespace io {
+
+namespace {
+
+// Files up to this size are read into a reused buffer; larger ones are mapped
+constexpr uint64_t READ_LIMIT = 1024 * 1024;
+
+// Bytes checked for NUL when deciding whether a file is binary
+constexpr size_t BINARY_PROBE = 8192;
+
+// Longest line text kept per match
+constexpr size_t MAX_LINE_TEXT = 300;
+
+// Lines starting with one of these are treated as definitions when ranking
+constexpr const char* DEFINITION_WORDS[] = {
+    "class ", "struct ", "enum ", "union ", "namespace ", "typedef ", "using ", "template",
+    "#define ", "def ", "fn ", "func ", "function ", "interface ", "type ", "impl ", "trait ",
+};
+
+// Per-thread state, so the hot path takes no locks
+struct Worker {
+    std::vector<FileMatches> files;
+    std::string buffer;   // Contents of small files
+    std::string lowered;  // Case-folded copy for ignore_case literals
+    regex_t regex{};
+    bool has_regex = false;
+    size_t files_searched = 0;
+    size_t binary_skipped = 0;
+    size_t large_skipped = 0;
+
+    Worker() = default;
+    Worker(const Worker&) = delete;
+    Worker& operator=(const Worker&) = delete;
+    ~Worker() {
+        if (has_regex) {
+            regfree(&regex);
+        }
+    }
+};
+
+bool is_word_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// ASCII case folding, the same as tolower in the C locale
+void lower_into(const char* data, size_t size, std::string& out) {
+    out.resize(size);
+    size_t i = 0;
+#if defined(__SSE2__)
+    // Bytes are shifted so that 'A'..'Z' are the 26 smallest signed values
+    const __m128i shift = _mm_set1_epi8(static_cast<char>(128 - 'A'));
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(-128 + 26));
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i upper = _mm_cmplt_epi8(_mm_add_epi8(chunk, shift), limit);
+        chunk = _mm_or_si128(chunk, _mm_and_si128(upper, case_bit));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&out[i]), chunk);
+    }
+#endif
+    for (; i < size; ++i) {
+        char c = data[i];
+        out[i] = c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c;
+    }
+}
+
+} // namespace
+
+std::string required_literal(const std::string& pattern) {
+    std::string best;
+    std::string run;
+    int depth = 0;
+    auto finish = [&]() {
+        if (run.size() > best.size()) {
+            best = run;
+        }
+        run.clear();
+    };
+
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        char c = pattern[i];
+        switch (c) {
+        case '(':
+            finish();
+            ++depth;
+            break;
+        case ')':
+            finish();
+            --depth;
+            break;
+        case '[': {
+            finish();
+            // Skip the bracket expression; a ']' right after '[' or '[^' is literal
+            size_t j = i + 1;
+            if (j < pattern.size() && pattern[j] == '^') {
+                ++j;
+            }
+            if (j < pattern.size() && pattern[j] == ']') {
+                ++j;
+            }
+            while (j < pattern.size() && pattern[j] != ']') {
+                // [:class:], [=equiv=] and [.coll.] may contain their own ']'
+                if (pattern[j] == '[' && j + 1 < pattern.size() &&
+                    (pattern[j + 1] == ':' || pattern[j + 1] == '=' || pattern[j + 1] == '.')) {
+                    size_t close = pattern.find(std::string{pattern[j + 1], ']'}, j + 2);
+                    if (close == std::string::npos) {
+                        return "";
+                    }
+                    j = close + 2;
+                    continue;
+                }
+                ++j;
+            }
+            i = j;
+            break;
+        }
+        case '*':
+        case '?':
+        case '{':
+            // The previous character may occur zero times
+            if (!run.empty()) {
+                run.pop_back();
+            }
+            finish();
+            if (c == '{') {
+                size_t close = pattern.find('}', i);
+                i = close == std::string::npos ? pattern.size() : close;
+            }
+            break;
+        case '|':
+            if (depth == 0) {
+                return "";
+            }
+            break;
+        case '+':
+            // The previous character is required, but what follows need not be adjacent to it
+            finish();
+            break;
+        case '.':
+        case '^':
+        case '$':
+            finish();
+            break;
+        case '\\':
+            if (i + 1 < pattern.size() && !std::isalnum(static_cast<unsigned char>(pattern[i + 1]))) {
+                if (depth == 0) {
+                    run += pattern[++i];
+                } else {
+                    ++i;
+                }
+            } else {
+                // GNU escapes like \w or \b
+                finish();
+                ++i;
+            }
+            break;
+        default:
+            if (depth == 0) {
+                run += c;
+            }
+            break;
+        }
+    }
+    finish();
+    return best.size() >= 3 ? best : "";
+}
+
+namespace {
+
+int score_line(std::string_view line, size_t match_start, size_t match_end) {
+    int score = 1;
+    bool word_start = match_start == 0 || !is_word_char(line[match_start - 1]);
+    bool word_end = match_end >= line.size() || !is_word_char(line[match_end]);
+    if (word_start && word_end) {
+        score += 2;
+    }
+    size_t first = line.find_first_not_of(" \t");
+    if (first != std::string_view::npos) {
+        std::string_view trimmed = line.substr(first);
+        for (const char* word : DEFINITION_WORDS) {
+            if (trimmed.compare(0, std::strlen(word), word) == 0) {
+                score += 3;
+                break;
+            }
+        }
+    }
+    return score;
+}
+
+class Searcher {
+public:
+    Searcher(const SearchOptions& options, size_t threads)
+        : options(options), workers(threads), stop_after(std::max<size_t>(options.max_matches * 10, 1000)) {
+        // Regexes are only run on lines that contain their required literal, if they have one
+        needle = options.regex ? required_literal(options.pattern) : options.pattern;
+        if (options.ignore_case) {
+            lower_into(needle.data(), needle.size(), needle);
+        }
+    }
+
+    bool compile(std::string& error) {
+        if (!options.regex) {
+            return true;
+        }
+        int flags = REG_EXTENDED | REG_NEWLINE | (options.ignore_case ? REG_ICASE : 0);
+        // regexec serializes callers of one regex_t, so each worker gets its own
+        for (auto& worker : workers) {
+            int status = regcomp(&worker.regex, options.pattern.c_str(), flags);
+            if (status != 0) {
+                char message[256];
+                regerror(status, &worker.regex, message, sizeof(message));
+                error = "Invalid regex: " + std::string(message);
+                return false;
+            }
+            worker.has_regex = true;
+        }
+        return true;
+    }
+
+    void run_walk(const std::string& root, SearchResult& result) {
+        WalkVisitor visitor;
+        visitor.file = [&](const std::string& path, const std::string& relative, size_t worker) {
+            search_file(path, relative, workers[worker]);
+        };
+        visitor.accept = [&](const std::string& relative, const char* name) { return wanted(relative, name); };
+        visitor.should_stop = [&]() { return enough(); };
+        walk_tree(root, workers.size(), visitor);
+        collect(result);
+    }
+
+    void run_files(const std::string& root, const std::vector<std::string>& files, SearchResult& result) {
+        WorkStealingPool<std::string> pool(workers.size());
+        std::vector<std::string> initial;
+        for (const auto& relative : files) {
+            size_t slash = relative.rfind('/');
+            if (wanted(relative, relative.c_str() + (slash == std::string::npos ? 0 : slash + 1))) {
+                initial.push_back(relative);
+            }
+        }
+        pool.run(std::move(initial), [&](std::string& relative, size_t worker) {
+            search_file(root.empty() ? relative : child_path(root, relative), relative, workers[worker]);
+            if (enough()) {
+                pool.stop();
+            }
+        });
+        collect(result);
+    }
+
+private:
+    bool enough() {
+        if (found.load(std::memory_order_relaxed) >= stop_after) {
+            stopped = true;
+        }
+        return stopped;
+    }
+
+    void collect(SearchResult& result) {
+        for (auto& worker : workers) {
+            result.files_searched += worker.files_searched;
+            result.binary_skipped += worker.binary_skipped;
+            result.large_skipped += worker.large_skipped;
+            for (auto& file : worker.files) {
+                result.total_matches += file.count;
+                result.files.push_back(std::move(file));
+            }
+        }
+        result.stopped_early = stopped;
+    }
+
+    bool wanted(const std::string& relative, const char* name) const {
+        if (options.glob.empty()) {
+            return true;
+        }
+        if (options.glob.find('/') != std::string::npos) {
+            return glob_match(options.glob, relative);
+        }
+        return fnmatch(options.glob.c_str(), name, 0) == 0;
+    }
+
+    // Small files are read into the worker's buffer, larger ones mapped
+    bool read_file(const std::string& path, Worker& worker, std::shared_ptr<const MappedFile>& mapped,
+                   std::string_view& data) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info {};
+        if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+            close(fd);
+            return false;
+        }
+        uint64_t size = static_cast<uint64_t>(info.st_size);
+        if (size > options.max_file_size) {
+            ++worker.large_skipped;
+            close(fd);
+            return false;
+        }
+
+        if (size <= READ_LIMIT) {
+            worker.buffer.resize(static_cast<size_t>(size));
+            size_t filled = 0;
+            while (filled < worker.buffer.size()) {
+                ssize_t got = read(fd, &worker.buffer[filled], worker.buffer.size() - filled);
+                if (got < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (got <= 0) {
+                    break;
+                }
+                filled += static_cast<size_t>(got);
+            }
+            close(fd);
+            data = std::string_view(worker.buffer.data(), filled);
+        } else {
+            close(fd);
+            std::string error;
+            mapped = MappedFile::open(path, error);
+            if (!mapped) {
+                return false;
+            }
+            data = mapped->view();
+        }
+        return true;
+    }
+
+    void search_file(const std::string& path, const std::string& relative, Worker& worker) {
+        // Files the tools already hold need no reading
+        std::shared_ptr<const MappedFile> mapped = options.cache ? options.cache->find(path) : nullptr;
+        std::string_view data;
+        if (mapped) {
+            if (mapped->size() > options.max_file_size) {
+                ++worker.large_skipped;
+                return;
+            }
+            data = mapped->view();
+        } else if (!read_file(path, worker, mapped, data)) {
+            return;
+        }
+
+        if (std::memchr(data.data(), '\0', std::min(data.size(), BINARY_PROBE))) {
+            ++worker.binary_skipped;
+            return;
+        }
+        ++worker.files_searched;
+
+        std::string_view haystack = data;
+        if (options.ignore_case && !needle.empty()) {
+            lower_into(data.data(), data.size(), worker.lowered);
+            haystack = worker.lowered;
+        }
+
+        FileMatches file;
+        uint64_t line = 1;
+        size_t counted_to = 0;
+        size_t pos = 0;
+        size_t match_start = 0;
+        size_t match_end = 0;
+        while (pos < data.size() && find(worker, data, haystack, pos, match_start, match_end)) {
+            // pos is always at a line start, so the match's line starts at or after it
+            const void* previous = match_start > pos ? memrchr(data.data() + pos, '\n', match_start - pos) : nullptr;
+            size_t line_start = previous ? static_cast<size_t>(static_cast<const char*>(previous) - data.data()) + 1 : pos;
+            const void* next = std::memchr(data.data() + match_start, '\n', data.size() - match_start);
+            size_t line_end = next ? static_cast<size_t>(static_cast<const char*>(next) - data.data()) : data.size();
+
+            line += count_newlines(data.data() + counted_to, line_start - counted_to);
+            counted_to = line_start;
+
+            ++file.count;
+            if (file.lines.size() < options.max_per_file) {
+                std::string_view text = data.substr(line_start, line_end - line_start);
+                if (!text.empty() && text.back() == '\r') {
+                    text.remove_suffix(1);
+                }
+                int score = score_line(text, match_start - line_start, std::max(match_end, match_start) - line_start);
+                std::string kept(text.substr(0, MAX_LINE_TEXT));
+                if (text.size() > MAX_LINE_TEXT) {
+                    kept += "...";
+                }
+                file.lines.push_back(LineMatch{line, std::move(kept), score});
+                file.score = std::max(file.score, score);
+            }
+            pos = line_end + 1;
+        }
+
+        if (file.count > 0) {
+            found.fetch_add(file.count, std::memory_order_relaxed);
+            file.path = path;
+            if (!options.regex) {
+                // A file named after what is searched for is probably the one wanted
+                size_t slash = relative.rfind('/');
+                std::string name = relative.substr(slash == std::string::npos ? 0 : slash + 1);
+                lower_into(name.data(), name.size(), name);
+                std::string lowered_pattern;
+                lower_into(options.pattern.data(), options.pattern.size(), lowered_pattern);
+                if (name.find(lowered_pattern) != std::string::npos) {
+                    file.score += 5;
+                }
+            }
+            worker.files.push_back(std::move(file));
+        }
+    }
+
+    // Next match at or after pos, which is always the start of a line
+    bool find(Worker& worker, std::string_view data, std::string_view haystack, size_t pos, size_t& start,
+              size_t& end) const {
+        if (!options.regex) {
+            const void* hit = memmem(haystack.data() + pos, haystack.size() - pos, needle.data(), needle.size());
+            if (!hit) {
+                return false;
+            }
+            start = static_cast<size_t>(static_cast<const char*>(hit) - haystack.data());
+            end = start + needle.size();
+            return true;
+        }
+
+        if (needle.empty()) {
+            return run_regex(worker, data, pos, data.size(), start, end);
+        }
+        // REG_NEWLINE keeps matches within a line, so only lines holding the literal can match
+        while (pos < data.size()) {
+            const void* hit = memmem(haystack.data() + pos, haystack.size() - pos, needle.data(), needle.size());
+            if (!hit) {
+                return false;
+            }
+            size_t offset = static_cast<size_t>(static_cast<const char*>(hit) - haystack.data());
+            const void* previous = offset > pos ? memrchr(data.data() + pos, '\n', offset - pos) : nullptr;
+            size_t line_start = previous ? static_cast<size_t>(static_cast<const char*>(previous) - data.data()) + 1 : pos;
+            const void* next = std::memchr(data.data() + offset, '\n', data.size() - offset);
+            size_t line_end = next ? static_cast<size_t>(static_cast<const char*>(next) - data.data()) : data.size();
+            if (run_regex(worker, data, line_start, line_end, start, end)) {
+                return true;
+            }
+            pos = line_end + 1;
+        }
+        return false;
+    }
+
+    static bool run_regex(Worker& worker, std::string_view data, size_t from, size_t to, size_t& start, size_t& end) {
+        regmatch_t match;
+        match.rm_so = static_cast<regoff_t>(from);
+        match.rm_eo = static_cast<regoff_t>(to);
+        if (regexec(&worker.regex, data.data(), 1, &match, REG_STARTEND) != 0) {
+            return false;
+        }
+        start = static_cast<size_t>(match.rm_so);
+        end = static_cast<size_t>(match.rm_eo);
+        return true;
+    }
+
+    const SearchOptions& options;
+    std::string needle;
+    std::vector<Worker> workers;
+    size_t stop_after;
+    std::atomic<size_t> found{0};
+    std::atomic<bool> stopped{false};
+};
+
+// Best files first, then cut to max_matches lines in total
+void rank(const SearchOptions& options, SearchResult& result) {
+    std::sort(result.files.begin(), result.files.end(), [](const FileMatches& a, const FileMatches& b) {
+        return a.score != b.score ? a.score > b.score : a.path < b.path;
+    });
+
+    size_t kept = 0;
+    size_t files = 0;
+    for (; files < result.files.size() && kept < options.max_matches; ++files) {
+        auto& lines = result.files[files].lines;
+        if (lines.size() > options.max_matches - kept) {
+            lines.resize(options.max_matches - kept);
+        }
+        kept += lines.size();
+    }
+    result.files.resize(files);
+}
+
+} // namespace
+
+bool search(const std::string& root, const SearchOptions& options, SearchResult& result, std::string& error) {
+    result = SearchResult{};
+    if (options.pattern.empty()) {
+        error = "Empty search pattern";
+        return false;
+    }
+
+    struct stat info {};
+    if (stat(root.c_str(), &info) != 0) {
+        error = "Path does not exist: " + root;
+        return false;
+    }
+    bool is_directory = S_ISDIR(info.st_mode);
+
+    size_t threads = options.threads > 0 ? options.threads : default_walk_threads();
+    Searcher searcher(options, is_directory ? threads : 1);
+    if (!searcher.compile(error)) {
+        return false;
+    }
+
+    if (is_directory) {
+        searcher.run_walk(root, result);
+    } else {
+        searcher.run_files("", {root}, result);
+    }
+    rank(options, result);
+    return true;
+}
+
+bool search_files(const std::string& root, const std::vector<std::string>& files, const SearchOptions& options,
+                  SearchResult& result, std::string& error) {
+    result = SearchResult{};
+    if (options.pattern.empty()) {
+        error = "Empty search pattern";
+        return false;
+    }
+
+    size_t threads = options.threads > 0 ? options.threads : default_walk_threads();
+    Searcher searcher(options, std::min(threads, std::max<size_t>(files.size(), 1)));
+    if (!searcher.compile(error)) {
+        return false;
+    }
+    searcher.run_files(root, files, result);
+    rank(options, result);
+    return true;
+}
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,118 @@
+#include "../../include/neoneo/io/spill_store.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace neoneo {
+namespace io {
+
+namespace fs = std::filesystem;
+
+SpillStore::SpillStore(uint64_t max_bytes) : max_bytes(max_bytes) {}
+
+SpillStore::~SpillStore() {
+    clear();
+    if (!directory.empty()) {
+        std::error_code ec;
+        fs::remove_all(directory, ec);
+    }
+}
+
+bool SpillStore::create_directory(std::string& error) {
+    // Private to this process: only its owner can list or read it
+    std::error_code ec;
+    std::string path = (fs::temp_directory_path(ec) / "neoneo-outputs-XXXXXX").string();
+    if (ec) {
+        path = "/tmp/neoneo-outputs-XXXXXX";
+    }
+    if (!mkdtemp(path.data())) {
+        error = "Could not create a directory for tool outputs: " + std::string(std::strerror(errno));
+        return false;
+    }
+    directory = path;
+    return true;
+}
+
+std::shared_ptr<const SpilledOutput> SpillStore::put(const std::string& tool_name, std::string_view content,
+                                                     std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (directory.empty() && !create_directory(error)) {
+        return nullptr;
+    }
+
+    uint64_t number = next_number++;
+    auto output = std::make_shared<SpilledOutput>();
+    output->handle = "out-" + std::to_string(number);
+    output->tool_name = tool_name;
+    output->name = output->handle + ".txt";
+    std::string path = directory + "/" + output->name;
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        error = "Could not create " + path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    for (size_t written = 0; written < content.size();) {
+        ssize_t n = ::write(fd, content.data() + written, content.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            error = "Could not write " + path + ": " + std::strerror(errno);
+            ::close(fd);
+            ::unlink(path.c_str());
+            return nullptr;
+        }
+        written += static_cast<size_t>(n);
+    }
+    ::close(fd);
+
+    output->file = MappedFile::open(path, error);
+    if (!output->file) {
+        ::unlink(path.c_str());
+        return nullptr;
+    }
+
+    outputs[number] = output;
+    stored_bytes += content.size();
+    // The newest output is kept even if it alone is over the budget
+    while (stored_bytes > max_bytes && outputs.size() > 1) {
+        remove(outputs.begin());
+    }
+    return output;
+}
+
+void SpillStore::remove(std::map<uint64_t, std::shared_ptr<const SpilledOutput>>::iterator it) {
+    // Readers holding the output keep its mapping; the file itself can go now
+    stored_bytes -= it->second->file->size();
+    ::unlink((directory + "/" + it->second->name).c_str());
+    outputs.erase(it);
+}
+
+std::shared_ptr<const SpilledOutput> SpillStore::find(const std::string& handle) const {
+    if (handle.compare(0, 4, "out-") != 0) {
+        return nullptr;
+    }
+    uint64_t number = std::strtoull(handle.c_str() + 4, nullptr, 10);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = outputs.find(number);
+    return it == outputs.end() ? nullptr : it->second;
+}
+
+std::string SpillStore::get_directory() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return directory;
+}
+
+void SpillStore::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!outputs.empty()) {
+        remove(outputs.begin());
+    }
+}
+
+} // namespace io
+} // namespace neoneo
@@ -0,0 +1,192 @@
+#include "../../include/neoneo/io/tail.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace neoneo {
+namespace io {
+
+namespace {
+
+// Backward scans count one block before looking for exact positions in it
+constexpr size_t TAIL_BLOCK = 64 * 1024;
+
+// How often a followed file is checked for new data
+constexpr auto FOLLOW_POLL = std::chrono::milliseconds(100);
+
+} // namespace
+
+uint64_t count_newlines(const char* data, size_t size) {
+    uint64_t count = 0;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // Matches are subtracted as -1 bytes into 16 byte-wide counters, which
+    // are summed with psadbw before any of them can overflow
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i zero = _mm_setzero_si128();
+    while (i + 16 <= size) {
+        __m128i counters = _mm_setzero_si128();
+        size_t rounds = std::min<size_t>((size - i) / 16, 255);
+        for (size_t r = 0; r < rounds; ++r, i += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(chunk, newline));
+        }
+        __m128i sums = _mm_sad_epu8(counters, zero);
+        count += static_cast<uint64_t>(_mm_cvtsi128_si32(sums)) +
+                 static_cast<uint64_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+    }
+    for (; i < size; ++i) {
+        count += data[i] == '\n';
+    }
+#else
+    const char* end = data + size;
+    while (const void* found = std::memchr(data + i, '\n', static_cast<size_t>(end - (data + i)))) {
+        ++count;
+        i = static_cast<size_t>(static_cast<const char*>(found) - data) + 1;
+    }
+#endif
+
+    return count;
+}
+
+uint64_t tail_offset(std::string_view data, uint64_t count, uint64_t& lines_found) {
+    lines_found = 0;
+    if (count == 0 || data.empty()) {
+        return data.size();
+    }
+
+    // A trailing newline ends the last line and is not a separator
+    size_t position = data.size();
+    if (data[position - 1] == '\n') {
+        --position;
+    }
+
+    // The tail starts just after the count-th newline from the end
+    uint64_t remaining = count;
+    while (position > 0) {
+        size_t start = position > TAIL_BLOCK ? position - TAIL_BLOCK : 0;
+        uint64_t newlines = count_newlines(data.data() + start, position - start);
+        if (newlines < remaining) {
+            remaining -= newlines;
+            position = start;
+            continue;
+        }
+
+        // That newline is in this block: walk back to it
+        const char* begin = data.data() + start;
+        const char* end = data.data() + position;
+        for (;;) {
+            const char* found = static_cast<const char*>(memrchr(begin, '\n', static_cast<size_t>(end - begin)));
+            if (--remaining == 0) {
+                lines_found = count;
+                return static_cast<uint64_t>(found - data.data()) + 1;
+            }
+            end = found;
+        }
+    }
+
+    // Ran out of data: the tail is the whole input, whose first line has no newline before it
+    lines_found = count - remaining + 1;
+    return 0;
+}
+
+FollowResult follow_file(const std::string& path, uint64_t offset, double seconds, size_t max_bytes) {
+    FollowResult result;
+    result.offset = offset;
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        result.end = FollowEnd::Error;
+        result.error = std::strerror(errno);
+        return result;
+    }
+    struct stat opened {};
+    if (fstat(fd, &opened) != 0) {
+        result.end = FollowEnd::Error;
+        result.error = std::strerror(errno);
+        close(fd);
+        return result;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(std::max(seconds, 0.0)));
+
+    // Read whatever has been appended since the last check
+    auto drain = [&]() -> bool {
+        struct stat info {};
+        if (fstat(fd, &info) != 0) {
+            result.end = FollowEnd::Error;
+            result.error = std::strerror(errno);
+            return false;
+        }
+        uint64_t size = static_cast<uint64_t>(info.st_size);
+        if (size < result.offset) {
+            result.end = FollowEnd::Truncated;
+            return false;
+        }
+        while (result.offset < size && result.data.size() < max_bytes) {
+            size_t want = static_cast<size_t>(std::min<uint64_t>(size - result.offset, max_bytes - result.data.size()));
+            size_t old_size = result.data.size();
+            result.data.resize(old_size + want);
+            ssize_t got = pread(fd, &result.data[old_size], want, static_cast<off_t>(result.offset));
+            if (got < 0 && errno == EINTR) {
+                result.data.resize(old_size);
+                continue;
+            }
+            if (got <= 0) {
+                result.data.resize(old_size);
+                if (got < 0) {
+                    result.end = FollowEnd::Error;
+                    result.error = std::strerror(errno);
+                    return false;
+                }
+                break;
+            }
+            result.data.resize(old_size + static_cast<size_t>(got));
+            result.offset += static_cast<uint64_t>(got);
+        }
+        if (result.data.size() >= max_bytes) {
+            result.end = FollowEnd::Limit;
+            return false;
+        }
+        return true;
+    };
+
+    for (;;) {
+        if (!drain()) {
+            break;
+        }
+
+        // Log rotation leaves the descriptor on the old file; stop once it is drained
+        struct stat current {};
+        if (stat(path.c_str(), &current) != 0 || current.st_dev != opened.st_dev ||
+            current.st_ino != opened.st_ino) {
+            result.end = FollowEnd::Replaced;
+            break;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            result.end = FollowEnd::Timeout;
+            break;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(FOLLOW_POLL, deadline - now));
+    }
+
+    close(fd);
+    return result;
+}
+
+} // namespace io
+} // namespace neoneo
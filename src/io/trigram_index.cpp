@@ -0,0 +1,621 @@
+#include "../../include/neoneo/io/trigram_index.hpp"
+#include "../../include/neoneo/io/walk.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace neoneo {
+namespace io {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char MAGIC[8] = "NNTRIGR";
+constexpr uint32_t VERSION = 1;
+
+// Trigram keys are 24 bits
+constexpr size_t KEY_SPACE = size_t(1) << 24;
+
+// Files larger than this are not indexed (nor searched, by default)
+constexpr uint64_t MAX_FILE_SIZE = 16 * 1024 * 1024;
+
+// Bytes checked for NUL when deciding whether a file is binary
+constexpr size_t BINARY_PROBE = 8192;
+
+// Changed files tolerated before the index is rebuilt
+constexpr size_t REBUILD_THRESHOLD = 2000;
+
+// How long the watcher sleeps between checks for stop requests
+constexpr int POLL_MS = 250;
+
+uint8_t fold(uint8_t c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<uint8_t>(c | 0x20) : c;
+}
+
+uint32_t trigram_key(const char* p) {
+    return uint32_t(fold(static_cast<uint8_t>(p[0]))) << 16 | uint32_t(fold(static_cast<uint8_t>(p[1]))) << 8 |
+           fold(static_cast<uint8_t>(p[2]));
+}
+
+int64_t mtime_of(const struct stat& info) {
+    return static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+}
+
+void put_varint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void align(std::string& out, size_t alignment) {
+    out.resize((out.size() + alignment - 1) / alignment * alignment, '\0');
+}
+
+template <typename T>
+void append_raw(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+uint64_t fnv1a(std::string_view text) {
+    uint64_t hash = 1469598103934665603ull;
+    for (char c : text) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// A file read during a build
+struct Ingested {
+    std::string relative;
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    uint32_t flags = 0;
+    std::vector<uint32_t> keys; // Distinct trigrams
+};
+
+// Per-thread build state
+struct Ingester {
+    std::vector<Ingested> files;
+    std::vector<uint64_t> seen = std::vector<uint64_t>(KEY_SPACE / 64); // Bitmap of keys in the current file
+    std::string buffer;
+
+    void ingest(const std::string& path, const std::string& relative) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info {};
+        if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+            close(fd);
+            return;
+        }
+
+        Ingested file;
+        file.relative = relative;
+        file.size = static_cast<uint64_t>(info.st_size);
+        file.mtime_ns = mtime_of(info);
+        if (file.size > MAX_FILE_SIZE) {
+            close(fd);
+            file.flags = TRIGRAM_FILE_SKIPPED;
+            files.push_back(std::move(file));
+            return;
+        }
+        buffer.resize(static_cast<size_t>(info.st_size));
+        size_t filled = 0;
+        while (filled < buffer.size()) {
+            ssize_t got = read(fd, &buffer[filled], buffer.size() - filled);
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                break;
+            }
+            filled += static_cast<size_t>(got);
+        }
+        close(fd);
+        if (std::memchr(buffer.data(), '\0', std::min(filled, BINARY_PROBE))) {
+            file.flags = TRIGRAM_FILE_SKIPPED;
+            files.push_back(std::move(file));
+            return;
+        }
+
+        for (size_t i = 0; i + 3 <= filled; ++i) {
+            uint32_t key = trigram_key(buffer.data() + i);
+            uint64_t bit = uint64_t(1) << (key & 63);
+            if (!(seen[key >> 6] & bit)) {
+                seen[key >> 6] |= bit;
+                file.keys.push_back(key);
+            }
+        }
+        for (uint32_t key : file.keys) {
+            seen[key >> 6] = 0;
+        }
+        files.push_back(std::move(file));
+    }
+};
+
+// Serialize an index; files must be sorted by path
+std::string serialize(const std::vector<Ingested>& files) {
+    // Count, then place postings in file order so every list comes out sorted.
+    // positions[key] starts as the beginning of key's range and ends up as its end.
+    std::vector<uint32_t> positions(KEY_SPACE, 0);
+    for (const auto& file : files) {
+        for (uint32_t key : file.keys) {
+            ++positions[key];
+        }
+    }
+    uint32_t total = 0;
+    for (size_t key = 0; key < KEY_SPACE; ++key) {
+        uint32_t count = positions[key];
+        positions[key] = total;
+        total += count;
+    }
+    std::vector<uint32_t> postings(total);
+    for (uint32_t id = 0; id < files.size(); ++id) {
+        for (uint32_t key : files[id].keys) {
+            postings[positions[key]++] = id;
+        }
+    }
+
+    std::string out;
+    TrigramIndexHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.file_count = static_cast<uint32_t>(files.size());
+    append_raw(out, header);
+
+    header.files_offset = out.size();
+    uint64_t name_offset = 0;
+    for (const auto& file : files) {
+        TrigramIndexFile entry{name_offset, static_cast<uint32_t>(file.relative.size()), file.flags, file.size,
+                               file.mtime_ns};
+        append_raw(out, entry);
+        name_offset += file.relative.size();
+    }
+    header.names_offset = out.size();
+    for (const auto& file : files) {
+        out += file.relative;
+    }
+    align(out, 8);
+
+    header.trigrams_offset = out.size();
+    std::string encoded;
+    for (size_t key = 0; key < KEY_SPACE; ++key) {
+        uint32_t begin = key == 0 ? 0 : positions[key - 1];
+        uint32_t end = positions[key];
+        if (begin == end) {
+            continue;
+        }
+        TrigramIndexEntry entry{static_cast<uint32_t>(key), end - begin, encoded.size()};
+        append_raw(out, entry);
+        ++header.trigram_count;
+        uint32_t previous = 0;
+        for (uint32_t i = begin; i < end; ++i) {
+            put_varint(encoded, postings[i] - previous);
+            previous = postings[i];
+        }
+    }
+    header.postings_offset = out.size();
+    out += encoded;
+    header.total_size = out.size();
+    std::memcpy(&out[0], &header, sizeof(header));
+    return out;
+}
+
+} // namespace
+
+std::string TrigramIndex::Snapshot::path_of(uint32_t id) const {
+    const TrigramIndexFile& file = files[id];
+    return std::string(this->file->data() + header->names_offset + file.name_offset, file.name_length);
+}
+
+const TrigramIndexEntry* TrigramIndex::Snapshot::find(uint32_t key) const {
+    const TrigramIndexEntry* end = entries + header->trigram_count;
+    const TrigramIndexEntry* it = std::lower_bound(
+        entries, end, key, [](const TrigramIndexEntry& entry, uint32_t value) { return entry.key < value; });
+    return it != end && it->key == key ? it : nullptr;
+}
+
+void TrigramIndex::Snapshot::decode(const TrigramIndexEntry& entry, std::vector<uint32_t>& ids) const {
+    ids.clear();
+    ids.reserve(entry.count);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(file->data() + header->postings_offset + entry.offset);
+    uint32_t id = 0;
+    for (uint32_t i = 0; i < entry.count; ++i) {
+        uint32_t delta = 0;
+        int shift = 0;
+        while (*p & 0x80) {
+            delta |= uint32_t(*p++ & 0x7f) << shift;
+            shift += 7;
+        }
+        delta |= uint32_t(*p++) << shift;
+        id += delta;
+        ids.push_back(id);
+    }
+}
+
+TrigramIndex::TrigramIndex(std::string root, std::string index_path)
+    : root(std::move(root)), index_path(std::move(index_path)) {}
+
+TrigramIndex::~TrigramIndex() {
+    stopping = true;
+    if (worker.joinable()) {
+        worker.join();
+    }
+    if (inotify_fd >= 0) {
+        close(inotify_fd);
+    }
+}
+
+void TrigramIndex::start() {
+    if (!worker.joinable()) {
+        worker = std::thread(&TrigramIndex::run, this);
+    }
+}
+
+std::string TrigramIndex::default_index_path(const std::string& root) {
+    std::string cache;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        cache = xdg;
+    } else if (const char* home = std::getenv("HOME")) {
+        cache = std::string(home) + "/.cache";
+    } else {
+        cache = fs::temp_directory_path().string();
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.trigrams", static_cast<unsigned long long>(fnv1a(root)));
+    return cache + "/neoneo/index/" + name;
+}
+
+std::shared_ptr<const TrigramIndex::Snapshot> TrigramIndex::load(const std::string& path) {
+    std::string error;
+    auto file = MappedFile::open(path, error);
+    if (!file || file->size() < sizeof(TrigramIndexHeader)) {
+        return nullptr;
+    }
+    const auto* header = reinterpret_cast<const TrigramIndexHeader*>(file->data());
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+        header->total_size != file->size() || header->postings_offset > file->size() ||
+        header->files_offset + uint64_t(header->file_count) * sizeof(TrigramIndexFile) > header->names_offset ||
+        header->trigrams_offset + header->trigram_count * sizeof(TrigramIndexEntry) > header->postings_offset) {
+        return nullptr;
+    }
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->header = header;
+    snapshot->files = reinterpret_cast<const TrigramIndexFile*>(file->data() + header->files_offset);
+    snapshot->entries = reinterpret_cast<const TrigramIndexEntry*>(file->data() + header->trigrams_offset);
+    snapshot->file = std::move(file);
+    return snapshot;
+}
+
+void TrigramIndex::run() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        status = "loading";
+    }
+    load_ignores(root, ignore_prefix);
+    // A saved index only needs the files that changed since it was written
+    auto saved = load(index_path);
+    if (saved) {
+        std::lock_guard<std::mutex> lock(mutex);
+        snapshot = saved;
+    }
+    bool structure_changed = !rebuild(saved != nullptr);
+
+    while (!stopping) {
+        if (structure_changed) {
+            structure_changed = !rebuild(false);
+            continue;
+        }
+
+        pollfd poller{inotify_fd, POLLIN, 0};
+        if (inotify_fd < 0 || poll(&poller, 1, POLL_MS) <= 0) {
+            if (inotify_fd < 0) {
+                usleep(POLL_MS * 1000);
+            }
+            continue;
+        }
+        read_events();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        structure_changed = (stale && inotify_fd >= 0 && status == "ready") || changed.size() > REBUILD_THRESHOLD;
+    }
+}
+
+bool TrigramIndex::rebuild(bool reuse_existing) {
+    std::shared_ptr<const Snapshot> previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        previous = reuse_existing ? snapshot : nullptr;
+        status = previous ? "checking for changes" : "building";
+    }
+
+    // Watches go in before a directory is read, so no change can slip between the two
+    int new_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    std::map<int, WatchedDirectory> new_watches;
+    std::mutex watch_mutex;
+    bool watch_failed = new_fd < 0;
+
+    size_t threads = default_walk_threads();
+    std::vector<Ingester> ingesters(previous ? 0 : threads);
+    std::vector<std::vector<std::string>> modified(threads);
+    std::vector<char> present(previous ? previous->header->file_count : 0, 0);
+
+    WalkVisitor visitor;
+    visitor.should_stop = [&]() { return stopping.load(); };
+    visitor.directory = [&](const std::string& path, const std::string& relative,
+                            const std::shared_ptr<const IgnoreList>& ignores) {
+        if (new_fd < 0) {
+            return;
+        }
+        int wd = inotify_add_watch(new_fd, path.c_str(),
+                                   IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM |
+                                       IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+        std::lock_guard<std::mutex> lock(watch_mutex);
+        if (wd < 0) {
+            watch_failed = true; // Usually fs.inotify.max_user_watches
+        } else {
+            new_watches[wd] = WatchedDirectory{relative, ignores};
+        }
+    };
+    visitor.file = [&](const std::string& path, const std::string& relative, size_t worker) {
+        if (!previous) {
+            ingesters[worker].ingest(path, relative);
+            return;
+        }
+        // Compare with the saved entry, which the table keeps sorted by path
+        const TrigramIndexFile* begin = previous->files;
+        const TrigramIndexFile* end = begin + previous->header->file_count;
+        const char* names = previous->file->data() + previous->header->names_offset;
+        auto name_of = [&](const TrigramIndexFile& file) {
+            return std::string_view(names + file.name_offset, file.name_length);
+        };
+        const TrigramIndexFile* it = std::lower_bound(begin, end, relative, [&](const TrigramIndexFile& file,
+                                                                                const std::string& value) {
+            return name_of(file) < value;
+        });
+        struct stat info {};
+        bool exists = stat(path.c_str(), &info) == 0;
+        if (it != end && name_of(*it) == relative) {
+            present[static_cast<size_t>(it - begin)] = 1;
+            if (exists && static_cast<uint64_t>(info.st_size) == it->size && mtime_of(info) == it->mtime_ns) {
+                return;
+            }
+        }
+        modified[worker].push_back(relative);
+    };
+
+    walk_tree(root, threads, visitor);
+    if (stopping) {
+        if (new_fd >= 0) {
+            close(new_fd);
+        }
+        return true;
+    }
+
+    std::unordered_map<std::string, bool> new_changed;
+    std::shared_ptr<const Snapshot> next;
+    if (previous) {
+        for (auto& list : modified) {
+            for (auto& relative : list) {
+                new_changed[relative] = false;
+            }
+        }
+        for (uint32_t id = 0; id < present.size(); ++id) {
+            if (!present[id]) {
+                new_changed[previous->path_of(id)] = true;
+            }
+        }
+        if (new_changed.size() > REBUILD_THRESHOLD) {
+            close(new_fd);
+            return rebuild(false);
+        }
+        next = previous;
+    } else {
+        std::vector<Ingested> files;
+        for (auto& ingester : ingesters) {
+            for (auto& file : ingester.files) {
+                files.push_back(std::move(file));
+            }
+        }
+        ingesters.clear();
+        std::sort(files.begin(), files.end(),
+                  [](const Ingested& a, const Ingested& b) { return a.relative < b.relative; });
+        std::string data = serialize(files);
+        files.clear();
+
+        // Written aside and renamed, so a crash never leaves a torn index
+        std::error_code ec;
+        fs::create_directories(fs::path(index_path).parent_path(), ec);
+        std::string temporary = index_path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+        if (std::rename(temporary.c_str(), index_path.c_str()) == 0) {
+            next = load(index_path);
+        }
+        if (!next) {
+            std::lock_guard<std::mutex> lock(mutex);
+            status = "could not write " + index_path;
+            stale = true;
+            if (new_fd >= 0) {
+                close(new_fd);
+            }
+            return true;
+        }
+    }
+
+    if (inotify_fd >= 0) {
+        close(inotify_fd);
+    }
+    inotify_fd = new_fd;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    watches = std::move(new_watches);
+    snapshot = next;
+    changed = std::move(new_changed);
+    stale = watch_failed;
+    status = watch_failed ? "not watching (inotify watch limit reached); searches scan the tree" : "ready";
+    return true;
+}
+
+void TrigramIndex::read_events() {
+    alignas(inotify_event) char buffer[64 * 1024];
+    for (;;) {
+        ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                stale = true; // Events were lost
+                continue;
+            }
+            auto watch = watches.find(event->wd);
+            if (watch == watches.end()) {
+                continue;
+            }
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                stale = true;
+                continue;
+            }
+            if (event->len == 0) {
+                continue;
+            }
+
+            std::string name = event->name;
+            if (name == ".gitignore") {
+                stale = true; // Which files belong in the index may have changed
+                continue;
+            }
+            if (name[0] == '.') {
+                continue;
+            }
+            std::string relative = watch->second.relative + name;
+            bool is_directory = event->mask & IN_ISDIR;
+            const auto& ignores = watch->second.ignores;
+            if (ignores && ignores->is_ignored(ignore_prefix + relative, is_directory)) {
+                continue;
+            }
+            if (is_directory) {
+                if (event->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)) {
+                    stale = true;
+                }
+                continue;
+            }
+            changed[relative] = (event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0;
+        }
+    }
+}
+
+std::optional<std::vector<std::string>> TrigramIndex::candidates(const std::string& literal,
+                                                                 const std::string& directory) const {
+    if (literal.size() < 3) {
+        return std::nullopt;
+    }
+
+    std::shared_ptr<const Snapshot> current;
+    std::unordered_map<std::string, bool> overlay;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stale || !snapshot || status != "ready") {
+            return std::nullopt;
+        }
+        // Hidden and ignored directories are not indexed, but may still be searched explicitly
+        bool indexed = std::any_of(watches.begin(), watches.end(), [&](const auto& watch) {
+            return watch.second.relative == directory;
+        });
+        if (!indexed) {
+            return std::nullopt;
+        }
+        current = snapshot;
+        overlay = changed;
+    }
+    auto below = [&](const std::string& path) { return path.compare(0, directory.size(), directory) == 0; };
+
+    std::vector<uint32_t> keys;
+    for (size_t i = 0; i + 3 <= literal.size(); ++i) {
+        keys.push_back(trigram_key(literal.data() + i));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    // Intersect the posting lists, shortest first
+    std::vector<const TrigramIndexEntry*> lists;
+    bool missing = false;
+    for (uint32_t key : keys) {
+        const TrigramIndexEntry* entry = current->find(key);
+        if (!entry) {
+            missing = true;
+            break;
+        }
+        lists.push_back(entry);
+    }
+
+    std::vector<uint32_t> ids;
+    if (!missing) {
+        std::sort(lists.begin(), lists.end(),
+                  [](const TrigramIndexEntry* a, const TrigramIndexEntry* b) { return a->count < b->count; });
+        current->decode(*lists[0], ids);
+        std::vector<uint32_t> other;
+        std::vector<uint32_t> common;
+        for (size_t i = 1; i < lists.size() && !ids.empty(); ++i) {
+            current->decode(*lists[i], other);
+            common.clear();
+            std::set_intersection(ids.begin(), ids.end(), other.begin(), other.end(), std::back_inserter(common));
+            ids.swap(common);
+        }
+    }
+
+    std::vector<std::string> paths;
+    paths.reserve(ids.size() + overlay.size());
+    for (uint32_t id : ids) {
+        std::string path = current->path_of(id);
+        if (below(path) && overlay.find(path) == overlay.end()) {
+            paths.push_back(path.substr(directory.size()));
+        }
+    }
+    // Changed files are always searched, as long as they are still regular files
+    for (const auto& [relative, deleted] : overlay) {
+        struct stat info {};
+        if (!deleted && below(relative) && lstat(child_path(root, relative).c_str(), &info) == 0 &&
+            S_ISREG(info.st_mode)) {
+            paths.push_back(relative.substr(directory.size()));
+        }
+    }
+    return paths;
+}
+
+std::string TrigramIndex::describe() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string text = "search index of " + root + ": " + status;
+    if (snapshot) {
+        text += " (" + std::to_string(snapshot->header->file_count) + " files, " +
+                std::to_string(changed.size()) + " changed since indexing)";
+    }
+    return text;
+}
+
+} // namespace io
+} // namespace neoneo
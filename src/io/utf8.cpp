@@ -0,0 +1,181 @@
+#include "../../include/neoneo/io/utf8.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace neoneo {
+namespace io {
+
+namespace {
+
+// First byte at or after pos with the high bit set, or size
+size_t skip_ascii(const unsigned char* data, size_t pos, size_t size) {
+#if defined(__SSE2__)
+    while (pos + 32 <= size) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 16));
+        if (_mm_movemask_epi8(_mm_or_si128(a, b)) != 0) {
+            break;
+        }
+        pos += 32;
+    }
+    while (pos + 16 <= size) {
+        int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos)));
+        if (mask != 0) {
+            return pos + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+        pos += 16;
+    }
+#endif
+    while (pos < size && data[pos] < 0x80) {
+        ++pos;
+    }
+    return pos;
+}
+
+// Checks the non-ASCII sequence at data[pos]. Returns its length if it is
+// well formed; otherwise sets valid to false and returns the length of the
+// maximal subpart that could have started a sequence (at least 1).
+size_t check_sequence(const unsigned char* data, size_t pos, size_t size, bool& valid) {
+    unsigned char lead = data[pos];
+    size_t length = 0;
+    unsigned char low = 0x80; // Range of the second byte; the rest are always 80..BF
+    unsigned char high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        low = lead == 0xE0 ? 0xA0 : 0x80; // No overlong forms
+        high = lead == 0xED ? 0x9F : 0xBF; // No surrogates
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF; // Nothing past U+10FFFF
+    } else {
+        valid = false;
+        return 1;
+    }
+
+    size_t i = 1;
+    if (pos + i < size && data[pos + i] >= low && data[pos + i] <= high) {
+        for (++i; i < length && pos + i < size && (data[pos + i] & 0xC0) == 0x80; ++i) {
+        }
+    }
+    valid = i == length;
+    return i;
+}
+
+} // namespace
+
+size_t valid_utf8_prefix(std::string_view text) {
+    const auto* data = reinterpret_cast<const unsigned char*>(text.data());
+    size_t size = text.size();
+    size_t pos = 0;
+    while (true) {
+        pos = skip_ascii(data, pos, size);
+        // Check sequences one by one until the text is back to ASCII
+        while (pos < size && data[pos] >= 0x80) {
+            // Most non-ASCII text is two-byte Latin, Greek or Cyrillic and three-byte CJK
+            unsigned char lead = data[pos];
+            if (lead >= 0xC2 && lead <= 0xDF && pos + 1 < size && (data[pos + 1] & 0xC0) == 0x80) {
+                pos += 2;
+                continue;
+            }
+            if (lead >= 0xE1 && lead <= 0xEF && lead != 0xED && pos + 2 < size && (data[pos + 1] & 0xC0) == 0x80 &&
+                (data[pos + 2] & 0xC0) == 0x80) {
+                pos += 3;
+                continue;
+            }
+            bool valid = true;
+            size_t length = check_sequence(data, pos, size, valid);
+            if (!valid) {
+                return pos;
+            }
+            pos += length;
+        }
+        if (pos >= size) {
+            return size;
+        }
+    }
+}
+
+size_t sanitize_utf8(std::string& text, Utf8Repair repair) {
+    size_t pos = valid_utf8_prefix(text);
+    if (pos == text.size()) {
+        return 0;
+    }
+
+    static const char HEX[] = "0123456789ABCDEF";
+    const auto* data = reinterpret_cast<const unsigned char*>(text.data());
+    std::string out;
+    out.reserve(text.size() + text.size() / 8);
+    out.append(text, 0, pos);
+    size_t repaired = 0;
+    while (pos < text.size()) {
+        bool valid = true;
+        size_t length = check_sequence(data, pos, text.size(), valid);
+        if (repair == Utf8Repair::Replace) {
+            out += "\xEF\xBF\xBD";
+        } else {
+            for (size_t i = 0; i < length; ++i) {
+                unsigned char c = data[pos + i];
+                out += "\\x";
+                out += HEX[c >> 4];
+                out += HEX[c & 0x0F];
+            }
+        }
+        ++repaired;
+        pos += length;
+
+        size_t valid_end = pos + valid_utf8_prefix(std::string_view(text).substr(pos));
+        out.append(text, pos, valid_end - pos);
+        pos = valid_end;
+    }
+    text = std::move(out);
+    return repaired;
+}
+
+bool looks_binary(std::string_view data, size_t probe) {
+    std::string_view sample = data.substr(0, probe);
+    if (sample.find('\0') != std::string_view::npos) {
+        return true;
+    }
+
+    // Control characters weigh double: text in a legacy encoding has invalid
+    // bytes but hardly any controls, while binary data has plenty of both
+    const auto* bytes = reinterpret_cast<const unsigned char*>(sample.data());
+    size_t odd = 0;
+    for (size_t pos = 0; pos < sample.size();) {
+        unsigned char c = bytes[pos];
+        if (c >= 0x80) {
+            bool valid = true;
+            size_t length = check_sequence(bytes, pos, sample.size(), valid);
+            // A sequence cut off by the end of the sample is not held against it
+            if (!valid && pos + length < sample.size()) {
+                odd += length;
+            }
+            pos += length;
+            continue;
+        }
+        if ((c < 0x20 && c != '\t' && c != '\n' && c != '\r' && c != '\f' && c != '\v' && c != '\b' && c != 0x1b) ||
+            c == 0x7f) {
+            odd += 2;
+        }
+        ++pos;
+    }
+    return odd * 10 > sample.size() * 3;
+}
+
+size_t utf8_boundary(std::string_view text, size_t pos) {
+    // A sequence is at most four bytes, so never step back further than three
+    size_t limit = pos > 3 ? pos - 3 : 0;
+    size_t start = pos;
+    while (start > limit && start < text.size() && (static_cast<unsigned char>(text[start]) & 0xC0) == 0x80) {
+        --start;
+    }
+    return start < text.size() && (static_cast<unsigned char>(text[start]) & 0xC0) == 0x80 ? pos : start;
+}
+
+} // namespace io
+} // namespace neoneo
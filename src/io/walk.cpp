@@ -0,0 +1,125 @@
+#include "../../include/neoneo/io/walk.hpp"
+#include "../../include/neoneo/io/work_stealing.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace neoneo {
+namespace io {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Task {
+    std::string path;     // As reported to the visitor
+    std::string relative; // Below the walk root; directories end in '/'
+    std::shared_ptr<const IgnoreList> ignores;
+    bool directory = false;
+};
+
+} // namespace
+
+std::shared_ptr<const IgnoreList> load_ignores(const std::string& directory, std::string& prefix) {
+    prefix.clear();
+    std::error_code ec;
+    fs::path start = fs::absolute(directory, ec).lexically_normal();
+    if (!start.has_filename() && start.has_parent_path()) {
+        start = start.parent_path(); // Drop a trailing separator
+    }
+
+    fs::path top = start;
+    while (!fs::exists(top / ".git", ec) && top.has_parent_path() && top.parent_path() != top) {
+        top = top.parent_path();
+    }
+    if (!fs::exists(top / ".git", ec)) {
+        top = start;
+    }
+
+    fs::path current = top;
+    std::shared_ptr<const IgnoreList> ignores = IgnoreList::load(current.string(), prefix, nullptr);
+    for (const auto& part : start.lexically_relative(top)) {
+        if (part == "." || part.empty()) {
+            continue;
+        }
+        current /= part;
+        prefix += part.string() + "/";
+        ignores = IgnoreList::load(current.string(), prefix, ignores);
+    }
+    return ignores;
+}
+
+size_t default_walk_threads() {
+    return std::min<size_t>(std::max<size_t>(std::thread::hardware_concurrency(), 1), 16);
+}
+
+std::string child_path(const std::string& parent, const std::string& name) {
+    return parent == "." ? name : parent.back() == '/' ? parent + name : parent + "/" + name;
+}
+
+void walk_tree(const std::string& root, size_t threads, const WalkVisitor& visitor) {
+    std::string prefix;
+    auto root_ignores = load_ignores(root, prefix);
+
+    WorkStealingPool<Task> pool(std::max<size_t>(threads, 1));
+    std::vector<Task> initial;
+    initial.push_back(Task{root, "", root_ignores, true});
+
+    pool.run(std::move(initial), [&](Task& task, size_t worker) {
+        if (!task.directory) {
+            visitor.file(task.path, task.relative, worker);
+        } else if (DIR* dir = opendir(task.path.c_str())) {
+            auto ignores = task.relative.empty()
+                               ? task.ignores
+                               : IgnoreList::load(task.path, prefix + task.relative, task.ignores);
+            if (visitor.directory) {
+                visitor.directory(task.path, task.relative, ignores);
+            }
+
+            while (dirent* entry = readdir(dir)) {
+                const char* name = entry->d_name;
+                // Hidden entries, which includes . .. and .git
+                if (name[0] == '.') {
+                    continue;
+                }
+
+                bool is_directory = entry->d_type == DT_DIR;
+                bool is_file = entry->d_type == DT_REG;
+                if (entry->d_type == DT_UNKNOWN) {
+                    struct stat info {};
+                    if (lstat(child_path(task.path, name).c_str(), &info) != 0) {
+                        continue;
+                    }
+                    is_directory = S_ISDIR(info.st_mode);
+                    is_file = S_ISREG(info.st_mode);
+                }
+                // Symlinks and special files are not followed
+                if (!is_directory && !is_file) {
+                    continue;
+                }
+
+                std::string relative = task.relative + name;
+                if (ignores && ignores->is_ignored(prefix + relative, is_directory)) {
+                    continue;
+                }
+                if (is_directory) {
+                    pool.push(worker, Task{child_path(task.path, name), relative + "/", ignores, true});
+                } else if (!visitor.accept || visitor.accept(relative, name)) {
+                    pool.push(worker, Task{child_path(task.path, name), std::move(relative), nullptr, false});
+                }
+            }
+            closedir(dir);
+        }
+
+        if (visitor.should_stop && visitor.should_stop()) {
+            pool.stop();
+        }
+    });
+}
+
+} // namespace io
+} // namespace neoneo
@@ -6,6 +6,7 @@
 #include <csignal>
 #include <fstream>
 #include <sstream>
+#include <unistd.h>
 #include <readline/readline.h>
 #include <readline/history.h>
 #include <nlohmann/json.hpp>
@@ -13,6 +14,7 @@
 #include "../include/neoneo/config/config.hpp"
 #include "../include/neoneo/terminal/terminal.hpp"
 #include "../include/neoneo/tools/tools.hpp"
+#include "../include/neoneo/conversation/tool_output_aging.hpp"
 
 using namespace neoneo;
 using json = nlohmann::json;
@@ -38,12 +40,19 @@ void print_usage() {
               << "  -t, --tools         Enable tool use with the model\n"
               << "  -d, --debug         Enable debug mode for detailed output\n"
               << "  -f, --file-ops      Enable file operations (read, write, edit)\n"
+              << "  --search-index      Keep a background trigram index of the working directory to speed up search\n"
               << "  -s, --shell         Enable shell command execution tool (use with caution)\n"
               << "  --auto-confirm      Automatically confirm shell commands without prompting\n"
               << "  --auto-confirm-files  Automatically confirm file operations without prompting\n"
-              << "  --ignore-calc-safety Ignore calculator safety checks for potentially dangerous patterns\n"
+              << "  --ignore-calc-safety Raise the calculator's precision and result size limits\n"
               << "  --ignore-shell-safety Ignore shell command safety checks for potentially dangerous operations\n"
+              << "  --block-command RULE  Also confirm shell commands matching RULE, e.g. \"git push --force|-f\" (repeatable)\n"
               << "  --model-list        Enable model listing tool for the LLM\n"
+              << "  --tool-output-age N Replace tool outputs older than N turns with a stub (0 = never, default: 3)\n"
+              << "  --tool-output-max-bytes N  Stub tool outputs larger than N bytes after one turn (0 = never, default: 16384)\n"
+              << "  --raw-tool-output   Pass command output to the model as is, without stripping escapes or collapsing repeated lines\n"
+              << "  --memoize-tools     Answer repeated calculator, statistics, model list and read-only commands (git status, ls, cat)\n"
+              << "                      from the earlier result while nothing they depend on has changed\n"
               << "  --host URL          Specify Ollama host URL (default: http://localhost:11434)\n"
               << "  --config FILE       Use specified config file (default: ~/.config/neoneo/config.json)\n"
               << "  --save-config       Save current settings to config file\n"
@@ -110,10 +119,47 @@ int main(int argc, char* argv[]) {
             config.set_calc_safety_ignored(true);
         } else if (arg == "--ignore-shell-safety") {
             config.set_shell_safety_ignored(true);
+        } else if (arg == "--block-command") {
+            if (i + 1 < argc) {
+                config.add_shell_policy_rule(argv[++i]);
+            } else {
+                terminal::print("Error: --block-command requires a rule.", terminal::MessageType::ERROR);
+                return 1;
+            }
         } else if (arg == "--model-list") {
             config.set_model_list_enabled(true);
+        } else if (arg == "--tool-output-age") {
+            if (i + 1 < argc) {
+                try {
+                    config.set_tool_output_max_age(std::stoi(argv[++i]));
+                } catch (const std::exception&) {
+                    terminal::print("Error: --tool-output-age requires a number of turns.", terminal::MessageType::ERROR);
+                    return 1;
+                }
+            } else {
+                terminal::print("Error: --tool-output-age requires a number of turns.", terminal::MessageType::ERROR);
+                return 1;
+            }
+        } else if (arg == "--tool-output-max-bytes") {
+            if (i + 1 < argc) {
+                try {
+                    config.set_tool_output_max_bytes(std::stoul(argv[++i]));
+                } catch (const std::exception&) {
+                    terminal::print("Error: --tool-output-max-bytes requires a byte count.", terminal::MessageType::ERROR);
+                    return 1;
+                }
+            } else {
+                terminal::print("Error: --tool-output-max-bytes requires a byte count.", terminal::MessageType::ERROR);
+                return 1;
+            }
+        } else if (arg == "--memoize-tools") {
+            config.set_tool_memo_enabled(true);
+        } else if (arg == "--raw-tool-output") {
+            config.set_tool_output_reduced(false);
         } else if (arg == "--file-ops" || arg == "-f") {
             config.set_file_ops_enabled(true);
+        } else if (arg == "--search-index") {
+            config.set_search_index_enabled(true);
         } else if (arg == "--host") {
             if (i + 1 < argc) {
                 config.set_host(argv[++i]);
@@ -199,12 +245,15 @@ int main(int argc, char* argv[]) {
     // Initialize tool manager
     tools::ToolManager tool_manager(config);
     
+    // Commands show their output while they run, unless it is going somewhere other than a terminal
+    tool_manager.set_live_output(isatty(STDOUT_FILENO));
+    
     // Register all available tools based on configuration
     if (config.is_tools_enabled()) {
         tool_manager.register_default_tools();
         
-        // Get tool definitions and print tool count
-        auto tool_definitions = tool_manager.get_tool_definitions();
+        // Compile tool definitions once and print tool count
+        auto tool_definitions = tool_manager.get_compiled_tool_definitions();
         
         // Show warnings for potentially dangerous tools
         if (config.is_shell_enabled()) {
@@ -215,7 +264,7 @@ int main(int argc, char* argv[]) {
             terminal::print("WARNING: Auto-confirmation for file operations is enabled.", terminal::MessageType::WARNING);
         }
         
-        terminal::print("Tool usage enabled with " + std::to_string(tool_definitions.size()) + " available tools.", terminal::MessageType::SUCCESS);
+        terminal::print("Tool usage enabled with " + std::to_string(tool_definitions->count) + " available tools.", terminal::MessageType::SUCCESS);
     }
     
     // Start chat session
@@ -244,6 +293,12 @@ int main(int argc, char* argv[]) {
     
     conversation.push_back(ChatMessage("system", system_prompt));
     
+    // Stubs out stale tool outputs so they are not re-evaluated on every turn
+    conversation::AgingPolicy aging_policy;
+    aging_policy.max_age_turns = config.get_tool_output_max_age();
+    aging_policy.max_bytes = config.get_tool_output_max_bytes();
+    conversation::ToolOutputAging output_aging(aging_policy);
+    
     while (running) {
         // Display prompt and get user input
         char prompt_buffer[20];
@@ -274,6 +329,8 @@ int main(int argc, char* argv[]) {
             // Clear conversation but preserve the system prompt
             conversation.clear();
             conversation.push_back(ChatMessage("system", system_prompt));
+            output_aging.reset();
+            tool_manager.reset_tools();
             terminal::print("Conversation reset.", terminal::MessageType::SUCCESS);
             continue;
         } else if (input == "/tools") {
@@ -310,6 +367,8 @@ int main(int argc, char* argv[]) {
             terminal::print("  /template      - Show the conversation template being sent to the LLM", terminal::MessageType::NORMAL);
             terminal::print("  /prompt        - Show the current system prompt", terminal::MessageType::NORMAL);
             terminal::print("  /setprompt     - Set a new system prompt", terminal::MessageType::NORMAL);
+            terminal::print("  /output ID     - Show the full text of an aged-out tool output", terminal::MessageType::NORMAL);
+            terminal::print("  /jobs          - List background jobs started by the tools", terminal::MessageType::NORMAL);
             if (config.is_tools_enabled()) {
                 terminal::print("  /tools         - List available tools", terminal::MessageType::TOOL);
             }
@@ -337,8 +396,16 @@ int main(int argc, char* argv[]) {
             terminal::print("  Model list tool: " + std::string(config.is_model_list_enabled() ? "Yes" : "No"), terminal::MessageType::NORMAL);
             terminal::print("  File ops enabled:" + std::string(config.is_file_ops_enabled() ? "Yes" : "No"), fileOpsType);
             terminal::print("  Auto-confirm files: " + std::string(config.is_auto_confirm_file_ops() ? "Yes" : "No"), autoFilesType);
+            terminal::print("  Search index:    " + std::string(config.is_search_index_enabled() ? "Yes" : "No"), terminal::MessageType::NORMAL);
             terminal::print("  Ignore calc safety: " + std::string(config.is_calc_safety_ignored() ? "Yes" : "No"), ignoreCalcType);
             terminal::print("  Ignore shell safety: " + std::string(config.is_shell_safety_ignored() ? "Yes" : "No"), ignoreShellType);
+            for (const auto& rule : config.get_shell_policy_rules()) {
+                terminal::print("  Blocked command: " + rule, terminal::MessageType::NORMAL);
+            }
+            terminal::print("  Tool output age: " + std::to_string(config.get_tool_output_max_age()) + " turns", terminal::MessageType::NORMAL);
+            terminal::print("  Tool output max: " + std::to_string(config.get_tool_output_max_bytes()) + " bytes", terminal::MessageType::NORMAL);
+            terminal::print("  Reduce tool output: " + std::string(config.is_tool_output_reduced() ? "Yes" : "No"), terminal::MessageType::NORMAL);
+            terminal::print("  Memoize tools:   " + std::string(config.is_tool_memo_enabled() ? "Yes" : "No"), terminal::MessageType::NORMAL);
             
             if (!config.get_config_file_path().empty()) {
                 terminal::print("  Config file:     " + config.get_config_file_path(), terminal::MessageType::NORMAL);
@@ -484,6 +551,47 @@ int main(int argc, char* argv[]) {
                 }
             }
             
+            continue;
+        } else if (input.rfind("/output", 0) == 0) {
+            // Show the full text behind an aged-out tool output stub
+            size_t id = 0;
+            try {
+                id = std::stoul(input.substr(7));
+            } catch (const std::exception&) {
+                terminal::print("Usage: /output ID", terminal::MessageType::WARNING);
+                continue;
+            }
+            
+            const conversation::ArchivedOutput* output = output_aging.find(id);
+            if (!output) {
+                terminal::print("No tool output with ID " + std::to_string(id) + ".", terminal::MessageType::WARNING);
+                continue;
+            }
+            
+            if (output->evicted) {
+                terminal::print("Tool output #" + std::to_string(id) + " (" + std::to_string(output->size) +
+                                    " bytes) was dropped from the local archive to keep it within " +
+                                    std::to_string(aging_policy.archive_bytes / (1024 * 1024)) +
+                                    " MB; only its stub remains.",
+                                terminal::MessageType::WARNING);
+                continue;
+            }
+            
+            terminal::print("Tool output #" + std::to_string(output->id) + " from '" + output->tool_name +
+                            "' (turn " + std::to_string(output->turn) + ", " +
+                            std::to_string(output->size) + " bytes):", terminal::MessageType::HEADER);
+            terminal::print(output->content, terminal::MessageType::TOOL);
+            continue;
+        } else if (input == "/jobs") {
+            auto jobs = tool_manager.get_jobs().list();
+            if (jobs.empty()) {
+                terminal::print("No background jobs.", terminal::MessageType::SYSTEM);
+            }
+            for (const auto& job : jobs) {
+                terminal::print("Job " + std::to_string(job.id) + ": " + job.describe(),
+                                job.running ? terminal::MessageType::TOOL : terminal::MessageType::NORMAL);
+                terminal::print("  " + job.command, terminal::MessageType::NORMAL);
+            }
             continue;
         } else if (input.empty()) {
             continue;
@@ -492,6 +600,14 @@ int main(int argc, char* argv[]) {
         // Add user message to conversation
         conversation.push_back(ChatMessage("user", input));
         
+        // Age out stale tool outputs before the conversation is sent again
+        output_aging.begin_turn();
+        tool_manager.set_turn(output_aging.current_turn());
+        size_t aged_bytes = output_aging.apply(conversation);
+        if (aged_bytes > 0 && config.is_debug_mode()) {
+            terminal::print("Aged out " + std::to_string(aged_bytes) + " bytes of stale tool output.", terminal::MessageType::SYSTEM);
+        }
+        
         // Send to Ollama and get response
         std::cout << std::endl;
         
@@ -499,10 +615,11 @@ int main(int argc, char* argv[]) {
         bool using_tools = config.is_tools_enabled();
         bool streaming_enabled = true; // User preference flag (could be added to config)
         
-        // Get tool definitions if tools are enabled
-        auto tool_definitions = using_tools ? 
-                              tool_manager.get_tool_definitions() : 
-                              std::vector<nlohmann::json>{};
+        // Pre-serialized tool definitions, only rebuilt when the tool set changes
+        auto tool_blob = using_tools ? 
+                         tool_manager.get_compiled_tool_definitions() : 
+                         std::make_shared<const ToolDefinitionBlob>();
+        const ToolDefinitionBlob& tool_definitions = *tool_blob;
         
         // Create a response object to hold the result
         ChatMessage response("assistant", "");
@@ -567,8 +684,16 @@ int main(int argc, char* argv[]) {
                 
                 // Display result
                 if (result.is_success) {
-                    terminal::print("Tool result:", terminal::MessageType::SUCCESS);
-                    terminal::print(result.content, terminal::MessageType::TOOL);
+                    terminal::print(result.memoized ? "Tool result (same call as before with nothing changed; not run again):"
+                                                    : "Tool result:", terminal::MessageType::SUCCESS);
+                    terminal::print(result.display.empty() ? result.content : result.display, terminal::MessageType::TOOL);
+                    if (result.original_bytes > result.content.size()) {
+                        size_t saved = result.original_bytes - result.content.size();
+                        terminal::print("Tool output reduced from " + std::to_string(result.original_bytes) + " to " +
+                                        std::to_string(result.content.size()) + " bytes (" +
+                                        std::to_string(saved * 100 / result.original_bytes) + "% saved)",
+                                        terminal::MessageType::SYSTEM);
+                    }
                 } else {
                     terminal::print("Tool error:", terminal::MessageType::ERROR);
                     terminal::print(result.error_message, terminal::MessageType::ERROR);
@@ -579,6 +704,7 @@ int main(int argc, char* argv[]) {
                     result.is_success ? result.content : result.error_message, 
                     tool_call.name
                 ));
+                output_aging.track(conversation.back());
             }
             
             // Get the final response after tool execution
@@ -93,6 +93,61 @@ static std::vector<ToolCall> parse_tool_calls(const json& message_json) {
     return tool_calls;
 }
 
+// Convert conversation messages to the JSON array expected by /api/chat
+static json messages_to_json(const std::vector<ChatMessage>& messages) {
+    json j_messages = json::array();
+    for (const auto& msg : messages) {
+        json message = {
+            {"role", msg.role},
+            {"content", msg.content}
+        };
+        
+        // Add name for tool responses
+        if (msg.role == "tool" && !msg.name.empty()) {
+            message["name"] = msg.name;
+        }
+        
+        j_messages.push_back(message);
+    }
+    return j_messages;
+}
+
+// Serialize tools to a JSON array string (empty string when there are no tools)
+static std::string tools_to_json(const std::vector<Tool>& tools) {
+    if (tools.empty()) {
+        return "";
+    }
+    
+    json j_tools = json::array();
+    for (const auto& tool : tools) {
+        json j_tool = {
+            {"type", tool.type},
+            {"function", {
+                {"name", tool.function.name},
+                {"description", tool.function.description},
+                {"parameters", tool.function.parameters}
+            }}
+        };
+        j_tools.push_back(j_tool);
+    }
+    return j_tools.dump();
+}
+
+// Serialize the request payload, splicing in an already serialized tools array
+static std::string serialize_payload(const json& payload, const std::string& tools_json) {
+    // Tool results are sanitized already; anything else that is not UTF-8 gets U+FFFD instead of an exception
+    std::string body = payload.dump(-1, ' ', false, json::error_handler_t::replace);
+    if (!tools_json.empty()) {
+        // Replace the closing brace of the payload object with the tools member
+        body.pop_back();
+        body.reserve(body.size() + tools_json.size() + 10);
+        body += ",\"tools\":";
+        body += tools_json;
+        body += '}';
+    }
+    return body;
+}
+
 // Implementation class (PIMPL pattern)
 class OllamaClient::Impl {
 public:
@@ -170,7 +225,7 @@ public:
     
     ChatMessage chat(const std::string& model, 
                      const std::vector<ChatMessage>& messages,
-                     const std::vector<Tool>& tools,
+                     const std::string& tools_json,
                      std::function<void(const std::string&)> stream_callback) {
         if (stream_callback) {
             // For streaming with tools, we currently just return the content
@@ -179,7 +234,7 @@ public:
             chat_stream(model, messages, [&](const std::string& chunk) {
                 full_response += chunk;
                 if (stream_callback) stream_callback(chunk);
-            }, tools);
+            }, tools_json);
             
             return ChatMessage("assistant", full_response);
         }
@@ -190,46 +245,14 @@ public:
         std::string url = host_ + "/api/chat";
         std::string response;
         
-        // Prepare JSON payload
-        json j_messages = json::array();
-        for (const auto& msg : messages) {
-            json message = {
-                {"role", msg.role},
-                {"content", msg.content}
-            };
-            
-            // Add name for tool responses
-            if (msg.role == "tool" && !msg.name.empty()) {
-                message["name"] = msg.name;
-            }
-            
-            j_messages.push_back(message);
-        }
-        
+        // Prepare JSON payload; the tools array is already serialized
         json payload = {
             {"model", model},
-            {"messages", j_messages},
+            {"messages", messages_to_json(messages)},
             {"stream", false}
         };
         
-        // Add tools if provided
-        if (!tools.empty()) {
-            json j_tools = json::array();
-            for (const auto& tool : tools) {
-                json j_tool = {
-                    {"type", tool.type},
-                    {"function", {
-                        {"name", tool.function.name},
-                        {"description", tool.function.description},
-                        {"parameters", tool.function.parameters}
-                    }}
-                };
-                j_tools.push_back(j_tool);
-            }
-            payload["tools"] = j_tools;
-        }
-        
-        std::string payload_str = payload.dump();
+        std::string payload_str = serialize_payload(payload, tools_json);
         
         // Set up HTTP request
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
@@ -273,53 +296,21 @@ public:
     void chat_stream(const std::string& model,
                    const std::vector<ChatMessage>& messages,
                    std::function<void(const std::string&)> callback,
-                   const std::vector<Tool>& tools) {
+                   const std::string& tools_json) {
         CURL* curl = curl_easy_init();
         if (!curl) return;
         
         std::string url = host_ + "/api/chat";
         std::string response_buffer;
         
-        // Prepare JSON payload
-        json j_messages = json::array();
-        for (const auto& msg : messages) {
-            json message = {
-                {"role", msg.role},
-                {"content", msg.content}
-            };
-            
-            // Add name for tool responses
-            if (msg.role == "tool" && !msg.name.empty()) {
-                message["name"] = msg.name;
-            }
-            
-            j_messages.push_back(message);
-        }
-        
+        // Prepare JSON payload; the tools array is already serialized
         json payload = {
             {"model", model},
-            {"messages", j_messages},
+            {"messages", messages_to_json(messages)},
             {"stream", true}
         };
         
-        // Add tools if provided
-        if (!tools.empty()) {
-            json j_tools = json::array();
-            for (const auto& tool : tools) {
-                json j_tool = {
-                    {"type", tool.type},
-                    {"function", {
-                        {"name", tool.function.name},
-                        {"description", tool.function.description},
-                        {"parameters", tool.function.parameters}
-                    }}
-                };
-                j_tools.push_back(j_tool);
-            }
-            payload["tools"] = j_tools;
-        }
-        
-        std::string payload_str = payload.dump();
+        std::string payload_str = serialize_payload(payload, tools_json);
         
         // Set up HTTP request
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
@@ -365,72 +356,44 @@ ChatMessage OllamaClient::chat(const std::string& model,
                              const std::vector<ChatMessage>& messages,
                              const std::vector<Tool>& tools,
                              std::function<void(const std::string&)> stream_callback) {
-    return pimpl->chat(model, messages, tools, stream_callback);
+    return pimpl->chat(model, messages, tools_to_json(tools), stream_callback);
 }
 
-// Convert tool definitions to tools and call the original method
+// Serialize tool definitions directly instead of converting them to Tool structs
 ChatMessage OllamaClient::chat(const std::string& model, 
                              const std::vector<ChatMessage>& messages,
                              const std::vector<nlohmann::json>& tool_definitions,
                              std::function<void(const std::string&)> stream_callback) {
-    // Convert tool_definitions to tools
-    std::vector<Tool> tools;
-    for (const auto& def : tool_definitions) {
-        Tool tool;
-        tool.type = "function";
-        
-        if (def.contains("function")) {
-            auto& function = def["function"];
-            if (function.contains("name")) {
-                tool.function.name = function["name"].get<std::string>();
-            }
-            if (function.contains("description")) {
-                tool.function.description = function["description"].get<std::string>();
-            }
-            if (function.contains("parameters")) {
-                tool.function.parameters = function["parameters"];
-            }
-        }
-        
-        tools.push_back(tool);
-    }
-    
-    return pimpl->chat(model, messages, tools, stream_callback);
+    std::string tools_json = tool_definitions.empty() ? "" : json(tool_definitions).dump();
+    return pimpl->chat(model, messages, tools_json, stream_callback);
+}
+
+ChatMessage OllamaClient::chat(const std::string& model, 
+                             const std::vector<ChatMessage>& messages,
+                             const ToolDefinitionBlob& tools,
+                             std::function<void(const std::string&)> stream_callback) {
+    return pimpl->chat(model, messages, tools.json, stream_callback);
 }
 
 void OllamaClient::chat_stream(const std::string& model,
                            const std::vector<ChatMessage>& messages,
                            std::function<void(const std::string&)> callback,
                            const std::vector<Tool>& tools) {
-    pimpl->chat_stream(model, messages, callback, tools);
+    pimpl->chat_stream(model, messages, callback, tools_to_json(tools));
 }
 
-// Convert tool definitions to tools and call the original method
+// Serialize tool definitions directly instead of converting them to Tool structs
 void OllamaClient::chat_stream(const std::string& model,
                            const std::vector<ChatMessage>& messages,
                            std::function<void(const std::string&)> callback,
                            const std::vector<nlohmann::json>& tool_definitions) {
-    // Convert tool_definitions to tools
-    std::vector<Tool> tools;
-    for (const auto& def : tool_definitions) {
-        Tool tool;
-        tool.type = "function";
-        
-        if (def.contains("function")) {
-            auto& function = def["function"];
-            if (function.contains("name")) {
-                tool.function.name = function["name"].get<std::string>();
-            }
-            if (function.contains("description")) {
-                tool.function.description = function["description"].get<std::string>();
-            }
-            if (function.contains("parameters")) {
-                tool.function.parameters = function["parameters"];
-            }
-        }
-        
-        tools.push_back(tool);
-    }
-    
-    pimpl->chat_stream(model, messages, callback, tools);
+    std::string tools_json = tool_definitions.empty() ? "" : json(tool_definitions).dump();
+    pimpl->chat_stream(model, messages, callback, tools_json);
+}
+
+void OllamaClient::chat_stream(const std::string& model,
+                           const std::vector<ChatMessage>& messages,
+                           std::function<void(const std::string&)> callback,
+                           const ToolDefinitionBlob& tools) {
+    pimpl->chat_stream(model, messages, callback, tools.json);
 }
\ No newline at end of file
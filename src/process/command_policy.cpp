@@ -0,0 +1,905 @@
+#include "../../include/neoneo/process/command_policy.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fnmatch.h>
+#include <sstream>
+
+namespace neoneo {
+namespace process {
+
+namespace {
+
+// Nesting of subshells, substitutions and bash -c scripts followed before giving up
+constexpr int MAX_DEPTH = 32;
+
+bool is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+bool is_digits(const std::string& word) {
+    return !word.empty() && std::all_of(word.begin(), word.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+// NAME=value, which sets a variable rather than naming a command
+bool is_assignment(const std::string& word) {
+    size_t equals = word.find('=');
+    if (equals == std::string::npos || equals == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < equals; ++i) {
+        char c = word[i];
+        bool ok = c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (i > 0 && c >= '0' && c <= '9');
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class Parser {
+public:
+    Parser(std::string_view text, ParsedCommandLine& out) : text(text), out(out) {}
+
+    // Parse commands up to the end of the text or, when nested, the close character
+    void parse_list(char close, int depth) {
+        if (depth > MAX_DEPTH) {
+            pos = text.size();
+            return;
+        }
+
+        ShellCommand current;
+        std::string word;
+        bool in_word = false;
+        std::string redirect_op; // Waiting for its target
+
+        auto end_word = [&]() {
+            if (!in_word) {
+                return;
+            }
+            if (!redirect_op.empty()) {
+                if (redirect_op == "<<" || redirect_op == "<<-") {
+                    heredocs.push_back(word);
+                }
+                current.redirections.push_back({redirect_op, word});
+                redirect_op.clear();
+            } else if (!current.words.empty() || !skip_reserved(word)) {
+                current.words.push_back(word);
+            }
+            word.clear();
+            in_word = false;
+        };
+        auto end_command = [&]() {
+            end_word();
+            if (current.words.empty() && current.redirections.empty()) {
+                return;
+            }
+            if (!current.words.empty()) {
+                for (const auto& function : functions) {
+                    if (function.first == current.words.front()) {
+                        out.recursive_calls.push_back(function.first);
+                        break;
+                    }
+                }
+            }
+            out.commands.push_back(std::move(current));
+            current = ShellCommand();
+        };
+        auto add_operator = [&](const char* op) {
+            end_command();
+            out.operators.push_back(op);
+            current.piped = op[0] == '|' && op[1] != '|';
+        };
+        auto peek = [&](size_t ahead) { return pos + ahead < text.size() ? text[pos + ahead] : '\0'; };
+
+        while (pos < text.size()) {
+            char c = text[pos];
+            if (close != '\0' && c == close) {
+                ++pos;
+                end_command();
+                return;
+            }
+
+            switch (c) {
+            case ' ':
+            case '\t':
+                end_word();
+                ++pos;
+                break;
+            case '\n':
+                // A pipeline may go on after a newline ("a |\n b")
+                if (!(current.piped && !in_word && current.words.empty() && current.redirections.empty())) {
+                    add_operator(";");
+                }
+                ++pos;
+                skip_heredocs();
+                break;
+            case ';':
+                add_operator(";");
+                pos += peek(1) == ';' ? 2 : 1;
+                break;
+            case '|':
+                if (peek(1) == '|') {
+                    add_operator("||");
+                    pos += 2;
+                } else if (peek(1) == '&') {
+                    add_operator("|&");
+                    pos += 2;
+                } else {
+                    add_operator("|");
+                    ++pos;
+                }
+                break;
+            case '&':
+                if (peek(1) == '&') {
+                    add_operator("&&");
+                    pos += 2;
+                } else if (peek(1) == '>') {
+                    end_word();
+                    redirect_op = peek(2) == '>' ? "&>>" : "&>";
+                    pos += redirect_op.size();
+                } else {
+                    add_operator("&");
+                    ++pos;
+                }
+                break;
+            case '<':
+            case '>': {
+                // A number right before the operator is the descriptor it redirects
+                if (in_word && redirect_op.empty() && is_digits(word)) {
+                    word.clear();
+                    in_word = false;
+                }
+                end_word();
+                static const char* const OPS[] = {"<<<", "<<-", ">>", ">|", ">&", "<<", "<&", "<>", ">", "<"};
+                for (const char* op : OPS) {
+                    if (text.compare(pos, std::strlen(op), op) == 0) {
+                        redirect_op = op;
+                        break;
+                    }
+                }
+                pos += redirect_op.size();
+                break;
+            }
+            case '(':
+                end_word();
+                if (current.words.size() == 1 && next_nonblank(pos + 1) == ')') {
+                    // name() starts a function definition; its body is the next brace group
+                    pending_function = current.words.front();
+                    current = ShellCommand();
+                    pos = text.find(')', pos) + 1;
+                } else {
+                    end_command();
+                    ++pos;
+                    parse_list(')', depth + 1);
+                }
+                break;
+            case ')':
+                // Unbalanced; bash would refuse the line
+                end_command();
+                ++pos;
+                break;
+            case '#':
+                if (in_word) {
+                    word += c;
+                    ++pos;
+                } else {
+                    while (pos < text.size() && text[pos] != '\n') {
+                        ++pos;
+                    }
+                }
+                break;
+            case '\'': {
+                in_word = true;
+                size_t end = text.find('\'', pos + 1);
+                end = end == std::string_view::npos ? text.size() : end;
+                word.append(text.substr(pos + 1, end - pos - 1));
+                pos = std::min(end + 1, text.size());
+                break;
+            }
+            case '"':
+                in_word = true;
+                ++pos;
+                parse_double_quoted(word, depth);
+                break;
+            case '\\':
+                in_word = true;
+                if (peek(1) != '\n' && peek(1) != '\0') {
+                    word += peek(1);
+                }
+                pos += 2;
+                break;
+            case '$':
+                in_word = true;
+                parse_dollar(word, depth);
+                break;
+            case '`':
+                in_word = true;
+                ++pos;
+                parse_list('`', depth + 1);
+                break;
+            case '{':
+            case '}':
+                // Brace groups only where a command starts; elsewhere braces are word characters
+                if (!in_word && current.words.empty() && (c == '}' || is_blank(peek(1)) || peek(1) == '\n')) {
+                    end_command();
+                    if (c == '{') {
+                        ++brace_depth;
+                        if (!pending_function.empty()) {
+                            functions.emplace_back(pending_function, brace_depth);
+                            pending_function.clear();
+                        }
+                    } else {
+                        while (!functions.empty() && functions.back().second == brace_depth) {
+                            functions.pop_back();
+                        }
+                        --brace_depth;
+                    }
+                    ++pos;
+                    break;
+                }
+                in_word = true;
+                word += c;
+                ++pos;
+                break;
+            default:
+                in_word = true;
+                word += c;
+                ++pos;
+                break;
+            }
+        }
+        end_command();
+    }
+
+private:
+    // Reserved words where a command starts are not commands themselves: the
+    // command after "if", "then", "do", "!" and the like is the one that runs,
+    // "function NAME" and "coproc NAME" name what follows. Returns whether
+    // word is to be left out of the command.
+    bool skip_reserved(const std::string& word) {
+        if (expect_function_name) {
+            expect_function_name = false;
+            pending_function = word;
+            return true;
+        }
+        if (after_coproc) {
+            // "coproc NAME { ...; }" names the coprocess; "coproc cmd args" runs cmd
+            after_coproc = false;
+            char next = next_nonblank(pos);
+            if (next == '{' || next == '(') {
+                return true;
+            }
+        }
+        static const char* const RESERVED[] = {"if",   "then", "else", "elif",  "fi",  "while",
+                                               "until", "do",   "done", "esac", "!",   "function",
+                                               "coproc"};
+        if (std::find_if(std::begin(RESERVED), std::end(RESERVED),
+                         [&](const char* reserved) { return word == reserved; }) == std::end(RESERVED)) {
+            return false;
+        }
+        out.keywords.push_back(word);
+        expect_function_name = word == "function";
+        after_coproc = word == "coproc";
+        return true;
+    }
+
+    char next_nonblank(size_t from) const {
+        while (from < text.size() && is_blank(text[from])) {
+            ++from;
+        }
+        return from < text.size() ? text[from] : '\0';
+    }
+
+    // After an opening '"'; leaves pos after the closing one
+    void parse_double_quoted(std::string& word, int depth) {
+        while (pos < text.size() && text[pos] != '"') {
+            char c = text[pos];
+            char next = pos + 1 < text.size() ? text[pos + 1] : '\0';
+            if (c == '\\' && next != '\0' && std::strchr("$`\"\\\n", next)) {
+                if (next != '\n') {
+                    word += next;
+                }
+                pos += 2;
+            } else if (c == '$') {
+                parse_dollar(word, depth);
+            } else if (c == '`') {
+                ++pos;
+                parse_list('`', depth + 1);
+            } else {
+                word += c;
+                ++pos;
+            }
+        }
+        ++pos;
+    }
+
+    // At a '$': command substitutions are parsed as commands, the rest kept as text
+    void parse_dollar(std::string& word, int depth) {
+        if (text.compare(pos, 3, "$((") == 0) {
+            size_t end = skip_balanced(pos + 1, '(', ')');
+            word.append(text.substr(pos, end - pos));
+            pos = end;
+        } else if (text.compare(pos, 2, "$(") == 0) {
+            pos += 2;
+            parse_list(')', depth + 1);
+        } else if (text.compare(pos, 2, "${") == 0) {
+            size_t end = skip_balanced(pos + 1, '{', '}');
+            word.append(text.substr(pos, end - pos));
+            pos = end;
+        } else {
+            word += '$';
+            ++pos;
+        }
+    }
+
+    // Position after the close matching the open at from
+    size_t skip_balanced(size_t from, char open, char close) const {
+        int level = 0;
+        for (size_t i = from; i < text.size(); ++i) {
+            if (text[i] == open) {
+                ++level;
+            } else if (text[i] == close && --level == 0) {
+                return i + 1;
+            }
+        }
+        return text.size();
+    }
+
+    // At the start of the line after a here-document operator: skip its body
+    void skip_heredocs() {
+        for (const auto& delimiter : heredocs) {
+            while (pos < text.size()) {
+                size_t end = text.find('\n', pos);
+                end = end == std::string_view::npos ? text.size() : end;
+                std::string_view line = text.substr(pos, end - pos);
+                while (!line.empty() && line.front() == '\t') {
+                    line.remove_prefix(1);
+                }
+                pos = std::min(end + 1, text.size());
+                if (line == delimiter) {
+                    break;
+                }
+            }
+        }
+        heredocs.clear();
+    }
+
+    std::string_view text;
+    ParsedCommandLine& out;
+    size_t pos = 0;
+    int brace_depth = 0;
+    std::string pending_function;
+    bool expect_function_name = false;
+    bool after_coproc = false;
+    std::vector<std::pair<std::string, int>> functions; // Being defined, with the depth of their body
+    std::vector<std::string> heredocs;                  // Delimiters of bodies starting on the next line
+};
+
+std::string base_name(const std::string& word) {
+    size_t slash = word.rfind('/');
+    return slash == std::string::npos ? word : word.substr(slash + 1);
+}
+
+std::string join(const std::vector<std::string>& words, size_t first) {
+    std::string joined;
+    for (size_t i = first; i < words.size(); ++i) {
+        if (i > first) {
+            joined += ' ';
+        }
+        joined += words[i];
+    }
+    return joined;
+}
+
+bool pattern_matches(const std::string& pattern, const std::string& word) {
+    return fnmatch(pattern.c_str(), word.c_str(), 0) == 0;
+}
+
+// Whether an argument matches a rule pattern (see CommandPolicy)
+bool argument_matches(const std::string& pattern, const std::string& word) {
+    if (pattern.size() == 2 && pattern[0] == '-' && pattern[1] != '-') {
+        return word.size() > 1 && word[0] == '-' && word[1] != '-' && word.find(pattern[1], 1) != std::string::npos;
+    }
+    if (pattern.compare(0, 2, "--") == 0 && word.compare(0, pattern.size(), pattern) == 0) {
+        return word.size() == pattern.size() || word[pattern.size()] == '=';
+    }
+    return pattern_matches(pattern, word);
+}
+
+// Redirection targets no rule is about
+bool is_harmless_target(const std::string& target) {
+    return target == "/dev/null" || target == "/dev/stdout" || target == "/dev/stderr" || target == "/dev/tty" ||
+           target.compare(0, 8, "/dev/fd/") == 0;
+}
+
+// Commands that run the command named by their arguments, and their options that take a value
+struct Wrapper {
+    const char* name;
+    const char* options_with_value;
+    bool takes_number; // A leading number or duration comes before the command (timeout 5 cmd)
+};
+
+const Wrapper WRAPPERS[] = {
+    {"sudo", " -u -g -C -D -h -p -r -t -U -R ", false},
+    {"doas", " -u -C ", false},
+    {"env", " -u -C -S ", false},
+    {"nice", " -n ", false},
+    {"nohup", " ", false},
+    {"time", " -f -o ", false},
+    {"timeout", " -s -k ", true},
+    {"xargs", " -a -d -E -e -I -L -n -P -s ", false},
+    {"exec", " -a ", false},
+    {"command", " ", false},
+    {"builtin", " ", false},
+    {"stdbuf", " -i -o -e ", false},
+    {"ionice", " -c -n -p ", false},
+    {"watch", " -n -d ", false},
+    {"busybox", " ", false},
+};
+
+// Index of the command a wrapper at words[i] runs, or words.size()
+size_t wrapped_command(const std::vector<std::string>& words, size_t i, const std::string& name) {
+    const Wrapper* wrapper = nullptr;
+    for (const auto& candidate : WRAPPERS) {
+        if (name == candidate.name) {
+            wrapper = &candidate;
+            break;
+        }
+    }
+    if (!wrapper) {
+        return words.size();
+    }
+
+    bool number_taken = false;
+    for (size_t j = i + 1; j < words.size(); ++j) {
+        const std::string& word = words[j];
+        if (word == "--") {
+            return j + 1;
+        }
+        if (word.size() > 1 && word[0] == '-') {
+            if (std::strstr(wrapper->options_with_value, (" " + word + " ").c_str())) {
+                ++j;
+            }
+            continue;
+        }
+        if (is_assignment(word)) {
+            continue;
+        }
+        if (wrapper->takes_number && !number_taken && word[0] >= '0' && word[0] <= '9') {
+            number_taken = true;
+            continue;
+        }
+        return j;
+    }
+    return words.size();
+}
+
+bool is_shell(const std::string& name) {
+    return name == "bash" || name == "sh" || name == "zsh" || name == "dash" || name == "ksh";
+}
+
+// Where a shell started at words[i] takes its script from
+enum class ScriptSource {
+    Argument, // bash -c SCRIPT; script points at it, or is nullptr when it comes later (xargs bash -c)
+    File,     // bash FILE
+    Input     // Standard input: bash, bash -s
+};
+
+ScriptSource shell_script(const std::vector<std::string>& words, size_t i, const std::string*& script) {
+    bool command_mode = false;
+    bool input_mode = false;
+    size_t j = i + 1;
+    while (j < words.size()) {
+        const std::string& word = words[j];
+        if (word == "--" || word == "-") {
+            ++j;
+            break;
+        }
+        if (word.compare(0, 2, "--") == 0) {
+            j += word == "--rcfile" || word == "--init-file" ? 2 : 1;
+            continue;
+        }
+        if (word.size() < 2 || (word[0] != '-' && word[0] != '+')) {
+            break;
+        }
+        // Short options may be clustered (-ec, -eo pipefail); -o and -O take the next word
+        size_t values = 0;
+        for (size_t k = 1; k < word.size(); ++k) {
+            command_mode = command_mode || (word[0] == '-' && word[k] == 'c');
+            input_mode = input_mode || word[k] == 's';
+            values += word[k] == 'o' || word[k] == 'O' ? 1 : 0;
+        }
+        j += 1 + values;
+    }
+
+    // The first word after the options is the script with -c, else a script file
+    script = nullptr;
+    if (command_mode) {
+        script = j < words.size() ? &words[j] : nullptr;
+        return ScriptSource::Argument;
+    }
+    return j < words.size() && !input_mode ? ScriptSource::File : ScriptSource::Input;
+}
+
+// Commands that only read, and their options that would make them write, wait or change the shell
+struct ReadOnlyCommand {
+    const char* name;
+    const char* unsafe_options;
+};
+
+const ReadOnlyCommand READ_ONLY_COMMANDS[] = {
+    {"cat", ""}, {"head", ""}, {"tail", " -f -F --follow "}, {"wc", ""}, {"grep", ""}, {"egrep", ""},
+    {"fgrep", ""}, {"rg", " --pre "}, {"ls", ""}, {"tree", " -o "}, {"pwd", ""}, {"stat", ""}, {"du", ""},
+    {"df", ""}, {"file", ""}, {"which", ""}, {"type", ""}, {"realpath", ""}, {"readlink", ""},
+    {"basename", ""}, {"dirname", ""}, {"echo", ""}, {"printf", " -v "}, {"sort", " -o --output "},
+    {"cut", ""}, {"tr", ""}, {"nl", ""}, {"diff", ""}, {"cmp", ""}, {"md5sum", ""}, {"sha1sum", ""},
+    {"sha256sum", ""}, {"true", ""}, {"test", ""}, {"[", ""}, {"id", ""}, {"whoami", ""}, {"uname", ""},
+    {"hostname", ""},
+};
+
+// git subcommands that only read the repository
+const char* const READ_ONLY_GIT[] = {"status", "diff", "log", "show", "rev-parse", "ls-files", "blame", "describe"};
+
+bool has_option(const std::string& options, const std::string& word) {
+    if (word.size() < 2 || word[0] != '-') {
+        return false;
+    }
+    if (word[1] == '-') {
+        std::string name = word.substr(0, word.find('='));
+        return options.find(" " + name + " ") != std::string::npos;
+    }
+    // Short options may be clustered (-fn) or carry their value (-ofile)
+    for (size_t i = 1; i < word.size(); ++i) {
+        if (options.find(std::string(" -") + word[i] + " ") != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// git options that run other programs (a configured pager, diff driver or
+// filter) or write files: global ones, then those of the subcommands
+const char* const UNSAFE_GIT_OPTIONS[] = {"-c", "--config-env", "-p", "--paginate", "--exec-path="};
+const char* const UNSAFE_GIT_SUBCOMMAND_OPTIONS[] = {"--ext-diff", "--textconv", "--output"};
+
+template <size_t N>
+bool has_git_option(const char* const (&options)[N], const std::string& word) {
+    for (const char* option : options) {
+        size_t length = std::strlen(option);
+        if (word.compare(0, length, option) == 0 &&
+            (word.size() == length || word[length] == '=' || option[length - 1] == '=')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Paths whose content changes on every read: devices and kernel state
+bool is_volatile_path(const std::string& word) {
+    std::string path = !word.empty() && word[0] == '-' && word.find('=') != std::string::npos ? word.substr(word.find('=') + 1) : word;
+    if (is_harmless_target(path)) {
+        return false;
+    }
+    for (const char* root : {"/dev", "/proc", "/sys"}) {
+        size_t length = std::strlen(root);
+        if (path.compare(0, length, root) == 0 && (path.size() == length || path[length] == '/')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool is_read_only_words(const std::vector<std::string>& words) {
+    size_t first = 0;
+    while (first < words.size() && is_assignment(words[first])) {
+        ++first;
+    }
+    if (first == words.size()) {
+        return false; // Only assignments, which change the shell
+    }
+    // Expansions ($RANDOM, $(date), ${x}) may differ from run to run
+    if (std::any_of(words.begin(), words.end(), [](const std::string& word) {
+            return word.find('$') != std::string::npos || is_volatile_path(word);
+        })) {
+        return false;
+    }
+    std::string name = base_name(words[first]);
+
+    if (name == "git") {
+        // Assignments such as GIT_PAGER or GIT_EXTERNAL_DIFF can run programs too
+        if (first > 0) {
+            return false;
+        }
+        size_t i = first + 1;
+        while (i < words.size() && words[i].size() > 1 && words[i][0] == '-') {
+            if (has_git_option(UNSAFE_GIT_OPTIONS, words[i])) {
+                return false;
+            }
+            i += words[i] == "-C" ? 2 : 1;
+        }
+        if (i >= words.size() ||
+            std::find(std::begin(READ_ONLY_GIT), std::end(READ_ONLY_GIT), words[i]) == std::end(READ_ONLY_GIT)) {
+            return false;
+        }
+        return std::none_of(words.begin() + i, words.end(), [](const std::string& word) {
+            return has_git_option(UNSAFE_GIT_SUBCOMMAND_OPTIONS, word);
+        });
+    }
+
+    for (const auto& command : READ_ONLY_COMMANDS) {
+        if (name == command.name) {
+            std::string options = command.unsafe_options;
+            return std::none_of(words.begin() + first + 1, words.end(),
+                                [&](const std::string& word) { return has_option(options, word); });
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool is_read_only_command(std::string_view command_line) {
+    ParsedCommandLine parsed = parse_command_line(command_line);
+    if (parsed.commands.empty() || !parsed.recursive_calls.empty() ||
+        std::find(parsed.operators.begin(), parsed.operators.end(), "&") != parsed.operators.end()) {
+        return false;
+    }
+    // Loops may wait for something else to change, and coprocesses keep running
+    for (const auto& keyword : parsed.keywords) {
+        if (keyword == "while" || keyword == "until" || keyword == "coproc") {
+            return false;
+        }
+    }
+    for (const auto& command : parsed.commands) {
+        for (const auto& redirection : command.redirections) {
+            bool output = redirection.op.find('>') != std::string::npos;
+            bool duplicate = redirection.op.back() == '&' && (is_digits(redirection.target) || redirection.target == "-");
+            if (output && !duplicate && !is_harmless_target(redirection.target)) {
+                return false;
+            }
+            if (!output && !duplicate && is_volatile_path(redirection.target)) {
+                return false;
+            }
+        }
+        if (!is_read_only_words(command.words)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ParsedCommandLine parse_command_line(std::string_view text) {
+    ParsedCommandLine parsed;
+    Parser(text, parsed).parse_list('\0', 0);
+    return parsed;
+}
+
+CommandPolicy::CommandPolicy(const std::vector<std::string>& rules) {
+    for (const auto& rule : rules) {
+        add_rule(rule);
+    }
+}
+
+void CommandPolicy::add_rule(const std::string& text) {
+    std::istringstream stream(text);
+    std::vector<std::string> tokens;
+    for (std::string token; stream >> token;) {
+        tokens.push_back(token);
+    }
+    if (tokens.empty()) {
+        return;
+    }
+
+    size_t index = rules.size();
+    Rule rule;
+    rule.text = text;
+    const std::string& head = tokens.front();
+
+    if (tokens.size() == 1 && (head == "|" || head == "|&" || head == "||" || head == "&&" || head == ";" ||
+                               head == "&")) {
+        operator_rules.emplace(head, index);
+    } else if (head[0] == '>' || head[0] == '<') {
+        redirect_rules.push_back({head[0] == '>', tokens.size() > 1 ? tokens[1] : "", index});
+    } else {
+        for (size_t i = 1; i < tokens.size(); ++i) {
+            std::vector<std::string> alternatives;
+            std::istringstream split(tokens[i]);
+            for (std::string alternative; std::getline(split, alternative, '|');) {
+                if (!alternative.empty()) {
+                    alternatives.push_back(alternative);
+                }
+            }
+            rule.arguments.push_back(std::move(alternatives));
+        }
+        if (head.find_first_of("*?[") != std::string::npos) {
+            pattern_rules.emplace_back(head, index);
+        } else {
+            command_rules[head].push_back(index);
+        }
+    }
+    rules.push_back(std::move(rule));
+}
+
+bool CommandPolicy::matches(const Rule& rule, const std::vector<std::string>& words, size_t first) const {
+    for (const auto& alternatives : rule.arguments) {
+        bool found = false;
+        for (size_t i = first + 1; i < words.size() && !found; ++i) {
+            for (const auto& pattern : alternatives) {
+                if (argument_matches(pattern, words[i])) {
+                    found = true;
+                    break;
+                }
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CommandPolicy::check_words(const std::vector<std::string>& words, size_t first, bool reads_input,
+                                PolicyVerdict& verdict, int depth) const {
+    // Each command in a chain like "sudo nice -n 5 rm -rf x" is checked with its arguments
+    for (size_t i = first; i < words.size();) {
+        std::string name = base_name(words[i]);
+        auto flag = [&](size_t rule) {
+            verdict.allowed = false;
+            verdict.rule = rules[rule].text;
+            verdict.command = join(words, first);
+            return true;
+        };
+
+        auto it = command_rules.find(name);
+        if (it != command_rules.end()) {
+            for (size_t rule : it->second) {
+                if (matches(rules[rule], words, i)) {
+                    return flag(rule);
+                }
+            }
+        }
+        for (const auto& [pattern, rule] : pattern_rules) {
+            if (pattern_matches(pattern, name) && matches(rules[rule], words, i)) {
+                return flag(rule);
+            }
+        }
+
+        // Scripts run by a shell or eval are checked like the command line itself
+        const std::string* script = nullptr;
+        ScriptSource source = is_shell(name) ? shell_script(words, i, script) : ScriptSource::File;
+
+        // A script fed through a pipe or here-document can not be checked, so it is flagged
+        // ("curl ... | bash", "bash <<< '...'", "xargs bash -c", eval "$(cat)")
+        bool sources_input = (name == "source" || name == ".") && i + 1 < words.size() &&
+                             (words[i + 1] == "/dev/stdin" || words[i + 1] == "/dev/fd/0" ||
+                              words[i + 1] == "/proc/self/fd/0");
+        bool unknown_script = source == ScriptSource::Input || (source == ScriptSource::Argument && !script) ||
+                              (name == "eval" && i + 1 < words.size()) || sources_input;
+        if (reads_input && unknown_script) {
+            verdict.allowed = false;
+            verdict.rule = "shell reading its script from standard input";
+            verdict.command = join(words, first);
+            return true;
+        }
+
+        std::string evaluated;
+        if (name == "eval") {
+            evaluated = join(words, i + 1);
+            script = &evaluated;
+        }
+        if (script && depth < MAX_DEPTH) {
+            PolicyVerdict inner = check(*script, depth + 1);
+            if (!inner.allowed) {
+                verdict = inner;
+                return true;
+            }
+        }
+
+        // find runs the command after -exec, -execdir, -ok or -okdir up to ";" or "+" for each file
+        if (name == "find" && depth < MAX_DEPTH) {
+            for (size_t j = i + 1; j < words.size(); ++j) {
+                if (words[j] != "-exec" && words[j] != "-execdir" && words[j] != "-ok" && words[j] != "-okdir") {
+                    continue;
+                }
+                size_t end = j + 1;
+                while (end < words.size() && words[end] != ";" && words[end] != "+") {
+                    ++end;
+                }
+                std::vector<std::string> executed(words.begin() + j + 1, words.begin() + end);
+                if (check_words(executed, 0, false, verdict, depth + 1)) {
+                    return true;
+                }
+                j = end;
+            }
+        }
+
+        i = wrapped_command(words, i, name);
+    }
+    return false;
+}
+
+PolicyVerdict CommandPolicy::check(std::string_view command_line) const {
+    return check(command_line, 0);
+}
+
+PolicyVerdict CommandPolicy::check(std::string_view command_line, int depth) const {
+    ParsedCommandLine parsed = parse_command_line(command_line);
+    PolicyVerdict verdict;
+
+    if (!parsed.recursive_calls.empty()) {
+        verdict.allowed = false;
+        verdict.rule = "recursive shell function (fork bomb)";
+        verdict.command = parsed.recursive_calls.front();
+        return verdict;
+    }
+
+    for (const auto& op : parsed.operators) {
+        auto it = operator_rules.find(op);
+        if (it != operator_rules.end()) {
+            verdict.allowed = false;
+            verdict.rule = rules[it->second].text;
+            verdict.command = op;
+            return verdict;
+        }
+    }
+
+    for (const auto& command : parsed.commands) {
+        for (const auto& redirection : command.redirections) {
+            bool output = redirection.op.find('>') != std::string::npos;
+            bool duplicate = redirection.op.back() == '&' && (is_digits(redirection.target) || redirection.target == "-");
+            for (const auto& rule : redirect_rules) {
+                if (rule.output != output || (!rule.target.empty() && (duplicate || is_harmless_target(redirection.target) ||
+                                                                       !pattern_matches(rule.target, redirection.target)))) {
+                    continue;
+                }
+                verdict.allowed = false;
+                verdict.rule = rules[rule.rule].text;
+                verdict.command = join(command.words, 0);
+                verdict.command += (verdict.command.empty() ? "" : " ") + redirection.op + " " + redirection.target;
+                return verdict;
+            }
+        }
+
+        size_t first = 0;
+        while (first < command.words.size() && is_assignment(command.words[first])) {
+            ++first;
+        }
+        bool reads_input = command.piped;
+        for (const auto& redirection : command.redirections) {
+            reads_input = reads_input || redirection.op == "<<<" || redirection.op == "<<" || redirection.op == "<<-";
+        }
+        if (check_words(command.words, first, reads_input, verdict, depth)) {
+            return verdict;
+        }
+    }
+    return verdict;
+}
+
+std::vector<std::string> CommandPolicy::bash_rules() {
+    return {
+        "rm -r|-R|--recursive -f|--force",
+        "mkfs*",
+        "dd if=*|of=*",
+        "> /dev/*",
+        "sudo rm|mv|cp",
+        "reboot",
+        "shutdown",
+        "halt",
+        "poweroff",
+        "passwd",
+        "chmod 777|0777|a+rwx",
+        "find -delete",
+    };
+}
+
+std::vector<std::string> CommandPolicy::shell_rules() {
+    return {
+        "rm", "mkfs*", "dd", "sudo", "su", "chmod", "chown", "passwd", "mv", "curl", "wget",
+        "ssh", "scp", "ftp", "telnet", "nc", "ncat", "sleep", "perl", "python*", "ruby",
+        "bash", "sh", "zsh", "csh", "ksh", "find -delete",
+        ">", "|", "|&", "&", ";", "&&", "||",
+    };
+}
+
+} // namespace process
+} // namespace neoneo
@@ -0,0 +1,421 @@
+#include "../../include/neoneo/process/executor.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace neoneo {
+namespace process {
+
+namespace {
+
+void close_fd(int& fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+// Inherited environment with the extra NAME=value entries applied on top
+std::vector<std::string> build_environment(const std::vector<std::string>& extra) {
+    std::vector<std::string> env;
+    for (char** entry = environ; entry && *entry; ++entry) {
+        env.emplace_back(*entry);
+    }
+    for (const auto& assignment : extra) {
+        std::string name = assignment.substr(0, assignment.find('='));
+        auto existing = std::find_if(env.begin(), env.end(), [&](const std::string& e) {
+            return e.compare(0, name.size(), name) == 0 && e.size() > name.size() && e[name.size()] == '=';
+        });
+        if (existing != env.end()) {
+            *existing = assignment;
+        } else {
+            env.push_back(assignment);
+        }
+    }
+    return env;
+}
+
+std::vector<char*> to_c_array(std::vector<std::string>& strings) {
+    std::vector<char*> array;
+    array.reserve(strings.size() + 1);
+    for (auto& s : strings) {
+        array.push_back(s.data());
+    }
+    array.push_back(nullptr);
+    return array;
+}
+
+// Read everything currently available from fd; returns false once the stream is closed
+bool drain_stream(int fd, std::string& data, size_t& total, bool& truncated, size_t max_bytes,
+                  const OutputCallback& on_output, OutputStream stream) {
+    char buffer[65536];
+    while (true) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            if (on_output) {
+                on_output(stream, std::string_view(buffer, static_cast<size_t>(n)));
+            }
+            total += static_cast<size_t>(n);
+            size_t room = data.size() < max_bytes ? max_bytes - data.size() : 0;
+            size_t keep = std::min(room, static_cast<size_t>(n));
+            data.append(buffer, keep);
+            if (keep < static_cast<size_t>(n)) {
+                truncated = true;
+            }
+            continue;
+        }
+        if (n == 0) {
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+double to_seconds(const struct timeval& tv) {
+    return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+}
+
+} // namespace
+
+std::string ProcessResult::describe_status() const {
+    if (!started) {
+        return "not started: " + error;
+    }
+
+    std::string status;
+    if (timed_out) {
+        status = "killed after timeout";
+    } else if (term_signal != 0) {
+        status = "terminated by signal " + std::to_string(term_signal);
+    } else {
+        status = "exit code " + std::to_string(exit_code);
+    }
+
+    char usage[128];
+    std::snprintf(usage, sizeof(usage), ", %.2fs wall, %.2fs user, %.2fs sys, max RSS %ld KB",
+                  wall_time.count() / 1000.0, user_seconds, system_seconds, max_rss_kb);
+    return status + usage;
+}
+
+ChildProcess::~ChildProcess() {
+    if (pid > 0 && !exited) {
+        kill_group(SIGKILL);
+        wait(true);
+    }
+    close_stdin();
+    close_stdout();
+    close_stderr();
+}
+
+std::unique_ptr<ChildProcess> ChildProcess::spawn(const std::vector<std::string>& argv,
+                                                  const std::string& working_directory,
+                                                  const std::vector<std::string>& environment,
+                                                  std::string& error) {
+    if (argv.empty()) {
+        error = "No command given";
+        return nullptr;
+    }
+
+    // A bad working directory would otherwise surface as a failure to start the program
+    if (!working_directory.empty()) {
+        struct stat info;
+        if (stat(working_directory.c_str(), &info) != 0) {
+            error = errno == ENOENT ? "Working directory '" + working_directory + "' does not exist"
+                                    : "Cannot use working directory '" + working_directory + "': " +
+                                          std::strerror(errno);
+            return nullptr;
+        }
+        if (!S_ISDIR(info.st_mode)) {
+            error = "Working directory '" + working_directory + "' is not a directory";
+            return nullptr;
+        }
+        if (access(working_directory.c_str(), X_OK) != 0) {
+            error = "Cannot enter working directory '" + working_directory + "': " + std::strerror(errno);
+            return nullptr;
+        }
+    }
+
+    int in_pipe[2] = {-1, -1};
+    int out_pipe[2] = {-1, -1};
+    int err_pipe[2] = {-1, -1};
+    if (pipe2(in_pipe, O_CLOEXEC) != 0 || pipe2(out_pipe, O_CLOEXEC) != 0 || pipe2(err_pipe, O_CLOEXEC) != 0) {
+        error = std::string("Failed to create pipes: ") + std::strerror(errno);
+        for (int* fds : {in_pipe, out_pipe, err_pipe}) {
+            close_fd(fds[0]);
+            close_fd(fds[1]);
+        }
+        return nullptr;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, in_pipe[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, err_pipe[1], STDERR_FILENO);
+
+    // Change directory in the child; without addchdir_np let a shell do it before exec
+    std::vector<std::string> args = argv;
+    // (addchdir_np is available in glibc 2.29+ and macOS 10.15+)
+    if (!working_directory.empty()) {
+#if (defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))) || defined(__APPLE__)
+        posix_spawn_file_actions_addchdir_np(&actions, working_directory.c_str());
+#else
+        args.insert(args.begin(), {"/bin/sh", "-c", "cd -- \"$0\" && exec \"$@\"", working_directory});
+#endif
+    }
+
+    // Own process group so a timeout can kill everything the command started,
+    // with default signal dispositions and an empty signal mask
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+    posix_spawnattr_setpgroup(&attr, 0);
+    sigset_t default_signals;
+    sigemptyset(&default_signals);
+    for (int sig : {SIGPIPE, SIGINT, SIGQUIT, SIGTERM, SIGHUP, SIGCHLD}) {
+        sigaddset(&default_signals, sig);
+    }
+    posix_spawnattr_setsigdefault(&attr, &default_signals);
+    sigset_t empty_mask;
+    sigemptyset(&empty_mask);
+    posix_spawnattr_setsigmask(&attr, &empty_mask);
+
+    std::vector<std::string> env = build_environment(environment);
+    std::vector<char*> c_argv = to_c_array(args);
+    std::vector<char*> c_envp = to_c_array(env);
+
+    pid_t child_pid = -1;
+    int rc = posix_spawnp(&child_pid, c_argv[0], &actions, &attr, c_argv.data(), c_envp.data());
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close_fd(in_pipe[0]);
+    close_fd(out_pipe[1]);
+    close_fd(err_pipe[1]);
+
+    if (rc != 0) {
+        error = "Failed to start '" + argv[0] + "': " + std::strerror(rc);
+        close_fd(in_pipe[1]);
+        close_fd(out_pipe[0]);
+        close_fd(err_pipe[0]);
+        return nullptr;
+    }
+
+    std::unique_ptr<ChildProcess> child(new ChildProcess());
+    child->pid = child_pid;
+    child->stdin_pipe = in_pipe[1];
+    child->stdout_pipe = out_pipe[0];
+    child->stderr_pipe = err_pipe[0];
+
+    for (int fd : {child->stdin_pipe, child->stdout_pipe, child->stderr_pipe}) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+    // Writing to a child that exited must not kill us
+    signal(SIGPIPE, SIG_IGN);
+
+    return child;
+}
+
+void ChildProcess::close_stdin() {
+    close_fd(stdin_pipe);
+}
+
+void ChildProcess::close_stdout() {
+    close_fd(stdout_pipe);
+}
+
+void ChildProcess::close_stderr() {
+    close_fd(stderr_pipe);
+}
+
+void ChildProcess::kill_group(int signal_number) {
+    if (pid > 0) {
+        // The group outlives the leader if it left children behind
+        if (kill(-pid, signal_number) != 0 && !exited) {
+            kill(pid, signal_number);
+        }
+    }
+}
+
+bool ChildProcess::wait(bool block) {
+    if (exited || pid <= 0) {
+        return true;
+    }
+
+    while (true) {
+        pid_t r = wait4(pid, &status, block ? 0 : WNOHANG, &usage);
+        if (r == pid) {
+            exited = true;
+            return true;
+        }
+        if (r == 0) {
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        // Already reaped elsewhere
+        exited = true;
+        return true;
+    }
+}
+
+ProcessResult run_process(const ProcessOptions& options) {
+    using clock = std::chrono::steady_clock;
+
+    ProcessResult result;
+    auto start_time = clock::now();
+    bool has_deadline = options.timeout.count() > 0;
+    auto deadline = start_time + options.timeout;
+
+    std::unique_ptr<ChildProcess> child = ChildProcess::spawn(
+        options.argv, options.working_directory, options.environment, result.error);
+    if (!child) {
+        return result;
+    }
+    result.started = true;
+
+    size_t stdin_offset = 0;
+    if (options.stdin_data.empty()) {
+        child->close_stdin();
+    }
+
+    auto read_stdout = [&]() {
+        if (!drain_stream(child->stdout_fd(), result.stdout_data, result.stdout_bytes,
+                          result.stdout_truncated, options.max_stdout_bytes, options.on_output, OutputStream::Stdout)) {
+            child->close_stdout();
+        }
+    };
+    auto read_stderr = [&]() {
+        if (!drain_stream(child->stderr_fd(), result.stderr_data, result.stderr_bytes,
+                          result.stderr_truncated, options.max_stderr_bytes, options.on_output, OutputStream::Stderr)) {
+            child->close_stderr();
+        }
+    };
+
+    // Pump the pipes until both outputs close or the deadline passes
+    while (child->stdout_fd() >= 0 || child->stderr_fd() >= 0) {
+        // Background processes may keep the pipes open after the command itself exited
+        if (child->wait(false)) {
+            if (child->stdout_fd() >= 0) read_stdout();
+            if (child->stderr_fd() >= 0) read_stderr();
+            break;
+        }
+
+        int wait_ms = 100;
+        if (has_deadline) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now());
+            if (remaining.count() <= 0) {
+                result.timed_out = true;
+                break;
+            }
+            wait_ms = static_cast<int>(std::min<long long>(remaining.count(), wait_ms));
+        }
+
+        pollfd fds[3];
+        nfds_t count = 0;
+        int stdout_index = -1, stderr_index = -1, stdin_index = -1;
+        if (child->stdout_fd() >= 0) {
+            stdout_index = count;
+            fds[count++] = {child->stdout_fd(), POLLIN, 0};
+        }
+        if (child->stderr_fd() >= 0) {
+            stderr_index = count;
+            fds[count++] = {child->stderr_fd(), POLLIN, 0};
+        }
+        if (child->stdin_fd() >= 0) {
+            stdin_index = count;
+            fds[count++] = {child->stdin_fd(), POLLOUT, 0};
+        }
+
+        int ready = poll(fds, count, wait_ms);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        if (stdout_index >= 0 && fds[stdout_index].revents) {
+            read_stdout();
+        }
+        if (stderr_index >= 0 && fds[stderr_index].revents) {
+            read_stderr();
+        }
+        if (stdin_index >= 0 && fds[stdin_index].revents) {
+            if (fds[stdin_index].revents & (POLLERR | POLLHUP)) {
+                child->close_stdin();
+            } else {
+                ssize_t n = write(child->stdin_fd(), options.stdin_data.data() + stdin_offset,
+                                  options.stdin_data.size() - stdin_offset);
+                if (n > 0) {
+                    stdin_offset += static_cast<size_t>(n);
+                } else if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                    child->close_stdin();
+                }
+                if (stdin_offset >= options.stdin_data.size()) {
+                    child->close_stdin();
+                }
+            }
+        }
+    }
+    child->close_stdin();
+
+    // Outputs are closed; wait for the exit itself, still bounded by the deadline
+    if (!result.timed_out && !child->wait(false)) {
+        if (!has_deadline) {
+            child->wait(true);
+        } else {
+            int sleep_ms = 1;
+            while (!child->wait(false)) {
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now());
+                if (remaining.count() <= 0) {
+                    result.timed_out = true;
+                    break;
+                }
+                poll(nullptr, 0, static_cast<int>(std::min<long long>(remaining.count(), sleep_ms)));
+                sleep_ms = std::min(sleep_ms * 2, 50);
+            }
+        }
+    }
+
+    if (result.timed_out) {
+        child->kill_group(SIGKILL);
+        child->wait(true);
+    }
+
+    int status = child->get_status();
+    if (WIFEXITED(status)) {
+        result.exit_code = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        result.term_signal = WTERMSIG(status);
+    }
+
+    const struct rusage& usage = child->get_usage();
+    result.user_seconds = to_seconds(usage.ru_utime);
+    result.system_seconds = to_seconds(usage.ru_stime);
+#ifdef __APPLE__
+    result.max_rss_kb = usage.ru_maxrss / 1024;
+#else
+    result.max_rss_kb = usage.ru_maxrss;
+#endif
+    result.wall_time = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start_time);
+
+    return result;
+}
+
+} // namespace process
+} // namespace neoneo
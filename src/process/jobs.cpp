@@ -0,0 +1,283 @@
+#include "../../include/neoneo/process/jobs.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace neoneo {
+namespace process {
+
+namespace {
+
+// Between SIGTERM and SIGKILL
+constexpr std::chrono::seconds KILL_GRACE{3};
+
+// Finished jobs remembered for status and output, beyond the running ones
+constexpr size_t MAX_FINISHED = 32;
+
+std::string format_seconds(std::chrono::milliseconds elapsed) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1fs", elapsed.count() / 1000.0);
+    return text;
+}
+
+} // namespace
+
+std::string JobStatus::describe() const {
+    std::string text;
+    if (running) {
+        text = "running for " + format_seconds(elapsed);
+    } else if (timed_out) {
+        text = "killed at its time limit after " + format_seconds(elapsed);
+    } else if (killed) {
+        text = "killed after " + format_seconds(elapsed);
+    } else if (term_signal != 0) {
+        text = "terminated by signal " + std::to_string(term_signal) + " after " + format_seconds(elapsed);
+    } else {
+        text = "exit code " + std::to_string(exit_code) + " after " + format_seconds(elapsed);
+    }
+    text += ", " + std::to_string(output_bytes) + " bytes of output";
+    if (dropped_bytes > 0) {
+        text += " (first " + std::to_string(dropped_bytes) + " dropped)";
+    }
+    return text;
+}
+
+JobManager::JobManager(size_t max_running, size_t max_output_bytes)
+    : max_running(max_running), max_output_bytes(max_output_bytes) {}
+
+JobManager::~JobManager() {
+    stop_all();
+}
+
+int JobManager::start(const std::string& command, const std::string& working_directory,
+                      std::chrono::seconds time_limit, std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t running = 0;
+    size_t finished = 0;
+    for (const auto& [id, job] : jobs) {
+        ++(job->status.running ? running : finished);
+    }
+    if (running >= max_running) {
+        error = "Too many jobs running (" + std::to_string(running) + "); wait for or kill one first";
+        return -1;
+    }
+    // Forget the oldest finished jobs
+    for (auto it = jobs.begin(); it != jobs.end() && finished >= MAX_FINISHED;) {
+        if (!it->second->status.running) {
+            it->second->reader.join();
+            it = jobs.erase(it);
+            --finished;
+        } else {
+            ++it;
+        }
+    }
+
+    auto job = std::make_unique<Job>();
+    job->child = ChildProcess::spawn({"/bin/bash", "-c", command}, working_directory, {}, error);
+    if (!job->child) {
+        return -1;
+    }
+    job->child->close_stdin();
+
+    int id = next_id++;
+    job->status.id = id;
+    job->status.command = command;
+    job->status.working_directory = working_directory;
+    job->status.running = true;
+    job->started = std::chrono::steady_clock::now();
+    if (time_limit.count() > 0) {
+        job->deadline = job->started + time_limit;
+    }
+    Job& started = *job;
+    jobs[id] = std::move(job);
+    started.reader = std::thread([this, &started] { collect(started); });
+    return id;
+}
+
+void JobManager::append(Job& job, const char* data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    job.output.append(data, size);
+    job.status.output_bytes += size;
+    if (job.output.size() > max_output_bytes) {
+        // Drop a quarter at a time rather than a little on every read
+        size_t drop = job.output.size() - max_output_bytes * 3 / 4;
+        job.output.erase(0, drop);
+        job.status.dropped_bytes += drop;
+    }
+}
+
+void JobManager::collect(Job& job) {
+    using clock = std::chrono::steady_clock;
+    ChildProcess& child = *job.child;
+    char buffer[65536];
+    auto drain = [&](int fd) {
+        while (true) {
+            ssize_t n = ::read(fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                append(job, buffer, static_cast<size_t>(n));
+                continue;
+            }
+            return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+        }
+    };
+
+    bool terminated = false;
+    clock::time_point kill_at{};
+    while (true) {
+        // Background processes may keep the pipes open after the job itself exited
+        if (child.wait(false)) {
+            if (child.stdout_fd() >= 0) drain(child.stdout_fd());
+            if (child.stderr_fd() >= 0) drain(child.stderr_fd());
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto now = clock::now();
+            bool expired = job.deadline != clock::time_point{} && now >= job.deadline;
+            if (job.force_kill) {
+                child.kill_group(SIGKILL);
+            } else if ((job.kill_requested || expired) && !terminated) {
+                job.status.timed_out = expired && !job.kill_requested;
+                job.status.killed = true;
+                child.kill_group(SIGTERM);
+                terminated = true;
+                kill_at = now + KILL_GRACE;
+            } else if (terminated && now >= kill_at) {
+                child.kill_group(SIGKILL);
+            }
+        }
+
+        pollfd fds[2];
+        nfds_t count = 0;
+        if (child.stdout_fd() >= 0) {
+            fds[count++] = {child.stdout_fd(), POLLIN, 0};
+        }
+        if (child.stderr_fd() >= 0) {
+            fds[count++] = {child.stderr_fd(), POLLIN, 0};
+        }
+        // Also wakes up to notice exits, kill requests and the deadline
+        int ready = poll(count > 0 ? fds : nullptr, count, 100);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        for (nfds_t i = 0; i < count && ready > 0; ++i) {
+            if (fds[i].revents && !drain(fds[i].fd)) {
+                if (fds[i].fd == child.stdout_fd()) {
+                    child.close_stdout();
+                } else {
+                    child.close_stderr();
+                }
+            }
+        }
+    }
+    child.close_stdout();
+    child.close_stderr();
+    child.wait(true);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    int status = child.get_status();
+    if (WIFEXITED(status)) {
+        job.status.exit_code = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        job.status.term_signal = WTERMSIG(status);
+    }
+    job.status.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - job.started);
+    job.status.running = false;
+    changed.notify_all();
+}
+
+JobStatus JobManager::snapshot(const Job& job) const {
+    JobStatus status = job.status;
+    if (status.running) {
+        status.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - job.started);
+    }
+    return status;
+}
+
+bool JobManager::status(int id, JobStatus& status) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(id);
+    if (it == jobs.end()) {
+        return false;
+    }
+    status = snapshot(*it->second);
+    return true;
+}
+
+std::vector<JobStatus> JobManager::list() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<JobStatus> statuses;
+    for (const auto& [id, job] : jobs) {
+        statuses.push_back(snapshot(*job));
+    }
+    return statuses;
+}
+
+bool JobManager::read(int id, uint64_t offset, size_t max_bytes, JobOutput& output) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(id);
+    if (it == jobs.end()) {
+        return false;
+    }
+    const Job& job = *it->second;
+    uint64_t first = job.status.dropped_bytes;
+    uint64_t end = first + job.output.size();
+    output.offset = std::min(std::max(offset, first), end);
+    size_t count = static_cast<size_t>(std::min<uint64_t>(max_bytes, end - output.offset));
+    output.data = job.output.substr(static_cast<size_t>(output.offset - first), count);
+    output.next = output.offset + count;
+    output.running = job.status.running;
+    return true;
+}
+
+bool JobManager::wait(int id, std::chrono::milliseconds timeout, JobStatus& status) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = jobs.find(id);
+    if (it == jobs.end()) {
+        return false;
+    }
+    Job& job = *it->second;
+    changed.wait_for(lock, timeout, [&] { return !job.status.running; });
+    status = snapshot(job);
+    return true;
+}
+
+bool JobManager::kill(int id, JobStatus& status) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = jobs.find(id);
+    if (it == jobs.end()) {
+        return false;
+    }
+    Job& job = *it->second;
+    if (job.status.running) {
+        job.kill_requested = true;
+        changed.wait_for(lock, KILL_GRACE + std::chrono::seconds(1), [&] { return !job.status.running; });
+    }
+    status = snapshot(job);
+    return true;
+}
+
+void JobManager::stop_all() {
+    std::map<int, std::unique_ptr<Job>> stopping;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& [id, job] : jobs) {
+            job->status.killed = job->status.killed || job->status.running;
+            job->force_kill = true;
+        }
+        stopping.swap(jobs);
+    }
+    // The reader threads kill their process groups within one poll interval
+    for (auto& [id, job] : stopping) {
+        job->reader.join();
+    }
+}
+
+} // namespace process
+} // namespace neoneo
@@ -0,0 +1,309 @@
+#include "../../include/neoneo/process/shell_session.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace neoneo {
+namespace process {
+
+namespace {
+
+// Quote a string for bash as a single-quoted word
+std::string shell_quote(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    quoted += "'";
+    return quoted;
+}
+
+// Output of one stream up to the command's sentinel line.
+// Bytes beyond the cap are dropped, keeping just enough to find the sentinel.
+struct FramedCapture {
+    const std::string& marker;
+    size_t max_bytes;
+    const OutputCallback& on_output;
+    OutputStream stream;
+    std::string data;
+    size_t marker_pos = std::string::npos;
+    size_t line_end = std::string::npos;
+    size_t received = 0;
+    size_t shown = 0; // Bytes of data passed to on_output
+    bool truncated = false;
+    bool closed = false;
+
+    FramedCapture(const std::string& marker, size_t max_bytes, const OutputCallback& on_output, OutputStream stream)
+        : marker(marker), max_bytes(max_bytes), on_output(on_output), stream(stream) {}
+
+    bool complete() const { return line_end != std::string::npos; }
+
+    void feed(const char* bytes, size_t count) {
+        received += count;
+        size_t search_from = data.size() >= marker.size() ? data.size() - marker.size() + 1 : 0;
+        data.append(bytes, count);
+
+        if (marker_pos == std::string::npos) {
+            marker_pos = data.find(marker, search_from);
+        }
+        if (on_output) {
+            // Hold back an end that could still turn out to be the start of the marker. A
+            // lone newline is let through, or every line would wait for the next one; if
+            // it does start the marker, the extra newline is all that is shown of it.
+            size_t safe = marker_pos;
+            if (safe == std::string::npos) {
+                size_t held = std::min(data.size(), marker.size() - 1);
+                while (held >= 2 && data.compare(data.size() - held, held, marker, 0, held) != 0) {
+                    --held;
+                }
+                safe = data.size() - (held >= 2 ? held : 0);
+            }
+            if (safe > shown) {
+                on_output(stream, std::string_view(data).substr(shown, safe - shown));
+                shown = safe;
+            }
+        }
+        if (marker_pos != std::string::npos) {
+            line_end = data.find('\n', marker_pos + marker.size());
+        } else if (data.size() > max_bytes + marker.size()) {
+            // Keep the capped prefix plus a tail long enough to hold a split marker
+            size_t dropped = data.size() - max_bytes - marker.size();
+            data.erase(max_bytes, dropped);
+            shown = shown > max_bytes + dropped ? shown - dropped : std::min(shown, max_bytes);
+            truncated = true;
+        }
+    }
+
+    // The command is over: pass on what was held back, if the marker never came
+    void show_rest() {
+        size_t end = std::min(marker_pos, data.size());
+        if (on_output && end > shown) {
+            on_output(stream, std::string_view(data).substr(shown, end - shown));
+            shown = end;
+        }
+    }
+
+    // Everything before the sentinel (or all captured data if it never came)
+    std::string output() {
+        size_t end = std::min(marker_pos, data.size());
+        if (end > max_bytes) {
+            end = max_bytes;
+            truncated = true;
+        }
+        return data.substr(0, end);
+    }
+
+    // Bytes of command output, excluding the sentinel
+    size_t output_bytes() const {
+        if (marker_pos == std::string::npos) {
+            return received;
+        }
+        return received - (data.size() - marker_pos);
+    }
+
+    // Text after the marker on the sentinel line
+    std::string trailer() const {
+        if (!complete()) {
+            return "";
+        }
+        return data.substr(marker_pos + marker.size(), line_end - marker_pos - marker.size());
+    }
+};
+
+// Read what is available into a capture; returns false once the stream is closed
+bool read_into(int fd, FramedCapture& capture) {
+    char buffer[65536];
+    while (true) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            capture.feed(buffer, static_cast<size_t>(n));
+            continue;
+        }
+        if (n == 0) {
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+} // namespace
+
+ShellSession::ShellSession(std::vector<std::string> argv) : argv(std::move(argv)) {
+    std::random_device random;
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%08x%08x", random(), random());
+    nonce = buffer;
+}
+
+ShellSession::~ShellSession() {
+    stop();
+}
+
+bool ShellSession::start(std::string& error) {
+    child = ChildProcess::spawn(argv, cwd, {}, error);
+    if (!child && !cwd.empty()) {
+        // The last working directory may have been removed
+        cwd.clear();
+        child = ChildProcess::spawn(argv, cwd, {}, error);
+    }
+    return child != nullptr;
+}
+
+void ShellSession::stop() {
+    // ChildProcess kills the process group and reaps it on destruction
+    child.reset();
+}
+
+bool ShellSession::is_running() const {
+    return child && !child->has_exited();
+}
+
+SessionCommandResult ShellSession::run(const std::string& command,
+                                       const std::string& working_directory,
+                                       std::chrono::milliseconds timeout,
+                                       size_t max_output_bytes,
+                                       const OutputCallback& on_output) {
+    using clock = std::chrono::steady_clock;
+
+    SessionCommandResult result;
+    auto start_time = clock::now();
+    auto deadline = start_time + timeout;
+
+    // Start or restart the shell if needed
+    if (child && child->wait(false)) {
+        child.reset();
+    }
+    if (!child) {
+        result.session_restarted = sequence > 0;
+        if (!start(result.error)) {
+            return result;
+        }
+    }
+    result.started = true;
+
+    // Sentinel is unique per session and command so output can not fake it
+    std::string marker = "__NEONEO_" + nonce + "_" + std::to_string(++sequence) + "__";
+    std::string line_marker = "\n" + marker;
+
+    std::string script;
+    if (working_directory.empty()) {
+        script = "eval " + shell_quote(command) + " < /dev/null\n";
+    } else {
+        script = "( builtin cd -- " + shell_quote(working_directory) + " && eval " +
+                 shell_quote(command) + " ) < /dev/null\n";
+    }
+    script += "__neoneo_status=$?\n"
+              "printf '\\n%s %d %s\\n' '" + marker + "' \"$__neoneo_status\" \"$PWD\"\n"
+              "printf '\\n%s\\n' '" + marker + "' >&2\n";
+
+    FramedCapture out(line_marker, max_output_bytes, on_output, OutputStream::Stdout);
+    FramedCapture err(line_marker, max_output_bytes, on_output, OutputStream::Stderr);
+    size_t written = 0;
+
+    while (!(out.complete() && err.complete())) {
+        if (out.closed && err.closed) {
+            break;
+        }
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now());
+        if (remaining.count() <= 0) {
+            result.timed_out = true;
+            break;
+        }
+
+        pollfd fds[3];
+        nfds_t count = 0;
+        int out_index = -1, err_index = -1, in_index = -1;
+        if (!out.closed && !out.complete()) {
+            out_index = count;
+            fds[count++] = {child->stdout_fd(), POLLIN, 0};
+        }
+        if (!err.closed && !err.complete()) {
+            err_index = count;
+            fds[count++] = {child->stderr_fd(), POLLIN, 0};
+        }
+        if (written < script.size()) {
+            in_index = count;
+            fds[count++] = {child->stdin_fd(), POLLOUT, 0};
+        }
+        if (count == 0) {
+            break;
+        }
+
+        int ready = poll(fds, count, static_cast<int>(std::min<long long>(remaining.count(), 1000)));
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        if (out_index >= 0 && fds[out_index].revents && !read_into(child->stdout_fd(), out)) {
+            out.closed = true;
+        }
+        if (err_index >= 0 && fds[err_index].revents && !read_into(child->stderr_fd(), err)) {
+            err.closed = true;
+        }
+        if (in_index >= 0 && fds[in_index].revents) {
+            ssize_t n = write(child->stdin_fd(), script.data() + written, script.size() - written);
+            if (n > 0) {
+                written += static_cast<size_t>(n);
+            } else if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                // Shell is gone; its output streams will report EOF
+                written = script.size();
+            }
+        }
+    }
+
+    out.show_rest();
+    err.show_rest();
+    result.stdout_data = out.output();
+    result.stderr_data = err.output();
+    result.stdout_bytes = out.output_bytes();
+    result.stderr_bytes = err.output_bytes();
+    result.stdout_truncated = out.truncated;
+    result.stderr_truncated = err.truncated;
+
+    if (result.timed_out) {
+        // The command is still running; kill the shell and everything it started
+        stop();
+    } else if (out.complete()) {
+        // Trailer is " <status> <cwd>"
+        std::string trailer = out.trailer();
+        size_t space = trailer.find(' ', 1);
+        result.exit_code = std::atoi(trailer.c_str());
+        if (space != std::string::npos) {
+            cwd = trailer.substr(space + 1);
+        }
+    } else {
+        // The shell itself exited (exit, exec, set -e, crash)
+        child->wait(true);
+        int status = child->get_status();
+        if (WIFEXITED(status)) {
+            result.exit_code = WEXITSTATUS(status);
+        } else if (WIFSIGNALED(status)) {
+            result.term_signal = WTERMSIG(status);
+        }
+        stop();
+    }
+
+    result.cwd = cwd;
+    result.wall_time = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start_time);
+    return result;
+}
+
+} // namespace process
+} // namespace neoneo
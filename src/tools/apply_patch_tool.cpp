@@ -0,0 +1,263 @@
+#include "../../include/neoneo/tools/tools.hpp"
+#include "../../include/neoneo/terminal/terminal.hpp"
+#include "../../include/neoneo/io/diff.hpp"
+#include "../../include/neoneo/io/file_transaction.hpp"
+#include "../../include/neoneo/io/patch.hpp"
+#include "../../include/neoneo/io/piece_table.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace neoneo {
+namespace tools {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Preview lines shown per file when asking for confirmation
+constexpr size_t PREVIEW_LINES = 200;
+
+const char* const DEV_NULL = "/dev/null";
+
+// One file the patch touches
+struct PatchJob {
+    const io::FilePatch* patch = nullptr;
+    std::string source; // File read; empty when the patch creates it
+    std::string target; // File written; empty when the patch deletes it
+    std::shared_ptr<const io::MappedFile> file;
+    std::unique_ptr<io::PieceTable> content;
+    std::vector<io::HunkPlacement> placements;
+    io::UnifiedDiff diff;
+};
+
+std::string plural(size_t count, const char* word) {
+    return std::to_string(count) + " " + word + (count == 1 ? "" : "s");
+}
+
+bool starts_with(const std::string& text, const char* prefix) {
+    return text.compare(0, std::strlen(prefix), prefix) == 0;
+}
+
+// Drop count leading components, like patch -p
+bool strip_path(std::string& path, int count) {
+    if (path == DEV_NULL) {
+        return true;
+    }
+    for (int i = 0; i < count; ++i) {
+        size_t slash = path.find('/');
+        if (slash == std::string::npos) {
+            return false;
+        }
+        path.erase(0, slash + 1);
+    }
+    return !path.empty();
+}
+
+} // namespace
+
+ApplyPatchTool::ApplyPatchTool(ToolManager& manager) : ToolBase(manager) {}
+
+std::string ApplyPatchTool::get_description() const {
+    return "Apply a unified diff to one or more files: the cheapest way to make several changes. Hunks are "
+           "found even if lines have moved or whitespace differs; new files use '--- /dev/null' and deleted "
+           "ones '+++ /dev/null'. Nothing is written unless every hunk applies";
+}
+
+nlohmann::json ApplyPatchTool::get_parameters() const {
+    return tool_schema<Args>();
+}
+
+ToolResult ApplyPatchTool::execute(const nlohmann::json& args) {
+    try {
+        // Parse and validate arguments against the declared schema
+        Args parsed;
+        std::string parse_error;
+        if (!parse_args(args, parsed, parse_error)) {
+            return ToolResult::error(parse_error);
+        }
+        if (parsed.strip && *parsed.strip < 0) {
+            return ToolResult::error("strip must be 0 or greater");
+        }
+
+        std::vector<io::FilePatch> patches;
+        std::string error;
+        if (!io::parse_patch(parsed.patch, patches, error)) {
+            return ToolResult::error(error);
+        }
+
+        // Work out which file each part of the patch reads and writes
+        std::vector<PatchJob> jobs;
+        std::vector<fs::path> seen;
+        for (const auto& patch : patches) {
+            PatchJob job;
+            job.patch = &patch;
+            std::string old_path = patch.old_path;
+            std::string new_path = patch.new_path;
+            int strip = parsed.strip.value_or(
+                (old_path == DEV_NULL || starts_with(old_path, "a/")) &&
+                        (new_path == DEV_NULL || starts_with(new_path, "b/")) ? 1 : 0);
+            if (!strip_path(old_path, strip) || !strip_path(new_path, strip)) {
+                return ToolResult::error("Can not remove " + plural(static_cast<size_t>(strip), "path component") +
+                                         " from " + patch.old_path + " or " + patch.new_path);
+            }
+            if (old_path == DEV_NULL && new_path == DEV_NULL) {
+                return ToolResult::error("A file in the patch is both created and deleted");
+            }
+            job.source = old_path == DEV_NULL ? "" : old_path;
+            job.target = new_path == DEV_NULL ? "" : new_path;
+
+            for (const std::string* path : {&job.source, &job.target}) {
+                if (path->empty()) {
+                    continue;
+                }
+                // Security check: Prevent directory traversal
+                if (path->find("..") != std::string::npos) {
+                    return ToolResult::error("Path contains forbidden '..' sequence");
+                }
+                fs::path canonical = fs::weakly_canonical(*path);
+                if (std::find(seen.begin(), seen.end(), canonical) != seen.end() &&
+                    !(path == &job.target && job.target == job.source)) {
+                    return ToolResult::error("File appears more than once in the patch: " + *path +
+                                             " (put all of its hunks under one header)");
+                }
+                seen.push_back(canonical);
+            }
+
+            if (!job.source.empty() && !fs::is_regular_file(job.source)) {
+                return ToolResult::error("File does not exist: " + job.source);
+            }
+            if (!job.target.empty() && job.target != job.source && fs::exists(job.target)) {
+                return ToolResult::error("File already exists: " + job.target);
+            }
+            jobs.push_back(std::move(job));
+        }
+
+        // Apply everything in memory first; nothing is written unless every hunk applies
+        for (auto& job : jobs) {
+            const std::string& name = job.target.empty() ? job.source : job.target;
+            std::string_view original;
+            if (!job.source.empty()) {
+                std::string open_error;
+                job.file = tool_manager.get_content_cache().open(job.source, open_error);
+                if (!job.file) {
+                    return ToolResult::error("Could not open file for reading: " + job.source);
+                }
+                original = job.file->view();
+            }
+            job.content = std::make_unique<io::PieceTable>(original);
+            if (!io::apply_hunks(original, job.patch->hunks, *job.content, job.placements, error)) {
+                return ToolResult::error(name + ": " + error + "; no files were changed");
+            }
+            if (job.target.empty() && job.content->size() > 0) {
+                return ToolResult::error(name + ": the patch deletes the file but its hunks leave " +
+                                         plural(static_cast<size_t>(job.content->size()), "byte") +
+                                         " in it; no files were changed");
+            }
+            job.diff = io::unified_diff(name, original, job.content->changes(), 3, PREVIEW_LINES);
+        }
+
+        std::string summary;
+        size_t added = 0;
+        size_t removed = 0;
+        for (const auto& job : jobs) {
+            summary += (job.target.empty() ? job.source : job.target) + ": " +
+                       plural(job.patch->hunks.size(), "hunk") + ", +" + std::to_string(job.diff.added) + " -" +
+                       std::to_string(job.diff.removed) + " lines";
+            if (job.source.empty()) {
+                summary += " (new file)";
+            } else if (job.target.empty()) {
+                summary += " (deleted)";
+            } else if (job.target != job.source) {
+                summary += " (renamed from " + job.source + ")";
+            }
+            summary += "\n";
+            for (size_t i = 0; i < job.placements.size(); ++i) {
+                const auto& placement = job.placements[i];
+                if (placement.offset == 0 && placement.fuzz == 0 && !placement.whitespace) {
+                    continue;
+                }
+                summary += "  hunk " + std::to_string(i + 1) + " applied at line " + std::to_string(placement.line);
+                if (placement.offset != 0) {
+                    summary += ", offset " + std::string(placement.offset > 0 ? "+" : "") +
+                               std::to_string(placement.offset) + " lines";
+                }
+                if (placement.fuzz > 0) {
+                    summary += ", fuzz " + std::to_string(placement.fuzz);
+                }
+                if (placement.whitespace) {
+                    summary += ", ignoring whitespace";
+                }
+                summary += "\n";
+            }
+            added += job.diff.added;
+            removed += job.diff.removed;
+        }
+        std::string totals = plural(jobs.size(), "file") + ", +" + std::to_string(added) + " -" +
+                             std::to_string(removed) + " lines";
+
+        if (parsed.check) {
+            return ToolResult::success("Patch applies (" + totals + "); no files were changed:\n" + summary);
+        }
+
+        // If auto-confirm is not enabled, require explicit confirmation of all files at once
+        if (!tool_manager.get_config().is_auto_confirm_file_ops()) {
+            std::string paths;
+            std::string details;
+            for (const auto& job : jobs) {
+                const std::string& name = job.target.empty() ? job.source : job.target;
+                paths += (paths.empty() ? "" : ", ") + name;
+                if (job.target.empty()) {
+                    details += name + ": delete\n";
+                } else if (!job.source.empty() && job.target != job.source) {
+                    details += name + ": rename from " + job.source + "\n";
+                }
+                details += job.diff.text;
+            }
+
+            bool confirmed = terminal::confirm_dialog(
+                terminal::ConfirmType::FILE_OPERATION,
+                "The AI is requesting to apply a patch to " + plural(jobs.size(), "file") + ":",
+                paths,
+                details,
+                ""
+            );
+
+            if (!confirmed) {
+                return ToolResult::error("Patch operation denied by user");
+            }
+        }
+
+        // Stage every new file next to its target, then rename them all into place together
+        io::FileTransaction transaction;
+        for (const auto& job : jobs) {
+            if (!job.target.empty()) {
+                // A renamed file keeps its permissions; missing directories are made by the transaction
+                if (!transaction.stage(job.target, *job.content, error, job.source)) {
+                    return ToolResult::error(error + "; no files were changed");
+                }
+            }
+            if (!job.source.empty() && job.source != job.target) {
+                transaction.remove(job.source);
+            }
+        }
+        if (!transaction.commit(error)) {
+            return ToolResult::error(error + "; no files were changed");
+        }
+        for (const auto& job : jobs) {
+            if (!job.source.empty() && job.source != job.target) {
+                tool_manager.get_content_cache().erase(job.source);
+            }
+            if (!job.target.empty()) {
+                tool_manager.get_content_cache().refresh(job.target);
+            }
+        }
+
+        return ToolResult::success("Patch applied (" + totals + "):\n" + summary);
+    } catch (const std::exception& e) {
+        return ToolResult::error("Error applying patch: " + std::string(e.what()));
+    }
+}
+
+} // namespace tools
+} // namespace neoneo
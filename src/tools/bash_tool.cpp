@@ -1,9 +1,9 @@
 #include "../../include/neoneo/tools/tools.hpp"
 #include "../../include/neoneo/terminal/terminal.hpp"
+#include "../../include/neoneo/process/shell_session.hpp"
+#include "../../include/neoneo/tools/live_output.hpp"
 #include <iostream>
 #include <chrono>
-#include <array>
-#include <cstdio>
 #include <vector>
 #include <algorithm>
 #include <regex>
@@ -15,111 +15,96 @@ namespace tools {
 
 BashTool::BashTool(ToolManager& manager) : ToolBase(manager) {}
 
+BashTool::~BashTool() = default;
+
 std::string BashTool::get_description() const {
-    return "Execute bash commands with advanced output handling and formatting. This tool is more powerful than execute_shell_command, with better error detection, command validation, and more comprehensive output.";
+    return "Execute bash commands with advanced output handling and formatting. This tool is more powerful than execute_shell_command, with better error detection, command validation, and more comprehensive output. "
+           "Commands run in a persistent bash session, so the working directory, exported variables and functions carry over between calls.";
+}
+
+void BashTool::reset() {
+    // New conversation, new shell
+    session.reset();
 }
 
 nlohmann::json BashTool::get_parameters() const {
-    return {
-        {"type", "object"},
-        {"required", nlohmann::json::array({"command"})},
-        {"properties", {
-            {"command", {
-                {"type", "string"}, 
-                {"description", "The bash command to execute. Must be a valid bash command."}
-            }},
-            {"timeout", {
-                {"type", "integer"}, 
-                {"description", "Maximum execution time in seconds (1-60). Defaults to 10 seconds."}
-            }},
-            {"working_directory", {
-                {"type", "string"},
-                {"description", "Working directory to execute the command in. Defaults to current directory."}
-            }}
-        }}
-    };
+    return tool_schema<Args>();
 }
 
-bool BashTool::is_command_safe(const std::string& command, std::string& operation_found) {
-    static const std::vector<std::string> blocked_commands = {
-        "rm -rf", "mkfs", "dd if=", "> /dev", "echo > /dev", ">/dev",
-        "sudo rm", "sudo mv", "sudo cp", "reboot", "shutdown",
-        "passwd", "chmod 777", "chmod -R 777", ":(){ :|:& };:", "fork bomb"
-    };
-    
-    for (const auto& blocked : blocked_commands) {
-        if (command.find(blocked) != std::string::npos) {
-            operation_found = blocked;
-            return false;
-        }
+MemoRule BashTool::memo_rule(const nlohmann::json& args) const {
+    // Read-only commands (git status, ls, cat, ...) give the same output until
+    // something changes files or the session; anything else runs every time
+    if (!args.contains("command") || !args["command"].is_string() ||
+        !process::is_read_only_command(args["command"].get<std::string>())) {
+        return MemoRule();
     }
-    
-    return true;
+    MemoRule rule = MemoRule::read_only();
+    rule.reusable = true;
+    rule.until_side_effect = true;
+    rule.max_age = std::chrono::seconds(60); // Other programs change files too
+    return rule;
 }
 
-std::string BashTool::execute_command(const std::string& command, int timeout_seconds, bool& timed_out) {
-    timed_out = false;
-    
-    // Use popen to execute the command and read its output
-    FILE* pipe = popen(command.c_str(), "r");
-    if (!pipe) {
-        return "Error: Failed to execute command";
+std::string BashTool::execute_command(const std::string& command, const std::string& working_directory,
+                                      int timeout_seconds, LiveOutput& live, process::SessionCommandResult& result) {
+    // Run in the conversation's long-lived bash session, started on first use
+    if (!session) {
+        session = std::make_unique<process::ShellSession>();
     }
     
-    // Start the timer
-    auto start_time = std::chrono::steady_clock::now();
-    auto timeout = std::chrono::seconds(timeout_seconds);
-    
-    // Buffer for reading output
-    std::array<char, 4096> buffer;
-    std::string result;
-    size_t max_output_size = 1000000; // 1MB max output
+    // Large outputs are spilled by the tool manager, so the cap only bounds memory
+    result = session->run(command, working_directory, std::chrono::seconds(timeout_seconds),
+                          64 * 1024 * 1024, live.callback()); // 64MB max output per stream
+    live.finish();
     
-    // Read until EOF, timeout, or size limit reached
-    while (!feof(pipe)) {
-        // Check for timeout
-        auto current_time = std::chrono::steady_clock::now();
-        auto elapsed = current_time - start_time;
-        
-        if (elapsed > timeout) {
-            timed_out = true;
-            pclose(pipe);
-            return "Error: Command execution timed out after " + std::to_string(timeout_seconds) + " seconds.";
-        }
-        
-        // Read a chunk of output
-        if (fgets(buffer.data(), buffer.size(), pipe) != nullptr) {
-            result += buffer.data();
-            
-            // Check size limit
-            if (result.size() > max_output_size) {
-                result = result.substr(0, max_output_size);
-                result += "\n... (output truncated due to size limit)";
-                break;
-            }
-        }
+    if (!result.started) {
+        return "Error: " + result.error;
     }
     
-    // Close the pipe and get the exit status
-    int status = pclose(pipe);
-    int exit_code = WEXITSTATUS(status);
+    if (tool_manager.get_config().is_debug_mode()) {
+        terminal::print("bash: " + result.describe_status() + ", cwd " + result.cwd, terminal::MessageType::SYSTEM);
+    }
     
     // Prepare the result string
     std::stringstream formatted_result;
     
-    // Format the result with exit code info
-    if (exit_code == 0) {
+    if (result.session_restarted) {
+        formatted_result << "(Note: the previous bash session ended, so this command ran in a new shell. "
+                         << "Exported variables and functions were reset; the working directory was kept.)\n";
+    }
+    
+    if (result.succeeded()) {
         // Command succeeded
-        if (result.empty()) {
+        if (result.stdout_data.empty() && result.stderr_data.empty() && !result.session_restarted) {
             formatted_result << "Command executed successfully (no output)";
         } else {
-            formatted_result << result;
+            formatted_result << result.stdout_data;
+        }
+    } else if (result.term_signal != 0) {
+        formatted_result << "Command terminated by signal: " << result.term_signal << "\n";
+        if (!result.stdout_data.empty()) {
+            formatted_result << "Output:\n" << result.stdout_data;
         }
     } else {
         // Command failed
-        formatted_result << "Command failed with exit code: " << exit_code << "\n";
-        if (!result.empty()) {
-            formatted_result << "Output:\n" << result;
+        formatted_result << "Command failed with exit code: " << result.exit_code << "\n";
+        if (!result.stdout_data.empty()) {
+            formatted_result << "Output:\n" << result.stdout_data;
+        }
+    }
+    
+    if (result.stdout_truncated) {
+        formatted_result << "\n... (output truncated due to size limit, " << result.stdout_bytes << " bytes total)";
+    }
+    
+    // stderr is captured separately and reported after stdout
+    if (!result.stderr_data.empty()) {
+        if (formatted_result.tellp() > 0) {
+            formatted_result << "\n";
+        }
+        formatted_result << "Stderr:\n" << result.stderr_data;
+        if (result.stderr_truncated) {
+            formatted_result << "\n... (stderr truncated due to size limit, " << result.stderr_bytes << " bytes total)";
         }
     }
     
@@ -128,47 +113,36 @@ std::string BashTool::execute_command(const std::string& command, int timeout_se
 
 ToolResult BashTool::execute(const nlohmann::json& args) {
     try {
-        // Validate command argument
-        if (!args.contains("command") || !args["command"].is_string()) {
-            return ToolResult::error("Missing or invalid 'command' parameter");
+        // Parse and validate arguments against the declared schema
+        Args parsed;
+        std::string parse_error;
+        if (!parse_args(args, parsed, parse_error)) {
+            return ToolResult::error(parse_error);
         }
         
-        std::string command = args["command"].get<std::string>();
+        std::string command = std::move(parsed.command);
         
-        // Extract timeout if provided (default: 10 seconds)
-        int timeout_seconds = 10;
-        if (args.contains("timeout") && args["timeout"].is_number()) {
-            timeout_seconds = args["timeout"].get<int>();
-            // Limit maximum timeout to 60 seconds
-            if (timeout_seconds > 60) {
-                timeout_seconds = 60;
-            } else if (timeout_seconds < 1) {
-                timeout_seconds = 1;
-            }
-        }
+        // Limit maximum timeout to 60 seconds
+        int timeout_seconds = std::clamp(parsed.timeout, 1, 60);
         
-        // Extract working directory if provided
-        if (args.contains("working_directory") && args["working_directory"].is_string()) {
-            std::string working_dir = args["working_directory"].get<std::string>();
-            // Prepend cd command
-            command = "cd \"" + working_dir + "\" && " + command;
-        }
+        // The persistent session applies it with a cd in a subshell, so it does not stick
+        std::string working_directory = parsed.working_directory.value_or("");
         
         // Check for potentially dangerous commands (unless safety checks are disabled)
         if (!tool_manager.get_config().is_shell_safety_ignored()) {
-            std::string operation_found;
-            if (!is_command_safe(command, operation_found)) {
+            process::PolicyVerdict verdict = tool_manager.get_bash_policy().check(command);
+            if (!verdict.allowed) {
                 // Potentially dangerous command found - ask for confirmation
                 bool confirmed = terminal::confirm_dialog(
                     terminal::ConfirmType::SHELL_COMMAND,
                     "The bash command contains a potentially dangerous operation:",
-                    "'" + operation_found + "' found in: " + command,
+                    "'" + verdict.rule + "' matches: " + verdict.command,
                     "This operation could potentially harm your system or delete data.",
                     "Tip: Use --ignore-shell-safety to disable these warnings."
                 );
                 
                 if (!confirmed) {
-                    return ToolResult::error("Command execution aborted due to security concerns with operation: " + operation_found);
+                    return ToolResult::error("Command execution aborted due to security concerns with operation: " + verdict.rule);
                 }
                 // If confirmed, continue with execution
                 terminal::print("Proceeding with execution despite warning.", terminal::MessageType::WARNING);
@@ -180,7 +154,7 @@ ToolResult BashTool::execute(const nlohmann::json& args) {
             bool confirmed = terminal::confirm_dialog(
                 terminal::ConfirmType::SHELL_COMMAND,
                 "The AI is requesting to execute the following bash command:",
-                command,
+                working_directory.empty() ? command : command + "\n  (in " + working_directory + ")",
                 "This command will be executed with your user permissions.",
                 "Use with caution. Some commands may modify your system."
             );
@@ -190,21 +164,23 @@ ToolResult BashTool::execute(const nlohmann::json& args) {
             }
         }
         
-        // Add output redirection to capture both stdout and stderr
-        command += " 2>&1";
-        
-        // Execute the command
-        bool timed_out = false;
-        std::string result = execute_command(command, timeout_seconds, timed_out);
+        // Execute the command, showing its output as it arrives
+        LiveOutput live(tool_manager.is_live_output());
+        process::SessionCommandResult run;
+        std::string output = execute_command(command, working_directory, timeout_seconds, live, run);
         
         // Handle timeout
-        if (timed_out) {
+        if (run.timed_out) {
             return ToolResult::error("Command execution timed out after " + 
-                                  std::to_string(timeout_seconds) + " seconds");
+                                  std::to_string(timeout_seconds) + " seconds; the bash session was restarted");
         }
         
         // Return the command output
-        return ToolResult::success(result);
+        ToolResult result = ToolResult::success(output);
+        if (live.has_output()) {
+            result.display = LiveOutput::describe(run);
+        }
+        return result;
     } catch (const std::exception& e) {
         terminal::print("Error in bash command: " + std::string(e.what()), terminal::MessageType::ERROR);
         return ToolResult::error("Error executing command: " + std::string(e.what()));
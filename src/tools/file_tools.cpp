@@ -1,8 +1,16 @@
 #include "../../include/neoneo/tools/tools.hpp"
 #include "../../include/neoneo/terminal/terminal.hpp"
+#include "../../include/neoneo/conversation/tool_output_aging.hpp"
+#include "../../include/neoneo/io/batch_read.hpp"
+#include "../../include/neoneo/io/diff.hpp"
+#include "../../include/neoneo/io/file_transaction.hpp"
+#include "../../include/neoneo/io/glob.hpp"
+#include "../../include/neoneo/io/piece_table.hpp"
+#include "../../include/neoneo/io/utf8.hpp"
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <vector>
 #include <filesystem>
 
@@ -15,30 +23,26 @@ namespace fs = std::filesystem;
 FileReadTool::FileReadTool(ToolManager& manager) : ToolBase(manager) {}
 
 std::string FileReadTool::get_description() const {
-    return "Read the contents of a file";
+    return "Read the contents of a file. Large files can be read in pieces with "
+           "start_line/end_line or offset/length, or from the end with tail (optionally following "
+           "appended lines for follow_seconds). Reading the same range again returns only what changed "
+           "since the earlier read, while that read is still in the conversation";
 }
 
 nlohmann::json FileReadTool::get_parameters() const {
-    return {
-        {"type", "object"},
-        {"required", nlohmann::json::array({"path"})},
-        {"properties", {
-            {"path", {
-                {"type", "string"}, 
-                {"description", "The path to the file to read"}
-            }}
-        }}
-    };
+    return tool_schema<Args>();
 }
 
 ToolResult FileReadTool::execute(const nlohmann::json& args) {
     try {
-        // Validate path parameter
-        if (!args.contains("path") || !args["path"].is_string()) {
-            return ToolResult::error("Missing or invalid 'path' parameter");
+        // Parse and validate arguments against the declared schema
+        Args parsed;
+        std::string parse_error;
+        if (!parse_args(args, parsed, parse_error)) {
+            return ToolResult::error(parse_error);
         }
         
-        std::string file_path = args["path"].get<std::string>();
+        const std::string& file_path = parsed.path;
         
         // Security check: Prevent directory traversal
         if (file_path.find("..") != std::string::npos) {
@@ -55,29 +59,363 @@ ToolResult FileReadTool::execute(const nlohmann::json& args) {
             return ToolResult::error("Not a regular file: " + file_path);
         }
         
-        // Open the file
-        std::ifstream file(file_path);
-        if (!file.is_open()) {
-            return ToolResult::error("Could not open file: " + file_path);
+        bool by_bytes = parsed.offset || parsed.length;
+        bool by_lines = parsed.start_line || parsed.end_line;
+        bool by_tail = parsed.tail.has_value();
+        if (by_bytes + by_lines + by_tail > 1) {
+            return ToolResult::error("Use only one of offset/length, start_line/end_line or tail");
+        }
+        if (parsed.follow_seconds != 0 && !by_tail) {
+            return ToolResult::error("follow_seconds can only be used with tail");
         }
         
-        // Read the file content
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        std::string content = buffer.str();
+        // Map the file, or reuse the mapping from an earlier call; only the
+        // pages of the requested slice are actually read
+        std::string map_error;
+        auto file = tool_manager.get_content_cache().open(file_path, map_error);
+        if (!file) {
+            return ToolResult::error("Could not open file: " + file_path + " (" + map_error + ")");
+        }
+        std::string_view data = file->view();
+        
+        const size_t max_size = 50000; // 50KB limit per call
+        bool binary = io::looks_binary(data);
         
-        // If the file is too large, truncate it
-        const size_t max_size = 50000; // 50KB limit
-        if (content.size() > max_size) {
-            content = content.substr(0, max_size) + "\n... (content truncated, file too large)";
+        if (by_lines) {
+            long long first = parsed.start_line.value_or(1);
+            if (first < 1) {
+                return ToolResult::error("start_line must be 1 or greater");
+            }
+            if (parsed.end_line && *parsed.end_line < first) {
+                return ToolResult::error("end_line must not be before start_line");
+            }
+            
+            auto start = line_cache.line_offset(*file, static_cast<uint64_t>(first - 1));
+            if (!start) {
+                return ToolResult::error("start_line " + std::to_string(first) + " is past the end of the file (" +
+                                         std::to_string(line_cache.count_lines(*file)) + " lines)");
+            }
+            
+            uint64_t wanted = parsed.end_line ? static_cast<uint64_t>(*parsed.end_line - first + 1) : UINT64_MAX;
+            uint64_t complete_lines = 0;
+            uint64_t end = io::skip_lines(data, *start, wanted, max_size, complete_lines);
+            if (end > *start && end < data.size() && data[end - 1] != '\n') {
+                // A line cut at the budget ends on a whole character
+                uint64_t cut = io::utf8_boundary(data, static_cast<size_t>(end));
+                end = cut > *start ? cut : end;
+            }
+            
+            // A final line without a newline (or one cut at the budget) still counts
+            uint64_t shown = complete_lines + (end > *start && data[end - 1] != '\n' ? 1 : 0);
+            uint64_t last = static_cast<uint64_t>(first) + shown - 1;
+            bool truncated = complete_lines < wanted && end < data.size();
+            
+            std::string header = "[lines " + std::to_string(first) + "-" + std::to_string(last);
+            if (auto total = line_cache.line_count(*file)) {
+                header += " of " + std::to_string(*total);
+            }
+            header += "]\n";
+            
+            std::string footer;
+            if (truncated && complete_lines > 0) {
+                footer = "\n... (truncated at the " + std::to_string(max_size) + " byte limit; continue with start_line=" +
+                         std::to_string(last + 1) + ")";
+            } else if (truncated) {
+                // A single line over the budget: starting at it again would give the same text
+                footer = "\n... (line " + std::to_string(last) + " is longer than the " + std::to_string(max_size) +
+                         " byte limit; continue with offset=" + std::to_string(end) + ")";
+            }
+            return since_last_read(parsed, "lines " + std::to_string(first) + "-" +
+                                               (parsed.end_line ? std::to_string(*parsed.end_line) : ""),
+                                   header, std::string(data.substr(*start, end - *start)), footer,
+                                   static_cast<size_t>(first));
         }
         
-        return ToolResult::success(content);
+        if (by_tail) {
+            if (*parsed.tail < 1) {
+                return ToolResult::error("tail must be 1 or greater");
+            }
+            if (!(parsed.follow_seconds >= 0 && parsed.follow_seconds <= 30)) {
+                return ToolResult::error("follow_seconds must be between 0 and 30");
+            }
+            
+            // Scan back from the end; the rest of the file is never touched
+            uint64_t lines = 0;
+            uint64_t start = io::tail_offset(data, static_cast<uint64_t>(*parsed.tail), lines);
+            bool truncated = false;
+            if (data.size() - start > max_size) {
+                // Keep the newest lines that fit, starting at a line boundary
+                uint64_t cut = data.size() - max_size;
+                size_t newline = data.find('\n', static_cast<size_t>(cut - 1));
+                start = newline != std::string_view::npos && newline + 1 < data.size()
+                            ? newline + 1
+                            : io::utf8_boundary(data, static_cast<size_t>(cut));
+                lines = io::count_newlines(data.data() + start, static_cast<size_t>(data.size() - start)) +
+                        (data.back() != '\n' ? 1 : 0);
+                truncated = true;
+            }
+            
+            std::string content = "[last " + std::to_string(lines) + " lines, bytes " + std::to_string(start) + "-" +
+                                  std::to_string(data.size()) + " of " + std::to_string(data.size()) + "]\n";
+            if (truncated) {
+                content += "... (earlier lines exceed the " + std::to_string(max_size) +
+                           " byte limit; read them with offset/length ending at offset " + std::to_string(start) + ")\n";
+            }
+            content.append(data.substr(static_cast<size_t>(start)));
+            
+            if (parsed.follow_seconds > 0) {
+                size_t budget = content.size() < max_size ? max_size - content.size() : 0;
+                io::FollowResult follow = io::follow_file(file_path, data.size(), parsed.follow_seconds,
+                                                          std::max<size_t>(budget, 4096));
+                if (!content.empty() && content.back() != '\n') {
+                    content += "\n";
+                }
+                char seconds[32];
+                std::snprintf(seconds, sizeof(seconds), "%g", parsed.follow_seconds);
+                content += "[followed for up to " + std::string(seconds) + "s: " + std::to_string(follow.data.size()) +
+                           " new bytes";
+                switch (follow.end) {
+                case io::FollowEnd::Timeout:
+                    break;
+                case io::FollowEnd::Limit:
+                    content += ", stopped at the output limit; continue with offset=" + std::to_string(follow.offset);
+                    break;
+                case io::FollowEnd::Truncated:
+                    content += ", stopped because the file was truncated";
+                    break;
+                case io::FollowEnd::Replaced:
+                    content += ", stopped because the file was replaced or removed";
+                    break;
+                case io::FollowEnd::Error:
+                    content += ", stopped on error: " + follow.error;
+                    break;
+                }
+                content += "]\n" + follow.data;
+            }
+            return ToolResult::success(content);
+        }
+        
+        if (by_bytes) {
+            long long offset = parsed.offset.value_or(0);
+            long long length = parsed.length.value_or(static_cast<long long>(max_size));
+            if (offset < 0 || length < 0) {
+                return ToolResult::error("offset and length must not be negative");
+            }
+            if (static_cast<uint64_t>(offset) > data.size()) {
+                return ToolResult::error("offset is past the end of the file (" + std::to_string(data.size()) + " bytes)");
+            }
+            
+            // Escaped binary takes up to four bytes per byte
+            uint64_t limit = binary ? max_size / 4 : max_size;
+            uint64_t count = std::min<uint64_t>({static_cast<uint64_t>(length), limit, data.size() - offset});
+            if (!binary && count < static_cast<uint64_t>(length) && offset + count < data.size()) {
+                // Stop before a character the limit would split, so the next read starts on it
+                uint64_t cut = io::utf8_boundary(data, static_cast<size_t>(offset + count));
+                count = cut > static_cast<uint64_t>(offset) ? cut - offset : count;
+            }
+            std::string slice(data.substr(static_cast<size_t>(offset), static_cast<size_t>(count)));
+            if (binary) {
+                io::sanitize_utf8(slice, io::Utf8Repair::Escape);
+            }
+            std::string header = "[bytes " + std::to_string(offset) + "-" + std::to_string(offset + count) +
+                                 " of " + std::to_string(data.size()) +
+                                 (binary ? ", binary; bytes that are not UTF-8 are shown as \\xNN" : "") + "]\n";
+            std::string footer;
+            if (count < static_cast<uint64_t>(length) && offset + count < data.size()) {
+                footer = "\n... (truncated at the " + std::to_string(limit) + " byte limit; continue with offset=" +
+                         std::to_string(offset + count) + ")";
+            }
+            return since_last_read(parsed, "bytes " + std::to_string(offset) + "+" + std::to_string(length), header,
+                                   std::move(slice), footer);
+        }
+        
+        // No range given: the start of the file, as before, unless it is not text
+        if (binary) {
+            return ToolResult::success("[" + file_path + " is a binary file (" + std::to_string(data.size()) +
+                                       " bytes); read a byte range with offset/length to see its bytes]");
+        }
+        std::string content(data.substr(0, data.size() > max_size ? io::utf8_boundary(data, max_size) : max_size));
+        std::string footer;
+        if (data.size() > max_size) {
+            footer = "\n... (content truncated, file is " + std::to_string(data.size()) +
+                     " bytes; use start_line/end_line or offset/length to read more)";
+        }
+        
+        return since_last_read(parsed, "", "", std::move(content), footer);
     } catch (const std::exception& e) {
         return ToolResult::error("Error reading file: " + std::string(e.what()));
     }
 }
 
+ToolResult FileReadTool::since_last_read(const Args& parsed, const std::string& range, const std::string& header,
+                                         std::string content, const std::string& footer, size_t first_line) {
+    // Reads that used to be in the conversation are still there until aging stubs them out
+    const auto& config = tool_manager.get_config();
+    conversation::AgingPolicy policy;
+    policy.max_age_turns = config.get_tool_output_max_age();
+    policy.max_bytes = config.get_tool_output_max_bytes();
+    
+    int turn = tool_manager.get_turn();
+    std::string key = fs::path(parsed.path).lexically_normal().string() + "\n" + range;
+    uint64_t hash = conversation::ToolOutputAging::hash_content(content);
+    std::string what = range.empty() ? parsed.path : parsed.path + " (" + range + ")";
+    
+    auto it = past_reads.find(key);
+    if (it != past_reads.end() && !parsed.full && !policy.is_aged(turn - it->second.turn, it->second.size)) {
+        PastRead& past = it->second;
+        if (past.hash == hash && past.content == content) {
+            return ToolResult::success(header + "[" + what + ": no changes since the last read (returned in full in "
+                                       "turn " + std::to_string(past.turn) + ")]" + footer);
+        }
+        
+        // A diff is only worth it while it is much smaller than the content itself. Only the
+        // content is compared; the header and footer describe the range and are sent as they are.
+        io::UnifiedDiff diff = io::unified_diff(parsed.path, past.content, io::line_changes(past.content, content), 3,
+                                                400, first_line);
+        size_t limit = content.size() / 2;
+        if (policy.max_bytes > 0) {
+            limit = std::min(limit, policy.max_bytes);
+        }
+        if (!diff.truncated && diff.text.size() <= limit) {
+            past.hash = hash;
+            past.content = std::move(content);
+            return ToolResult::success(header + "[" + what + ": +" + std::to_string(diff.added) + " -" +
+                                       std::to_string(diff.removed) + " lines since the last read (returned in full "
+                                       "in turn " + std::to_string(past.turn) + "); read with full=true for all of it]\n" +
+                                       diff.text + footer);
+        }
+    }
+    
+    // Keep only the most recent reads
+    const size_t max_past_reads = 128;
+    if (it == past_reads.end() && past_reads.size() >= max_past_reads) {
+        past_reads.erase(std::min_element(past_reads.begin(), past_reads.end(), [](const auto& a, const auto& b) {
+            return a.second.turn < b.second.turn;
+        }));
+    }
+    std::string full = header + content + footer;
+    past_reads[key] = PastRead{turn, full.size(), hash, std::move(content)};
+    return ToolResult::success(full);
+}
+
+void FileReadTool::reset() {
+    past_reads.clear();
+}
+
+// Multi-File Read Tool Implementation
+MultiFileReadTool::MultiFileReadTool(ToolManager& manager) : ToolBase(manager) {}
+
+std::string MultiFileReadTool::get_description() const {
+    return "Read several files in one call. Accepts a list of paths and glob patterns and returns the "
+           "files one after another, each under a '===== path =====' header. Prefer this over "
+           "repeated read_file calls";
+}
+
+nlohmann::json MultiFileReadTool::get_parameters() const {
+    return tool_schema<Args>();
+}
+
+ToolResult MultiFileReadTool::execute(const nlohmann::json& args) {
+    try {
+        // Parse and validate arguments against the declared schema
+        Args parsed;
+        std::string parse_error;
+        if (!parse_args(args, parsed, parse_error)) {
+            return ToolResult::error(parse_error);
+        }
+        
+        const size_t max_files = 100;
+        if (parsed.paths.empty()) {
+            return ToolResult::error("No paths given");
+        }
+        if (parsed.max_bytes_per_file < 1 || parsed.max_bytes_per_file > 50000) {
+            return ToolResult::error("max_bytes_per_file must be between 1 and 50000");
+        }
+        if (parsed.max_total_bytes < 1 || parsed.max_total_bytes > 200000) {
+            return ToolResult::error("max_total_bytes must be between 1 and 200000");
+        }
+        
+        // Expand globs, keeping the order the paths were given in and dropping repeats
+        std::vector<std::string> paths;
+        std::vector<std::string> notes;
+        bool too_many = false;
+        for (const std::string& pattern : parsed.paths) {
+            // Security check: Prevent directory traversal
+            if (pattern.find("..") != std::string::npos) {
+                return ToolResult::error("Path contains forbidden '..' sequence: " + pattern);
+            }
+            
+            std::vector<std::string> matches;
+            if (io::has_glob_chars(pattern)) {
+                bool truncated = false;
+                matches = io::expand_glob(pattern, max_files, truncated);
+                too_many = too_many || truncated;
+                if (matches.empty()) {
+                    notes.push_back("No files match " + pattern);
+                }
+            } else {
+                matches.push_back(pattern);
+            }
+            for (std::string& match : matches) {
+                if (std::find(paths.begin(), paths.end(), match) == paths.end()) {
+                    paths.push_back(std::move(match));
+                }
+            }
+        }
+        if (paths.size() > max_files) {
+            paths.resize(max_files);
+            too_many = true;
+        }
+        if (too_many) {
+            notes.push_back("Only the first " + std::to_string(paths.size()) + " files are read; narrow the patterns to see the rest");
+        }
+        
+        std::vector<io::FileContent> files = io::read_batch(paths, static_cast<size_t>(parsed.max_bytes_per_file),
+                                                            static_cast<size_t>(parsed.max_total_bytes),
+                                                            &tool_manager.get_content_cache());
+        
+        size_t total = 0;
+        for (const auto& file : files) {
+            total += file.data.size();
+        }
+        
+        std::string content = "[" + std::to_string(files.size()) + " files, " + std::to_string(total) + " bytes]\n";
+        content.reserve(total + files.size() * 64 + 256);
+        for (const auto& note : notes) {
+            content += note + "\n";
+        }
+        for (const auto& file : files) {
+            content += "\n===== " + file.path;
+            if (!file.error.empty()) {
+                content += " (error: " + file.error + ") =====\n";
+                continue;
+            }
+            if (file.binary) {
+                content += " (binary file, " + std::to_string(file.size) + " bytes, not shown) =====\n";
+                continue;
+            }
+            if (file.truncated && file.data.empty()) {
+                content += " (" + std::to_string(file.size) + " bytes, not read: the total byte budget is used up) =====\n";
+                continue;
+            }
+            if (file.truncated) {
+                content += " (first " + std::to_string(file.data.size()) + " of " + std::to_string(file.size) +
+                           " bytes; use read_file with offset=" + std::to_string(file.data.size()) + " for more) =====\n";
+            } else {
+                content += " (" + std::to_string(file.size) + " bytes) =====\n";
+            }
+            content += file.data;
+            if (!file.data.empty() && file.data.back() != '\n') {
+                content += "\n";
+            }
+        }
+        
+        return ToolResult::success(content);
+    } catch (const std::exception& e) {
+        return ToolResult::error("Error reading files: " + std::string(e.what()));
+    }
+}
+
 // File Write Tool Implementation
 FileWriteTool::FileWriteTool(ToolManager& manager) : ToolBase(manager) {}
 
@@ -86,35 +424,20 @@ std::string FileWriteTool::get_description() const {
 }
 
 nlohmann::json FileWriteTool::get_parameters() const {
-    return {
-        {"type", "object"},
-        {"required", nlohmann::json::array({"path", "content"})},
-        {"properties", {
-            {"path", {
-                {"type", "string"}, 
-                {"description", "The path to the file to write"}
-            }},
-            {"content", {
-                {"type", "string"}, 
-                {"description", "The content to write to the file"}
-            }}
-        }}
-    };
+    return tool_schema<Args>();
 }
 
 ToolResult FileWriteTool::execute(const nlohmann::json& args) {
     try {
-        // Validate parameters
-        if (!args.contains("path") || !args["path"].is_string()) {
-            return ToolResult::error("Missing or invalid 'path' parameter");
+        // Parse and validate arguments against the declared schema
+        Args parsed;
+        std::string parse_error;
+        if (!parse_args(args, parsed, parse_error)) {
+            return ToolResult::error(parse_error);
         }
         
-        if (!args.contains("content") || !args["content"].is_string()) {
-            return ToolResult::error("Missing or invalid 'content' parameter");
-        }
-        
-        std::string file_path = args["path"].get<std::string>();
-        std::string content = args["content"].get<std::string>();
+        const std::string& file_path = parsed.path;
+        std::string_view content = parsed.content;
         
         // Security check: Prevent directory traversal
         if (file_path.find("..") != std::string::npos) {
@@ -124,9 +447,9 @@ ToolResult FileWriteTool::execute(const nlohmann::json& args) {
         // If auto-confirm is not enabled, require explicit confirmation
         if (!tool_manager.get_config().is_auto_confirm_file_ops()) {
             // Truncate content preview if too long
-            std::string content_preview = content;
-            if (content_preview.length() > 200) {
-                content_preview = content_preview.substr(0, 200) + "... (truncated)";
+            std::string content_preview(content.substr(0, 200));
+            if (content.length() > 200) {
+                content_preview += "... (truncated)";
             }
             
             bool confirmed = terminal::confirm_dialog(
@@ -156,6 +479,7 @@ ToolResult FileWriteTool::execute(const nlohmann::json& args) {
         
         file << content;
         file.close();
+        tool_manager.get_content_cache().refresh(file_path);
         
         return ToolResult::success("File successfully written: " + file_path + 
                                  " (" + std::to_string(content.size()) + " bytes)");
@@ -165,223 +489,247 @@ ToolResult FileWriteTool::execute(const nlohmann::json& args) {
 }
 
 // File Edit Tool Implementation
+namespace {
+
+// Preview lines shown per file when asking for confirmation
+constexpr size_t PREVIEW_LINES = 200;
+
+// Apply one edit to content; returns what is wrong with it, or "" if it applied
+std::string apply_edit(io::PieceTable& content, const FileEditTool::Edit& edit) {
+    int operations = (edit.replace_all ? 1 : 0) + (edit.old_text ? 1 : 0) + (edit.append ? 1 : 0) +
+                     (edit.prepend ? 1 : 0) + (edit.insert_at_line ? 1 : 0);
+    if (operations != 1) {
+        return "No valid edit operation specified. Use 'replace_all', 'old_text'+'new_text', 'append', "
+               "'prepend', or 'insert_at_line'+'text'";
+    }
+
+    if (edit.replace_all) {
+        content.replace(0, content.size(), *edit.replace_all);
+    } else if (edit.old_text) {
+        std::string_view old_text = *edit.old_text;
+        if (!edit.new_text) {
+            return "'old_text' needs 'new_text'";
+        }
+        if (old_text.empty()) {
+            return "'old_text' must not be empty";
+        }
+        std::string_view new_text = *edit.new_text;
+
+        if (edit.all) {
+            if (content.replace_every(old_text, new_text) == 0) {
+                return "Could not find the text to replace in the file";
+            }
+            return "";
+        }
+
+        int occurrence = edit.occurrence.value_or(1);
+        if (occurrence < 1) {
+            return "'occurrence' must be 1 or greater";
+        }
+        auto pos = content.find(old_text);
+        int found = pos ? 1 : 0;
+        while (pos && found < occurrence) {
+            pos = content.find(old_text, *pos + old_text.size());
+            found += pos ? 1 : 0;
+        }
+        if (!pos) {
+            return found == 0 ? "Could not find the text to replace in the file"
+                              : "The text to replace occurs only " +
+                                    (found == 1 ? std::string("once") : std::to_string(found) + " times");
+        }
+        content.replace(*pos, old_text.size(), new_text);
+    } else if (edit.append) {
+        content.insert(content.size(), *edit.append);
+    } else if (edit.prepend) {
+        content.insert(0, *edit.prepend);
+    } else {
+        if (!edit.text) {
+            return "'insert_at_line' needs 'text'";
+        }
+        // Boundary checking for line number: past the last line appends
+        uint64_t line_number = static_cast<uint64_t>(std::max(*edit.insert_at_line, 0));
+        std::string text(*edit.text);
+
+        if (auto offset = content.line_offset(line_number)) {
+            content.insert(*offset, text + "\n");
+        } else if (content.size() > 0 && content.at(content.size() - 1) != '\n') {
+            content.insert(content.size(), "\n" + text);
+        } else {
+            content.insert(content.size(), text + "\n");
+        }
+    }
+    return "";
+}
+
+// One file being edited: its mapping, the edits applied over it and their diff
+struct EditJob {
+    std::string path;
+    std::vector<const FileEditTool::Edit*> edits;
+    std::shared_ptr<const io::MappedFile> file;
+    std::unique_ptr<io::PieceTable> content;
+    std::vector<io::TextChange> changes;
+    io::UnifiedDiff diff;
+};
+
+std::string plural(size_t count, const char* word) {
+    return std::to_string(count) + " " + word + (count == 1 ? "" : "s");
+}
+
+} // namespace
+
 FileEditTool::FileEditTool(ToolManager& manager) : ToolBase(manager) {}
 
 std::string FileEditTool::get_description() const {
-    return "Edit an existing file (partial edits or replacement)";
+    return "Edit existing files (partial edits or replacement). Give one edit inline, a list of edits for "
+           "path, or several files each with their edits; all edits are checked before any file is written";
 }
 
 nlohmann::json FileEditTool::get_parameters() const {
-    return {
-        {"type", "object"},
-        {"required", nlohmann::json::array({"path"})},
-        {"properties", {
-            {"path", {
-                {"type", "string"}, 
-                {"description", "The path to the file to edit"}
-            }},
-            {"replace_all", {
-                {"type", "string"}, 
-                {"description", "If provided, replaces the entire file content"}
-            }},
-            {"old_text", {
-                {"type", "string"}, 
-                {"description", "The text to find and replace"}
-            }},
-            {"new_text", {
-                {"type", "string"}, 
-                {"description", "The new text to replace with"}
-            }},
-            {"append", {
-                {"type", "string"}, 
-                {"description", "Text to append to the end of the file"}
-            }},
-            {"prepend", {
-                {"type", "string"}, 
-                {"description", "Text to insert at the beginning of the file"}
-            }},
-            {"insert_at_line", {
-                {"type", "integer"}, 
-                {"description", "Line number where to insert text (0-based)"}
-            }},
-            {"text", {
-                {"type", "string"}, 
-                {"description", "Text to insert at the specified line"}
-            }}
-        }}
-    };
+    return tool_schema<Args>();
 }
 
 ToolResult FileEditTool::execute(const nlohmann::json& args) {
     try {
-        // Validate parameters
-        if (!args.contains("path") || !args["path"].is_string()) {
+        // Parse and validate arguments against the declared schema
+        Args parsed;
+        std::string parse_error;
+        if (!parse_args(args, parsed, parse_error)) {
+            return ToolResult::error(parse_error);
+        }
+
+        // Gather the edits per file: inline and listed ones for path, then files
+        std::vector<EditJob> jobs;
+        const Edit& inline_edit = parsed;
+        bool has_inline = inline_edit.replace_all || inline_edit.old_text || inline_edit.new_text ||
+                          inline_edit.append || inline_edit.prepend || inline_edit.insert_at_line || inline_edit.text;
+        if (!parsed.path.empty()) {
+            EditJob job;
+            job.path = parsed.path;
+            if (has_inline) {
+                job.edits.push_back(&inline_edit);
+            }
+            if (parsed.edits) {
+                for (const auto& edit : *parsed.edits) {
+                    job.edits.push_back(&edit);
+                }
+            }
+            if (job.edits.empty()) {
+                return ToolResult::error("No valid edit operation specified. Use 'replace_all', "
+                                         "'old_text'+'new_text', 'append', 'prepend', or "
+                                         "'insert_at_line'+'text'");
+            }
+            jobs.push_back(std::move(job));
+        } else if (has_inline || parsed.edits) {
             return ToolResult::error("Missing or invalid 'path' parameter");
         }
-        
-        std::string file_path = args["path"].get<std::string>();
-        
-        // Security check: Prevent directory traversal
-        if (file_path.find("..") != std::string::npos) {
-            return ToolResult::error("Path contains forbidden '..' sequence");
+        if (parsed.files) {
+            for (const auto& file : *parsed.files) {
+                EditJob job;
+                job.path = file.path;
+                for (const auto& edit : file.edits) {
+                    job.edits.push_back(&edit);
+                }
+                jobs.push_back(std::move(job));
+            }
         }
-        
-        // Check if file exists and read it
-        if (!fs::exists(file_path)) {
-            return ToolResult::error("File does not exist: " + file_path);
+        if (jobs.empty()) {
+            return ToolResult::error("Missing or invalid 'path' parameter");
         }
-        
-        std::ifstream in_file(file_path);
-        if (!in_file.is_open()) {
-            return ToolResult::error("Could not open file for reading: " + file_path);
+
+        std::vector<fs::path> seen;
+        for (const auto& job : jobs) {
+            // Security check: Prevent directory traversal
+            if (job.path.find("..") != std::string::npos) {
+                return ToolResult::error("Path contains forbidden '..' sequence");
+            }
+            // Check if file exists
+            if (!fs::exists(job.path)) {
+                return ToolResult::error("File does not exist: " + job.path);
+            }
+            fs::path canonical = fs::weakly_canonical(job.path);
+            if (std::find(seen.begin(), seen.end(), canonical) != seen.end()) {
+                return ToolResult::error("File is listed more than once: " + job.path +
+                                         " (put all of its edits in one list)");
+            }
+            seen.push_back(canonical);
         }
-        
-        std::stringstream buffer;
-        buffer << in_file.rdbuf();
-        std::string content = buffer.str();
-        in_file.close();
-        
-        // Determine operation type and description for confirmation
-        enum class EditOp { REPLACE_ALL, REPLACE_TEXT, APPEND, PREPEND, INSERT_LINE, UNKNOWN };
-        EditOp operation = EditOp::UNKNOWN;
-        std::string op_description;
-        std::string preview_old;
-        std::string preview_new;
-        
-        if (args.contains("replace_all") && args["replace_all"].is_string()) {
-            operation = EditOp::REPLACE_ALL;
-            op_description = "Replace entire file";
-            preview_new = args["replace_all"].get<std::string>();
-        } else if (args.contains("old_text") && args.contains("new_text") && 
-                   args["old_text"].is_string() && args["new_text"].is_string()) {
-            operation = EditOp::REPLACE_TEXT;
-            op_description = "Replace text in file";
-            preview_old = args["old_text"].get<std::string>();
-            preview_new = args["new_text"].get<std::string>();
-        } else if (args.contains("append") && args["append"].is_string()) {
-            operation = EditOp::APPEND;
-            op_description = "Append to file";
-            preview_new = args["append"].get<std::string>();
-        } else if (args.contains("prepend") && args["prepend"].is_string()) {
-            operation = EditOp::PREPEND;
-            op_description = "Prepend to file";
-            preview_new = args["prepend"].get<std::string>();
-        } else if (args.contains("insert_at_line") && args.contains("text") &&
-                   args["insert_at_line"].is_number() && args["text"].is_string()) {
-            operation = EditOp::INSERT_LINE;
-            op_description = "Insert at line " + std::to_string(args["insert_at_line"].get<int>());
-            preview_new = args["text"].get<std::string>();
-        } else {
-            return ToolResult::error("No valid edit operation specified. Use 'replace_all', "
-                                   "'old_text'+'new_text', 'append', 'prepend', or "
-                                   "'insert_at_line'+'text'");
+
+        // Apply everything in memory first; nothing is written unless every edit applies
+        bool single = jobs.size() == 1 && jobs[0].edits.size() == 1;
+        for (auto& job : jobs) {
+            std::string open_error;
+            job.file = tool_manager.get_content_cache().open(job.path, open_error);
+            if (!job.file) {
+                return ToolResult::error("Could not open file for reading: " + job.path);
+            }
+            job.content = std::make_unique<io::PieceTable>(job.file->view());
+            for (size_t i = 0; i < job.edits.size(); ++i) {
+                std::string problem = apply_edit(*job.content, *job.edits[i]);
+                if (!problem.empty()) {
+                    if (single) {
+                        return ToolResult::error(problem);
+                    }
+                    return ToolResult::error(job.path + ", edit " + std::to_string(i + 1) + ": " + problem +
+                                             "; no files were changed");
+                }
+            }
+            job.changes = job.content->changes();
+            job.diff = io::unified_diff(job.path, job.file->view(), job.changes, 3, PREVIEW_LINES);
         }
-        
-        // If auto-confirm is not enabled, require explicit confirmation
+
+        // If auto-confirm is not enabled, require explicit confirmation of all files at once
         if (!tool_manager.get_config().is_auto_confirm_file_ops()) {
-            // Format preview strings
-            auto format_preview = [](const std::string& text, size_t max_len = 100) -> std::string {
-                if (text.length() > max_len) {
-                    return text.substr(0, max_len) + "... (truncated)";
-                }
-                return text;
-            };
-            
-            std::string details = "Operation: " + op_description;
-            
-            if (operation == EditOp::REPLACE_TEXT) {
-                details += "\nOld Text: " + format_preview(preview_old);
-                details += "\nNew Text: " + format_preview(preview_new);
-            } else if (operation != EditOp::UNKNOWN) {
-                details += "\nNew Content: " + format_preview(preview_new);
+            std::string paths;
+            std::string details;
+            for (const auto& job : jobs) {
+                paths += (paths.empty() ? "" : ", ") + job.path;
+                details += job.diff.text.empty() ? job.path + ": no changes\n" : job.diff.text;
             }
-            
+
             bool confirmed = terminal::confirm_dialog(
                 terminal::ConfirmType::FILE_OPERATION,
-                "The AI is requesting to edit the file:",
-                file_path,
+                jobs.size() == 1 ? "The AI is requesting to edit the file:"
+                                 : "The AI is requesting to edit " + std::to_string(jobs.size()) + " files:",
+                paths,
                 details,
                 ""
             );
-            
+
             if (!confirmed) {
                 return ToolResult::error("File edit operation denied by user");
             }
         }
-        
-        // Perform the requested edit
-        switch (operation) {
-            case EditOp::REPLACE_ALL:
-                content = args["replace_all"].get<std::string>();
-                break;
-                
-            case EditOp::REPLACE_TEXT: {
-                std::string old_text = args["old_text"].get<std::string>();
-                std::string new_text = args["new_text"].get<std::string>();
-                
-                size_t pos = content.find(old_text);
-                if (pos == std::string::npos) {
-                    return ToolResult::error("Could not find the text to replace in the file");
-                }
-                
-                content.replace(pos, old_text.length(), new_text);
-                break;
-            }
-                
-            case EditOp::APPEND:
-                content += args["append"].get<std::string>();
-                break;
-                
-            case EditOp::PREPEND:
-                content = args["prepend"].get<std::string>() + content;
-                break;
-                
-            case EditOp::INSERT_LINE: {
-                int line_number = args["insert_at_line"].get<int>();
-                std::string text = args["text"].get<std::string>();
-                
-                std::stringstream ss(content);
-                std::string line;
-                std::vector<std::string> lines;
-                
-                while (std::getline(ss, line)) {
-                    lines.push_back(line);
-                }
-                
-                // Boundary checking for line number
-                if (line_number < 0) {
-                    line_number = 0;
-                } else if (line_number > (int)lines.size()) {
-                    line_number = (int)lines.size();
-                }
-                
-                lines.insert(lines.begin() + line_number, text);
-                
-                // Reconstruct content
-                content = "";
-                for (size_t i = 0; i < lines.size(); ++i) {
-                    content += lines[i];
-                    if (i < lines.size() - 1) {
-                        content += "\n";
-                    }
+
+        // Stage every changed file next to itself, then rename them all into place together
+        io::FileTransaction transaction;
+        std::string summary;
+        for (const auto& job : jobs) {
+            if (!job.changes.empty()) {
+                std::string save_error;
+                if (!transaction.stage(job.path, *job.content, save_error)) {
+                    return ToolResult::error(save_error + "; no files were changed");
                 }
-                break;
             }
-                
-            case EditOp::UNKNOWN:
-                return ToolResult::error("Unknown edit operation");
+            summary += job.path + ": " + plural(job.edits.size(), "edit") + ", +" + std::to_string(job.diff.added) +
+                       " -" + std::to_string(job.diff.removed) + " lines\n";
         }
-        
-        // Write back to file
-        std::ofstream out_file(file_path);
-        if (!out_file.is_open()) {
-            return ToolResult::error("Could not open file for writing: " + file_path);
+        std::string commit_error;
+        if (!transaction.commit(commit_error)) {
+            return ToolResult::error(commit_error + "; no files were changed");
         }
-        
-        out_file << content;
-        out_file.close();
-        
-        return ToolResult::success("File successfully edited: " + file_path);
+        for (const auto& job : jobs) {
+            if (!job.changes.empty()) {
+                tool_manager.get_content_cache().refresh(job.path);
+            }
+        }
+
+        if (jobs.size() == 1) {
+            return ToolResult::success("File successfully edited: " + jobs[0].path + " (" +
+                                       plural(jobs[0].edits.size(), "edit") + ", +" +
+                                       std::to_string(jobs[0].diff.added) + " -" +
+                                       std::to_string(jobs[0].diff.removed) + " lines)");
+        }
+        return ToolResult::success("Edited " + plural(jobs.size(), "file") + ":\n" + summary);
     } catch (const std::exception& e) {
         return ToolResult::error("Error editing file: " + std::string(e.what()));
     }
@@ -0,0 +1,245 @@
+#include "../../include/neoneo/tools/tools.hpp"
+#include "../../include/neoneo/terminal/terminal.hpp"
+#include <algorithm>
+
+namespace neoneo {
+namespace tools {
+
+namespace {
+
+std::string describe_job(const process::JobStatus& status) {
+    std::string text = "Job " + std::to_string(status.id) + ": " + status.describe() + "\n  " + status.command;
+    if (!status.working_directory.empty()) {
+        text += "\n  (in " + status.working_directory + ")";
+    }
+    return text;
+}
+
+std::string unknown_job(int id) {
+    return "No job with id " + std::to_string(id) + " (see job_status for the current jobs)";
+}
+
+} // namespace
+
+// Start Job Tool Implementation
+StartJobTool::StartJobTool(ToolManager& manager) : ToolBase(manager) {}
+
+std::string StartJobTool::get_description() const {
+    return "Start a long-running bash command (build, test suite, data job) in the background and return "
+           "its job id at once. Use job_status, job_output, wait_job and kill_job with that id; keep working "
+           "on other things while it runs";
+}
+
+nlohmann::json StartJobTool::get_parameters() const {
+    return tool_schema<Args>();
+}
+
+ToolResult StartJobTool::execute(const nlohmann::json& args) {
+    try {
+        // Parse and validate arguments against the declared schema
+        Args parsed;
+        std::string parse_error;
+        if (!parse_args(args, parsed, parse_error)) {
+            return ToolResult::error(parse_error);
+        }
+        if (parsed.time_limit < 1 || parsed.time_limit > 86400) {
+            return ToolResult::error("time_limit must be between 1 and 86400 seconds");
+        }
+        std::string working_directory = parsed.working_directory.value_or("");
+
+        // Same checks and confirmation as the bash tool
+        if (!tool_manager.get_config().is_shell_safety_ignored()) {
+            process::PolicyVerdict verdict = tool_manager.get_bash_policy().check(parsed.command);
+            if (!verdict.allowed) {
+                bool confirmed = terminal::confirm_dialog(
+                    terminal::ConfirmType::SHELL_COMMAND,
+                    "The background job contains a potentially dangerous operation:",
+                    "'" + verdict.rule + "' matches: " + verdict.command,
+                    "This operation could potentially harm your system or delete data.",
+                    "Tip: Use --ignore-shell-safety to disable these warnings."
+                );
+
+                if (!confirmed) {
+                    return ToolResult::error("Job aborted due to security concerns with operation: " + verdict.rule);
+                }
+                terminal::print("Proceeding with execution despite warning.", terminal::MessageType::WARNING);
+            }
+        }
+
+        if (!tool_manager.get_config().is_auto_confirm_shell()) {
+            bool confirmed = terminal::confirm_dialog(
+                terminal::ConfirmType::SHELL_COMMAND,
+                "The AI is requesting to start the following command in the background:",
+                working_directory.empty() ? parsed.command : parsed.command + "\n  (in " + working_directory + ")",
+                "It will keep running with your user permissions for up to " +
+                    std::to_string(parsed.time_limit) + " seconds.",
+                "Use with caution. Some commands may modify your system."
+            );
+
+            if (!confirmed) {
+                return ToolResult::error("Job denied by user");
+            }
+        }
+
+        std::string error;
+        int id = tool_manager.get_jobs().start(parsed.command, working_directory,
+                                               std::chrono::seconds(parsed.time_limit), error);
+        if (id < 0) {
+            return ToolResult::error("Could not start job: " + error);
+        }
+        return ToolResult::success("Started job " + std::to_string(id) + ". Check on it with job_status, read its "
+                                   "output with job_output or wait for it with wait_job.");
+    } catch (const std::exception& e) {
+        return ToolResult::error("Error starting job: " + std::string(e.what()));
+    }
+}
+
+// Job Status Tool Implementation
+JobStatusTool::JobStatusTool(ToolManager& manager) : ToolBase(manager) {}
+
+std::string JobStatusTool::get_description() const {
+    return "Show whether a background job is still running, its exit code and how much output it has "
+           "produced; all jobs if no id is given";
+}
+
+nlohmann::json JobStatusTool::get_parameters() const {
+    return tool_schema<Args>();
+}
+
+ToolResult JobStatusTool::execute(const nlohmann::json& args) {
+    Args parsed;
+    std::string parse_error;
+    if (!parse_args(args, parsed, parse_error)) {
+        return ToolResult::error(parse_error);
+    }
+
+    if (parsed.id) {
+        process::JobStatus status;
+        if (!tool_manager.get_jobs().status(*parsed.id, status)) {
+            return ToolResult::error(unknown_job(*parsed.id));
+        }
+        return ToolResult::success(describe_job(status));
+    }
+
+    auto statuses = tool_manager.get_jobs().list();
+    if (statuses.empty()) {
+        return ToolResult::success("No jobs have been started");
+    }
+    std::string text;
+    for (const auto& status : statuses) {
+        text += describe_job(status) + "\n";
+    }
+    return ToolResult::success(text);
+}
+
+// Job Output Tool Implementation
+JobOutputTool::JobOutputTool(ToolManager& manager) : ToolBase(manager) {}
+
+std::string JobOutputTool::get_description() const {
+    return "Read a background job's output (stdout and stderr as they were written), continuing from the "
+           "previous read unless an offset is given. Works while the job runs and after it has finished";
+}
+
+nlohmann::json JobOutputTool::get_parameters() const {
+    return tool_schema<Args>();
+}
+
+void JobOutputTool::reset() {
+    read_offsets.clear();
+}
+
+ToolResult JobOutputTool::execute(const nlohmann::json& args) {
+    Args parsed;
+    std::string parse_error;
+    if (!parse_args(args, parsed, parse_error)) {
+        return ToolResult::error(parse_error);
+    }
+    if (parsed.offset && *parsed.offset < 0) {
+        return ToolResult::error("offset must not be negative");
+    }
+    size_t max_bytes = static_cast<size_t>(std::clamp(parsed.max_bytes, 1, 50000));
+
+    uint64_t offset = parsed.offset ? static_cast<uint64_t>(*parsed.offset) : read_offsets[parsed.id];
+    process::JobOutput output;
+    if (!tool_manager.get_jobs().read(parsed.id, offset, max_bytes, output)) {
+        read_offsets.erase(parsed.id);
+        return ToolResult::error(unknown_job(parsed.id));
+    }
+    read_offsets[parsed.id] = output.next;
+
+    std::string text = "[job " + std::to_string(parsed.id) + " output, bytes " + std::to_string(output.offset) + "-" +
+                       std::to_string(output.next);
+    if (output.offset > offset) {
+        text += "; bytes " + std::to_string(offset) + "-" + std::to_string(output.offset) +
+                " were dropped to bound memory";
+    }
+    process::JobStatus status;
+    tool_manager.get_jobs().status(parsed.id, status);
+    if (output.next < status.output_bytes) {
+        text += "; more follows, continue with offset=" + std::to_string(output.next);
+    } else if (output.running) {
+        text += "; job still running, no more output yet";
+    } else {
+        text += "; end of output, job " + status.describe();
+    }
+    text += "]\n" + output.data;
+    return ToolResult::success(text);
+}
+
+// Wait Job Tool Implementation
+WaitJobTool::WaitJobTool(ToolManager& manager) : ToolBase(manager) {}
+
+std::string WaitJobTool::get_description() const {
+    return "Wait until a background job finishes or the timeout passes, then report its status";
+}
+
+nlohmann::json WaitJobTool::get_parameters() const {
+    return tool_schema<Args>();
+}
+
+ToolResult WaitJobTool::execute(const nlohmann::json& args) {
+    Args parsed;
+    std::string parse_error;
+    if (!parse_args(args, parsed, parse_error)) {
+        return ToolResult::error(parse_error);
+    }
+    int timeout = std::clamp(parsed.timeout, 0, 300);
+
+    process::JobStatus status;
+    if (!tool_manager.get_jobs().wait(parsed.id, std::chrono::seconds(timeout), status)) {
+        return ToolResult::error(unknown_job(parsed.id));
+    }
+    std::string text = describe_job(status);
+    if (status.running) {
+        text += "\nStill running after waiting " + std::to_string(timeout) + " seconds";
+    }
+    return ToolResult::success(text);
+}
+
+// Kill Job Tool Implementation
+KillJobTool::KillJobTool(ToolManager& manager) : ToolBase(manager) {}
+
+std::string KillJobTool::get_description() const {
+    return "Stop a background job and everything it started (SIGTERM, then SIGKILL after a few seconds)";
+}
+
+nlohmann::json KillJobTool::get_parameters() const {
+    return tool_schema<Args>();
+}
+
+ToolResult KillJobTool::execute(const nlohmann::json& args) {
+    Args parsed;
+    std::string parse_error;
+    if (!parse_args(args, parsed, parse_error)) {
+        return ToolResult::error(parse_error);
+    }
+
+    process::JobStatus status;
+    if (!tool_manager.get_jobs().kill(parsed.id, status)) {
+        return ToolResult::error(unknown_job(parsed.id));
+    }
+    return ToolResult::success(describe_job(status));
+}
+
+} // namespace tools
+} // namespace neoneo
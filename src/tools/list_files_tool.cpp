@@ -0,0 +1,108 @@
+#include "../../include/neoneo/tools/tools.hpp"
+#include <ctime>
+
+namespace neoneo {
+namespace tools {
+
+namespace {
+
+std::string format_mtime(int64_t mtime_ns) {
+    std::time_t seconds = static_cast<std::time_t>(mtime_ns / 1000000000);
+    std::tm local {};
+    localtime_r(&seconds, &local);
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M", &local);
+    return text;
+}
+
+} // namespace
+
+ListFilesTool::ListFilesTool(ToolManager& manager) : ToolBase(manager) {}
+
+std::string ListFilesTool::get_description() const {
+    return "List the files and directories below a directory, like ls or find but without confirmation. "
+           "Skips hidden and .gitignored entries by default; returns one path per line, directories "
+           "ending in '/', optionally with size and modification time";
+}
+
+nlohmann::json ListFilesTool::get_parameters() const {
+    return tool_schema<Args>();
+}
+
+ToolResult ListFilesTool::execute(const nlohmann::json& args) {
+    try {
+        // Parse and validate arguments against the declared schema
+        Args parsed;
+        std::string parse_error;
+        if (!parse_args(args, parsed, parse_error)) {
+            return ToolResult::error(parse_error);
+        }
+
+        // Security check: Prevent directory traversal
+        if (parsed.path.find("..") != std::string::npos) {
+            return ToolResult::error("Path contains forbidden '..' sequence");
+        }
+        if (parsed.depth < 1 || parsed.depth > 32) {
+            return ToolResult::error("depth must be between 1 and 32");
+        }
+        if (parsed.max_entries < 1 || parsed.max_entries > 10000) {
+            return ToolResult::error("max_entries must be between 1 and 10000");
+        }
+
+        io::ListOptions options;
+        options.max_depth = static_cast<size_t>(parsed.depth);
+        options.max_entries = static_cast<size_t>(parsed.max_entries);
+        options.glob = parsed.glob.value_or("");
+        options.hidden = parsed.hidden;
+        options.ignored = parsed.ignored;
+        options.metadata = parsed.details;
+
+        io::ListResult result;
+        std::string error;
+        if (!io::list_directory(parsed.path, options, cache, result, error)) {
+            return ToolResult::error(error);
+        }
+
+        size_t found = result.directories + result.files + result.others;
+        std::string content = "[" + std::to_string(found) + " entries";
+        if (result.incomplete) {
+            content += " or more";
+        }
+        content += ": " + std::to_string(result.directories) + " directories, " + std::to_string(result.files) +
+                   " files";
+        if (result.others > 0) {
+            content += ", " + std::to_string(result.others) + " other";
+        }
+        content += "; showing " + std::to_string(result.entries.size()) + "]\n";
+        if (found == 0) {
+            content += "No entries\n";
+        }
+
+        for (const auto& entry : result.entries) {
+            if (parsed.details) {
+                bool is_directory = entry.type == io::EntryType::Directory;
+                std::string size = is_directory ? "-" : std::to_string(entry.size);
+                std::string mtime = is_directory ? "-" : format_mtime(entry.mtime_ns);
+                content += std::string(size.size() < 12 ? 12 - size.size() : 0, ' ') + size + "  " + mtime +
+                           std::string(mtime.size() < 16 ? 16 - mtime.size() : 0, ' ') + "  ";
+            }
+            content += entry.path;
+            if (entry.type == io::EntryType::Directory) {
+                content += "/";
+            } else if (entry.type == io::EntryType::Symlink) {
+                content += " -> " + entry.target;
+            }
+            content += "\n";
+        }
+        if (result.truncated) {
+            content += "(more entries than max_entries; use a smaller depth, a glob or a subdirectory)\n";
+        }
+
+        return ToolResult::success(content);
+    } catch (const std::exception& e) {
+        return ToolResult::error("Error listing files: " + std::string(e.what()));
+    }
+}
+
+} // namespace tools
+} // namespace neoneo
@@ -0,0 +1,132 @@
+#include "../../include/neoneo/tools/live_output.hpp"
+#include "../../include/neoneo/terminal/terminal.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace neoneo {
+namespace tools {
+
+namespace {
+
+constexpr double LINES_PER_SECOND = 25;
+constexpr double BURST_LINES = 50;
+constexpr size_t RECENT_SKIPPED = 5;   // Lines shown after a run of skipped ones
+constexpr size_t MAX_LINE_BYTES = 400; // Longer lines are cut on screen
+constexpr size_t MAX_PARTIAL_BYTES = 16 * 1024; // A line without newline is shown once this long
+
+} // namespace
+
+LiveOutput::LiveOutput(bool enabled)
+    : enabled(enabled), tokens(BURST_LINES), last_refill(std::chrono::steady_clock::now()) {}
+
+LiveOutput::~LiveOutput() {
+    finish();
+}
+
+process::OutputCallback LiveOutput::callback() {
+    if (!enabled) {
+        return nullptr;
+    }
+    return [this](process::OutputStream stream, std::string_view data) { write(stream, data); };
+}
+
+std::string LiveOutput::describe(const process::ProcessResult& result) {
+    std::string status = result.term_signal != 0 ? "terminated by signal " + std::to_string(result.term_signal)
+                                                 : "exit code " + std::to_string(result.exit_code);
+    char seconds[32];
+    std::snprintf(seconds, sizeof(seconds), ", %.2fs", result.wall_time.count() / 1000.0);
+    return status + seconds + "; output shown above";
+}
+
+void LiveOutput::write(process::OutputStream stream, std::string_view data) {
+    if (!enabled || finished) {
+        return;
+    }
+    size_t index = stream == process::OutputStream::Stderr ? 1 : 0;
+    std::string& line = partial[index];
+    bool& carriage_return = pending_return[index];
+    for (char c : data) {
+        if (c == '\n') {
+            // \r\n is a plain line end
+            carriage_return = false;
+            add_line(stream, std::move(line));
+            line.clear();
+            continue;
+        }
+        if (c == '\r') {
+            carriage_return = true;
+            continue;
+        }
+        if (carriage_return) {
+            // Progress bars redraw their line; only the final state is worth showing
+            carriage_return = false;
+            line.clear();
+        }
+        if (line.size() < MAX_PARTIAL_BYTES) {
+            line += c;
+        } else {
+            add_line(stream, std::move(line));
+            line.assign(1, c);
+        }
+    }
+}
+
+void LiveOutput::add_line(process::OutputStream stream, std::string text) {
+    auto now = std::chrono::steady_clock::now();
+    tokens = std::min(BURST_LINES, tokens + std::chrono::duration<double>(now - last_refill).count() * LINES_PER_SECOND);
+    last_refill = now;
+
+    if (tokens < 1) {
+        ++skipped;
+        recent_skipped.push_back(Line{stream, std::move(text)});
+        if (recent_skipped.size() > RECENT_SKIPPED) {
+            recent_skipped.pop_front();
+        }
+        return;
+    }
+    tokens -= 1;
+    show_skipped();
+    show(Line{stream, std::move(text)});
+}
+
+void LiveOutput::show(const Line& line) {
+    std::string text = line.text.size() > MAX_LINE_BYTES ? line.text.substr(0, MAX_LINE_BYTES) + "..." : line.text;
+    terminal::print("  " + text, line.stream == process::OutputStream::Stderr ? terminal::Color::YELLOW
+                                                                               : terminal::Color::DIM);
+    ++lines_shown;
+}
+
+void LiveOutput::show_skipped() {
+    if (skipped == 0) {
+        return;
+    }
+    size_t hidden = skipped - recent_skipped.size();
+    if (hidden > 0) {
+        terminal::print("  ... (" + std::to_string(hidden) + " lines not shown)", terminal::Color::DIM);
+    }
+    for (const auto& line : recent_skipped) {
+        show(line);
+    }
+    skipped = 0;
+    recent_skipped.clear();
+}
+
+void LiveOutput::finish() {
+    if (!enabled || finished) {
+        return;
+    }
+    finished = true;
+    // The end of the output is always shown, whatever the budget
+    for (auto stream : {process::OutputStream::Stdout, process::OutputStream::Stderr}) {
+        std::string& line = partial[stream == process::OutputStream::Stderr ? 1 : 0];
+        if (!line.empty()) {
+            recent_skipped.push_back(Line{stream, std::move(line)});
+            ++skipped;
+            line.clear();
+        }
+    }
+    show_skipped();
+}
+
+} // namespace tools
+} // namespace neoneo
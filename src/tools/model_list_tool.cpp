@@ -12,25 +12,28 @@ std::string ModelListTool::get_description() const {
 }
 
 nlohmann::json ModelListTool::get_parameters() const {
-    return {
-        {"type", "object"},
-        {"properties", {
-            {"host", {
-                {"type", "string"}, 
-                {"description", "Optional: The Ollama server URL (default: http://localhost:11434)"}
-            }}
-        }}
-    };
+    return tool_schema<Args>();
+}
+
+MemoRule ModelListTool::memo_rule(const nlohmann::json&) const {
+    // Models are rarely pulled or removed mid-session
+    MemoRule rule = MemoRule::pure();
+    rule.max_age = std::chrono::seconds(30);
+    return rule;
 }
 
 ToolResult ModelListTool::execute(const nlohmann::json& args) {
     try {
-        // Get the host parameter if provided
-        std::string host = tool_manager.get_config().get_host();
-        if (args.contains("host") && args["host"].is_string()) {
-            host = args["host"].get<std::string>();
+        // Parse and validate arguments against the declared schema
+        Args parsed;
+        std::string parse_error;
+        if (!parse_args(args, parsed, parse_error)) {
+            return ToolResult::error(parse_error);
         }
         
+        // Use the host parameter if provided
+        std::string host = parsed.host.value_or(tool_manager.get_config().get_host());
+        
         // Create a temporary OllamaClient
         OllamaClient client(host);
         
@@ -0,0 +1,146 @@
+#include "../../include/neoneo/tools/tools.hpp"
+#include "../../include/neoneo/io/search.hpp"
+#include <algorithm>
+
+namespace neoneo {
+namespace tools {
+
+ReadOutputTool::ReadOutputTool(ToolManager& manager) : ToolBase(manager) {}
+
+std::string ReadOutputTool::get_description() const {
+    return "Read part of a large tool output that was cut to a summary and kept under a handle (out-N): "
+           "a line range, a byte range, or the lines matching grep";
+}
+
+nlohmann::json ReadOutputTool::get_parameters() const {
+    return tool_schema<Args>();
+}
+
+ToolResult ReadOutputTool::execute(const nlohmann::json& args) {
+    try {
+        // Parse and validate arguments against the declared schema
+        Args parsed;
+        std::string parse_error;
+        if (!parse_args(args, parsed, parse_error)) {
+            return ToolResult::error(parse_error);
+        }
+
+        auto output = tool_manager.get_spill_store().find(parsed.handle);
+        if (!output) {
+            return ToolResult::error("No stored output " + parsed.handle +
+                                     " (handles look like out-3; old outputs are removed once the store is full)");
+        }
+        const io::MappedFile& file = *output->file;
+        std::string_view data = file.view();
+
+        bool by_bytes = parsed.offset || parsed.length;
+        bool by_lines = parsed.start_line || parsed.end_line;
+        bool by_grep = parsed.grep.has_value();
+        if (by_bytes + by_lines + by_grep > 1) {
+            return ToolResult::error("Use only one of offset/length, start_line/end_line or grep");
+        }
+
+        const size_t max_size = 50000; // 50KB limit per call, as for read_file
+        std::string what = output->handle + " (" + output->tool_name + ")";
+
+        if (by_grep) {
+            io::SearchOptions options;
+            options.pattern = *parsed.grep;
+            options.regex = parsed.regex;
+            options.ignore_case = parsed.ignore_case;
+            options.max_matches = static_cast<size_t>(std::clamp(parsed.max_matches, 1, 1000));
+            options.max_per_file = options.max_matches;
+            options.max_file_size = UINT64_MAX;
+            options.threads = 1;
+
+            io::SearchResult result;
+            std::string error;
+            if (!io::search_files(tool_manager.get_spill_store().get_directory(), {output->name}, options, result,
+                                  error)) {
+                return ToolResult::error(error);
+            }
+            if (result.binary_skipped > 0) {
+                return ToolResult::error(what + " is binary; read it with offset/length instead");
+            }
+            if (result.files.empty()) {
+                return ToolResult::success("[" + what + ": no lines match]");
+            }
+
+            auto& lines = result.files.front().lines;
+            std::sort(lines.begin(), lines.end(), [](const auto& a, const auto& b) { return a.line < b.line; });
+            std::string content = "[" + what + ": " + std::to_string(result.files.front().count) + " matching lines";
+            if (lines.size() < result.files.front().count) {
+                content += ", first " + std::to_string(lines.size()) + " shown";
+            }
+            content += "]\n";
+            for (const auto& match : lines) {
+                content += std::to_string(match.line) + ": " + match.text + "\n";
+            }
+            return ToolResult::success(content);
+        }
+
+        if (by_lines) {
+            long long first = parsed.start_line.value_or(1);
+            if (first < 1) {
+                return ToolResult::error("start_line must be 1 or greater");
+            }
+            if (parsed.end_line && *parsed.end_line < first) {
+                return ToolResult::error("end_line must not be before start_line");
+            }
+
+            auto start = line_cache.line_offset(file, static_cast<uint64_t>(first - 1));
+            if (!start) {
+                return ToolResult::error("start_line " + std::to_string(first) + " is past the end of " +
+                                         output->handle + " (" + std::to_string(line_cache.count_lines(file)) +
+                                         " lines)");
+            }
+
+            uint64_t wanted = parsed.end_line ? static_cast<uint64_t>(*parsed.end_line - first + 1) : UINT64_MAX;
+            uint64_t complete_lines = 0;
+            uint64_t end = io::skip_lines(data, *start, wanted, max_size, complete_lines);
+            uint64_t shown = complete_lines + (end > *start && data[end - 1] != '\n' ? 1 : 0);
+            uint64_t last = static_cast<uint64_t>(first) + shown - 1;
+
+            std::string content = "[" + what + ", lines " + std::to_string(first) + "-" + std::to_string(last) +
+                                  " of " + std::to_string(line_cache.count_lines(file)) + "]\n" +
+                                  std::string(data.substr(*start, end - *start));
+            if (complete_lines < wanted && end < data.size()) {
+                if (complete_lines > 0) {
+                    content += "\n... (truncated at the " + std::to_string(max_size) +
+                               " byte limit; continue with start_line=" + std::to_string(last + 1) + ")";
+                } else {
+                    // A single line over the budget: starting at it again would give the same text
+                    content += "\n... (line " + std::to_string(last) + " is longer than the " +
+                               std::to_string(max_size) + " byte limit; continue with offset=" + std::to_string(end) +
+                               ")";
+                }
+            }
+            return ToolResult::success(content);
+        }
+
+        long long offset = parsed.offset.value_or(0);
+        long long length = parsed.length.value_or(static_cast<long long>(max_size));
+        if (offset < 0 || length < 0) {
+            return ToolResult::error("offset and length must not be negative");
+        }
+        if (static_cast<uint64_t>(offset) > data.size()) {
+            return ToolResult::error("offset is past the end of " + output->handle + " (" +
+                                     std::to_string(data.size()) + " bytes)");
+        }
+
+        uint64_t count = std::min<uint64_t>({static_cast<uint64_t>(length), max_size, data.size() - offset});
+        std::string content = "[" + what + ", bytes " + std::to_string(offset) + "-" +
+                              std::to_string(offset + count) + " of " + std::to_string(data.size()) + "]\n" +
+                              std::string(data.substr(static_cast<size_t>(offset), static_cast<size_t>(count)));
+        if (count < static_cast<uint64_t>(length) && offset + count < data.size()) {
+            content += "\n... (truncated at the " + std::to_string(max_size) + " byte limit; continue with offset=" +
+                       std::to_string(offset + count) + ")";
+        }
+        return ToolResult::success(content);
+    } catch (const std::exception& e) {
+        return ToolResult::error("Error reading stored output: " + std::string(e.what()));
+    }
+}
+
+} // namespace tools
+} // namespace neoneo
@@ -0,0 +1,126 @@
+#include "../../include/neoneo/tools/tools.hpp"
+#include "../../include/neoneo/io/search.hpp"
+#include "../../include/neoneo/io/trigram_index.hpp"
+#include <filesystem>
+
+namespace neoneo {
+namespace tools {
+
+namespace fs = std::filesystem;
+
+SearchTool::SearchTool(ToolManager& manager) : ToolBase(manager) {
+    if (manager.get_config().is_search_index_enabled()) {
+        std::error_code ec;
+        std::string root = fs::current_path(ec).string();
+        if (!ec) {
+            index = std::make_unique<io::TrigramIndex>(root, io::TrigramIndex::default_index_path(root));
+            index->start();
+        }
+    }
+}
+
+SearchTool::~SearchTool() = default;
+
+std::string SearchTool::get_description() const {
+    return "Search file contents below a directory, like grep -rn but faster and without confirmation. "
+           "Skips hidden, .gitignored and binary files and returns the best matching lines first as "
+           "path:line: text";
+}
+
+nlohmann::json SearchTool::get_parameters() const {
+    return tool_schema<Args>();
+}
+
+ToolResult SearchTool::execute(const nlohmann::json& args) {
+    try {
+        // Parse and validate arguments against the declared schema
+        Args parsed;
+        std::string parse_error;
+        if (!parse_args(args, parsed, parse_error)) {
+            return ToolResult::error(parse_error);
+        }
+
+        // Security check: Prevent directory traversal
+        if (parsed.path.find("..") != std::string::npos) {
+            return ToolResult::error("Path contains forbidden '..' sequence");
+        }
+        if (parsed.max_results < 1 || parsed.max_results > 1000) {
+            return ToolResult::error("max_results must be between 1 and 1000");
+        }
+        if (parsed.max_per_file < 1) {
+            return ToolResult::error("max_per_file must be 1 or greater");
+        }
+
+        io::SearchOptions options;
+        options.pattern = parsed.pattern;
+        options.regex = parsed.regex;
+        options.ignore_case = parsed.ignore_case;
+        options.glob = parsed.glob.value_or("");
+        options.max_matches = static_cast<size_t>(parsed.max_results);
+        options.max_per_file = static_cast<size_t>(parsed.max_per_file);
+        options.cache = &tool_manager.get_content_cache();
+
+        // With an index, only the files holding the pattern's trigrams need reading
+        std::optional<std::vector<std::string>> candidates;
+        if (index) {
+            std::error_code ec;
+            fs::path target = fs::weakly_canonical(fs::absolute(parsed.path, ec), ec);
+            fs::path below = target.lexically_relative(index->get_root());
+            if (!ec && fs::is_directory(target, ec) && !below.empty() && *below.begin() != "..") {
+                std::string directory = below == "." ? "" : below.generic_string() + "/";
+                candidates = index->candidates(parsed.regex ? io::required_literal(parsed.pattern) : parsed.pattern,
+                                               directory);
+            }
+        }
+
+        io::SearchResult result;
+        std::string error;
+        bool ok = candidates ? io::search_files(parsed.path, *candidates, options, result, error)
+                             : io::search(parsed.path, options, result, error);
+        if (!ok) {
+            return ToolResult::error(error);
+        }
+
+        size_t shown = 0;
+        for (const auto& file : result.files) {
+            shown += file.lines.size();
+        }
+
+        std::string content = "[" + std::to_string(result.total_matches) + " matching lines";
+        if (result.stopped_early) {
+            content += " or more";
+        }
+        content += "; searched " + std::to_string(result.files_searched) + " files";
+        if (candidates) {
+            content += " picked by the index";
+        }
+        if (result.binary_skipped > 0 || result.large_skipped > 0) {
+            content += ", skipped " + std::to_string(result.binary_skipped) + " binary and " +
+                       std::to_string(result.large_skipped) + " oversized";
+        }
+        content += "; showing " + std::to_string(shown) + "]\n";
+        if (result.total_matches == 0) {
+            content += "No matches\n";
+        }
+
+        for (const auto& file : result.files) {
+            for (const auto& line : file.lines) {
+                content += file.path + ":" + std::to_string(line.line) + ": " + line.text + "\n";
+            }
+            if (file.count > file.lines.size()) {
+                content += file.path + ": ... " + std::to_string(file.count - file.lines.size()) +
+                           " more matching lines\n";
+            }
+        }
+        if (result.stopped_early) {
+            content += "(stopped after finding many matches; use a more specific pattern, path or glob)\n";
+        }
+
+        return ToolResult::success(content);
+    } catch (const std::exception& e) {
+        return ToolResult::error("Error searching: " + std::string(e.what()));
+    }
+}
+
+} // namespace tools
+} // namespace neoneo
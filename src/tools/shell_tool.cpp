@@ -1,11 +1,12 @@
 #include "../../include/neoneo/tools/tools.hpp"
 #include "../../include/neoneo/terminal/terminal.hpp"
+#include "../../include/neoneo/process/executor.hpp"
+#include "../../include/neoneo/tools/live_output.hpp"
 #include <iostream>
 #include <chrono>
-#include <array>
-#include <cstdio>
 #include <vector>
 #include <algorithm>
+#include <wordexp.h>
 
 namespace neoneo {
 namespace tools {
@@ -17,76 +18,84 @@ std::string ShellTool::get_description() const {
 }
 
 nlohmann::json ShellTool::get_parameters() const {
-    return {
-        {"type", "object"},
-        {"required", nlohmann::json::array({"command"})},
-        {"properties", {
-            {"command", {
-                {"type", "string"}, 
-                {"description", "The shell command to execute. Certain commands are blocked for security."}
-            }},
-            {"timeout", {
-                {"type", "integer"}, 
-                {"description", "Maximum execution time in seconds (1-30). Defaults to 5 seconds."}
-            }}
-        }}
-    };
+    return tool_schema<Args>();
 }
 
-bool ShellTool::is_command_safe(const std::string& command, std::string& operation_found) {
-    static const std::vector<std::string> blocked_commands = {
-        "rm", "mkfs", "dd", ">", ">>", "|", "&", ";", "&&", "||", 
-        "sudo", "su", "chmod", "chown", "passwd", "mv", "curl", "wget",
-        "ssh", "scp", "ftp", "telnet", "nc", "ncat", "sleep", "perl",
-        "python", "python3", "ruby", "bash", "sh", "zsh", "csh", "ksh"
-    };
-    
-    for (const auto& blocked : blocked_commands) {
-        if (command.find(blocked) != std::string::npos) {
-            operation_found = blocked;
+MemoRule ShellTool::memo_rule(const nlohmann::json& args) const {
+    // As for bash: only commands that just read
+    if (!args.contains("command") || !args["command"].is_string() ||
+        !process::is_read_only_command(args["command"].get<std::string>())) {
+        return MemoRule();
+    }
+    MemoRule rule = MemoRule::read_only();
+    rule.reusable = true;
+    rule.until_side_effect = true;
+    rule.max_age = std::chrono::seconds(60);
+    return rule;
+}
+
+bool ShellTool::split_command(const std::string& command, std::vector<std::string>& argv, std::string& error) {
+    wordexp_t words;
+    int rc = wordexp(command.c_str(), &words, WRDE_NOCMD);
+    switch (rc) {
+        case 0:
+            break;
+        case WRDE_BADCHAR:
+            error = "Command contains shell operators (|, &, ;, <, >, parentheses or braces); use the bash tool for pipelines";
+            return false;
+        case WRDE_CMDSUB:
+            error = "Command substitution is not allowed in shell commands";
+            return false;
+        case WRDE_SYNTAX:
+            error = "Shell syntax error in command (unbalanced quotes?)";
+            return false;
+        default:
+            error = "Could not parse command";
+            if (rc == WRDE_NOSPACE) {
+                wordfree(&words);
+            }
             return false;
-        }
     }
     
+    argv.assign(words.we_wordv, words.we_wordv + words.we_wordc);
+    wordfree(&words);
+    
+    if (argv.empty()) {
+        error = "Empty command";
+        return false;
+    }
     return true;
 }
 
 ToolResult ShellTool::execute(const nlohmann::json& args) {
     try {
-        // Validate command argument
-        if (!args.contains("command") || !args["command"].is_string()) {
-            return ToolResult::error("Missing or invalid 'command' parameter");
+        // Parse and validate arguments against the declared schema
+        Args parsed;
+        std::string parse_error;
+        if (!parse_args(args, parsed, parse_error)) {
+            return ToolResult::error(parse_error);
         }
         
-        std::string command = args["command"].get<std::string>();
+        std::string command = std::move(parsed.command);
         
-        // Extract timeout if provided (default: 5 seconds)
-        int timeout_seconds = 5;
-        if (args.contains("timeout") && args["timeout"].is_number()) {
-            timeout_seconds = args["timeout"].get<int>();
-            // Limit maximum timeout to 30 seconds for safety
-            if (timeout_seconds > 30) {
-                timeout_seconds = 30;
-            } else if (timeout_seconds < 1) {
-                timeout_seconds = 1;
-            }
-        }
+        // Limit maximum timeout to 30 seconds for safety
+        int timeout_seconds = std::clamp(parsed.timeout, 1, 30);
         
         // Check for potentially dangerous commands (unless safety checks are disabled)
         if (!tool_manager.get_config().is_shell_safety_ignored()) {
-            std::string operation_found;
-            if (!is_command_safe(command, operation_found)) {
+            process::PolicyVerdict verdict = tool_manager.get_shell_policy().check(command);
+            if (!verdict.allowed) {
                 // Potentially dangerous command found - ask for confirmation
                 bool confirmed = terminal::confirm_dialog(
                     terminal::ConfirmType::SHELL_COMMAND,
                     "The command contains a potentially dangerous operation:",
-                    "'" + operation_found + "' found in: " + command,
+                    "'" + verdict.rule + "' matches: " + verdict.command,
                     "This could potentially harm your system or expose sensitive data.",
                     "Tip: Use --ignore-shell-safety to disable these warnings."
                 );
                 
                 if (!confirmed) {
-                    return ToolResult::error("Command execution aborted due to security concerns with operation: " + operation_found);
+                    return ToolResult::error("Command execution aborted due to security concerns with operation: " + verdict.rule);
                 }
                 // If confirmed, continue with execution
                 std::cout << "Proceeding with execution despite warning." << std::endl;
@@ -108,58 +117,61 @@ ToolResult ShellTool::execute(const nlohmann::json& args) {
             }
         }
         
-        // Add output redirection to capture command output
-        command += " 2>&1";
-        
-        // Execute the command and capture output with basic timing
-        auto start_time = std::chrono::steady_clock::now();
-        
-        FILE* pipe = popen(command.c_str(), "r");
-        if (!pipe) {
-            return ToolResult::error("Failed to execute command");
+        // Split the command into words (quotes, globs and variables are expanded,
+        // command substitution is refused) and run it without a shell
+        std::vector<std::string> argv;
+        std::string split_error;
+        if (!split_command(command, argv, split_error)) {
+            return ToolResult::error(split_error);
         }
         
-        // Calculate timeout in microseconds
-        auto timeout = std::chrono::seconds(timeout_seconds);
+        process::ProcessOptions options;
+        options.argv = std::move(argv);
+        options.timeout = std::chrono::seconds(timeout_seconds);
+        // Large outputs are spilled by the tool manager, so the cap only bounds memory
+        options.max_stdout_bytes = 64 * 1024 * 1024;
+        options.max_stderr_bytes = 64 * 1024 * 1024;
         
-        char buffer[128];
-        std::string result;
-        bool timed_out = false;
-        
-        while (!feof(pipe)) {
-            // Check if we've exceeded the timeout
-            auto current_time = std::chrono::steady_clock::now();
-            auto elapsed = current_time - start_time;
-            
-            if (elapsed > timeout) {
-                timed_out = true;
-                break;
-            }
-            
-            // Try to read with a short timeout to check periodically
-            if (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-                result += buffer;
-                
-                // Limit output size
-                if (result.size() > 1000) {
-                    result = result.substr(0, 1000) + "\n... (output truncated)";
-                    break;
-                }
-            }
+        // Show all of the output as it arrives, though only the start of it is returned
+        LiveOutput live(tool_manager.is_live_output());
+        options.on_output = live.callback();
+        process::ProcessResult run = process::run_process(options);
+        live.finish();
+        if (!run.started) {
+            return ToolResult::error("Failed to execute command: " + run.error);
         }
         
-        // Close the pipe
-        pclose(pipe);
-        
         // Handle timeout
-        if (timed_out) {
+        if (run.timed_out) {
             return ToolResult::error("Command execution timed out after " + 
                                    std::to_string(timeout_seconds) + " seconds");
         }
         
+        std::string result = run.stdout_data;
+        if (run.stdout_truncated) {
+            result += "\n... (output truncated)";
+        }
+        if (!run.stderr_data.empty()) {
+            result += (result.empty() ? "" : "\n") + std::string("Stderr:\n") + run.stderr_data;
+            if (run.stderr_truncated) {
+                result += "\n... (output truncated)";
+            }
+        }
+        if (!run.succeeded() && run.term_signal == 0) {
+            result = "Command failed with exit code: " + std::to_string(run.exit_code) +
+                     (result.empty() ? "" : "\n" + result);
+        } else if (run.term_signal != 0) {
+            result = "Command terminated by signal: " + std::to_string(run.term_signal) +
+                     (result.empty() ? "" : "\n" + result);
+        }
+        
         // Return the command output
-        return ToolResult::success(result.empty() ? 
-                                 "Command executed successfully (no output)" : result);
+        ToolResult tool_result = ToolResult::success(result.empty() ?
+                                                     "Command executed successfully (no output)" : result);
+        if (live.has_output()) {
+            tool_result.display = LiveOutput::describe(run);
+        }
+        return tool_result;
     } catch (const std::exception& e) {
         std::cerr << "Error in shell command: " << e.what() << std::endl;
         return ToolResult::error("Error executing command: " + std::string(e.what()));
@@ -0,0 +1,318 @@
+#include "../../include/neoneo/tools/tools.hpp"
+#include "../../include/neoneo/calc/statistics.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+
+namespace neoneo {
+namespace tools {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Files larger than this are refused rather than read into memory
+constexpr uintmax_t MAX_FILE_SIZE = 256 * 1024 * 1024;
+
+std::string format_number(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.10g", value);
+    return buffer;
+}
+
+// Strip surrounding whitespace and CSV quotes
+std::string_view trim_field(std::string_view field) {
+    while (!field.empty() && (field.front() == ' ' || field.front() == '\t' || field.front() == '"')) {
+        field.remove_prefix(1);
+    }
+    while (!field.empty() && (field.back() == ' ' || field.back() == '\t' || field.back() == '"' ||
+                              field.back() == '\r')) {
+        field.remove_suffix(1);
+    }
+    return field;
+}
+
+bool parse_field(std::string_view field, double& out) {
+    field = trim_field(field);
+    if (!field.empty() && field.front() == '+') {
+        field.remove_prefix(1);
+    }
+    if (field.empty()) {
+        return false;
+    }
+    auto [end, ec] = std::from_chars(field.data(), field.data() + field.size(), out);
+    return ec == std::errc() && end == field.data() + field.size() && std::isfinite(out);
+}
+
+// Field number index of a line; delimiter '\0' splits on runs of whitespace
+bool nth_field(std::string_view line, char delimiter, size_t index, std::string_view& out) {
+    size_t pos = 0;
+    for (size_t field = 0;; ++field) {
+        if (delimiter == '\0') {
+            while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) {
+                ++pos;
+            }
+            if (pos >= line.size()) {
+                return false;
+            }
+        }
+        size_t end = delimiter == '\0' ? line.find_first_of(" \t", pos) : line.find(delimiter, pos);
+        if (end == std::string_view::npos) {
+            end = line.size();
+        }
+        if (field == index) {
+            out = line.substr(pos, end - pos);
+            return true;
+        }
+        if (end >= line.size()) {
+            return false;
+        }
+        pos = end + 1;
+    }
+}
+
+} // namespace
+
+StatisticsTool::StatisticsTool(ToolManager& manager) : ToolBase(manager) {}
+
+std::string StatisticsTool::get_description() const {
+    return "Compute count, sum, mean, standard deviation, min, max, percentiles and an optional histogram "
+           "for a list of numbers or a column of a CSV/TSV/text file. Use this instead of the calculator "
+           "for more than a handful of values";
+}
+
+nlohmann::json StatisticsTool::get_parameters() const {
+    return tool_schema<Args>();
+}
+
+MemoRule StatisticsTool::memo_rule(const nlohmann::json& args) const {
+    // Values in the call make it pure; a file is read again once it changes
+    MemoRule rule = MemoRule::pure();
+    if (args.contains("file") && args["file"].is_string()) {
+        rule.files.push_back(args["file"].get<std::string>());
+    }
+    return rule;
+}
+
+bool StatisticsTool::load_column(const Args& args, std::vector<double>& values, size_t& skipped,
+                                 std::string& error) {
+    const std::string& file_path = *args.file;
+
+    if (!tool_manager.get_config().is_file_ops_enabled()) {
+        error = "Reading files requires file operations to be enabled (--file-ops)";
+        return false;
+    }
+    if (file_path.find("..") != std::string::npos) {
+        error = "Path contains forbidden '..' sequence";
+        return false;
+    }
+    if (!fs::is_regular_file(file_path)) {
+        error = "Not a regular file: " + file_path;
+        return false;
+    }
+    if (fs::file_size(file_path) > MAX_FILE_SIZE) {
+        error = "File too large (limit is 256 MB): " + file_path;
+        return false;
+    }
+
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file.is_open()) {
+        error = "Could not open file: " + file_path;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string content = buffer.str();
+    std::string_view text(content);
+
+    // First non-empty line decides the delimiter and may be a header
+    size_t first_start = text.find_first_not_of("\r\n");
+    if (first_start == std::string_view::npos) {
+        error = "File is empty: " + file_path;
+        return false;
+    }
+    size_t first_end = text.find('\n', first_start);
+    std::string_view first_line = text.substr(first_start, first_end == std::string_view::npos
+                                                               ? std::string_view::npos
+                                                               : first_end - first_start);
+
+    char delimiter;
+    std::string requested = args.delimiter.value_or("");
+    if (requested == "," || requested == "comma") {
+        delimiter = ',';
+    } else if (requested == "\t" || requested == "tab") {
+        delimiter = '\t';
+    } else if (requested == ";") {
+        delimiter = ';';
+    } else if (requested == " " || requested == "whitespace") {
+        delimiter = '\0';
+    } else if (requested.empty()) {
+        delimiter = first_line.find('\t') != std::string_view::npos ? '\t'
+                    : first_line.find(',') != std::string_view::npos ? ','
+                                                                     : '\0';
+    } else {
+        error = "Unsupported delimiter '" + requested + "' (use ',', 'tab', ';' or 'whitespace')";
+        return false;
+    }
+
+    // Column by 1-based number or by header name
+    size_t column = 0;
+    bool header = false;
+    if (args.column && args.column->is_string()) {
+        const std::string& name = args.column->get_ref<const std::string&>();
+        double number;
+        if (parse_field(name, number) && number >= 1 && number == std::floor(number)) {
+            column = static_cast<size_t>(number) - 1;
+        } else {
+            std::string_view field;
+            bool found = false;
+            for (size_t i = 0; nth_field(first_line, delimiter, i, field); ++i) {
+                if (trim_field(field) == name) {
+                    column = i;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                error = "Column '" + name + "' not found in header: " + std::string(first_line);
+                return false;
+            }
+            header = true;
+        }
+    } else if (args.column && args.column->is_number()) {
+        double number = args.column->get<double>();
+        if (number < 1 || number != std::floor(number)) {
+            error = "Invalid 'column' parameter: expected a 1-based column number";
+            return false;
+        }
+        column = static_cast<size_t>(number) - 1;
+    } else if (args.column) {
+        error = "Invalid 'column' parameter: expected a column number or header name";
+        return false;
+    }
+
+    // A non-numeric value on the first line is a header, not a skipped row
+    std::string_view field;
+    double number;
+    if (!header && (!nth_field(first_line, delimiter, column, field) || !parse_field(field, number))) {
+        header = true;
+    }
+
+    size_t pos = first_start;
+    bool first = true;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        std::string_view line = text.substr(pos, end - pos);
+        pos = end + 1;
+
+        if (first) {
+            first = false;
+            if (header) {
+                continue;
+            }
+        }
+        if (trim_field(line).empty()) {
+            continue;
+        }
+        if (nth_field(line, delimiter, column, field) && parse_field(field, number)) {
+            values.push_back(number);
+        } else {
+            ++skipped;
+        }
+    }
+    return true;
+}
+
+ToolResult StatisticsTool::execute(const nlohmann::json& args) {
+    try {
+        // Parse and validate arguments against the declared schema
+        Args parsed;
+        std::string parse_error;
+        if (!parse_args(args, parsed, parse_error)) {
+            return ToolResult::error(parse_error);
+        }
+
+        if (parsed.values.has_value() == parsed.file.has_value()) {
+            return ToolResult::error("Provide exactly one of 'values' or 'file'");
+        }
+        if (parsed.histogram_bins < 0 || parsed.histogram_bins > 1000) {
+            return ToolResult::error("Invalid 'histogram_bins' parameter: expected 0-1000");
+        }
+        std::vector<double> ranks = parsed.percentiles.value_or(std::vector<double>{25, 50, 75, 90, 99});
+        for (double rank : ranks) {
+            if (!(rank >= 0 && rank <= 100)) {
+                return ToolResult::error("Percentiles must be between 0 and 100");
+            }
+        }
+
+        std::vector<double> values;
+        size_t skipped = 0;
+        if (parsed.file) {
+            std::string error;
+            if (!load_column(parsed, values, skipped, error)) {
+                return ToolResult::error(error);
+            }
+        } else {
+            values = std::move(*parsed.values);
+            for (double value : values) {
+                if (!std::isfinite(value)) {
+                    return ToolResult::error("Values must be finite numbers");
+                }
+            }
+        }
+        if (values.empty()) {
+            return ToolResult::error(skipped > 0 ? "No numeric values found (" + std::to_string(skipped) +
+                                                       " non-numeric rows)"
+                                                 : "No values to analyze");
+        }
+
+        calc::Summary summary = calc::summarize(values.data(), values.size());
+        std::vector<size_t> bins;
+        if (parsed.histogram_bins > 0) {
+            bins = calc::histogram(values.data(), values.size(), summary.min, summary.max,
+                                   static_cast<size_t>(parsed.histogram_bins));
+        }
+        // Selection reorders the values, so it runs after the passes that need them
+        std::vector<double> results = calc::percentiles(values, ranks);
+
+        std::string output = "count: " + std::to_string(summary.count);
+        if (skipped > 0) {
+            output += " (skipped " + std::to_string(skipped) + " non-numeric rows)";
+        }
+        output += "\nsum: " + format_number(summary.sum) +
+                  " | mean: " + format_number(summary.mean) +
+                  " | stddev: " + format_number(summary.stddev) +
+                  " | variance: " + format_number(summary.variance);
+        output += "\nmin: " + format_number(summary.min) + " | max: " + format_number(summary.max);
+        if (!ranks.empty()) {
+            output += "\npercentiles:";
+            for (size_t i = 0; i < ranks.size(); ++i) {
+                output += " p" + format_number(ranks[i]) + "=" + format_number(results[i]);
+            }
+        }
+        if (!bins.empty()) {
+            // Divided before subtracting, so a range wider than the largest double still has a width
+            double divisions = static_cast<double>(bins.size());
+            double width = summary.max / divisions - summary.min / divisions;
+            output += "\nhistogram (" + std::to_string(bins.size()) + " bins of width " + format_number(width) +
+                      " from " + format_number(summary.min) + "):";
+            for (size_t count : bins) {
+                output += " " + std::to_string(count);
+            }
+        }
+
+        return ToolResult::success(output);
+    } catch (const std::exception& e) {
+        return ToolResult::error("Error computing statistics: " + std::string(e.what()));
+    }
+}
+
+} // namespace tools
+} // namespace neoneo
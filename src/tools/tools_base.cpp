@@ -1,9 +1,55 @@
 #include "../../include/neoneo/tools/tools.hpp"
+#include "../../include/neoneo/conversation/output_reduction.hpp"
+#include "../../include/neoneo/io/tail.hpp"
+#include "../../include/neoneo/io/utf8.hpp"
+#include <algorithm>
 #include <memory>
+#include <sys/stat.h>
 
 namespace neoneo {
 namespace tools {
 
+namespace {
+
+// Outputs larger than this are spilled, and the model gets a reduced view of them
+constexpr size_t SPILL_BYTES = 32 * 1024;
+constexpr size_t SUMMARY_BYTES = 8192;
+
+// A spilled output cut to SUMMARY_BYTES: its head and tail plus the lines around errors
+std::string summarize(const io::SpilledOutput& output, bool is_command_output) {
+    std::string_view content = output.file->view();
+    uint64_t lines = io::count_newlines(content.data(), content.size()) + (content.back() != '\n' ? 1 : 0);
+
+    conversation::ReductionOptions options;
+    options.strip_control = is_command_output;
+    options.collapse_progress = is_command_output;
+    options.min_run = is_command_output ? options.min_run : 0;
+    options.max_bytes = SUMMARY_BYTES;
+    conversation::ReductionStats stats;
+    std::string shown = conversation::reduce_output(content, options, stats);
+
+    return "[Output of " + output.tool_name + " is " + std::to_string(content.size()) + " bytes, " +
+           std::to_string(lines) + " lines; shown are " + std::to_string(shown.size()) +
+           " bytes of it: the start, the end and the lines around errors. The whole output is kept as " +
+           output.handle + ": use read_output with that handle to read line or byte ranges of it or grep it]\n" +
+           shown;
+}
+
+// Memoized results kept at most; the oldest is dropped to make room
+constexpr size_t MEMO_ENTRIES = 256;
+
+// Identity, size and modification time of a file, or "-" if it can not be stat'ed
+std::string file_stamp(const std::string& path) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return "-";
+    }
+    return std::to_string(st.st_dev) + ":" + std::to_string(st.st_ino) + ":" + std::to_string(st.st_size) + ":" +
+           std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec);
+}
+
+} // namespace
+
 // Base class implementation
 ToolBase::ToolBase(ToolManager& manager) : tool_manager(manager) {}
 
@@ -25,18 +71,41 @@ ToolManager::~ToolManager() = default;
 
 void ToolManager::register_tool(std::unique_ptr<ToolBase> tool) {
     tools[tool->get_name()] = std::move(tool);
+    
+    // Tool set changed, recompile definitions on next use
+    ++definitions_version;
+    compiled_definitions.reset();
+}
+
+bool ToolManager::unregister_tool(const std::string& name) {
+    if (tools.erase(name) == 0) {
+        return false;
+    }
+    
+    ++definitions_version;
+    compiled_definitions.reset();
+    return true;
 }
 
 void ToolManager::register_default_tools() {
     // Register calculator tool
     register_tool(std::make_unique<CalculatorTool>(*this));
+    register_tool(std::make_unique<StatisticsTool>(*this));
     
     // Register shell tools if enabled
     if (config.is_shell_enabled()) {
         register_tool(std::make_unique<ShellTool>(*this));
         register_tool(std::make_unique<BashTool>(*this));
+        register_tool(std::make_unique<StartJobTool>(*this));
+        register_tool(std::make_unique<JobStatusTool>(*this));
+        register_tool(std::make_unique<JobOutputTool>(*this));
+        register_tool(std::make_unique<WaitJobTool>(*this));
+        register_tool(std::make_unique<KillJobTool>(*this));
     }
     
+    // Reading back spilled outputs is needed as soon as any tool can produce one
+    register_tool(std::make_unique<ReadOutputTool>(*this));
+    
     // Register model listing tool if enabled
     if (config.is_model_list_enabled()) {
         register_tool(std::make_unique<ModelListTool>(*this));
@@ -45,8 +114,12 @@ void ToolManager::register_default_tools() {
     // Register file operation tools if enabled
     if (config.is_file_ops_enabled()) {
         register_tool(std::make_unique<FileReadTool>(*this));
+        register_tool(std::make_unique<MultiFileReadTool>(*this));
+        register_tool(std::make_unique<SearchTool>(*this));
+        register_tool(std::make_unique<ListFilesTool>(*this));
         register_tool(std::make_unique<FileWriteTool>(*this));
         register_tool(std::make_unique<FileEditTool>(*this));
+        register_tool(std::make_unique<ApplyPatchTool>(*this));
     }
 }
 
@@ -58,6 +131,25 @@ std::vector<nlohmann::json> ToolManager::get_tool_definitions() const {
     return definitions;
 }
 
+std::shared_ptr<const ToolDefinitionBlob> ToolManager::get_compiled_tool_definitions() const {
+    if (!compiled_definitions) {
+        auto blob = std::make_shared<ToolDefinitionBlob>();
+        blob->version = definitions_version;
+        blob->count = tools.size();
+        
+        if (!tools.empty()) {
+            nlohmann::json definitions = nlohmann::json::array();
+            for (const auto& [name, tool] : tools) {
+                definitions.push_back(tool->get_definition());
+            }
+            blob->json = definitions.dump();
+        }
+        
+        compiled_definitions = std::move(blob);
+    }
+    return compiled_definitions;
+}
+
 bool ToolManager::has_tool(const std::string& name) const {
     return tools.find(name) != tools.end();
 }
@@ -68,7 +160,135 @@ ToolResult ToolManager::execute_tool(const std::string& name, const nlohmann::js
         return ToolResult::error("Tool not found: " + name);
     }
     
-    return it->second->execute(args);
+    ToolBase& tool = *it->second;
+    
+    // Answer a repeated call from memory if nothing it depended on has changed.
+    // Only calls without side effects are kept, so a hit never needs confirming
+    MemoRule rule = tool.memo_rule(args);
+    std::string memo_key;
+    std::vector<std::string> stamps;
+    if (config.is_tool_memo_enabled() && rule.reusable && !rule.side_effects) {
+        memo_key = name + "\n" + args.dump(); // Object keys are sorted, so the dump is canonical
+        // Stamped before the call runs, so a change made meanwhile invalidates the result
+        for (const auto& file : rule.files) {
+            stamps.push_back(file_stamp(file));
+        }
+        auto hit = memo.find(memo_key);
+        if (hit != memo.end()) {
+            if (is_memo_valid(hit->second, stamps)) {
+                ToolResult result = hit->second.result;
+                result.display.clear();
+                result.memoized = true;
+                return result;
+            }
+            memo.erase(hit);
+        }
+    }
+    if (rule.side_effects) {
+        ++side_effect_epoch;
+    }
+    
+    ToolResult result = tool.execute(args);
+    if (!result.is_success) {
+        io::sanitize_utf8(result.error_message);
+        return result;
+    }
+    
+    // Command output loses escape sequences, progress redraws and repeated lines
+    bool reduce = config.is_tool_output_reduced() && tool.reduces_output();
+    std::string original;
+    bool lossy = false;
+    if (reduce) {
+        conversation::ReductionStats stats;
+        std::string reduced = conversation::reduce_output(result.content, conversation::ReductionOptions{}, stats);
+        if (reduced.size() < result.content.size()) {
+            original = std::move(result.content);
+            result.content = std::move(reduced);
+            lossy = stats.lines_collapsed > 0;
+        }
+    }
+    const std::string& full = original.empty() ? result.content : original;
+    
+    // Keep large outputs out of the conversation: the model gets a summary and a handle.
+    // Collapsed lines are kept the same way, so none of the output is out of reach
+    if (!tool.pages_output() && (result.content.size() > SPILL_BYTES || lossy)) {
+        std::string error;
+        auto spilled = spill_store.put(name, full, error);
+        if (spilled && result.content.size() > SPILL_BYTES) {
+            result.content = summarize(*spilled, reduce);
+        } else if (spilled) {
+            result.content += "\n[Repeated lines were collapsed; the output as produced is kept as " +
+                              spilled->handle + " for read_output]";
+        }
+    }
+    if (result.content.size() < full.size()) {
+        result.original_bytes = full.size();
+    }
+    
+    // Binary files and Latin-1 output must not reach the request as invalid UTF-8
+    io::sanitize_utf8(result.content);
+    
+    if (!memo_key.empty()) {
+        if (memo.size() >= MEMO_ENTRIES) {
+            auto oldest = std::min_element(memo.begin(), memo.end(), [](const auto& a, const auto& b) {
+                return a.second.stored < b.second.stored;
+            });
+            memo.erase(oldest);
+        }
+        memo[memo_key] = MemoEntry{result, rule, std::move(stamps), side_effect_epoch,
+                                   std::chrono::steady_clock::now()};
+    }
+    return result;
+}
+
+bool ToolManager::is_memo_valid(const MemoEntry& entry, const std::vector<std::string>& stamps) const {
+    if (entry.stamps != stamps) {
+        return false;
+    }
+    if (entry.rule.max_age.count() > 0 && std::chrono::steady_clock::now() - entry.stored >= entry.rule.max_age) {
+        return false;
+    }
+    if (entry.rule.until_side_effect) {
+        if (entry.epoch != side_effect_epoch) {
+            return false;
+        }
+        // A background job may be changing files at any moment
+        for (const auto& job : jobs.list()) {
+            if (job.running) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+const process::CommandPolicy& ToolManager::get_bash_policy() {
+    if (!bash_policy) {
+        bash_policy = std::make_unique<process::CommandPolicy>(process::CommandPolicy::bash_rules());
+        for (const auto& rule : config.get_shell_policy_rules()) {
+            bash_policy->add_rule(rule);
+        }
+    }
+    return *bash_policy;
+}
+
+const process::CommandPolicy& ToolManager::get_shell_policy() {
+    if (!shell_policy) {
+        shell_policy = std::make_unique<process::CommandPolicy>(process::CommandPolicy::shell_rules());
+        for (const auto& rule : config.get_shell_policy_rules()) {
+            shell_policy->add_rule(rule);
+        }
+    }
+    return *shell_policy;
+}
+
+void ToolManager::reset_tools() {
+    for (auto& [name, tool] : tools) {
+        tool->reset();
+    }
+    jobs.stop_all();
+    spill_store.clear();
+    memo.clear();
 }
 
 } // namespace tools
@@ -0,0 +1,61 @@
+#include "../include/neoneo/calc/expression.hpp"
+#include <iostream>
+#include <string>
+
+using namespace neoneo::calc;
+
+namespace {
+
+int failures = 0;
+
+void expect_output(const std::string& source, const std::string& expected) {
+    try {
+        auto result = evaluate(source);
+        if (result.output != expected) {
+            std::cerr << source << ": expected '" << expected << "', got '" << result.output << "'\n";
+            ++failures;
+        }
+    } catch (const CalcError& e) {
+        std::cerr << source << ": expected '" << expected << "', got error '" << e.what() << "'\n";
+        ++failures;
+    }
+}
+
+void expect_error(const std::string& source, const std::string& message) {
+    try {
+        auto result = evaluate(source);
+        std::cerr << source << ": expected error '" << message << "', got '" << result.output << "'\n";
+        ++failures;
+    } catch (const CalcError& e) {
+        if (std::string(e.what()).find(message) == std::string::npos) {
+            std::cerr << source << ": expected error '" << message << "', got '" << e.what() << "'\n";
+            ++failures;
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    // Literals outside double range run on the decimal backend
+    expect_output("1e400 / 1e399", "10.00000000000000000000");
+    expect_output("1e400 + 1 - 1e400", "1");
+    expect_output("2e400 / 1e400", "2.00000000000000000000");
+    expect_output("1e-400 > 0", "1");
+    expect_error("scale=1000; 1e-9999999", "Exponent out of range");
+
+    EvalOptions doubles;
+    doubles.backend = Backend::Double;
+    try {
+        evaluate("1e400 + 1", doubles);
+        std::cerr << "double backend accepted 1e400\n";
+        ++failures;
+    } catch (const CalcError&) {
+    }
+
+    if (failures > 0) {
+        std::cerr << failures << " calculator checks failed\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include "../include/neoneo/config/config.hpp"
+#include "../include/neoneo/tools/tools.hpp"
+#include <cstdio>
+#include <iostream>
+#include <memory>
+
+using namespace neoneo;
+
+int main() {
+    // With no terminal to answer, every confirmation dialog is cancelled
+    if (!std::freopen("/dev/null", "r", stdin)) {
+        std::cerr << "cannot redirect stdin\n";
+        return 1;
+    }
+
+    config::Config config;
+    config.set_auto_confirm_shell(true); // Only the policy dialog can stop the job
+    tools::ToolManager manager(config);
+    manager.register_tool(std::make_unique<tools::StartJobTool>(manager));
+
+    // A dangerous command behind reserved words still needs confirmation
+    auto result = manager.execute_tool(
+        "start_job", {{"command", "if true; then rm -rf ./neoneo-job-policy-test-missing; fi"}});
+    if (result.is_success || result.error_message.find("security concerns") == std::string::npos) {
+        std::cerr << "start_job ran a flagged command without confirmation: "
+                  << (result.is_success ? result.content : result.error_message) << "\n";
+        return 1;
+    }
+    return 0;
+}
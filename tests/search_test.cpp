@@ -0,0 +1,61 @@
+#include "../include/neoneo/io/search.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+using namespace neoneo;
+using neoneo::io::required_literal;
+
+namespace {
+
+int failures = 0;
+
+void expect_literal(const std::string& pattern, const std::string& expected) {
+    std::string literal = required_literal(pattern);
+    if (literal != expected) {
+        std::cerr << pattern << ": expected literal '" << expected << "', got '" << literal << "'\n";
+        ++failures;
+    }
+}
+
+} // namespace
+
+int main() {
+    expect_literal("foo[0-9]+bar", "foo");
+    expect_literal("[]abc]xyz", "xyz");
+    expect_literal("[^]abc]xyz", "xyz");
+
+    // Bracket expressions nested in a bracket expression end with their own ']'
+    expect_literal("[[:digit:]]xyz", "xyz");
+    expect_literal("[[:alpha:]_]+_name", "_name");
+    expect_literal("[^[:space:]]+ident", "ident");
+    expect_literal("[[=a=]]bcd", "bcd");
+    expect_literal("[[.].]]xyz", "xyz");
+    expect_literal("[[:digit:]xyz", "");
+
+    // The search itself must not drop lines a POSIX class matches
+    char root[] = "/tmp/neoneo-search-test-XXXXXX";
+    if (!mkdtemp(root)) {
+        std::cerr << "cannot create a temporary directory\n";
+        return 1;
+    }
+    std::ofstream(std::string(root) + "/sample.txt") << "foo1xyz\nfooxyz\n";
+    io::SearchOptions options;
+    options.pattern = "[[:digit:]]xyz";
+    options.regex = true;
+    io::SearchResult result;
+    std::string error;
+    if (!io::search(root, options, result, error) || result.total_matches != 1) {
+        std::cerr << options.pattern << ": expected 1 match, got " << result.total_matches << " " << error << "\n";
+        ++failures;
+    }
+    std::system(("rm -rf " + std::string(root)).c_str());
+
+    if (failures > 0) {
+        std::cerr << failures << " search checks failed\n";
+        return 1;
+    }
+    return 0;
+}